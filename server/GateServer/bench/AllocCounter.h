@@ -0,0 +1,92 @@
+/**
+ * @file    AllocCounter.h
+ * @brief   基准程序共用: 替换全局 operator new 统计分配次数，以及逐项计时的 Measure
+ * @author  msr
+ *
+ * @details
+ * - 每个线程用普通计数器累计自己的 operator new 次数 (AllocCount)，单线程基准直接前后相减；
+ * - 需要按线程归类的基准 (如只统计 IO 线程) 在目标线程上把 tl_alloc_counter 指向一个共享的原子计数器。
+ *
+ * @note    定义了全局 operator new / delete，每个可执行文件只能在一个源文件中包含。
+ */
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+#include <type_traits>
+
+// 替换全局 operator new/delete 后 GCC 会对 malloc/free 配对误报
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic ignored "-Wmismatched-new-delete"
+#endif
+
+namespace bench
+{
+inline thread_local std::size_t tl_allocs = 0;                          ///< 本线程累计的分配次数
+inline thread_local std::atomic<std::uint64_t> *tl_alloc_counter = nullptr; ///< 非空时同时计入该计数器
+
+/**
+ * @brief   调用线程到目前为止的 operator new 次数
+ */
+inline std::size_t AllocCount()
+{
+    return tl_allocs;
+}
+
+/**
+ * @brief   执行 fn iterations 次，输出每次的耗时与 operator new 次数
+ * @param   fn 无参数或以迭代序号为参数，返回值累加后取平均输出 (字节数 / 命中数等，同时防止被优化掉)
+ */
+template <typename Fn>
+void Measure(const char *group, const char *name, std::size_t iterations, Fn &&fn)
+{
+    std::size_t sink = 0;
+    std::size_t allocs_before = AllocCount();
+    auto begin = std::chrono::steady_clock::now();
+    for (std::size_t i = 0; i < iterations; ++i)
+    {
+        if constexpr (std::is_invocable_v<Fn &, std::size_t>)
+        {
+            sink += static_cast<std::size_t>(fn(i));
+        }
+        else
+        {
+            sink += static_cast<std::size_t>(fn());
+        }
+    }
+    auto end = std::chrono::steady_clock::now();
+    double ns = std::chrono::duration<double, std::nano>(end - begin).count() / static_cast<double>(iterations);
+    std::printf("%-16s %-18s %8.1f ns  allocs=%5.2f  avg=%.2f\n", group, name, ns,
+                static_cast<double>(AllocCount() - allocs_before) / static_cast<double>(iterations),
+                static_cast<double>(sink) / static_cast<double>(iterations));
+}
+} // namespace bench
+
+void *operator new(std::size_t size)
+{
+    ++bench::tl_allocs;
+    if (bench::tl_alloc_counter != nullptr)
+    {
+        bench::tl_alloc_counter->fetch_add(1, std::memory_order_relaxed);
+    }
+    if (void *p = std::malloc(size == 0 ? 1 : size))
+    {
+        return p;
+    }
+    throw std::bad_alloc();
+}
+
+void operator delete(void *p) noexcept
+{
+    std::free(p);
+}
+
+void operator delete(void *p, std::size_t) noexcept
+{
+    std::free(p);
+}
@@ -0,0 +1,152 @@
+/**
+ * @file    accept_bench.cpp
+ * @brief   Accept 吞吐基准测试: Single vs ReusePort
+ * @author  msr
+ *
+ * @details
+ * 在进程内依次启动两种接收布局的 CServer，多个客户端线程循环 connect/close，
+ * 统计服务端在固定时长内完成的 Accept 数。
+ * 客户端使用 SO_LINGER(0) 关闭，避免本机 TIME_WAIT 耗尽临时端口。
+ *
+ * 用法: accept_bench [seconds=5] [clients=4] [port=18080]
+ */
+
+#include "AsioIOServicePool.h"
+#include "CServer.h"
+#include "Logger.h"
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <thread>
+#include <vector>
+
+namespace
+{
+struct BenchResult
+{
+    std::uint64_t accepted = 0;
+    std::uint64_t connected = 0;
+    double seconds = 0;
+};
+
+/**
+ * @brief   客户端压测循环: 建连后立即 RST 关闭
+ */
+void RunClients(unsigned short port, int clients, std::chrono::seconds duration, std::atomic<std::uint64_t> &connected)
+{
+    std::atomic<bool> stop{false};
+    std::vector<std::thread> threads;
+    for (int i = 0; i < clients; ++i)
+    {
+        threads.emplace_back(
+            [&]()
+            {
+                net::io_context ioc;
+                tcp::endpoint ep(net::ip::make_address("127.0.0.1"), port);
+                while (!stop.load(std::memory_order_relaxed))
+                {
+                    tcp::socket s(ioc);
+                    beast::error_code ec;
+                    s.connect(ep, ec);
+                    if (ec)
+                    {
+                        continue;
+                    }
+                    s.set_option(net::socket_base::linger(true, 0), ec);
+                    s.close(ec);
+                    connected.fetch_add(1, std::memory_order_relaxed);
+                }
+            });
+    }
+    std::this_thread::sleep_for(duration);
+    stop = true;
+    for (auto &t : threads)
+    {
+        t.join();
+    }
+}
+
+BenchResult RunSingle(unsigned short port, int clients, std::chrono::seconds duration)
+{
+    // 模拟 GateServer.cpp 的主线程 ioc{1}
+    net::io_context acceptor_ioc{1};
+    auto server = std::make_shared<CServer>(acceptor_ioc, port, AcceptMode::Single);
+    server->HandleAccept();
+    std::thread acceptor_thread([&acceptor_ioc]() { acceptor_ioc.run(); });
+
+    std::atomic<std::uint64_t> connected{0};
+    auto begin = std::chrono::steady_clock::now();
+    RunClients(port, clients, duration, connected);
+    auto end = std::chrono::steady_clock::now();
+
+    BenchResult result;
+    result.accepted = server->AcceptedCount();
+    result.connected = connected.load();
+    result.seconds = std::chrono::duration<double>(end - begin).count();
+
+    server->Close();
+    acceptor_thread.join();
+    return result;
+}
+
+BenchResult RunReusePort(unsigned short port, int clients, std::chrono::seconds duration)
+{
+    auto pool = AsioIOServicePool::GetInstance();
+    std::vector<std::shared_ptr<CServer>> servers;
+    for (std::size_t i = 0; i < pool->Size(); ++i)
+    {
+        auto server = std::make_shared<CServer>(*pool->GetIOService(i), port, AcceptMode::ReusePort);
+        net::post(*pool->GetIOService(i), [server]() { server->HandleAccept(); });
+        servers.push_back(server);
+    }
+
+    std::atomic<std::uint64_t> connected{0};
+    auto begin = std::chrono::steady_clock::now();
+    RunClients(port, clients, duration, connected);
+    auto end = std::chrono::steady_clock::now();
+
+    BenchResult result;
+    for (auto &server : servers)
+    {
+        result.accepted += server->AcceptedCount();
+        server->Close();
+    }
+    result.connected = connected.load();
+    result.seconds = std::chrono::duration<double>(end - begin).count();
+    return result;
+}
+
+void Print(const char *layout, std::size_t acceptors, const BenchResult &r)
+{
+    std::printf("%-10s acceptors=%-3zu accepted=%-10llu connected=%-10llu accepts/s=%.0f\n", layout, acceptors,
+                static_cast<unsigned long long>(r.accepted), static_cast<unsigned long long>(r.connected),
+                r.accepted / r.seconds);
+}
+} // namespace
+
+int main(int argc, char *argv[])
+{
+    int seconds = argc > 1 ? std::atoi(argv[1]) : 5;
+    int clients = argc > 2 ? std::atoi(argv[2]) : 4;
+    unsigned short port = static_cast<unsigned short>(argc > 3 ? std::atoi(argv[3]) : 18080);
+
+    // HttpConnection 的调试输出会淹没结果，压测期间丢弃
+    Logger::SetLevel(LogLevel::Off);
+
+    auto pool = AsioIOServicePool::GetInstance();
+    std::printf("accept_bench: %d s, %d clients, port %u, io threads %zu\n", seconds, clients, port, pool->Size());
+
+    auto single = RunSingle(port, clients, std::chrono::seconds(seconds));
+    Print("single", 1, single);
+
+#ifdef SO_REUSEPORT
+    auto reuse = RunReusePort(port, clients, std::chrono::seconds(seconds));
+    Print("reuseport", pool->Size(), reuse);
+#else
+    std::printf("reuseport  skipped: SO_REUSEPORT not supported\n");
+#endif
+
+    pool->Stop();
+    return 0;
+}
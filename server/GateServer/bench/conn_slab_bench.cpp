@@ -0,0 +1,170 @@
+/**
+ * @file    conn_slab_bench.cpp
+ * @brief   连接对象池分配计数: ConnectionSlab 关闭 vs 开启
+ * @author  msr
+ *
+ * @details
+ * 替换全局 operator new，按线程分别统计:
+ * - accept: Acceptor 线程上的分配 (Acquire + async_accept + 投递)，即 Accept 路径本身
+ * - session: IO 线程上的分配 (Session 读请求、关闭、回收)
+ * 客户端循环 connect/close，预热后统计稳态下每个连接的平均分配次数，并打印池计数。
+ *
+ * 用法: conn_slab_bench [connections=20000] [clients=4] [port=18081]
+ */
+
+#include "AllocCounter.h"
+#include "AsioIOServicePool.h"
+#include "CServer.h"
+#include "HttpConnectionSlab.h"
+#include "Logger.h"
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <future>
+#include <thread>
+#include <vector>
+
+namespace
+{
+std::atomic<std::uint64_t> g_accept_allocs{0};
+std::atomic<std::uint64_t> g_session_allocs{0};
+
+HttpConnectionSlab::Stats SumStats(AsioIOServicePool &pool)
+{
+    HttpConnectionSlab::Stats total;
+    for (std::size_t i = 0; i < pool.Size(); ++i)
+    {
+        auto s = net::use_service<HttpConnectionSlab>(*pool.GetIOService(i)).GetStats();
+        total.created += s.created;
+        total.reused += s.reused;
+        total.recycled += s.recycled;
+        total.destroyed += s.destroyed;
+        total.cached += s.cached;
+    }
+    return total;
+}
+
+void Connect(unsigned short port, int count, int clients)
+{
+    std::vector<std::thread> threads;
+    for (int c = 0; c < clients; ++c)
+    {
+        threads.emplace_back(
+            [port, n = count / clients]()
+            {
+                net::io_context ioc;
+                tcp::endpoint ep(net::ip::make_address("127.0.0.1"), port);
+                for (int i = 0; i < n; ++i)
+                {
+                    tcp::socket s(ioc);
+                    beast::error_code ec;
+                    s.connect(ep, ec);
+                    s.set_option(net::socket_base::linger(true, 0), ec);
+                    s.close(ec);
+                }
+            });
+    }
+    for (auto &t : threads)
+    {
+        t.join();
+    }
+}
+
+/**
+ * @brief   等待所有连接关闭并回到池中 (或被销毁)
+ */
+void WaitReleased(AsioIOServicePool &pool, std::uint64_t expected)
+{
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+    while (std::chrono::steady_clock::now() < deadline)
+    {
+        auto s = SumStats(pool);
+        if (s.recycled + s.destroyed >= expected)
+        {
+            return;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+}
+
+void Run(const char *name, std::size_t capacity, unsigned short port, int connections, int clients)
+{
+    auto pool = AsioIOServicePool::GetInstance();
+    for (std::size_t i = 0; i < pool->Size(); ++i)
+    {
+        net::use_service<HttpConnectionSlab>(*pool->GetIOService(i)).SetCapacity(capacity);
+    }
+
+    net::io_context acceptor_ioc{1};
+    auto server = std::make_shared<CServer>(acceptor_ioc, port, AcceptMode::Single);
+    server->HandleAccept();
+    std::thread acceptor_thread(
+        [&acceptor_ioc]()
+        {
+            bench::tl_alloc_counter = &g_accept_allocs;
+            acceptor_ioc.run();
+        });
+
+    // 预热: 填满池、预热 Asio 的 handler 内存缓存
+    auto before_warm = SumStats(*pool);
+    int warmup = connections / 10;
+    Connect(port, warmup, clients);
+    WaitReleased(*pool, before_warm.recycled + before_warm.destroyed + warmup / clients * clients);
+
+    auto before = SumStats(*pool);
+    std::uint64_t accept_before = g_accept_allocs.load();
+    std::uint64_t session_before = g_session_allocs.load();
+
+    auto begin = std::chrono::steady_clock::now();
+    Connect(port, connections, clients);
+    std::uint64_t done = connections / clients * clients;
+    WaitReleased(*pool, before.recycled + before.destroyed + done);
+    auto end = std::chrono::steady_clock::now();
+
+    auto after = SumStats(*pool);
+    double accept_per_conn = double(g_accept_allocs.load() - accept_before) / done;
+    double session_per_conn = double(g_session_allocs.load() - session_before) / done;
+    std::printf("%-8s capacity=%-5zu conns=%-7llu accept_allocs/conn=%.3f session_allocs/conn=%.3f "
+                "created=%llu reused=%llu recycled=%llu destroyed=%llu time=%.2fs\n",
+                name, capacity, static_cast<unsigned long long>(done), accept_per_conn, session_per_conn,
+                static_cast<unsigned long long>(after.created - before.created),
+                static_cast<unsigned long long>(after.reused - before.reused),
+                static_cast<unsigned long long>(after.recycled - before.recycled),
+                static_cast<unsigned long long>(after.destroyed - before.destroyed),
+                std::chrono::duration<double>(end - begin).count());
+
+    server->Close();
+    acceptor_thread.join();
+}
+} // namespace
+
+int main(int argc, char *argv[])
+{
+    int connections = argc > 1 ? std::atoi(argv[1]) : 20000;
+    int clients = argc > 2 ? std::atoi(argv[2]) : 4;
+    unsigned short port = static_cast<unsigned short>(argc > 3 ? std::atoi(argv[3]) : 18081);
+
+    Logger::SetLevel(LogLevel::Off);
+
+    // 标记 IO 线程，只统计服务端线程上的分配
+    auto pool = AsioIOServicePool::GetInstance();
+    for (std::size_t i = 0; i < pool->Size(); ++i)
+    {
+        std::promise<void> marked;
+        net::post(*pool->GetIOService(i),
+                  [&marked]()
+                  {
+                      bench::tl_alloc_counter = &g_session_allocs;
+                      marked.set_value();
+                  });
+        marked.get_future().wait();
+    }
+
+    std::printf("conn_slab_bench: %d connections, %d clients, io threads %zu\n", connections, clients, pool->Size());
+    Run("no-slab", 0, port, connections, clients);
+    Run("slab", 1024, port, connections, clients);
+
+    pool->Stop();
+    return 0;
+}
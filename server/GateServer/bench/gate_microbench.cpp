@@ -0,0 +1,279 @@
+/**
+ * @file    gate_microbench.cpp
+ * @brief   请求热路径的微基准 (Google Benchmark)
+ * @author  msr
+ *
+ * @details
+ * 每个函数单独测量，用于在合入前发现热路径的性能回退:
+ * - UrlDecode:        QueryParams::Decode (含 FromHex)，纯文本 / 混合 / 全部 %xx
+ * - FindEscape:       '%' / '+' 的 SIMD 扫描
+ * - PreParseGetParam: 切出路径并解析查询串 (HttpConnection 的私有步骤)
+ * - RouteLookup:      LogicSystem 实际注册的路由表上查找 (命中 / 404 / 405)
+ * - RegisterJson:     /user_register 请求体解析 + DTO 校验，响应 DTO 序列化
+ * - ConfigLookup:     ConfigMgr::operator[] 两级查找 (按值返回 SectionInfo)
+ * - RPConPool / MySqlPool: 多线程 getConnection + returnConnection，线程数超过池大小时排队
+ *   (MySqlPool 按 config.ini 的 [Mysql] 建连，连不上时跳过)
+ *
+ * 用法: gate_microbench [--benchmark_filter=...] [--benchmark_format=json] (在含 config.ini 的目录下运行)
+ */
+
+#include "ConfigMgr.h"
+#include "GateMessages.h"
+#include "HttpConnection.h"
+#include "JsonCodec.h"
+#include "Logger.h"
+#include "LogicSystem.h"
+#include "MysqlPool.h"
+#include "QueryParams.h"
+#include "VerifyGrpcClient.h"
+#include <benchmark/benchmark.h>
+#include <string>
+#include <vector>
+
+/**
+ * @struct  GateBenchAccess
+ * @brief   访问 HttpConnection / LogicSystem 私有成员 (两者声明了友元)
+ */
+struct GateBenchAccess
+{
+    static void SetTarget(HttpConnection &connection, http::verb method, std::string_view target)
+    {
+        connection._request.method(method);
+        connection._request.target(target);
+    }
+
+    static void PreParseGetParam(HttpConnection &connection)
+    {
+        connection.PreParseGetParam();
+    }
+
+    static std::size_t ParamCount(const HttpConnection &connection)
+    {
+        return connection._get_params.Size();
+    }
+
+    static const Router &Routes(const LogicSystem &logic)
+    {
+        return logic._router;
+    }
+};
+
+namespace
+{
+// ---------------------------------------------------------------------------
+// URL 解码
+// ---------------------------------------------------------------------------
+const std::vector<std::string> &DecodeInputs()
+{
+    static const std::vector<std::string> inputs = {
+        "someone.long.name.example.com.with.no.escapes.at.all",
+        "someone%40example.com&name=hello+world%21+and+more%2C+text",
+        "%E4%BD%A0%E5%A5%BD%E4%B8%96%E7%95%8C%E4%BD%A0%E5%A5%BD%E4%B8%96%E7%95%8C",
+    };
+    return inputs;
+}
+
+void BM_UrlDecode(benchmark::State &state)
+{
+    const std::string &input = DecodeInputs()[static_cast<std::size_t>(state.range(0))];
+    std::string out;
+    out.reserve(input.size());
+    for (auto _ : state)
+    {
+        out.clear();
+        QueryParams::Decode(input, out);
+        benchmark::DoNotOptimize(out.data());
+    }
+    state.SetBytesProcessed(static_cast<std::int64_t>(state.iterations() * input.size()));
+}
+BENCHMARK(BM_UrlDecode)->ArgName("input")->Arg(0)->Arg(1)->Arg(2);
+
+void BM_FindEscape(benchmark::State &state)
+{
+    std::string input(static_cast<std::size_t>(state.range(0)), 'a');
+    input.back() = '%';
+    for (auto _ : state)
+    {
+        benchmark::DoNotOptimize(QueryParams::FindEscape(input.data(), input.size()));
+    }
+    state.SetBytesProcessed(static_cast<std::int64_t>(state.iterations() * input.size()));
+}
+BENCHMARK(BM_FindEscape)->Arg(16)->Arg(64)->Arg(512);
+
+// ---------------------------------------------------------------------------
+// 请求行解析
+// ---------------------------------------------------------------------------
+void BM_PreParseGetParam(benchmark::State &state)
+{
+    static const char *kTargets[] = {
+        "/get_test",
+        "/get_test?key=value&page=2&size=20",
+        "/get_test?email=someone%40example.com&name=hello+world&tag=%E4%BD%A0%E5%A5%BD",
+    };
+    const char *target = kTargets[state.range(0)];
+    net::io_context ioc;
+    HttpConnection connection(ioc);
+    GateBenchAccess::SetTarget(connection, http::verb::get, target);
+    for (auto _ : state)
+    {
+        GateBenchAccess::PreParseGetParam(connection);
+        benchmark::DoNotOptimize(GateBenchAccess::ParamCount(connection));
+    }
+}
+BENCHMARK(BM_PreParseGetParam)->ArgName("target")->Arg(0)->Arg(1)->Arg(2);
+
+// ---------------------------------------------------------------------------
+// 路由查找
+// ---------------------------------------------------------------------------
+void BM_RouteLookup(benchmark::State &state)
+{
+    struct Lookup
+    {
+        http::verb method;
+        std::string_view path;
+    };
+    static const Lookup kLookups[] = {
+        {http::verb::post, "/user_register"},
+        {http::verb::get, "/get_test"},
+        {http::verb::get, "/no/such/route"},
+        {http::verb::get, "/user_register"},
+    };
+    const Lookup &lookup = kLookups[state.range(0)];
+    const Router &router = GateBenchAccess::Routes(*LogicSystem::GetInstance());
+    PathParams params;
+    for (auto _ : state)
+    {
+        std::size_t index = 0;
+        benchmark::DoNotOptimize(router.Find(lookup.method, lookup.path, index, params));
+        benchmark::DoNotOptimize(index);
+    }
+}
+// 0: POST 命中  1: GET 命中  2: 404  3: 405
+BENCHMARK(BM_RouteLookup)->ArgName("case")->Arg(0)->Arg(1)->Arg(2)->Arg(3);
+
+// ---------------------------------------------------------------------------
+// /user_register 的 JSON 编解码
+// ---------------------------------------------------------------------------
+void BM_RegisterJsonParse(benchmark::State &state)
+{
+    JsonBackend previous = JsonDocument::GetBackend();
+    if (!JsonDocument::SetBackend(static_cast<JsonBackend>(state.range(0))))
+    {
+        state.SkipWithError("backend not compiled in");
+        return;
+    }
+    static const std::string kBody = R"({"user":"someone","email":"someone.long.name@example.com",)"
+                                     R"("passwd":"a-long-password-123","confirm":"a-long-password-123",)"
+                                     R"("varifycode":"123456","icon":""})";
+    beast::flat_buffer body;
+    body.commit(net::buffer_copy(body.prepare(kBody.size()), net::buffer(kBody)));
+    JsonDocument::ReservePadding(body);
+    for (auto _ : state)
+    {
+        JsonDocument document;
+        RegisterRequest request;
+        bool ok = document.Parse(body) && static_cast<bool>(DtoDecode(document, request));
+        benchmark::DoNotOptimize(ok);
+        benchmark::DoNotOptimize(request.user.data());
+    }
+    state.SetBytesProcessed(static_cast<std::int64_t>(state.iterations() * kBody.size()));
+    JsonDocument::SetBackend(previous);
+}
+BENCHMARK(BM_RegisterJsonParse)
+    ->ArgName("backend")
+    ->Arg(static_cast<int>(JsonBackend::JsonCpp))
+    ->Arg(static_cast<int>(JsonBackend::Simdjson));
+
+void BM_RegisterJsonSerialize(benchmark::State &state)
+{
+    RegisterResponse response{"someone.long.name@example.com", 0, 10086, "someone"};
+    beast::flat_buffer out;
+    for (auto _ : state)
+    {
+        out.consume(out.size());
+        JsonWriter writer(out);
+        DtoEncode(writer, response);
+        benchmark::DoNotOptimize(out.data().data());
+    }
+}
+BENCHMARK(BM_RegisterJsonSerialize);
+
+// ---------------------------------------------------------------------------
+// 配置读取
+// ---------------------------------------------------------------------------
+void BM_ConfigLookup(benchmark::State &state)
+{
+    auto &config = ConfigMgr::GetInstance();
+    for (auto _ : state)
+    {
+        std::string value = config["Workers"]["IoThreads"];
+        benchmark::DoNotOptimize(value.data());
+    }
+}
+BENCHMARK(BM_ConfigLookup);
+
+// ---------------------------------------------------------------------------
+// 连接池争用
+// ---------------------------------------------------------------------------
+void BM_RPConPoolAcquire(benchmark::State &state)
+{
+    // 只创建 Channel，不会真正连接 VerifyServer
+    static RPConPool pool(5, "localhost", "50051");
+    for (auto _ : state)
+    {
+        auto stub = pool.getConnection();
+        benchmark::DoNotOptimize(stub.get());
+        pool.returnConnection(std::move(stub));
+    }
+}
+BENCHMARK(BM_RPConPoolAcquire)->Threads(1)->Threads(4)->Threads(16)->UseRealTime();
+
+/**
+ * @brief   与 MysqlDao 相同的配置与池大小；建连失败 (池为空) 时返回 nullptr
+ * @note    进程退出时不析构 (可能仍有线程持有连接)
+ */
+MySqlPool *BenchMysqlPool()
+{
+    static MySqlPool *pool = []() -> MySqlPool *
+    {
+        auto &cfg = ConfigMgr::GetInstance();
+        auto *created = new MySqlPool("tcp://" + cfg["Mysql"]["Host"] + ":" + cfg["Mysql"]["Port"],
+                                      cfg["Mysql"]["User"], cfg["Mysql"]["Passwd"], cfg["Mysql"]["Name"], 5);
+        return created->Available() != 0 ? created : nullptr;
+    }();
+    return pool;
+}
+
+void BM_MySqlPoolAcquire(benchmark::State &state)
+{
+    MySqlPool *pool = BenchMysqlPool();
+    if (pool == nullptr)
+    {
+        state.SkipWithError("MySQL unreachable, pool is empty");
+        return;
+    }
+    for (auto _ : state)
+    {
+        auto connection = pool->getConnection();
+        benchmark::DoNotOptimize(connection.get());
+        pool->returnConnection(std::move(connection));
+    }
+}
+BENCHMARK(BM_MySqlPoolAcquire)->Threads(1)->Threads(4)->Threads(16)->UseRealTime();
+} // namespace
+
+int main(int argc, char *argv[])
+{
+    Logger::SetLevel(LogLevel::Warn);
+    benchmark::Initialize(&argc, argv);
+    if (benchmark::ReportUnrecognizedArguments(argc, argv))
+    {
+        return 1;
+    }
+    benchmark::RunSpecifiedBenchmarks();
+    benchmark::Shutdown();
+
+    LogicSystem::GetInstance()->Stop();
+    Logger::Shutdown();
+    return 0;
+}
@@ -0,0 +1,153 @@
+/**
+ * @file    json_codec_bench.cpp
+ * @brief   各路由的 JSON 解析 / 序列化开销: 原 JsonCpp 写法 vs JsonCodec
+ * @author  msr
+ *
+ * @details
+ * 按 LogicSystem 中各 POST 路由实际读写的字段构造请求 / 响应，统计每次操作的耗时与 operator new 次数:
+ * - parse:     legacy (buffers_to_string + Json::Reader + asString) / jsoncpp / simdjson (编译了 simdjson 时)
+ * - serialize: legacy (Json::Value + toStyledString + ostream) / writer (JsonWriter 直接写 flat_buffer)
+ *
+ * 用法: json_codec_bench [iterations=200000]
+ */
+
+#include "AllocCounter.h"
+#include "JsonCodec.h"
+#include <boost/asio/buffer.hpp>
+#include <boost/beast/core.hpp>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <jsoncpp/json/json.h>
+#include <string>
+#include <vector>
+
+namespace
+{
+namespace beast = boost::beast;
+
+struct RouteCase
+{
+    const char *route;
+    const char *request;
+    std::vector<const char *> fields;                              ///< Handler 读取的请求字段
+    std::vector<std::pair<const char *, const char *>> response; ///< 响应中的字符串字段
+    int uid;                                                       ///< 非 0 时响应带 uid
+};
+
+void ParseCase(const RouteCase &c, std::size_t iterations)
+{
+    // 与 HttpConnection 一致: Body 在 flat_buffer 中，simdjson 后端已预留 padding
+    beast::flat_buffer body;
+    std::string_view request = c.request;
+    body.commit(boost::asio::buffer_copy(body.prepare(request.size()),
+                                         boost::asio::buffer(request.data(), request.size())));
+
+    bench::Measure(c.route, "parse/legacy", iterations,
+                   [&]()
+                   {
+                       auto body_str = beast::buffers_to_string(body.data());
+                       Json::Value request_json;
+                       Json::Reader reader;
+                       reader.parse(body_str, request_json);
+                       std::size_t bytes = 0;
+                       for (const char *field : c.fields)
+                       {
+                           bytes += request_json[field].asString().size();
+                       }
+                       return bytes;
+                   });
+
+    auto parse_with = [&](const char *name, JsonBackend backend)
+    {
+        if (!JsonDocument::SetBackend(backend))
+        {
+            std::printf("%-16s %-18s skipped: simdjson not compiled in\n", c.route, name);
+            return;
+        }
+        JsonDocument::ReservePadding(body);
+        bench::Measure(c.route, name, iterations,
+                       [&]()
+                       {
+                           JsonDocument doc;
+                           doc.Parse(body);
+                           std::size_t bytes = 0;
+                           for (const char *field : c.fields)
+                           {
+                               bytes += doc.GetString(field).size();
+                           }
+                           return bytes;
+                       });
+    };
+    parse_with("parse/jsoncpp", JsonBackend::JsonCpp);
+    parse_with("parse/simdjson", JsonBackend::Simdjson);
+}
+
+void SerializeCase(const RouteCase &c, std::size_t iterations)
+{
+    beast::flat_buffer out;
+    bench::Measure(c.route, "serialize/legacy", iterations,
+                   [&]()
+                   {
+                       out.clear();
+                       Json::Value response_json;
+                       for (const auto &[key, value] : c.response)
+                       {
+                           response_json[key] = value;
+                       }
+                       response_json["error"] = 0;
+                       if (c.uid != 0)
+                       {
+                           response_json["uid"] = c.uid;
+                       }
+                       beast::ostream(out) << response_json.toStyledString();
+                       return out.size();
+                   });
+
+    bench::Measure(c.route, "serialize/writer", iterations,
+                   [&]()
+                   {
+                       out.clear();
+                       JsonWriter writer(out);
+                       writer.BeginObject();
+                       for (const auto &[key, value] : c.response)
+                       {
+                           writer.Field(key, value);
+                       }
+                       writer.Field("error", 0);
+                       if (c.uid != 0)
+                       {
+                           writer.Field("uid", c.uid);
+                       }
+                       writer.EndObject();
+                       return out.size();
+                   });
+}
+} // namespace
+
+int main(int argc, char *argv[])
+{
+    std::size_t iterations = static_cast<std::size_t>(argc > 1 ? std::atoll(argv[1]) : 200000);
+
+    const RouteCase cases[] = {
+        {"/get_varifycode",
+         R"({"email":"someone.long.name@example.com"})",
+         {"email"},
+         {{"code", "a1b2c3"}, {"email", "someone.long.name@example.com"}},
+         0},
+        {"/user_register",
+         R"({"user":"msr_test_user","email":"someone.long.name@example.com","passwd":"5f4dcc3b5aa765d61d8327deb882cf99",)"
+         R"("confirm":"5f4dcc3b5aa765d61d8327deb882cf99","varifycode":"a1b2c3","icon":":/res/head_1.jpg"})",
+         {"user", "email", "passwd", "varifycode"},
+         {{"email", "someone.long.name@example.com"}, {"user", "msr_test_user"}},
+         10086},
+    };
+
+    std::printf("json_codec_bench: %zu iterations\n", iterations);
+    for (const auto &c : cases)
+    {
+        ParseCase(c, iterations);
+        SerializeCase(c, iterations);
+    }
+    return 0;
+}
@@ -0,0 +1,157 @@
+/**
+ * @file    kv_contention_bench.cpp
+ * @brief   本地 KV 引擎 (LocalKv) 的锁争用、TTL 回收与内存统计
+ * @author  msr
+ *
+ * @details
+ * 1. 争用: 1 ~ max_threads 个线程对同一引擎执行 80% GET / 20% SET EX 60 (键空间 keys 个)，
+ *    分片数 1 (等同一把全局锁 + 一个 unordered_map) 与默认分片数对比 ops/s。
+ *    命令在计时前预先构造，结果只含引擎本身的开销。
+ * 2. TTL: 写入 keys 个 PX 200 的键后不再访问，等待时间轮回收，输出剩余键数与内存变化。
+ * 3. 内存: 写入 keys 个 32 字节值的键，输出估算的每键内存。
+ *
+ * 用法: kv_contention_bench [ops_per_thread=500000] [keys=100000] [max_threads=硬件线程数]
+ */
+
+#include "LocalKv.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace
+{
+using Clock = std::chrono::steady_clock;
+
+/// 每个线程预先构造的命令，循环使用
+std::vector<RedisCommand> MakeCommands(int seed, int keys)
+{
+    std::vector<RedisCommand> commands;
+    commands.reserve(4096);
+    std::uint64_t x = static_cast<std::uint64_t>(seed) * 0x9E3779B97F4A7C15ull + 1;
+    for (int i = 0; i < 4096; ++i)
+    {
+        x ^= x << 13;
+        x ^= x >> 7;
+        x ^= x << 17;
+        std::string key = "user:" + std::to_string(x % static_cast<std::uint64_t>(keys));
+        if (x % 10 < 8)
+        {
+            commands.push_back({"GET", key});
+        }
+        else
+        {
+            commands.push_back({"SET", key, "123456", "EX", "60"});
+        }
+    }
+    return commands;
+}
+
+double Contention(std::size_t shards, int threads, int ops, int keys)
+{
+    LocalKv::Options options;
+    options.shards = shards;
+    LocalKv kv(options);
+    for (int i = 0; i < keys; ++i)
+    {
+        kv.Execute({"SET", "user:" + std::to_string(i), "123456", "EX", "60"});
+    }
+
+    std::vector<std::vector<RedisCommand>> commands;
+    for (int t = 0; t < threads; ++t)
+    {
+        commands.push_back(MakeCommands(t, keys));
+    }
+    auto begin = Clock::now();
+    std::vector<std::thread> workers;
+    for (int t = 0; t < threads; ++t)
+    {
+        workers.emplace_back(
+            [&kv, &list = commands[t], ops]()
+            {
+                for (int i = 0; i < ops; ++i)
+                {
+                    kv.Execute(list[i & 4095]);
+                }
+            });
+    }
+    for (auto &worker : workers)
+    {
+        worker.join();
+    }
+    double seconds = std::chrono::duration<double>(Clock::now() - begin).count();
+    return static_cast<double>(ops) * threads / seconds;
+}
+
+void ContentionTable(int ops, int keys, int max_threads)
+{
+    std::size_t sharded = LocalKv(LocalKv::Options{}).ShardCount();
+    std::printf("\n[contention] 80%% GET / 20%% SET EX, %d keys, %d ops per thread\n", keys, ops);
+    std::printf("  %7s  %16s  %16s  %8s\n", "threads", "1 shard ops/s", "sharded ops/s", "speedup");
+    std::printf("  %7s  %16s  %16s\n", "", "", ("(" + std::to_string(sharded) + " shards)").c_str());
+    for (int threads = 1;; threads = std::min(threads * 2, max_threads))
+    {
+        double single = Contention(1, threads, ops, keys);
+        double striped = Contention(0, threads, ops, keys);
+        std::printf("  %7d  %16.0f  %16.0f  %7.2fx\n", threads, single, striped, striped / single);
+        if (threads == max_threads)
+        {
+            break;
+        }
+    }
+}
+
+void TtlReap(int keys)
+{
+    LocalKv::Options options;
+    options.tick = std::chrono::milliseconds(50);
+    LocalKv kv(options);
+    for (int i = 0; i < keys; ++i)
+    {
+        kv.Execute({"SET", "code:" + std::to_string(i), "123456", "PX", "200"});
+    }
+    auto before = kv.GetStats();
+    auto begin = Clock::now();
+    while (kv.GetStats().keys > 0 && Clock::now() - begin < std::chrono::seconds(5))
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    double ms = std::chrono::duration<double, std::milli>(Clock::now() - begin).count();
+    auto after = kv.GetStats();
+    std::printf("\n[ttl] %d keys with PX 200, tick 50 ms, never read again\n", keys);
+    std::printf("  all reaped after %.0f ms: keys %llu -> %llu, memory %llu -> %llu bytes, reaped %llu\n", ms,
+                static_cast<unsigned long long>(before.keys), static_cast<unsigned long long>(after.keys),
+                static_cast<unsigned long long>(before.memory), static_cast<unsigned long long>(after.memory),
+                static_cast<unsigned long long>(after.reaped));
+}
+
+void Memory(int keys)
+{
+    LocalKv kv(LocalKv::Options{});
+    const std::string value(32, 'v');
+    for (int i = 0; i < keys; ++i)
+    {
+        kv.Execute({"SET", "user:" + std::to_string(i), value});
+    }
+    auto stats = kv.GetStats();
+    std::printf("\n[memory] %d keys, 32-byte values: %llu bytes estimated, %.1f bytes/key\n", keys,
+                static_cast<unsigned long long>(stats.memory), static_cast<double>(stats.memory) / keys);
+}
+} // namespace
+
+int main(int argc, char *argv[])
+{
+    int ops = argc > 1 ? std::max(1, std::atoi(argv[1])) : 500000;
+    int keys = argc > 2 ? std::max(1, std::atoi(argv[2])) : 100000;
+    int max_threads = argc > 3 ? std::max(1, std::atoi(argv[3]))
+                               : static_cast<int>(std::max(1u, std::thread::hardware_concurrency()));
+
+    std::printf("kv_contention_bench: hardware threads %u\n", std::thread::hardware_concurrency());
+    ContentionTable(ops, keys, max_threads);
+    TtlReap(keys);
+    Memory(keys);
+    return 0;
+}
@@ -0,0 +1,200 @@
+/**
+ * @file    logging_bench.cpp
+ * @brief   日志开销: 请求吞吐 (日志开 / 关) 与多线程写日志 (std::cout vs Logger)
+ * @author  msr
+ *
+ * @details
+ * 1. 进程内启动 Single 模式的 CServer，若干客户端各持一个 Keep-Alive 连接，
+ *    串行发送 POST /get_varifycode (走阻塞 IO 线程池、Mock gRPC，每个请求约 6 条日志)，
+ *    分别在日志级别 debug (请求路径日志全开) / info (默认配置) / off 下统计 req/s。
+ *    验证码写入本进程内的 LocalKv (强制 [Redis] Backend=local)，不依赖 Redis 服务器，
+ *    日志写到 /dev/null，只衡量日志子系统本身的开销。
+ * 2. 多个线程同时写与请求路径相同形状的日志行:
+ *    legacy  (std::cout << ... << std::endl，写到 /dev/null，即迁移前的写法)
+ *    logger  (LOG_INFO + 字段，写线程写到 /dev/null)
+ *    off     (运行期级别关闭)
+ *
+ * 用法: logging_bench [requests_per_client=20000] [clients=4] [port=18083]
+ */
+
+#include "AsioIOServicePool.h"
+#include "CServer.h"
+#include "ConfigMgr.h"
+#include "HttpConnection.h"
+#include "LogicSystem.h"
+#include "Logger.h"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+namespace
+{
+using Clock = std::chrono::steady_clock;
+
+void RunClient(unsigned short port, int count)
+{
+    net::io_context ioc;
+    tcp::socket socket(ioc);
+    socket.connect(tcp::endpoint(net::ip::make_address("127.0.0.1"), port));
+    socket.set_option(tcp::no_delay(true));
+
+    http::request<http::string_body> req{http::verb::post, "/get_varifycode", 11};
+    req.set(http::field::host, "127.0.0.1");
+    req.set(http::field::content_type, "application/json");
+    req.body() = R"({"email":"someone.long.name@example.com"})";
+    req.prepare_payload();
+    req.keep_alive(true);
+
+    beast::flat_buffer buffer;
+    for (int i = 0; i < count; ++i)
+    {
+        http::response<http::string_body> res;
+        http::write(socket, req);
+        http::read(socket, buffer, res);
+    }
+    beast::error_code ec;
+    socket.shutdown(tcp::socket::shutdown_both, ec);
+}
+
+double RunClients(unsigned short port, int requests, int clients)
+{
+    auto begin = Clock::now();
+    std::vector<std::thread> threads;
+    for (int c = 0; c < clients; ++c)
+    {
+        threads.emplace_back([port, requests]() { RunClient(port, requests); });
+    }
+    for (auto &t : threads)
+    {
+        t.join();
+    }
+    double seconds = std::chrono::duration<double>(Clock::now() - begin).count();
+    return static_cast<double>(requests) * clients / seconds;
+}
+
+void ServerThroughput(unsigned short port, int requests, int clients)
+{
+    net::io_context acceptor_ioc{1};
+    auto server = std::make_shared<CServer>(acceptor_ioc, port, AcceptMode::Single);
+    server->HandleAccept();
+    std::thread acceptor_thread([&acceptor_ioc]() { acceptor_ioc.run(); });
+
+    Logger::SetLevel(LogLevel::Off);
+    RunClients(port, requests / 10 + 1, clients);
+
+    const std::pair<const char *, LogLevel> modes[] = {
+        {"debug", LogLevel::Debug},
+        {"info", LogLevel::Info},
+        {"off", LogLevel::Off},
+    };
+    for (const auto &[name, level] : modes)
+    {
+        Logger::SetLevel(level);
+        std::uint64_t dropped_before = Logger::Dropped();
+        double rps = RunClients(port, requests, clients);
+        Logger::Flush();
+        std::printf("server   level=%-6s rps=%-9.0f dropped=%llu\n", name, rps,
+                    static_cast<unsigned long long>(Logger::Dropped() - dropped_before));
+    }
+
+    server->Close();
+    acceptor_thread.join();
+}
+
+/// 每次调用写的日志行数 (与请求路径上一次 Handler 的两行对应)
+constexpr int kLinesPerCall = 2;
+
+template <typename Fn>
+void RecordThroughput(const char *name, int threads, int calls, Fn &&fn)
+{
+    std::uint64_t dropped_before = Logger::Dropped();
+    auto begin = Clock::now();
+    std::vector<std::thread> workers;
+    for (int t = 0; t < threads; ++t)
+    {
+        workers.emplace_back(
+            [&fn, calls]()
+            {
+                for (int i = 0; i < calls; ++i)
+                {
+                    fn(i);
+                }
+            });
+    }
+    for (auto &w : workers)
+    {
+        w.join();
+    }
+    double seconds = std::chrono::duration<double>(Clock::now() - begin).count();
+    double lines = static_cast<double>(calls) * threads * kLinesPerCall;
+    std::printf("records  %-7s threads=%d  %8.1f ns/line  %10.0f lines/s  dropped=%llu\n", name, threads,
+                seconds * 1e9 / lines, lines / seconds,
+                static_cast<unsigned long long>(Logger::Dropped() - dropped_before));
+}
+
+void RecordCost(int threads, int calls)
+{
+    std::ofstream null_stream("/dev/null");
+    std::streambuf *saved = std::cout.rdbuf(null_stream.rdbuf());
+    const std::string email = "someone.long.name@example.com";
+
+    RecordThroughput("legacy", threads, calls,
+                     [&](int i)
+                     {
+                         std::cout << "[HTTP Request] Method: POST, Target: /get_varifycode" << std::endl;
+                         std::cout << "get varify code is " << i << " for " << email << std::endl;
+                     });
+    std::cout.rdbuf(saved);
+
+    Logger::SetLevel(LogLevel::Info);
+    RecordThroughput("logger", threads, calls,
+                     [&](int i)
+                     {
+                         LOG_INFO("http request").Field("method", "POST").Field("target", "/get_varifycode");
+                         LOG_INFO("get varify code").Field("email", email).Field("code", i);
+                     });
+    Logger::Flush();
+
+    Logger::SetLevel(LogLevel::Off);
+    RecordThroughput("off", threads, calls,
+                     [&](int i)
+                     {
+                         LOG_INFO("http request").Field("method", "POST").Field("target", "/get_varifycode");
+                         LOG_INFO("get varify code").Field("email", email).Field("code", i);
+                     });
+}
+} // namespace
+
+int main(int argc, char *argv[])
+{
+    int requests = argc > 1 ? std::atoi(argv[1]) : 20000;
+    int clients = argc > 2 ? std::atoi(argv[2]) : 4;
+    unsigned short port = static_cast<unsigned short>(argc > 3 ? std::atoi(argv[3]) : 18083);
+
+    if (!Logger::SetOutput("/dev/null"))
+    {
+        std::printf("cannot open /dev/null\n");
+        return 1;
+    }
+    // 没有 Redis 服务器时每个请求都会以连接错误或超时结束，测到的是 Redis 的失败路径而不是日志
+    ConfigMgr::GetInstance().Set("Redis", "Backend", "local");
+    LogicSystem::GetInstance();
+    auto pool = AsioIOServicePool::GetInstance();
+
+    std::printf("logging_bench: %d requests x %d clients, io threads %zu\n", requests, clients, pool->Size());
+    ServerThroughput(port, requests, clients);
+    // 生产速度超过写线程时环会写满，超出部分被丢弃 (dropped 列)，调用方的耗时不受影响
+    RecordCost(clients, requests);
+
+    Logger::SetOutput("");
+    std::printf("dropped total=%llu\n", static_cast<unsigned long long>(Logger::Dropped()));
+
+    LogicSystem::GetInstance()->Stop();
+    pool->Stop();
+    Logger::Shutdown();
+    return 0;
+}
@@ -0,0 +1,137 @@
+/**
+ * @file    query_parse_bench.cpp
+ * @brief   查询串解析开销: 原 unordered_map + 逐字节 UrlDecode vs QueryParams
+ * @author  msr
+ *
+ * @details
+ * 对几类常见的查询串反复解析，统计每次解析的耗时与 operator new 次数:
+ * - legacy: 原 PreParseGetParam 的写法，每个键值构造 std::string，UrlDecode 逐字节追加，存入 unordered_map
+ * - view:   QueryParams::Parse，复用同一个对象 (与连接复用时一致)
+ * 另外单独比较长值 (少量转义) 的解码: 逐字节 vs SIMD 扫描 + 整段拷贝。
+ *
+ * 用法: query_parse_bench [iterations=1000000]
+ */
+
+#include "AllocCounter.h"
+#include "QueryParams.h"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+namespace
+{
+
+struct Case
+{
+    const char *name;
+    const char *query;
+};
+
+const Case kCases[] = {
+    {"short", "a=1"},
+    {"verify", "email=someone%40example.com&type=register&ts=1700000000"},
+    {"search", "q=hello+world+%E4%BD%A0%E5%A5%BD&page=2&size=20&sort=time&order=desc"},
+    {"tracking", "uid=10086&token=3f2a9c7e5b1d4e8fa0b6c2d9e7f1a3b5&utm_source=newsletter&utm_medium=email"
+                 "&utm_campaign=spring_sale_2024&utm_content=header_banner&ref=https%3A%2F%2Fexample.com%2Fhome"},
+};
+
+unsigned char LegacyFromHex(unsigned char x)
+{
+    if (x >= 'A' && x <= 'Z')
+        return x - 'A' + 10;
+    if (x >= 'a' && x <= 'z')
+        return x - 'a' + 10;
+    return x - '0';
+}
+
+/// 原 HttpConnection.cpp 中的 UrlDecode
+std::string LegacyUrlDecode(const std::string &str)
+{
+    std::string strTemp = "";
+    size_t length = str.length();
+    for (size_t i = 0; i < length; i++)
+    {
+        if (str[i] == '+')
+            strTemp += ' ';
+        else if (str[i] == '%' && i + 2 < length)
+        {
+            unsigned char high = LegacyFromHex((unsigned char)str[++i]);
+            unsigned char low = LegacyFromHex((unsigned char)str[++i]);
+            strTemp += high * 16 + low;
+        }
+        else
+            strTemp += str[i];
+    }
+    return strTemp;
+}
+
+/// 原 PreParseGetParam 的查询串部分
+void LegacyParse(std::string_view query_string, std::unordered_map<std::string, std::string> &params)
+{
+    params.clear();
+    while (!query_string.empty())
+    {
+        auto amp_pos = query_string.find('&');
+        auto segment = (amp_pos == std::string_view::npos) ? query_string : query_string.substr(0, amp_pos);
+        auto eq_pos = segment.find('=');
+        if (eq_pos != std::string_view::npos)
+        {
+            params[LegacyUrlDecode(std::string(segment.substr(0, eq_pos)))] =
+                LegacyUrlDecode(std::string(segment.substr(eq_pos + 1)));
+        }
+        if (amp_pos == std::string_view::npos)
+        {
+            break;
+        }
+        query_string.remove_prefix(amp_pos + 1);
+    }
+}
+
+} // namespace
+
+int main(int argc, char *argv[])
+{
+    std::size_t iterations = static_cast<std::size_t>(argc > 1 ? std::atoll(argv[1]) : 1000000);
+    std::printf("query_parse_bench: %zu iterations per case\n", iterations);
+
+    std::unordered_map<std::string, std::string> legacy;
+    QueryParams view;
+    for (const auto &c : kCases)
+    {
+        std::string_view query = c.query;
+        bench::Measure(c.name, "legacy", iterations,
+                       [&]()
+                       {
+                           LegacyParse(query, legacy);
+                           return legacy.size();
+                       });
+        bench::Measure(c.name, "view", iterations,
+                       [&]()
+                       {
+                           view.Parse(query);
+                           return view.Size();
+                       });
+    }
+
+    // 2KB 的值，每 256 字节一个转义
+    std::string long_value;
+    for (int i = 0; i < 8; ++i)
+    {
+        long_value.append(253, 'x');
+        long_value += "%2F";
+    }
+    std::string decoded;
+    decoded.reserve(long_value.size());
+    bench::Measure("decode2k", "legacy", iterations / 10, [&]() { return LegacyUrlDecode(long_value).size(); });
+    bench::Measure("decode2k", "simd", iterations / 10,
+                   [&]()
+                   {
+                       decoded.clear();
+                       QueryParams::Decode(long_value, decoded);
+                       return decoded.size();
+                   });
+    return 0;
+}
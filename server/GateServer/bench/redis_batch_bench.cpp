@@ -0,0 +1,205 @@
+/**
+ * @file    redis_batch_bench.cpp
+ * @brief   RedisMgr 自动批量开 / 关的吞吐与批量接口的往返开销 (需要本地 redis-server)
+ * @author  msr
+ *
+ * @details
+ * 每项都在 AutoBatch on / off 下各跑一次，并给出 commands/write (平均每次 write 携带的命令数):
+ * 1. sync:     1 / 4 / 16 个线程各自循环调用同步 Get (模拟 BlockingIO 线程池里的业务)。
+ * 2. async:    主线程连续发出 ops 条 SET 完成回调，全部回复后计时结束。
+ * 3. register: 注册流程的检查，Get + ExistsKey (2 个 RTT)、ExecuteBatch({GET, EXISTS}) (1 个 RTT)
+ *              与 VerifyCodeStore::VerifyAndConsume (EVALSHA，1 个 RTT) 的单次平均耗时
+ *              (提交错误的验证码，脚本完整执行但不消费)。
+ * 测试键以 gate_bench:<pid>: 为前缀，结束时删除。
+ *
+ * 用法: redis_batch_bench [host=127.0.0.1] [port=6379] [ops=200000]
+ */
+
+#include "AsioIOServicePool.h"
+#include "Logger.h"
+#include "RedisMgr.h"
+#include "VerifyCodeStore.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <future>
+#include <string>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+namespace
+{
+using Clock = std::chrono::steady_clock;
+
+double SecondsSince(Clock::time_point start)
+{
+    return std::chrono::duration<double>(Clock::now() - start).count();
+}
+
+/**
+ * @brief   打印一行结果，附带这段时间内的 commands/write
+ */
+void Report(const char *name, bool auto_batch, long long ops, double seconds,
+            const RedisConnection::Stats &before, const RedisConnection::Stats &after)
+{
+    std::uint64_t commands = after.commands - before.commands;
+    std::uint64_t writes = after.writes - before.writes;
+    std::printf("  %-22s batch=%-3s %10.0f ops/s  %8.1f ms  commands/write %.1f\n", name, auto_batch ? "on" : "off",
+                ops / seconds, seconds * 1000.0, writes > 0 ? static_cast<double>(commands) / writes : 0.0);
+}
+
+void SyncGet(RedisMgr &redis, const std::string &key, int threads, int ops, bool auto_batch)
+{
+    redis.SetAutoBatch(auto_batch);
+    int per_thread = ops / threads;
+    std::atomic<int> failed{0};
+    auto before = redis.GetStats();
+    auto start = Clock::now();
+    std::vector<std::thread> workers;
+    for (int t = 0; t < threads; ++t)
+    {
+        workers.emplace_back(
+            [&]()
+            {
+                std::string value;
+                for (int i = 0; i < per_thread; ++i)
+                {
+                    if (!redis.Get(key, value))
+                    {
+                        failed.fetch_add(1);
+                    }
+                }
+            });
+    }
+    for (auto &worker : workers)
+    {
+        worker.join();
+    }
+    double seconds = SecondsSince(start);
+    std::string name = "sync get x" + std::to_string(threads);
+    Report(name.c_str(), auto_batch, static_cast<long long>(per_thread) * threads, seconds, before, redis.GetStats());
+    if (failed > 0)
+    {
+        std::printf("    %d failed\n", failed.load());
+    }
+}
+
+void AsyncSet(RedisMgr &redis, const std::string &prefix, int ops, bool auto_batch)
+{
+    redis.SetAutoBatch(auto_batch);
+    std::atomic<int> completed{0};
+    std::atomic<int> failed{0};
+    std::promise<void> done;
+    auto before = redis.GetStats();
+    auto start = Clock::now();
+    for (int i = 0; i < ops; ++i)
+    {
+        redis.Set(prefix + std::to_string(i % 1024), "v",
+                  [&, ops](RedisReply reply)
+                  {
+                      if (reply.IsError())
+                      {
+                          failed.fetch_add(1);
+                      }
+                      if (completed.fetch_add(1) + 1 == ops)
+                      {
+                          done.set_value();
+                      }
+                  });
+    }
+    if (done.get_future().wait_for(std::chrono::seconds(60)) != std::future_status::ready)
+    {
+        // 回调仍引用栈上的计数器，不能继续
+        std::printf("async set did not complete, abort\n");
+        std::exit(1);
+    }
+    double seconds = SecondsSince(start);
+    Report("async set", auto_batch, ops, seconds, before, redis.GetStats());
+    if (failed > 0)
+    {
+        std::printf("    %d failed\n", failed.load());
+    }
+}
+
+void RegisterCheck(RedisMgr &redis, const std::string &email, const std::string &user, int rounds, bool auto_batch)
+{
+    redis.SetAutoBatch(auto_batch);
+    std::string value;
+    auto start = Clock::now();
+    for (int i = 0; i < rounds; ++i)
+    {
+        redis.Get(email, value);
+        redis.ExistsKey(user);
+    }
+    double two_calls = SecondsSince(start);
+
+    start = Clock::now();
+    for (int i = 0; i < rounds; ++i)
+    {
+        redis.ExecuteBatch({{"GET", email}, {"EXISTS", user}});
+    }
+    double batched = SecondsSince(start);
+
+    auto store = VerifyCodeStore::GetInstance();
+    start = Clock::now();
+    for (int i = 0; i < rounds; ++i)
+    {
+        store->VerifyAndConsume(email, "wrong", user);
+    }
+    double scripted = SecondsSince(start);
+    std::printf("  %-22s batch=%-3s Get+ExistsKey %7.1f us   ExecuteBatch %7.1f us   EVALSHA %7.1f us\n",
+                "register check", auto_batch ? "on" : "off", two_calls * 1e6 / rounds, batched * 1e6 / rounds,
+                scripted * 1e6 / rounds);
+}
+} // namespace
+
+int main(int argc, char *argv[])
+{
+    std::string host = argc > 1 ? argv[1] : "127.0.0.1";
+    int port = argc > 2 ? std::atoi(argv[2]) : 6379;
+    int ops = argc > 3 ? std::max(16, std::atoi(argv[3])) : 200000;
+
+    Logger::SetLevel(LogLevel::Warn);
+    auto redis = RedisMgr::GetInstance();
+    if (!redis->Connect(host, port))
+    {
+        std::fprintf(stderr, "redis_batch_bench: cannot connect to %s:%d\n", host.c_str(), port);
+        return 1;
+    }
+    std::printf("redis_batch_bench: %s:%d, %d ops, %zu io threads\n", host.c_str(), port, ops,
+                AsioIOServicePool::GetInstance()->Size());
+
+    const std::string prefix = "gate_bench:" + std::to_string(::getpid()) + ":";
+    redis->Set(prefix + "email", "123456");
+
+    for (int threads : {1, 4, 16})
+    {
+        for (bool auto_batch : {false, true})
+        {
+            SyncGet(*redis, prefix + "email", threads, ops / 4, auto_batch);
+        }
+    }
+    for (bool auto_batch : {false, true})
+    {
+        AsyncSet(*redis, prefix + "set:", ops, auto_batch);
+    }
+    for (bool auto_batch : {false, true})
+    {
+        RegisterCheck(*redis, prefix + "email", prefix + "user", ops / 20, auto_batch);
+    }
+
+    RedisCommand del = {"DEL", prefix + "email"};
+    for (int i = 0; i < 1024; ++i)
+    {
+        del.push_back(prefix + "set:" + std::to_string(i));
+    }
+    redis->Execute(std::move(del));
+
+    redis->Close();
+    AsioIOServicePool::GetInstance()->Stop();
+    Logger::Shutdown();
+    return 0;
+}
@@ -0,0 +1,195 @@
+/**
+ * @file    session_engine_bench.cpp
+ * @brief   Session 引擎对比: 回调链 vs 协程
+ * @author  msr
+ *
+ * @details
+ * 进程内启动 Single 模式的 CServer，若干客户端线程各持一个 Keep-Alive 连接，
+ * 按下面的负载发送请求，统计:
+ * - 每个请求的往返延迟 (p50 / p99 / 平均)
+ * - IO 线程上每个请求的 operator new 次数 (替换全局 operator new 按线程计数)
+ * 每个引擎测四种负载: GET 与带 512 字节 Body 的 POST (未注册路径，404)，各自串行 (一问一答) 与
+ * 流水线 (一次写出 pipeline 个请求再依次读回，后续请求走 ParseBuffered)；流水线的延迟是整批的往返。
+ * 流水线的 io_allocs/req 不应高于串行: 后续请求同样复用请求 Body 的缓冲，读取与写回按批摊薄。
+ * 未以 GATE_COROUTINE_SESSION=ON 编译时只测回调引擎。
+ *
+ * 用法: session_engine_bench [requests_per_client=20000] [clients=4] [port=18082] [pipeline=8]
+ */
+
+#include "AllocCounter.h"
+#include "AsioIOServicePool.h"
+#include "CServer.h"
+#include "HttpConnection.h"
+#include "Logger.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <future>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace
+{
+std::atomic<std::uint64_t> g_io_allocs{0};
+
+using Clock = std::chrono::steady_clock;
+
+/**
+ * @struct  Workload
+ * @brief   一轮测试的请求形态
+ */
+struct Workload
+{
+    const char *name;
+    int depth;        ///< 每次写出的请求数，1 为串行
+    std::size_t body; ///< 0 为 GET /get_test，否则为带该长度 Body 的 POST
+};
+
+/**
+ * @brief   单个客户端: 一个 Keep-Alive 连接上发送 count 个请求，每次写出 depth 个，记录每批的延迟 (ns)
+ */
+void RunClient(unsigned short port, int count, const Workload &load, std::vector<std::uint64_t> &latencies)
+{
+    net::io_context ioc;
+    tcp::socket socket(ioc);
+    socket.connect(tcp::endpoint(net::ip::make_address("127.0.0.1"), port));
+    socket.set_option(tcp::no_delay(true));
+
+    http::request<http::string_body> req{http::verb::get, "/get_test?a=1", 11};
+    if (load.body > 0)
+    {
+        req.method(http::verb::post);
+        req.target("/bench/post");
+        req.set(http::field::content_type, "application/json");
+        req.body().assign(load.body, 'x');
+        req.prepare_payload();
+    }
+    req.set(http::field::host, "127.0.0.1");
+    req.keep_alive(true);
+    std::ostringstream one;
+    one << req;
+    std::string batch;
+    for (int i = 0; i < load.depth; ++i)
+    {
+        batch += one.str();
+    }
+
+    beast::flat_buffer buffer;
+    latencies.reserve(latencies.size() + count / load.depth);
+    for (int i = 0; i + load.depth <= count; i += load.depth)
+    {
+        auto begin = Clock::now();
+        net::write(socket, net::buffer(batch));
+        for (int j = 0; j < load.depth; ++j)
+        {
+            http::response<http::string_body> res;
+            http::read(socket, buffer, res);
+        }
+        latencies.push_back(std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - begin).count());
+    }
+    beast::error_code ec;
+    socket.shutdown(tcp::socket::shutdown_both, ec);
+}
+
+void Run(const char *name, SessionEngine engine, unsigned short port, int requests, int clients, const Workload &load)
+{
+    HttpConnection::SetSessionEngine(engine);
+
+    net::io_context acceptor_ioc{1};
+    auto server = std::make_shared<CServer>(acceptor_ioc, port, AcceptMode::Single);
+    server->HandleAccept();
+    std::thread acceptor_thread([&acceptor_ioc]() { acceptor_ioc.run(); });
+
+    // 预热: 填充连接池与 Asio 的 handler 内存缓存
+    {
+        std::vector<std::uint64_t> warm;
+        RunClient(port, requests / 10 + load.depth, load, warm);
+    }
+
+    std::vector<std::vector<std::uint64_t>> per_client(clients);
+    std::uint64_t allocs_before = g_io_allocs.load();
+    auto begin = Clock::now();
+    std::vector<std::thread> threads;
+    for (int c = 0; c < clients; ++c)
+    {
+        threads.emplace_back([port, requests, &load, &per_client, c]()
+                             { RunClient(port, requests, load, per_client[c]); });
+    }
+    for (auto &t : threads)
+    {
+        t.join();
+    }
+    double seconds = std::chrono::duration<double>(Clock::now() - begin).count();
+    std::uint64_t allocs = g_io_allocs.load() - allocs_before;
+
+    std::vector<std::uint64_t> all;
+    for (auto &v : per_client)
+    {
+        all.insert(all.end(), v.begin(), v.end());
+    }
+    std::sort(all.begin(), all.end());
+    double mean = 0;
+    for (auto ns : all)
+    {
+        mean += static_cast<double>(ns);
+    }
+    mean /= static_cast<double>(all.size());
+    std::size_t total = all.size() * static_cast<std::size_t>(load.depth);
+
+    std::printf("%-10s %-8s pipeline=%-3d requests=%-8zu rps=%-9.0f p50=%7.1f us  p99=%7.1f us  mean=%7.1f us  "
+                "io_allocs/req=%.2f\n",
+                name, load.name, load.depth, total, static_cast<double>(total) / seconds, all[all.size() / 2] / 1000.0,
+                all[all.size() * 99 / 100] / 1000.0, mean / 1000.0,
+                static_cast<double>(allocs) / static_cast<double>(total));
+
+    server->Close();
+    acceptor_thread.join();
+}
+} // namespace
+
+int main(int argc, char *argv[])
+{
+    int requests = argc > 1 ? std::atoi(argv[1]) : 20000;
+    int clients = argc > 2 ? std::atoi(argv[2]) : 4;
+    unsigned short port = static_cast<unsigned short>(argc > 3 ? std::atoi(argv[3]) : 18082);
+    int pipeline = argc > 4 ? std::max(1, std::atoi(argv[4])) : 8;
+
+    // 关闭请求日志，避免 stdout 成为瓶颈
+    Logger::SetLevel(LogLevel::Off);
+
+    // 标记 IO 线程，只统计服务端 Session 上的分配
+    auto pool = AsioIOServicePool::GetInstance();
+    for (std::size_t i = 0; i < pool->Size(); ++i)
+    {
+        std::promise<void> marked;
+        net::post(*pool->GetIOService(i),
+                  [&marked]()
+                  {
+                      bench::tl_alloc_counter = &g_io_allocs;
+                      marked.set_value();
+                  });
+        marked.get_future().wait();
+    }
+
+    std::printf("session_engine_bench: %d requests x %d clients, io threads %zu\n", requests, clients, pool->Size());
+    const Workload loads[] = {{"get", 1, 0}, {"get", pipeline, 0}, {"post512", 1, 512}, {"post512", pipeline, 512}};
+    for (const auto &load : loads)
+    {
+        Run("callback", SessionEngine::Callback, port, requests, clients, load);
+    }
+#ifdef GATE_HAVE_COROUTINES
+    for (const auto &load : loads)
+    {
+        Run("coroutine", SessionEngine::Coroutine, port, requests, clients, load);
+    }
+#else
+    std::printf("coroutine  skipped: build with -DGATE_COROUTINE_SESSION=ON\n");
+#endif
+
+    pool->Stop();
+    return 0;
+}
@@ -0,0 +1,101 @@
+/**
+ * @file    wire_format_bench.cpp
+ * @brief   各路由 JSON 与 protobuf 两种编码的体积与编解码开销
+ * @author  msr
+ *
+ * @details
+ * 用 LogicSystem 实际使用的 DTO 与编解码路径 (DtoDecode / DtoEncode / DtoDecodeProto / DtoEncodeProto)，
+ * 对每个路由的请求解码与响应编码分别统计: 每次耗时、operator new 次数、载荷字节数。
+ * JSON 解码使用当前可用的最快后端 (编译了 simdjson 时为 simdjson)。
+ *
+ * 用法: wire_format_bench [iterations=200000]
+ */
+
+#include "AllocCounter.h"
+#include "DtoProto.h"
+#include "GateMessages.h"
+#include "JsonCodec.h"
+#include <boost/asio/buffer.hpp>
+#include <boost/beast/core.hpp>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+
+namespace
+{
+namespace beast = boost::beast;
+
+std::string_view View(const beast::flat_buffer &buffer)
+{
+    return std::string_view(static_cast<const char *>(buffer.data().data()), buffer.size());
+}
+
+/**
+ * @brief   以 request 为样本: 两种格式各编码一次作为输入，再循环解码；response 循环编码
+ */
+template <typename Request, typename Response>
+void RouteCase(const char *route, const Request &request, const Response &response, std::size_t iterations)
+{
+    beast::flat_buffer json_body;
+    {
+        JsonWriter writer(json_body);
+        DtoEncode(writer, request);
+    }
+    JsonDocument::ReservePadding(json_body);
+    beast::flat_buffer proto_body;
+    DtoEncodeProto(request, proto_body);
+
+    bench::Measure(route, "decode/json", iterations,
+                   [&]()
+                   {
+                       JsonDocument document;
+                       Request decoded;
+                       document.Parse(json_body);
+                       DtoDecode(document, decoded);
+                       return json_body.size();
+                   });
+    bench::Measure(route, "decode/protobuf", iterations,
+                   [&]()
+                   {
+                       Request decoded;
+                       DtoDecodeProto(View(proto_body), decoded);
+                       return proto_body.size();
+                   });
+
+    beast::flat_buffer out;
+    bench::Measure(route, "encode/json", iterations,
+                   [&]()
+                   {
+                       out.clear();
+                       JsonWriter writer(out);
+                       DtoEncode(writer, response);
+                       return out.size();
+                   });
+    bench::Measure(route, "encode/protobuf", iterations,
+                   [&]()
+                   {
+                       out.clear();
+                       DtoEncodeProto(response, out);
+                       return out.size();
+                   });
+}
+} // namespace
+
+int main(int argc, char *argv[])
+{
+    std::size_t iterations = static_cast<std::size_t>(argc > 1 ? std::atoll(argv[1]) : 200000);
+    if (!JsonDocument::SetBackend(JsonBackend::Simdjson))
+    {
+        JsonDocument::SetBackend(JsonBackend::JsonCpp);
+    }
+    std::printf("wire_format_bench: %zu iterations, json backend=%s\n", iterations,
+                JsonDocument::GetBackend() == JsonBackend::Simdjson ? "simdjson" : "jsoncpp");
+
+    const std::string email = "someone.long.name@example.com";
+    RouteCase("/get_varifycode", VerifyCodeRequest{email}, VerifyCodeResponse{"a1b2c3", email, 0}, iterations);
+    RouteCase("/user_register",
+              RegisterRequest{"msr_test_user", email, "5f4dcc3b5aa765d61d8327deb882cf99", "a1b2c3"},
+              RegisterResponse{email, 0, 10086, "msr_test_user"}, iterations);
+    return 0;
+}
@@ -4,17 +4,74 @@
  * @author  msr
  *
  * @details 管理多个 io_context 和工作线程，通过 Round-Robin 方式分配 IO 任务。
+ *          线程数、绑核与 NUMA 策略由 config.ini 的 [IOPool] 段配置。
  */
 
 #pragma once
 
+#include "Metrics.h"
 #include "Singleton.h"
 #include <atomic>
 #include <boost/asio.hpp>
 #include <memory>
+#include <string>
 #include <thread>
 #include <vector>
 
+/**
+ * @struct  IOPoolTopology
+ * @brief   IO 线程池拓扑配置
+ *
+ * @details
+ * 对应 config.ini:
+ * @code
+ * [IOPool]
+ * Threads  = 0         ; 0 = 自动 (绑定节点的 CPU 数 / Cpus 个数 / 硬件并发数)
+ * Pinning  = none      ; none | compact | list
+ * Cpus     = 0,2,4,6   ; Pinning = list 时使用
+ * NumaNode = -1        ; -1 = 不干预 | local = 各线程本地分配 | N = 绑定到节点 N
+ * @endcode
+ */
+struct IOPoolTopology
+{
+    enum class Pinning
+    {
+        None,    ///< 不绑核，由调度器决定
+        Compact, ///< 第 i 个线程绑定到第 i 个可用 CPU (绑定节点时仅取该节点的 CPU)
+        List     ///< 按 cpus 列表绑定
+    };
+
+    enum class NumaPolicy
+    {
+        None,  ///< 不设置内存策略
+        Local, ///< 线程内存从所在 CPU 的本地节点分配
+        Bind   ///< 线程运行与内存分配都限定在 numa_node
+    };
+
+    std::size_t threads = 0;
+    Pinning pinning = Pinning::None;
+    std::vector<int> cpus;
+    NumaPolicy numa = NumaPolicy::None;
+    int numa_node = -1;
+
+    /**
+     * @brief   从 ConfigMgr 的 [IOPool] 段读取，缺省项保持默认值
+     */
+    static IOPoolTopology FromConfig();
+};
+
+/**
+ * @struct  IOContextInfo
+ * @brief   单个 io_context 的运行位置
+ */
+struct IOContextInfo
+{
+    std::size_t index = 0;
+    int pinned_cpu = -1; ///< 绑定的 CPU，-1 表示未绑核
+    int start_cpu = -1;  ///< 线程启动时实际所在的 CPU (sched_getcpu)
+    int numa_node = -1;  ///< start_cpu 所在的 NUMA 节点，未知为 -1
+};
+
 /**
  * @class   AsioIOServicePool
  * @brief   IO 上下文线程池 (Singleton)
@@ -23,6 +80,8 @@
  * 1. 预先创建 N 个线程，每个线程运行一个 `io_context::run()`。
  * 2. 提供 GetIOService() 接口，轮询返回一个 io_context 供 Session 绑定。
  * 3. 避免单线程 Reactor 在高并发下的性能瓶颈。
+ * 4. 每个 io_context 在自己的线程里构造：先绑核、设置内存策略，再分配 Reactor 内部结构，
+ *    保证它们落在线程所在的 NUMA 节点上。
  */
 class AsioIOServicePool : public Singleton<AsioIOServicePool>
 {
@@ -43,20 +102,50 @@ public:
      */
     std::shared_ptr<IOService> GetIOService();
 
+    /**
+     * @brief   按下标获取 IO 上下文
+     * @details 用于 SO_REUSEPORT 模式下为每个 io_context 绑定独立的 Acceptor。
+     * @param   index 下标，范围 [0, Size())
+     * @return  std::shared_ptr<IOService>
+     */
+    std::shared_ptr<IOService> GetIOService(std::size_t index);
+
+    /**
+     * @brief   获取 IO 上下文数量
+     * @return  std::size_t 线程池大小
+     */
+    std::size_t Size() const;
+
+    /**
+     * @brief   获取各 io_context 所在的 CPU / NUMA 节点
+     */
+    const std::vector<IOContextInfo> &GetContextInfo() const;
+
     /**
      * @brief   停止所有 IO 服务和线程
+     * @note    可重复调用 (析构时会再次调用)。
      */
     void Stop();
 
 private:
     /**
      * @brief   构造函数
-     * @param   size 线程池大小，默认为硬件并发数 (CPU 核数)
+     * @param   topology 线程数、绑核与 NUMA 策略，默认读取 [IOPool] 配置
+     */
+    AsioIOServicePool(const IOPoolTopology &topology = IOPoolTopology::FromConfig());
+
+    /**
+     * @brief   在第 index 个 IO 线程内应用绑核与内存策略
+     * @return  绑定的 CPU，未绑核返回 -1
      */
-    AsioIOServicePool(std::size_t size = std::thread::hardware_concurrency());
+    int ApplyTopology(std::size_t index);
 
+    IOPoolTopology topology_;
+    std::vector<int> cpuPlan_; ///< 第 i 个线程计划绑定的 CPU，空表示不绑核
     std::vector<std::shared_ptr<IOService>> ioServices_;
-    std::vector<WorkGuard> works_;
+    std::vector<std::unique_ptr<WorkGuard>> works_; ///< 由各 IO 线程自行创建
     std::vector<std::thread> threads_;
+    std::vector<IOContextInfo> contextInfo_;
     std::atomic<std::size_t> nextIOService_;
+    Metrics::CollectorHandle metricsCollector_; ///< 最后声明，最先注销
 };
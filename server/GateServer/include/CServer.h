@@ -11,12 +11,30 @@
 #include <boost/asio.hpp>
 #include <boost/beast.hpp>
 #include <boost/beast/http.hpp>
+#include <atomic>
 #include <memory>
+#include <string>
 
 namespace net = boost::asio;
 namespace beast = boost::beast;
 using tcp = boost::asio::ip::tcp;
 
+/**
+ * @enum    AcceptMode
+ * @brief   连接接收布局
+ */
+enum class AcceptMode
+{
+    Single,   ///< 主线程上单个 Acceptor，Accept 后轮询分发到 AsioIOServicePool
+    ReusePort ///< 每个 io_context 一个 SO_REUSEPORT Acceptor，由内核分流，本地 Accept 不跨线程
+};
+
+/**
+ * @brief   解析配置中的 AcceptMode 字符串
+ * @param   name "single" / "reuseport" (大小写不敏感)，无法识别时返回 Single
+ */
+AcceptMode ParseAcceptMode(const std::string &name);
+
 /**
  * @class   CServer
  * @brief   TCP 连接接收器 (Acceptor)
@@ -32,8 +50,10 @@ public:
      * @brief   构造函数
      * @param   ioc  IO 上下文引用，用于注册 Accept 事件
      * @param   port 监听端口
+     * @param   mode 接收布局。ReusePort 模式下 ioc 必须是 AsioIOServicePool 中的某个上下文，
+     *               新连接直接在 ioc 上处理。
      */
-    CServer(net::io_context &ioc, unsigned short &port);
+    CServer(net::io_context &ioc, unsigned short &port, AcceptMode mode = AcceptMode::Single);
 
     /**
      * @brief   启动异步接收循环
@@ -41,6 +61,17 @@ public:
      */
     void HandleAccept();
 
+    /**
+     * @brief   关闭监听 Socket，终止 Accept 循环
+     * @note    投递到 Acceptor 所在的 io_context 执行，可从任意线程调用。
+     */
+    void Close();
+
+    /**
+     * @brief   已成功 Accept 的连接数
+     */
+    std::uint64_t AcceptedCount() const;
+
 private:
     /**
      * @brief   内核监听 Socket
@@ -50,6 +81,10 @@ private:
 
     net::io_context &_ioc;
 
+    AcceptMode _mode;
+
+    std::atomic<std::uint64_t> _accepted{0}; ///< Accept 计数 (基准测试 / 监控用)
+
     /**
      * @warning [CRITICAL ARCHITECTURAL HAZARD] (架构级隐患)
      * @details
@@ -82,6 +82,15 @@ public:
         return _config_map[section];
     }
 
+    /**
+     * @brief 覆盖一项配置 (基准 / 工具在读取该项的单例创建之前调用)
+     * @note  非线程安全，只应在启动阶段调用
+     */
+    void Set(const std::string &section, const std::string &key, const std::string &value)
+    {
+        _config_map[section]._section_datas[key] = value;
+    }
+
 private:
     /**
      * @brief 私有构造函数 (加载配置)
@@ -0,0 +1,178 @@
+/**
+ * @file    Dto.h
+ * @brief   模板驱动的请求 / 响应 DTO (Data Transfer Object) 编解码
+ * @author  msr
+ *
+ * @details
+ * DTO 是普通结构体，用静态成员函数 Schema() 描述字段 (JSON 键名、成员指针、校验规则)：
+ * @code
+ *   struct LoginRequest
+ *   {
+ *       std::string user;
+ *       std::string passwd;
+ *       static constexpr auto Schema()
+ *       {
+ *           return std::make_tuple(DtoField("user", &LoginRequest::user, 32),
+ *                                  DtoField("passwd", &LoginRequest::passwd, 128));
+ *       }
+ *   };
+ * @endcode
+ * DtoDecode / DtoEncode 由编译器按 Schema 展开，不需要额外的代码生成步骤：
+ * - 解码：遍历一次 JsonDocument 的顶层字段，按键名分派到成员，同时校验类型与长度，最后检查必填字段；
+ * - 编码：按 Schema 顺序写入 JsonWriter。
+ * 支持的成员类型: std::string, int, std::int64_t。
+ */
+
+#pragma once
+
+#include "JsonCodec.h"
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <type_traits>
+
+/**
+ * @struct  DtoFieldSpec
+ * @brief   一个字段的描述
+ */
+template <typename T, typename M>
+struct DtoFieldSpec
+{
+    std::string_view name;    ///< JSON 键名
+    M T::*member;             ///< 对应的成员
+    std::size_t max_length;   ///< 字符串最大长度，0 表示不限
+    bool required;            ///< 缺失时解码失败
+};
+
+/**
+ * @brief   描述一个字段 (默认必填)
+ */
+template <typename T, typename M>
+constexpr DtoFieldSpec<T, M> DtoField(std::string_view name, M T::*member, std::size_t max_length = 0,
+                                      bool required = true)
+{
+    return DtoFieldSpec<T, M>{name, member, max_length, required};
+}
+
+/**
+ * @struct  DtoStatus
+ * @brief   解码结果；失败时 field / reason 指出原因，可直接打日志
+ */
+struct DtoStatus
+{
+    bool ok = true;
+    std::string_view field;
+    std::string_view reason;
+
+    explicit operator bool() const { return ok; }
+};
+
+namespace dto_detail
+{
+inline bool Fail(DtoStatus &status, std::string_view field, std::string_view reason)
+{
+    status = DtoStatus{false, field, reason};
+    return true;
+}
+
+/**
+ * @brief   member 的键名与 spec 匹配时解码到 out
+ * @return  true 键名匹配 (无论成功与否，停止尝试后续字段)
+ */
+template <typename T, typename M>
+bool DecodeMember(const DtoFieldSpec<T, M> &spec, const JsonDocument::Member &member, T &out, std::size_t index,
+                  std::uint64_t &seen, DtoStatus &status)
+{
+    if (member.key != spec.name)
+    {
+        return false;
+    }
+    seen |= std::uint64_t{1} << index;
+
+    if constexpr (std::is_same_v<M, std::string>)
+    {
+        if (member.kind != JsonDocument::Kind::String)
+        {
+            return Fail(status, spec.name, "expect string");
+        }
+        if (spec.max_length != 0 && member.text.size() > spec.max_length)
+        {
+            return Fail(status, spec.name, "too long");
+        }
+        (out.*spec.member).assign(member.text.data(), member.text.size());
+    }
+    else
+    {
+        static_assert(std::is_same_v<M, int> || std::is_same_v<M, std::int64_t>, "unsupported DTO member type");
+        if (member.kind != JsonDocument::Kind::Int)
+        {
+            return Fail(status, spec.name, "expect integer");
+        }
+        if (member.number < std::numeric_limits<M>::min() || member.number > std::numeric_limits<M>::max())
+        {
+            return Fail(status, spec.name, "out of range");
+        }
+        out.*spec.member = static_cast<M>(member.number);
+    }
+    return true;
+}
+
+template <typename T, typename M>
+bool CheckRequired(const DtoFieldSpec<T, M> &spec, std::size_t index, std::uint64_t seen, DtoStatus &status)
+{
+    if (spec.required && (seen & (std::uint64_t{1} << index)) == 0)
+    {
+        return Fail(status, spec.name, "missing");
+    }
+    return false;
+}
+} // namespace dto_detail
+
+/**
+ * @brief   单遍解码并校验；未在 Schema 中的键被忽略
+ */
+template <typename T>
+DtoStatus DtoDecode(const JsonDocument &doc, T &out)
+{
+    constexpr auto schema = T::Schema();
+    static_assert(std::tuple_size_v<decltype(schema)> <= 64, "too many DTO fields");
+
+    DtoStatus status;
+    std::uint64_t seen = 0;
+    for (const auto &member : doc)
+    {
+        std::apply(
+            [&](const auto &...spec)
+            {
+                std::size_t index = 0;
+                (void)(dto_detail::DecodeMember(spec, member, out, index++, seen, status) || ...);
+            },
+            schema);
+        if (!status.ok)
+        {
+            return status;
+        }
+    }
+    std::apply(
+        [&](const auto &...spec)
+        {
+            std::size_t index = 0;
+            (void)(dto_detail::CheckRequired(spec, index++, seen, status) || ...);
+        },
+        schema);
+    return status;
+}
+
+/**
+ * @brief   按 Schema 顺序写成一个 JSON 对象
+ */
+template <typename T>
+JsonWriter &DtoEncode(JsonWriter &writer, const T &value)
+{
+    writer.BeginObject();
+    std::apply([&](const auto &...spec) { (writer.Field(spec.name, value.*spec.member), ...); }, T::Schema());
+    return writer.EndObject();
+}
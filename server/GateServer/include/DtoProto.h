@@ -0,0 +1,185 @@
+/**
+ * @file    DtoProto.h
+ * @brief   DTO 与 protobuf 消息之间的编解码
+ * @author  msr
+ *
+ * @details
+ * DTO 通过 `using Proto = message::Xxx;` 指定对应的消息类型，字段按 Schema() 中的键名与 proto 字段同名对应。
+ * 字段描述符 (FieldDescriptor) 在每个 DTO 类型第一次使用时查找并缓存；
+ * 名称或类型对不上属于编码错误，第一次使用即抛出 std::logic_error。
+ * 校验规则与 JSON 相同；proto3 标量没有“是否存在”的概念，必填字符串以空串视为缺失。
+ */
+
+#pragma once
+
+#include "Dto.h"
+#include <array>
+#include <boost/beast/core/flat_buffer.hpp>
+#include <google/protobuf/descriptor.h>
+#include <google/protobuf/message.h>
+#include <stdexcept>
+
+namespace dto_detail
+{
+using google::protobuf::FieldDescriptor;
+
+template <typename M>
+constexpr FieldDescriptor::CppType ExpectedCppType()
+{
+    if constexpr (std::is_same_v<M, std::string>)
+    {
+        return FieldDescriptor::CPPTYPE_STRING;
+    }
+    else if constexpr (std::is_same_v<M, int>)
+    {
+        return FieldDescriptor::CPPTYPE_INT32;
+    }
+    else
+    {
+        static_assert(std::is_same_v<M, std::int64_t>, "unsupported DTO member type");
+        return FieldDescriptor::CPPTYPE_INT64;
+    }
+}
+
+template <typename T, typename M>
+const FieldDescriptor *CheckedField(const google::protobuf::Descriptor *descriptor, const DtoFieldSpec<T, M> &spec)
+{
+    const FieldDescriptor *field = descriptor->FindFieldByName(std::string(spec.name));
+    if (field == nullptr || field->is_repeated() || field->cpp_type() != ExpectedCppType<M>())
+    {
+        throw std::logic_error("DTO field '" + std::string(spec.name) + "' does not match " + descriptor->full_name());
+    }
+    return field;
+}
+
+/**
+ * @brief   T 的各字段对应的 FieldDescriptor，按 Schema 顺序
+ */
+template <typename T>
+const auto &ProtoFields()
+{
+    constexpr std::size_t count = std::tuple_size_v<decltype(T::Schema())>;
+    static const std::array<const FieldDescriptor *, count> fields = []()
+    {
+        std::array<const FieldDescriptor *, count> result{};
+        const auto *descriptor = T::Proto::descriptor();
+        std::apply(
+            [&](const auto &...spec)
+            {
+                std::size_t index = 0;
+                ((result[index++] = CheckedField(descriptor, spec)), ...);
+            },
+            T::Schema());
+        return result;
+    }();
+    return fields;
+}
+
+/**
+ * @return  true 校验失败，停止处理后续字段
+ */
+template <typename T, typename M>
+bool DecodeProtoField(const DtoFieldSpec<T, M> &spec, const google::protobuf::Message &message,
+                      const FieldDescriptor *field, T &out, DtoStatus &status)
+{
+    const auto *reflection = message.GetReflection();
+    if constexpr (std::is_same_v<M, std::string>)
+    {
+        std::string scratch;
+        const std::string &value = reflection->GetStringReference(message, field, &scratch);
+        if (spec.required && value.empty())
+        {
+            return Fail(status, spec.name, "missing");
+        }
+        if (spec.max_length != 0 && value.size() > spec.max_length)
+        {
+            return Fail(status, spec.name, "too long");
+        }
+        out.*spec.member = value;
+    }
+    else if constexpr (std::is_same_v<M, int>)
+    {
+        out.*spec.member = reflection->GetInt32(message, field);
+    }
+    else
+    {
+        out.*spec.member = reflection->GetInt64(message, field);
+    }
+    return false;
+}
+
+template <typename T, typename M>
+void EncodeProtoField(const DtoFieldSpec<T, M> &spec, const T &value, google::protobuf::Message &message,
+                      const FieldDescriptor *field)
+{
+    const auto *reflection = message.GetReflection();
+    if constexpr (std::is_same_v<M, std::string>)
+    {
+        reflection->SetString(&message, field, value.*spec.member);
+    }
+    else if constexpr (std::is_same_v<M, int>)
+    {
+        reflection->SetInt32(&message, field, value.*spec.member);
+    }
+    else
+    {
+        reflection->SetInt64(&message, field, value.*spec.member);
+    }
+}
+
+/**
+ * @brief   每线程复用的消息对象；Clear() 保留字符串字段已分配的容量，稳态下编解码不再分配
+ */
+template <typename T>
+typename T::Proto &ScratchMessage()
+{
+    thread_local typename T::Proto message;
+    message.Clear();
+    return message;
+}
+} // namespace dto_detail
+
+/**
+ * @brief   从 protobuf 二进制解码并校验；Proto 中多出的字段被忽略
+ */
+template <typename T>
+DtoStatus DtoDecodeProto(std::string_view bytes, T &out)
+{
+    auto &message = dto_detail::ScratchMessage<T>();
+    if (!message.ParseFromArray(bytes.data(), static_cast<int>(bytes.size())))
+    {
+        return DtoStatus{false, std::string_view(), "invalid protobuf"};
+    }
+    const auto &fields = dto_detail::ProtoFields<T>();
+    DtoStatus status;
+    std::apply(
+        [&](const auto &...spec)
+        {
+            std::size_t index = 0;
+            (void)(dto_detail::DecodeProtoField(spec, message, fields[index++], out, status) || ...);
+        },
+        T::Schema());
+    return status;
+}
+
+/**
+ * @brief   编码为 protobuf 二进制，直接序列化到 out 的可写区域
+ */
+template <typename T>
+void DtoEncodeProto(const T &value, boost::beast::flat_buffer &out)
+{
+    auto &message = dto_detail::ScratchMessage<T>();
+    const auto &fields = dto_detail::ProtoFields<T>();
+    std::apply(
+        [&](const auto &...spec)
+        {
+            std::size_t index = 0;
+            (dto_detail::EncodeProtoField(spec, value, message, fields[index++]), ...);
+        },
+        T::Schema());
+
+    std::size_t size = message.ByteSizeLong();
+    auto buffer = out.prepare(size);
+    message.SerializeWithCachedSizesToArray(static_cast<std::uint8_t *>(buffer.data()));
+    out.commit(size);
+}
@@ -0,0 +1,109 @@
+/**
+ * @file    GateMessages.h
+ * @brief   GateServer HTTP 接口的请求 / 响应 DTO
+ * @author  msr
+ *
+ * @details
+ * 字段与客户端的 JSON 协议一致 (键名保持原拼写，如 varifycode)。
+ * 每个 DTO 的 Proto 指向 shared/message.proto 中同名字段的消息，用于 application/x-protobuf 编码 (见 DtoProto.h)。
+ * 只含错误码的失败响应在启动时按两种格式各序列化一次，见 ErrorBody()。
+ */
+
+#pragma once
+
+#include "Dto.h"
+#include "WireFormat.h"
+#include "const.h"
+#include "message.pb.h"
+#include <string>
+#include <string_view>
+
+/// 邮箱最大长度 (RFC 5321)
+constexpr std::size_t kMaxEmailLength = 254;
+constexpr std::size_t kMaxUserLength = 64;
+constexpr std::size_t kMaxPasswdLength = 128;
+constexpr std::size_t kMaxVerifyCodeLength = 16;
+
+/**
+ * @struct  VerifyCodeRequest
+ * @brief   POST /get_varifycode
+ */
+struct VerifyCodeRequest
+{
+    std::string email;
+
+    using Proto = message::GetVerifyRequest;
+
+    static constexpr auto Schema()
+    {
+        return std::make_tuple(DtoField("email", &VerifyCodeRequest::email, kMaxEmailLength));
+    }
+};
+
+struct VerifyCodeResponse
+{
+    std::string code;
+    std::string email;
+    int error = 0;
+
+    using Proto = message::GetVerifyResponse;
+
+    static constexpr auto Schema()
+    {
+        return std::make_tuple(DtoField("code", &VerifyCodeResponse::code),
+                               DtoField("email", &VerifyCodeResponse::email),
+                               DtoField("error", &VerifyCodeResponse::error));
+    }
+};
+
+/**
+ * @struct  RegisterRequest
+ * @brief   POST /user_register (客户端额外发送的 confirm / icon 被忽略)
+ */
+struct RegisterRequest
+{
+    std::string user;
+    std::string email;
+    std::string passwd;
+    std::string varifycode;
+
+    using Proto = message::RegisterUserRequest;
+
+    static constexpr auto Schema()
+    {
+        return std::make_tuple(DtoField("user", &RegisterRequest::user, kMaxUserLength),
+                               DtoField("email", &RegisterRequest::email, kMaxEmailLength),
+                               DtoField("passwd", &RegisterRequest::passwd, kMaxPasswdLength),
+                               DtoField("varifycode", &RegisterRequest::varifycode, kMaxVerifyCodeLength));
+    }
+};
+
+/**
+ * @struct  RegisterResponse
+ * @brief   注册成功的响应 (不返回密码)
+ */
+struct RegisterResponse
+{
+    std::string email;
+    int error = 0;
+    int uid = 0;
+    std::string user;
+
+    using Proto = message::RegisterUserResponse;
+
+    static constexpr auto Schema()
+    {
+        return std::make_tuple(DtoField("email", &RegisterResponse::email),
+                               DtoField("error", &RegisterResponse::error),
+                               DtoField("uid", &RegisterResponse::uid),
+                               DtoField("user", &RegisterResponse::user));
+    }
+};
+
+/**
+ * @brief   只含错误码的响应体，启动时预先序列化
+ * @details JSON 为 {"error":N}；protobuf 为只设置了 error (字段 1) 的 GetVerifyResponse，
+ *          所有响应消息的 error 都是字段 1，客户端按任一响应类型解析都能得到错误码。
+ * @return  指向静态存储，进程生命周期内有效
+ */
+std::string_view ErrorBody(ChatApp::ErrorCode code, WireFormat format = WireFormat::Json);
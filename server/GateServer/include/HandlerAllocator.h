@@ -0,0 +1,146 @@
+/**
+ * @file    HandlerAllocator.h
+ * @brief   异步操作的自定义内存分配 (Asio Custom Allocation)
+ * @author  msr
+ *
+ * @details
+ * Asio 为每个异步操作分配一个 op 对象，默认使用线程本地缓存回收。
+ * 但跨线程投递 (在 A 线程分配、B 线程释放) 时缓存无法命中，每次都会走 operator new。
+ * 这里按 Asio 官方 allocation 示例，让 handler 通过关联分配器使用对象自带的定长内存块。
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+/**
+ * @class   HandlerMemory
+ * @brief   一块可重复使用的 handler 内存
+ * @note    同一时刻只服务一个 op；已被占用或尺寸不够时退化为 operator new。
+ */
+class HandlerMemory
+{
+public:
+    HandlerMemory() = default;
+    HandlerMemory(const HandlerMemory &) = delete;
+    HandlerMemory &operator=(const HandlerMemory &) = delete;
+
+    void *Allocate(std::size_t size)
+    {
+        if (!_in_use && size <= sizeof(_storage))
+        {
+            _in_use = true;
+            return &_storage;
+        }
+        return ::operator new(size);
+    }
+
+    void Deallocate(void *pointer)
+    {
+        if (pointer == &_storage)
+        {
+            _in_use = false;
+        }
+        else
+        {
+            ::operator delete(pointer);
+        }
+    }
+
+private:
+    typename std::aligned_storage<512>::type _storage;
+    bool _in_use = false;
+};
+
+/**
+ * @class   HandlerAllocator
+ * @brief   满足 Allocator 要求的轻量包装，转发到 HandlerMemory
+ */
+template <typename T>
+class HandlerAllocator
+{
+public:
+    using value_type = T;
+
+    explicit HandlerAllocator(HandlerMemory &memory)
+        : _memory(memory)
+    {
+    }
+
+    template <typename U>
+    HandlerAllocator(const HandlerAllocator<U> &other) noexcept
+        : _memory(other._memory)
+    {
+    }
+
+    bool operator==(const HandlerAllocator &other) const noexcept
+    {
+        return &_memory == &other._memory;
+    }
+
+    bool operator!=(const HandlerAllocator &other) const noexcept
+    {
+        return &_memory != &other._memory;
+    }
+
+    T *allocate(std::size_t n) const
+    {
+        return static_cast<T *>(_memory.Allocate(sizeof(T) * n));
+    }
+
+    void deallocate(T *pointer, std::size_t /*n*/) const
+    {
+        return _memory.Deallocate(pointer);
+    }
+
+private:
+    template <typename>
+    friend class HandlerAllocator;
+
+    HandlerMemory &_memory;
+};
+
+/**
+ * @class   CustomAllocHandler
+ * @brief   为 handler 关联 HandlerAllocator (Asio 通过 allocator_type / get_allocator() 识别)
+ */
+template <typename Handler>
+class CustomAllocHandler
+{
+public:
+    using allocator_type = HandlerAllocator<Handler>;
+
+    CustomAllocHandler(HandlerMemory &memory, Handler handler)
+        : _memory(memory),
+          _handler(std::move(handler))
+    {
+    }
+
+    allocator_type get_allocator() const noexcept
+    {
+        return allocator_type(_memory);
+    }
+
+    template <typename... Args>
+    void operator()(Args &&...args)
+    {
+        _handler(std::forward<Args>(args)...);
+    }
+
+private:
+    HandlerMemory &_memory;
+    Handler _handler;
+};
+
+/**
+ * @brief   包装 handler，使其 op 内存从 memory 中分配
+ */
+template <typename Handler>
+inline CustomAllocHandler<typename std::decay<Handler>::type> MakeCustomAllocHandler(HandlerMemory &memory,
+                                                                                     Handler &&handler)
+{
+    return CustomAllocHandler<typename std::decay<Handler>::type>(memory, std::forward<Handler>(handler));
+}
@@ -8,11 +8,18 @@
 
 #pragma once
 
+#include "HandlerAllocator.h"
+#include "QueryParams.h"
+#include "RequestTrace.h"
+#include "Router.h"
+#include "TimingWheel.h"
 #include <boost/asio.hpp>
 #include <boost/beast.hpp>
 #include <boost/beast/http.hpp>
+#include <array>
 #include <memory>
-#include <unordered_map>
+#include <string>
+#include <string_view>
 
 namespace net = boost::asio;
 namespace beast = boost::beast;
@@ -20,6 +27,28 @@ namespace http = boost::beast::http;
 using tcp = boost::asio::ip::tcp;
 
 class LogicSystem;
+class HttpConnectionSlab;
+class HttpResponder;
+class RouteMetrics;
+
+/// 请求 / 响应 Body 使用连续的 flat_buffer：清空时保留容量，连接复用时无需重新分配
+using HttpBody = http::basic_dynamic_body<beast::flat_buffer>;
+
+/**
+ * @enum    SessionEngine
+ * @brief   读 / 处理 / 写 / Keep-Alive 循环的实现方式
+ */
+enum class SessionEngine
+{
+    Callback, ///< 回调链：Start -> async_read -> HandleRequest -> WriteResponse -> Start
+    Coroutine ///< net::awaitable 协程循环 (需要以 GATE_COROUTINE_SESSION=ON 编译，C++20)
+};
+
+/**
+ * @brief   解析配置中的 SessionEngine 字符串
+ * @param   name "callback" / "coroutine" (大小写不敏感)，无法识别时返回 Callback
+ */
+SessionEngine ParseSessionEngine(const std::string &name);
 
 /**
  * @class   HttpConnection
@@ -33,6 +62,9 @@ class LogicSystem;
 class HttpConnection : public std::enable_shared_from_this<HttpConnection>
 {
     friend class LogicSystem;
+    friend class HttpConnectionSlab;
+    friend class HttpResponder;
+    friend struct GateBenchAccess; ///< bench/gate_microbench 单独测量私有的请求解析步骤
 
 public:
     /**
@@ -42,23 +74,111 @@ public:
     HttpConnection(tcp::socket &&socket);
 
     /**
-     * @brief   启动异步读取流程
+     * @brief   构造一个未连接的 Session，由 HttpConnectionSlab 创建后交给 Acceptor 填充 socket
+     * @param   ioc Session 所属的 IO 上下文
+     */
+    explicit HttpConnection(net::io_context &ioc);
+
+    /**
+     * @brief   启动 Session
+     * @details 按 SetSessionEngine() 选择的实现启动读 / 处理 / 写循环。
      */
     void Start();
 
+    /**
+     * @brief   设置之后新启动的 Session 使用的引擎 (进程级)
+     * @return  false 请求 Coroutine 但未编译协程支持，保持 Callback
+     */
+    static bool SetSessionEngine(SessionEngine engine);
+
+    static SessionEngine GetSessionEngine();
+
+    /**
+     * @brief   底层 socket，供 Acceptor 直接 Accept 到复用的连接对象上
+     */
+    tcp::socket &Socket();
+
+    /**
+     * @brief   Accept 及移交到 IO 线程这两步异步操作使用的 handler 内存
+     * @details 复用连接对象时一并复用，跨线程投递也不再触发 operator new。
+     */
+    HandlerMemory &AcceptHandlerMemory();
+
 private:
     /**
-     * @brief   超时检测协程 (Watchdog)
+     * @brief   连接结束后清空状态以便复用 (由 HttpConnectionSlab 在引用计数归零时调用)
+     * @details 关闭 socket，取消空闲超时，清空读缓冲与请求/响应，但保留各缓冲区已分配的容量。
+     */
+    void Reset();
+
+    /**
+     * @brief   清空请求与响应 (Keep-Alive 复用 / 连接复用)，保留 Body 容量
+     */
+    void ResetMessages();
+
+    /**
+     * @brief   只清空响应 (流水线中下一个请求已解析到 _request 时使用)
+     */
+    void ResetResponse();
+
+    /**
+     * @brief   空闲超时回调 (Watchdog)
      * @details 防止 Slowloris 攻击（客户端建立连接后不发数据，耗尽服务器资源）。
+     *          由时间轮在 IO 线程上调用，关闭 socket 使挂起的读写以错误返回。
      */
-    void CheckDeadline();
+    void OnIdleTimeout();
 
+    /**
+     * @brief   Handler 执行完毕后补齐响应头并写回 (必须在 IO 线程上调用)
+     * @details Handler 可以自行设置状态码，未设置时保持 200。
+     */
+    void CompleteResponse();
+
+    /**
+     * @brief   响应已就绪：回调引擎直接 WriteResponse()，协程引擎唤醒等待中的协程
+     */
+    void SendResponse();
+
+    /**
+     * @brief   回调引擎：重新 Arm 空闲超时并异步读取下一个请求
+     */
+    void ReadRequest();
+
+    /**
+     * @brief   渲染当前响应的头部
+     * @details 命中 ResponseHeaderCache 时 _head 只含 "<长度>\r\n\r\n"，模板由 _head_template 指向；
+     *          否则 _head 为 Beast 序列化的完整头部。
+     */
+    void RenderHead();
+
+    /**
+     * @brief   当前响应的 Scatter-Gather 缓冲序列: [_out, 头部模板, _head, Body]
+     * @note    调用前须先 RenderHead()。
+     */
+    std::array<net::const_buffer, 4> ResponseBuffers() const;
+
+    /**
+     * @brief   把当前响应拷贝追加到 _out 并清空响应 (仅用于流水线中非最后一个响应)
+     */
+    void AppendResponse();
+
+    /**
+     * @brief   缓冲区里已有完整的下一个请求时同步解析到 _request (HTTP/1.1 Pipelining)
+     * @return  false 缓冲区为空、请求不完整或格式错误，交给 async_read 处理
+     */
+    bool ParseBuffered(beast::flat_buffer &buffer);
+
+    /**
+     * @brief   一次 writev 写出 _out 中攒下的响应与当前响应 (当前响应的 Body 不拷贝)
+     */
     void WriteResponse();
     void HandleRequest();
     void PreParseGetParam();
 
     tcp::socket _socket;
 
+    HandlerMemory _accept_memory;
+
     /**
      * @brief   Beast 动态缓冲区 (Dynamic Buffer)
      * @note
@@ -70,21 +190,60 @@ private:
 
     /**
      * @brief   HTTP 请求对象
-     * @tparam  dynamic_body 表示 Body 可以是字符串、文件等动态内容。
+     * @tparam  HttpBody 连续缓冲的动态 Body，可直接用 beast::ostream 写入。
      */
-    http::request<http::dynamic_body> _request;
+    http::request<HttpBody> _request;
 
     /**
      * @brief   HTTP 响应对象
      */
-    http::response<http::dynamic_body> _response;
+    http::response<HttpBody> _response;
+
+    /**
+     * @brief   待写出的响应 (已序列化)
+     * @details 流水线时按请求顺序追加多个响应，一次 async_write 写出。
+     */
+    beast::flat_buffer _out;
+
+    /**
+     * @brief   当前响应的头部 (模板之后的部分，或未命中模板时的完整头部)
+     */
+    beast::flat_buffer _head;
+    const std::string *_head_template = nullptr; ///< 命中的预渲染头部模板，未命中为 nullptr
+    std::size_t _pipelined = 0;       ///< _out 中已攒的响应数
+    bool _close_after_write = false; ///< 最后一个响应不是 Keep-Alive，写完后关闭
+
+    /**
+     * @brief   请求路径 (不含查询串)，指向 _request.target()，不拷贝
+     */
+    std::string_view _get_url;
+    QueryParams _get_params; ///< 查询参数，视图指向 _request.target() 或自身的解码 Arena
+    PathParams _path_params; ///< 路由匹配得到的路径参数，值指向 _request.target()
+
+    RouteMetrics *_metrics = nullptr; ///< 本次请求所属路由的指标，由 LogicSystem::Handle 设置
+    std::uint64_t _request_start = 0; ///< 请求解析完成的时刻 (Metrics::Now)，响应就绪时计入延迟
+    RequestTrace _trace;              ///< 本次请求的 ID 与分段计时，Handler 执行期间绑定到执行线程
+
+    /**
+     * @brief   空闲超时，挂在 _socket 所属 io_context 的时间轮上
+     * @details 每个请求开始读取时重新 Arm (O(1))。时间轮不持有 self：连接被回收/析构时自动 Cancel。
+     * @warning 只能在 _socket 所属 io_context 的线程上 Arm / Cancel。
+     */
+    TimingWheel::Entry _idle_timer;
+
+#ifdef GATE_HAVE_COROUTINES
+    /**
+     * @brief   协程引擎的 Session 循环
+     * @details 读缓冲在协程帧上；请求 / 响应仍放在连接里，LogicSystem 与 HttpResponder 不区分引擎。
+     */
+    net::awaitable<void> CoroutineSession(std::shared_ptr<HttpConnection> self);
 
-    std::string _get_url;
-    std::unordered_map<std::string, std::string> _get_params;
+    bool _coroutine = false;     ///< 当前 Session 由协程驱动
+    bool _response_ready = false; ///< 本次请求的响应已就绪 (只在 IO 线程读写)
 
     /**
-     * @brief   截止时间定时器
-     * @warning 必须与 _socket 绑定在同一个 io_context (executor) 上，避免线程安全问题。
+     * @brief   等待异步 Handler 完成：到期时间为 max，SendResponse() 里 cancel 以唤醒协程
      */
-    net::steady_timer deadline_{_socket.get_executor(), std::chrono::seconds(60)};
+    net::steady_timer _response_signal{_socket.get_executor()};
+#endif
 };
@@ -0,0 +1,84 @@
+/**
+ * @file    HttpConnectionSlab.h
+ * @brief   HttpConnection 对象池 (每个 io_context 一个)
+ * @author  msr
+ *
+ * @details
+ * 以 Asio Service 的形式挂在 io_context 上 (`net::use_service<HttpConnectionSlab>(ioc)`)。
+ * 连接关闭后对象不析构，而是清空状态放回空闲链表，下次 Accept 直接复用：
+ * socket / 定时器 / 读缓冲 / 请求与响应 Body 的容量全部保留。
+ * shared_ptr 的控制块也由池内的定长块分配，稳态下 Accept 不再触发堆分配。
+ */
+
+#pragma once
+
+#include <boost/asio.hpp>
+#include <cstdint>
+#include <memory>
+
+namespace net = boost::asio;
+
+class HttpConnection;
+
+/**
+ * @class   HttpConnectionSlab
+ * @brief   HttpConnection 对象池 (Asio Service)
+ *
+ * @details
+ * 1. Acquire(): 优先从空闲链表取对象；为空时 new 一个新对象。
+ * 2. 引用计数归零时自定义 Deleter 在所属 io_context 的线程上把对象 Reset() 后放回空闲链表 (超过容量才真正 delete)。
+ * 3. 空闲链表由互斥锁保护：Single 模式下 Acquire 在主线程，而回收发生在 IO 线程。
+ * 4. 容量读取 config.ini 的 `[GateServer] ConnectionSlab`，0 表示关闭池化。
+ */
+class HttpConnectionSlab : public net::execution_context::service
+{
+public:
+    using key_type = HttpConnectionSlab;
+    static net::execution_context::id id;
+
+    /**
+     * @struct  Stats
+     * @brief   分配计数
+     */
+    struct Stats
+    {
+        std::uint64_t created = 0;   ///< new 出来的连接对象数
+        std::uint64_t reused = 0;    ///< 从空闲链表复用的次数
+        std::uint64_t recycled = 0;  ///< 放回空闲链表的次数
+        std::uint64_t destroyed = 0; ///< 超出容量 (或池已关闭) 被 delete 的次数
+        std::uint64_t cached = 0;    ///< 当前空闲链表长度
+    };
+
+    explicit HttpConnectionSlab(net::execution_context &ctx);
+    ~HttpConnectionSlab() override;
+
+    /**
+     * @brief   获取一个未连接的 HttpConnection，其 socket 属于本 io_context
+     * @note    线程安全。
+     */
+    std::shared_ptr<HttpConnection> Acquire();
+
+    /**
+     * @brief   预先创建 count 个对象放入空闲链表
+     * @note    应在本 io_context 的线程上调用，使对象内存落在该线程的 NUMA 节点上。
+     */
+    void Reserve(std::size_t count);
+
+    /**
+     * @brief   修改空闲链表容量，0 表示关闭池化 (每次都 new/delete)
+     */
+    void SetCapacity(std::size_t capacity);
+
+    Stats GetStats() const;
+
+private:
+    void shutdown() override;
+
+    struct State;
+    struct Deleter;
+    template <typename T>
+    struct ControlBlockAllocator;
+
+    /// 池状态以 shared_ptr 持有：Deleter / 控制块分配器各持一份，晚于 io_context 销毁的连接也能安全回收
+    std::shared_ptr<State> _state;
+};
@@ -0,0 +1,86 @@
+/**
+ * @file    HttpResponder.h
+ * @brief   异步 Handler 的响应句柄声明
+ * @author  msr
+ *
+ * @details
+ * Handler 拿到一个 HttpResponder，填好响应后调用 Send() 才会真正写回客户端，
+ * 因此 Handler 可以先返回，在异步 Redis / MySQL / gRPC 的回调里再 Send()，单线程上可以同时挂起大量请求。
+ */
+
+#pragma once
+
+#include "HttpConnection.h"
+#include <atomic>
+#include <memory>
+#include <string>
+#include <string_view>
+
+/**
+ * @class   HttpResponder
+ * @brief   一次请求的完成句柄 (Completion Handle)
+ *
+ * @details
+ * 1. 可拷贝，所有拷贝共享同一个完成状态；可以放进 std::function 回调里跨线程传递。
+ * 2. Send() / Fail() 只有第一次生效，写回操作会被投递到连接所属的 IO 线程执行 (已在该线程时直接执行)。
+ * 3. 最后一个拷贝析构时仍未 Send，自动回 500，避免连接永远挂起。
+ * 4. 调用 Send() 之前 Handler 独占 Request() / Response()；Send() 之后不得再访问。
+ */
+class HttpResponder
+{
+public:
+    explicit HttpResponder(std::shared_ptr<HttpConnection> connection);
+
+    /**
+     * @brief   请求对象 (只读)
+     */
+    const http::request<HttpBody> &Request() const;
+
+    /**
+     * @brief   GET 请求的查询参数 (已 URL 解码)
+     * @note    键值为 string_view，只在 Send() 之前有效；需要保留时自行拷贝。
+     */
+    const QueryParams &GetParams() const;
+
+    /**
+     * @brief   路径参数，如路由 "/user/{uid}" 匹配 "/user/42" 时 PathParam("uid") == "42"
+     * @return  未 URL 解码的原始值，指向请求行，只在 Send() 之前有效；不存在时为空
+     */
+    std::string_view PathParam(std::string_view name) const;
+
+    /**
+     * @brief   响应对象，Handler 直接填写状态码、头和 Body
+     */
+    http::response<HttpBody> &Response() const;
+
+    /**
+     * @brief   连接所属 IO 线程的 executor，异步客户端可以把完成回调投递到这里
+     */
+    net::any_io_executor GetExecutor() const;
+
+    /**
+     * @brief   完成请求，写回 Response()
+     * @note    线程安全，可在任意线程调用；重复调用无效果。
+     */
+    void Send() const;
+
+    /**
+     * @brief   以错误状态完成请求，丢弃已写入的 Body
+     */
+    void Fail(http::status status, const std::string &message) const;
+
+    /**
+     * @brief   是否已经 Send / Fail
+     */
+    bool Done() const;
+
+    /**
+     * @brief   底层连接，仅供同步 Handler 适配使用
+     */
+    const std::shared_ptr<HttpConnection> &Connection() const;
+
+private:
+    struct State;
+
+    std::shared_ptr<State> _state;
+};
@@ -0,0 +1,183 @@
+/**
+ * @file    JsonCodec.h
+ * @brief   Handler 使用的 JSON 编解码层
+ * @author  msr
+ *
+ * @details
+ * - JsonDocument: 直接从请求 Body 的缓冲区解析，只保留顶层字段 (字符串 / 整数)，
+ *   后端可选 simdjson (On-Demand，SIMD 解析，需以 simdjson 编译) 或 JsonCpp (始终可用，作为回退)。
+ * - JsonWriter:   紧凑格式 (无缩进 / 换行)，直接写进响应 Body 的 flat_buffer，不经过中间字符串。
+ * 后端由 config.ini 的 [GateServer] JsonCodec 选择。
+ */
+
+#pragma once
+
+#include <boost/beast/core/flat_buffer.hpp>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+/**
+ * @enum    JsonBackend
+ * @brief   JsonDocument 的解析后端
+ */
+enum class JsonBackend
+{
+    JsonCpp, ///< Json::CharReader，始终可用
+    Simdjson ///< simdjson On-Demand (需要找到 simdjson 包，定义 GATE_HAVE_SIMDJSON)
+};
+
+/**
+ * @brief   解析配置中的 JsonCodec 字符串
+ * @param   name "simdjson" / "jsoncpp" / "auto" (大小写不敏感)；auto 及无法识别时优先 simdjson (已编译时)
+ */
+JsonBackend ParseJsonBackend(const std::string &name);
+
+/**
+ * @class   JsonDocument
+ * @brief   请求 JSON 的只读视图 (仅顶层对象的标量字段)
+ *
+ * @details
+ * 解析时把键与字符串值 (已反转义) 拷贝进文档自己的 Arena (按 Body 长度一次预留)，
+ * 之后返回的 string_view 只依赖本对象，与解析器 / 请求缓冲区的生命周期无关。
+ * 嵌套的对象 / 数组 / 浮点数 / 布尔值会被跳过，只记录键名 (Has() 返回 true)。
+ */
+class JsonDocument
+{
+public:
+    enum class Kind
+    {
+        String,
+        Int,
+        Other ///< 对象 / 数组 / 浮点数 / 布尔值 / null，不保留值
+    };
+
+    /**
+     * @struct  Member
+     * @brief   顶层字段；key / text 指向文档的 Arena
+     */
+    struct Member
+    {
+        std::string_view key;
+        Kind kind;
+        std::string_view text; ///< kind == String 时有效 (已反转义)
+        std::int64_t number;   ///< kind == Int 时有效
+    };
+
+    using const_iterator = std::vector<Member>::const_iterator;
+
+    /// simdjson 要求输入之后至少有这么多字节可读
+    static constexpr std::size_t kPadding = 64;
+
+    /**
+     * @brief   设置之后解析使用的后端 (进程级)
+     * @return  false 请求 Simdjson 但未编译 simdjson 支持，保持 JsonCpp
+     */
+    static bool SetBackend(JsonBackend backend);
+
+    static JsonBackend GetBackend();
+
+    /**
+     * @brief   在请求 Body 之后预留 kPadding 字节 (不计入 Body)，使 simdjson 可以原地解析
+     * @details 只在 Simdjson 后端下生效；由 HttpConnection 在分发请求之前调用。
+     */
+    static void ReservePadding(boost::beast::flat_buffer &buffer);
+
+    /**
+     * @brief   解析请求 Body；缓冲区尾部有足够空余时 simdjson 不拷贝输入
+     * @return  false 不是合法 JSON，或顶层不是对象
+     */
+    bool Parse(const boost::beast::flat_buffer &buffer);
+
+    /**
+     * @brief   解析一段文本 (simdjson 后端会拷贝到带 padding 的缓冲区)
+     */
+    bool Parse(std::string_view text);
+
+    /**
+     * @brief   顶层字符串字段，缺失或类型不是字符串时返回空；同名字段取最后一个
+     */
+    std::string_view GetString(std::string_view key) const;
+
+    /**
+     * @brief   顶层整数字段
+     * @return  false 缺失或类型不是整数
+     */
+    bool GetInt(std::string_view key, std::int64_t &value) const;
+
+    /**
+     * @brief   是否存在该顶层字段 (任意类型)
+     */
+    bool Has(std::string_view key) const;
+
+    /**
+     * @brief   按出现顺序遍历顶层字段 (DTO 单遍解码使用)
+     */
+    const_iterator begin() const { return _fields.begin(); }
+    const_iterator end() const { return _fields.end(); }
+
+private:
+    bool ParseJsonCpp(std::string_view text);
+    bool ParseSimdjson(const char *data, std::size_t size, std::size_t capacity);
+    const Member *Find(std::string_view key) const;
+
+    /**
+     * @brief   拷贝进 Arena，Arena 已按输入长度预留，不会重新分配
+     */
+    std::string_view Store(std::string_view text);
+
+    std::vector<Member> _fields;
+    std::string _arena;
+};
+
+/**
+ * @class   JsonWriter
+ * @brief   紧凑 JSON 写入器，直接追加到 flat_buffer (通常是 Response().body())
+ *
+ * @details
+ * 逗号与嵌套由写入器维护，调用方只需按顺序写键值：
+ * @code
+ *   JsonWriter(responder.Response().body()).BeginObject().Field("error", 0).Field("email", email).EndObject();
+ * @endcode
+ * 嵌套深度不超过 64 层。
+ */
+class JsonWriter
+{
+public:
+    explicit JsonWriter(boost::beast::flat_buffer &out);
+
+    JsonWriter &BeginObject();
+    JsonWriter &EndObject();
+    JsonWriter &BeginArray();
+    JsonWriter &EndArray();
+
+    JsonWriter &Key(std::string_view key);
+    JsonWriter &String(std::string_view value);
+    JsonWriter &Int(std::int64_t value);
+    JsonWriter &Bool(bool value);
+    JsonWriter &Null();
+
+    JsonWriter &Field(std::string_view key, std::string_view value) { return Key(key).String(value); }
+    JsonWriter &Field(std::string_view key, const char *value) { return Key(key).String(value); }
+    JsonWriter &Field(std::string_view key, const std::string &value) { return Key(key).String(value); }
+    JsonWriter &Field(std::string_view key, int value) { return Key(key).Int(value); }
+    JsonWriter &Field(std::string_view key, std::int64_t value) { return Key(key).Int(value); }
+    JsonWriter &Field(std::string_view key, bool value) { return Key(key).Bool(value); }
+
+private:
+    /**
+     * @brief   写值之前补逗号 (同一层的第二个及之后的元素)
+     */
+    void Separate();
+    void Open(char c);
+    void Close(char c);
+    void Raw(const char *data, std::size_t size);
+    void Escaped(std::string_view text);
+
+    boost::beast::flat_buffer &_out;
+    std::uint64_t _has_element = 0; ///< 第 i 位: 第 i 层是否已写过元素
+    unsigned _depth = 0;
+    bool _after_key = false;
+};
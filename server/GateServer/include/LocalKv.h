@@ -0,0 +1,167 @@
+/**
+ * @file    LocalKv.h
+ * @brief   进程内 KV 引擎: 分片加锁、按键 TTL、时间轮回收、内存统计
+ * @author  msr
+ *
+ * @details
+ * 没有 Redis 时 ([Redis] Backend = local) 作为 RedisMgr 的后端，实现业务用到的 Redis 命令子集，
+ * 回复格式与 Redis 一致，上层代码无需区分后端:
+ * - 键按哈希分到 N 个分片 (2 的幂)，每个分片一把锁、一个 unordered_map，不同键的操作基本不互相等待；
+ * - TTL: 读到已过期的键时惰性删除；另有后台线程按 tick 推进每个分片自己的时间轮，回收无人再读的过期键；
+ * - 内存: 按 键 + 值 + 固定开销 估算每个条目的占用，MaxMemory 按分片均摊，超出后写命令返回 OOM 错误；
+ * - 脚本: 不内嵌 Lua，EVAL / EVALSHA 只执行经 RegisterScript 注册了本地实现的脚本，
+ *   脚本在其声明的所有键所在分片都加锁后执行，与 Redis 一样是原子的。
+ *
+ * 支持的命令: PING AUTH GET SET(EX/PX/NX/XX) SETEX DEL EXISTS EXPIRE PEXPIRE TTL PTTL INCR
+ *            LPUSH RPUSH LPOP LLEN HSET HGET HDEL DBSIZE FLUSHALL FLUSHDB SCRIPT(LOAD/EXISTS/FLUSH) EVAL EVALSHA
+ *
+ * @note    多键命令 (DEL / EXISTS 多个键) 按分片逐个执行，不保证跨分片原子。
+ */
+
+#pragma once
+
+#include "RedisConnection.h"
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * @class   LocalKv
+ * @brief   分片 TTL KV 引擎，公有接口线程安全
+ */
+class LocalKv
+{
+    struct Entry;
+    struct Shard;
+
+public:
+    using Clock = std::chrono::steady_clock;
+
+    /**
+     * @struct  Options
+     * @brief   引擎参数，对应 config.ini 的 [LocalKv] 段
+     */
+    struct Options
+    {
+        std::size_t shards = 0;               ///< 分片数，向上取 2 的幂；0 表示 4 x 硬件线程数
+        std::chrono::milliseconds tick{100};  ///< 时间轮 tick，即过期键最晚被回收的延迟
+        std::size_t max_memory = 0;           ///< 内存上限 (字节，估算值)，0 表示不限制
+    };
+
+    /**
+     * @struct  Stats
+     * @brief   全部分片的计数之和
+     */
+    struct Stats
+    {
+        std::uint64_t keys = 0;     ///< 当前键数 (含已过期但尚未回收的)
+        std::uint64_t memory = 0;   ///< 估算内存 (字节)，含时间轮条目
+        std::uint64_t commands = 0; ///< 累计执行的命令数
+        std::uint64_t expired = 0;  ///< 累计删除的过期键 (惰性 + 时间轮)
+        std::uint64_t reaped = 0;   ///< 其中由时间轮回收的
+        std::uint64_t oom = 0;      ///< 因内存上限被拒绝的写命令
+    };
+
+    /**
+     * @class   Transaction
+     * @brief   脚本执行期间对所声明键的访问，相关分片均已加锁
+     * @note    只能访问 EVAL 中声明的键 (KEYS)，否则抛 std::invalid_argument
+     */
+    class Transaction
+    {
+    public:
+        /**
+         * @return  字符串值，不存在 (或类型不是字符串) 时为 nullptr
+         */
+        const std::string *Get(const std::string &key);
+        /**
+         * @return  false 超出内存上限未写入，脚本结束后 EVAL 回复 OOM 错误 (已做的写入不回滚，与 Redis 相同)
+         */
+        bool Set(const std::string &key, std::string value);
+        bool Del(const std::string &key);
+        bool Exists(const std::string &key);
+
+    private:
+        friend class LocalKv;
+        Transaction(LocalKv &kv, std::vector<Shard *> shards, Clock::time_point now);
+        Shard &ShardOf(const std::string &key);
+
+        LocalKv &_kv;
+        std::vector<Shard *> _shards;
+        Clock::time_point _now;
+        bool _oom = false; ///< 有写入因内存上限被拒绝
+    };
+
+    /**
+     * @brief   脚本的本地实现，返回值即 EVAL 的回复
+     */
+    using Script = std::function<RedisReply(Transaction &txn, const std::vector<std::string> &keys,
+                                            const std::vector<std::string> &argv)>;
+
+    explicit LocalKv(Options options);
+    ~LocalKv();
+
+    LocalKv(const LocalKv &) = delete;
+    LocalKv &operator=(const LocalKv &) = delete;
+
+    /**
+     * @brief   执行一条命令
+     * @param   args 命令与参数 (命令名不区分大小写)
+     * @return  与 Redis 相同形式的回复；未支持的命令为 Error
+     */
+    RedisReply Execute(const RedisCommand &args);
+
+    /**
+     * @brief   注册脚本的本地实现；之后 SCRIPT LOAD / EVAL 该脚本正文时执行 script
+     * @return  std::string 脚本 ID (EVALSHA 使用；由正文哈希得到，不是 SHA1)
+     */
+    std::string RegisterScript(const std::string &body, Script script);
+
+    Stats GetStats() const;
+
+    std::size_t ShardCount() const
+    {
+        return _shards.size();
+    }
+
+private:
+    Shard &ShardOf(const std::string &key);
+
+    RedisReply ExecuteKey(Shard &shard, const RedisCommand &args, Clock::time_point now);
+    RedisReply Eval(const Script &script, const RedisCommand &args, Clock::time_point now);
+    RedisReply Scripting(const RedisCommand &args);
+
+    Entry *Find(Shard &shard, const std::string &key, Clock::time_point now);
+    Entry &Upsert(Shard &shard, const std::string &key);
+    void Erase(Shard &shard, const std::string &key);
+    void SetExpire(Shard &shard, const std::string &key, Entry &entry, Clock::time_point expire_at);
+    void Account(Shard &shard, Entry &entry, std::int64_t delta);
+    bool OverBudget(Shard &shard);
+
+    std::uint64_t TickOf(Clock::time_point time) const;
+    void Reap(Shard &shard, std::uint64_t now_tick, Clock::time_point now);
+    void ReaperLoop();
+
+    static std::string ScriptId(const std::string &body);
+
+    Options _options;
+    Clock::time_point _epoch;
+    std::size_t _shard_budget = 0; ///< 每个分片的内存上限，0 表示不限制
+    std::vector<std::unique_ptr<Shard>> _shards;
+
+    mutable std::mutex _script_mutex;
+    std::unordered_map<std::string, std::shared_ptr<Script>> _scripts; ///< 脚本 ID -> 本地实现
+
+    std::mutex _reaper_mutex;
+    std::condition_variable _reaper_cv;
+    bool _stopping = false;
+    std::thread _reaper; ///< 最后声明: 启动时其余成员均已构造
+};
@@ -0,0 +1,202 @@
+/**
+ * @file    Logger.h
+ * @brief   异步日志: 每线程无锁环形缓冲 + 后台写线程
+ * @author  msr
+ *
+ * @details
+ * 用法:
+ * @code
+ * LOG_INFO("http request").Field("method", method).Field("target", target);
+ * @endcode
+ * 输出一行: `2026-01-01 12:00:00.123456 INFO  [T3] http request method=POST target=/user_register`
+ *
+ * - 级别: 低于编译期下限 GATE_LOG_MIN_LEVEL 的调用整条被消除 (参数也不会求值)；
+ *   其余按运行期级别 ([Log] Level) 过滤，关闭时只有一次 relaxed 原子读。
+ * - 结构化字段: Field(key, value) 追加 key=value，值含空白 / 引号 / = 时加引号并转义。
+ *   线程绑定了请求 (Logger::SetRequestId) 时，消息之后先追加 req=ID。
+ * - 热路径: 在调用线程的栈上格式化 (单条上限 kMaxLogRecord 字节，超出截断)，
+ *   再拷贝进本线程的 SPSC 环形缓冲，无锁、无 flush、无系统调用。
+ *   环满时丢弃并计数，由写线程输出丢弃条数，业务线程永不阻塞在日志上。
+ * - 写线程: 轮询各线程的缓冲，批量格式化时间戳与级别后一次 write 到 stdout 或 [Log] File。
+ *   不同线程的日志按到达写线程的批次输出，跨线程不保证严格时间序。
+ * - Logger::Shutdown() 之后 (以及线程局部缓冲已析构的退出阶段) 改为同步直接写，保证退出日志不丢。
+ */
+
+#pragma once
+
+#include <atomic>
+#include <charconv>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <type_traits>
+
+/**
+ * @brief   日志级别
+ */
+enum class LogLevel : std::uint8_t
+{
+    Trace = 0,
+    Debug = 1,
+    Info = 2,
+    Warn = 3,
+    Error = 4,
+    Off = 5
+};
+
+/// 编译期级别下限 (LogLevel 的数值)，低于它的 LOG_XXX 被整条消除；Release 可 -DGATE_LOG_MIN_LEVEL=2
+#ifndef GATE_LOG_MIN_LEVEL
+#define GATE_LOG_MIN_LEVEL 1
+#endif
+
+/// 单条日志 (消息 + 字段) 的最大字节数
+constexpr std::size_t kMaxLogRecord = 512;
+
+/**
+ * @brief   解析配置中的级别名 (trace/debug/info/warn/error/off)，未知值按 info
+ */
+LogLevel ParseLogLevel(const std::string &name);
+
+/**
+ * @brief   级别的固定宽度名称 ("INFO " 等)
+ */
+std::string_view LogLevelName(LogLevel level);
+
+/**
+ * @class   Logger
+ * @brief   进程级日志后端，首次使用时启动写线程
+ *
+ * @details 实例在进程内永不析构，静态对象析构期间仍可安全写日志。
+ */
+class Logger
+{
+public:
+    /**
+     * @brief   运行期级别过滤
+     */
+    static bool IsEnabled(LogLevel level)
+    {
+        return static_cast<std::uint8_t>(level) >= _level.load(std::memory_order_relaxed);
+    }
+
+    static void SetLevel(LogLevel level);
+    static LogLevel GetLevel();
+
+    /**
+     * @brief   切换输出目标
+     * @param   path 空串为 stdout，否则以追加方式打开该文件
+     * @return  false 打开文件失败，保持原输出
+     */
+    static bool SetOutput(const std::string &path);
+
+    /**
+     * @brief   设置每线程环形缓冲的容量 (字节，向上取 2 的幂)，只影响之后首次写日志的线程
+     */
+    static void SetRingSize(std::size_t bytes);
+
+    /**
+     * @brief   提交一条已格式化的记录 (由 LogRecord 调用)
+     */
+    static void Commit(LogLevel level, std::uint64_t time_ns, std::string_view text);
+
+    /**
+     * @brief   等待写线程把此刻之前提交的记录全部写出
+     */
+    static void Flush();
+
+    /**
+     * @brief   写出剩余记录并停止写线程，之后的日志同步写出
+     * @note    应在 IO / 业务线程停止之后调用，否则其间提交的记录可能丢失
+     */
+    static void Shutdown();
+
+    /**
+     * @brief   因环满被丢弃的记录总数
+     */
+    static std::uint64_t Dropped();
+
+    /**
+     * @brief   本线程正在处理的请求 ID，非 0 时之后的每条日志都追加 req=ID (由 TraceScope 设置)
+     */
+    static void SetRequestId(std::uint64_t id)
+    {
+        _request_id = id;
+    }
+
+    static std::uint64_t RequestId()
+    {
+        return _request_id;
+    }
+
+private:
+    inline static std::atomic<std::uint8_t> _level{static_cast<std::uint8_t>(LogLevel::Info)};
+    inline static thread_local std::uint64_t _request_id = 0;
+};
+
+/**
+ * @class   LogRecord
+ * @brief   一条日志，在栈上拼装，析构时提交
+ */
+class LogRecord
+{
+public:
+    LogRecord(LogLevel level, std::string_view message);
+    ~LogRecord();
+
+    LogRecord(const LogRecord &) = delete;
+    LogRecord &operator=(const LogRecord &) = delete;
+
+    LogRecord &Field(std::string_view key, std::string_view value);
+
+    LogRecord &Field(std::string_view key, const char *value)
+    {
+        return Field(key, std::string_view(value != nullptr ? value : "(null)"));
+    }
+
+    LogRecord &Field(std::string_view key, const std::string &value)
+    {
+        return Field(key, std::string_view(value));
+    }
+
+    LogRecord &Field(std::string_view key, bool value)
+    {
+        return Field(key, std::string_view(value ? "true" : "false"));
+    }
+
+    template <typename T, typename = std::enable_if_t<std::is_integral_v<T> && !std::is_same_v<T, bool>>>
+    LogRecord &Field(std::string_view key, T value)
+    {
+        char digits[24];
+        auto result = std::to_chars(digits, digits + sizeof(digits), value);
+        AppendKey(key);
+        Append(std::string_view(digits, static_cast<std::size_t>(result.ptr - digits)));
+        return *this;
+    }
+
+private:
+    void AppendKey(std::string_view key);
+    void Append(std::string_view text);
+    void AppendQuoted(std::string_view value);
+
+    LogLevel _level;
+    std::uint64_t _time_ns;
+    std::size_t _size = 0;
+    bool _truncated = false;
+    char _text[kMaxLogRecord];
+};
+
+/**
+ * @brief   按级别写日志；if/else 结构使条件不成立时整个 Field 链都不求值
+ */
+#define GATE_LOG(level, message)                                                                                       \
+    if (static_cast<int>(level) < GATE_LOG_MIN_LEVEL || !Logger::IsEnabled(level))                                    \
+    {                                                                                                                  \
+    }                                                                                                                  \
+    else                                                                                                               \
+        LogRecord(level, message)
+
+#define LOG_TRACE(message) GATE_LOG(LogLevel::Trace, message)
+#define LOG_DEBUG(message) GATE_LOG(LogLevel::Debug, message)
+#define LOG_INFO(message) GATE_LOG(LogLevel::Info, message)
+#define LOG_WARN(message) GATE_LOG(LogLevel::Warn, message)
+#define LOG_ERROR(message) GATE_LOG(LogLevel::Error, message)
@@ -8,63 +8,144 @@
 
 #pragma once
 
+#include "Metrics.h"
+#include "Router.h"
 #include "Singleton.h"
+#include "WorkerPool.h"
 #include <functional>
 #include <memory>
 #include <string>
-#include <unordered_map>
+#include <string_view>
+#include <vector>
 
 class HttpConnection;
-// 定义 HTTP 处理函数签名：接受一个 HttpConnection 的智能指针
-using HttpHandler = std::function<void(std::shared_ptr<HttpConnection>)>;
+class HttpResponder;
+
+/**
+ * @brief   HTTP 处理函数签名 (完成式)：填写 responder.Response() 后调用 responder.Send()
+ * @details Handler 返回时请求不必已完成，可以在异步调用的回调中再 Send()，期间不占用任何线程。
+ */
+using HttpHandler = std::function<void(HttpResponder)>;
+
+/**
+ * @brief   同步 Handler 签名 (兼容旧写法)：返回即视为完成
+ */
+using SyncHttpHandler = std::function<void(std::shared_ptr<HttpConnection>)>;
+
+/**
+ * @enum    ExecPolicy
+ * @brief   路由 Handler 的执行位置
+ */
+enum class ExecPolicy
+{
+    Inline,    ///< 直接在 IO 线程执行，只适合不阻塞、计算量很小的 Handler
+    Cpu,       ///< CPU 线程池 (线程数 ≈ 核数)，适合 JSON / 加解密等纯计算
+    BlockingIO ///< 阻塞 IO 线程池 (线程数较多)，适合同步的 Redis / MySQL / gRPC 调用
+};
 
 /**
  * @class   LogicSystem
  * @brief   业务逻辑分发系统 (Singleton)
  *
- * @details 维护 URL 到处理函数 (Handler) 的映射表。
+ * @details
+ * 维护 URL 到处理函数 (Handler) 的映射表，每个路由带一个执行策略 (ExecPolicy)。
+ * Handler 通过 HttpResponder 完成请求，写响应总在连接所属的 io_context 上执行；
+ * 非 Inline 的 Handler 在线程池中执行；
+ * 线程池队列满时直接回 503，不阻塞 IO 线程。
+ * 线程池大小与队列容量读取 config.ini 的 [Workers] 段。
  */
 class LogicSystem : public Singleton<LogicSystem>
 {
     friend class Singleton<LogicSystem>;
+    friend struct GateBenchAccess; ///< bench/gate_microbench 单独测量路由查找
 
 public:
     ~LogicSystem() = default;
 
     /**
-     * @brief   查找并执行 GET 请求对应的 Handler
-     * @param   path       请求路径
-     * @param   connection HTTP 连接对象
-     * @return  true 找到路由并执行; false 未找到路由
+     * @brief   查找并执行请求对应的 Handler
+     * @param   method     HTTP 方法
+     * @param   path       请求路径 (不含查询串)
+     * @param   connection HTTP 连接对象，Found 时路径参数写入其中
+     * @return  Found 已交给 Handler；NotFound / MethodNotAllowed 由调用方回 404 / 405
+     */
+    Router::Result Handle(boost::beast::http::verb method, std::string_view path,
+                          std::shared_ptr<HttpConnection> connection);
+
+    /**
+     * @brief   注册路由
+     * @param   method  HTTP 方法
+     * @param   url     路径模式，可含参数段 (如 "/user/{uid}")
+     * @param   handler 回调函数 lambda
+     * @param   policy  执行策略
      */
-    bool HandleGet(std::string path, std::shared_ptr<HttpConnection> connection);
+    void Register(boost::beast::http::verb method, std::string url, HttpHandler handler,
+                  ExecPolicy policy = ExecPolicy::Inline);
 
     /**
      * @brief   注册 GET 路由
      * @param   url     路径 (如 "/login")
      * @param   handler 回调函数 lambda
+     * @param   policy  执行策略
      */
-    void RegisterGet(std::string url, HttpHandler handler);
+    void RegisterGet(std::string url, HttpHandler handler, ExecPolicy policy = ExecPolicy::Inline);
 
     /**
-     * @brief   查找并执行 POST 请求对应的 Handler
-     * @param   path       请求路径
-     * @param   connection HTTP 连接对象
-     * @return  true 找到路由并执行; false 未找到路由
+     * @brief   注册同步 GET 路由，Handler 返回后自动 Send()
      */
-    bool HandlePost(std::string path, std::shared_ptr<HttpConnection> connection);
+    void RegisterGet(std::string url, SyncHttpHandler handler, ExecPolicy policy = ExecPolicy::Inline);
 
     /**
      * @brief   注册 POST 路由
      * @param   url     路径 (如 "/user_register")
      * @param   handler 回调函数 lambda
+     * @param   policy  执行策略
+     */
+    void RegisterPost(std::string url, HttpHandler handler, ExecPolicy policy = ExecPolicy::Inline);
+
+    /**
+     * @brief   注册同步 POST 路由，Handler 返回后自动 Send()
+     */
+    void RegisterPost(std::string url, SyncHttpHandler handler, ExecPolicy policy = ExecPolicy::Inline);
+
+    /**
+     * @brief   获取执行策略对应的线程池 (Inline 返回 nullptr)，用于读取队列指标
+     */
+    const WorkerPool *GetPool(ExecPolicy policy) const;
+
+    /**
+     * @brief   停止业务线程池，丢弃排队中的请求
+     * @note    应在 IO 线程停止之后调用。
      */
-    void RegisterPost(std::string url, HttpHandler handler);
+    void Stop();
 
 private:
     LogicSystem();
 
-    // 使用 Hash Map 存储路由表，查询时间复杂度 O(1)
-    std::unordered_map<std::string, HttpHandler> _registerPost;
-    std::unordered_map<std::string, HttpHandler> _registerGet;
+    /**
+     * @struct  Route
+     * @brief   路由项
+     */
+    struct Route
+    {
+        HttpHandler handler;
+        ExecPolicy policy = ExecPolicy::Inline;
+        RouteMetrics *metrics = nullptr; ///< 请求计数与延迟直方图，由 Metrics 持有
+    };
+
+    /**
+     * @brief   按执行策略运行 Handler，Handler 通过 HttpResponder 完成请求
+     */
+    void Dispatch(const Route &route, std::shared_ptr<HttpConnection> connection);
+
+    // 路由前缀树只保存 _routes 的下标；查找按 string_view 进行，不分配内存
+    // 构造完成后只读，线程池中的任务可以直接引用其中的 Handler
+    std::vector<Route> _routes;
+    Router _router;
+
+    std::unique_ptr<WorkerPool> _cpuPool;
+    std::unique_ptr<WorkerPool> _ioPool;
+
+    RouteMetrics *_unmatched = nullptr;       ///< 404 / 405 请求的指标
+    Metrics::CollectorHandle _pool_collector; ///< 业务线程池的 Gauge，声明在最后以最先析构
 };
@@ -0,0 +1,240 @@
+/**
+ * @file    Metrics.h
+ * @brief   请求指标: 按路由的计数与延迟直方图，以及各连接池的 Gauge，按 Prometheus 文本格式导出
+ * @author  msr
+ *
+ * @details
+ * - 记录: 每个路由一个 RouteMetrics，内部按线程分片 (Shard)，每个分片独占缓存行，
+ *   线程首次记录时分配分片下标；一次记录是本分片上的三次 relaxed fetch_add，线程之间没有共享写。
+ * - 直方图: HDR 风格的对数-线性桶，单位微秒，每个 2 的幂区间再等分 8 份 (相对误差 ≤ 12.5%)，
+ *   16 us 以内精确；导出时按 2 的幂微秒作为 le 边界累加，另外给出 p50 / p90 / p99 / p999。
+ * - Gauge: 连接池等组件通过 AddCollector() 注册采集回调，抓取 /metrics 时调用；
+ *   回调由 CollectorHandle 持有，组件析构时自动注销。
+ */
+
+#pragma once
+
+#include "Singleton.h"
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <vector>
+
+/**
+ * @class   LatencyHistogram
+ * @brief   对数-线性桶的下标计算 (纯函数，无状态)
+ */
+class LatencyHistogram
+{
+public:
+    static constexpr int kSubBits = 3;
+    static constexpr std::uint64_t kSubCount = 1u << kSubBits;
+    /// 最大可区分约 2^36 us (19 小时)，更大的值计入最后一个桶
+    static constexpr std::size_t kBuckets = (36 - kSubBits + 1) * kSubCount + kSubCount;
+
+    static std::size_t Index(std::uint64_t us)
+    {
+        if (us < 2 * kSubCount)
+        {
+            return static_cast<std::size_t>(us);
+        }
+        int shift = 63 - __builtin_clzll(us) - kSubBits;
+        std::size_t index = static_cast<std::size_t>(shift) * kSubCount + static_cast<std::size_t>(us >> shift);
+        return index < kBuckets ? index : kBuckets - 1;
+    }
+
+    /**
+     * @brief   桶 [Lower, Upper) 的下界 (微秒)
+     */
+    static std::uint64_t Lower(std::size_t index)
+    {
+        if (index < 2 * kSubCount)
+        {
+            return index;
+        }
+        std::size_t shift = index / kSubCount - 1;
+        return (index % kSubCount + kSubCount) << shift;
+    }
+
+    static std::uint64_t Upper(std::size_t index)
+    {
+        return index + 1 < kBuckets ? Lower(index + 1) : Lower(index) * 2;
+    }
+};
+
+/**
+ * @class   RouteMetrics
+ * @brief   单个路由的请求计数 (按状态码类别) 与延迟直方图
+ */
+class RouteMetrics
+{
+public:
+    /// 分片数；线程数超过分片数时多个线程共用一个分片 (仍然正确，只是有竞争)
+    static constexpr std::size_t kShards = 32;
+
+    RouteMetrics(std::string method, std::string route);
+
+    /**
+     * @brief   记录一次请求
+     * @param   status     HTTP 状态码
+     * @param   latency_ns 耗时 (纳秒)
+     */
+    void Record(unsigned status, std::uint64_t latency_ns)
+    {
+        Shard &shard = _shards[ShardIndex()];
+        std::uint64_t us = latency_ns / 1000;
+        shard.buckets[LatencyHistogram::Index(us)].fetch_add(1, std::memory_order_relaxed);
+        shard.sum_us.fetch_add(us, std::memory_order_relaxed);
+        shard.status[status / 100 < 6 ? status / 100 : 0].fetch_add(1, std::memory_order_relaxed);
+    }
+
+    /**
+     * @struct  Snapshot
+     * @brief   各分片合并后的快照
+     */
+    struct Snapshot
+    {
+        std::array<std::uint64_t, LatencyHistogram::kBuckets> buckets{};
+        std::array<std::uint64_t, 6> status{}; ///< 下标为状态码 / 100，0 为非法状态码
+        std::uint64_t count = 0;
+        std::uint64_t sum_us = 0;
+
+        /**
+         * @brief   分位数 (微秒)，取所在桶的上界
+         */
+        std::uint64_t Quantile(double q) const;
+    };
+
+    Snapshot Collect() const;
+
+    const std::string &Method() const { return _method; }
+    const std::string &Route() const { return _route; }
+
+    /**
+     * @brief   当前线程使用的分片下标
+     */
+    static std::size_t ShardIndex();
+
+private:
+    struct alignas(64) Shard
+    {
+        std::array<std::atomic<std::uint64_t>, LatencyHistogram::kBuckets> buckets{};
+        std::atomic<std::uint64_t> sum_us{0};
+        std::array<std::atomic<std::uint64_t>, 6> status{};
+    };
+
+    std::string _method;
+    std::string _route;
+    std::unique_ptr<Shard[]> _shards;
+};
+
+/**
+ * @class   MetricsWriter
+ * @brief   Gauge / Counter 样本收集，同名指标合并到一个 family 后输出
+ */
+class MetricsWriter
+{
+public:
+    /**
+     * @param   labels 形如 `pool="verify",state="idle"`，可为空
+     */
+    void Gauge(std::string_view name, std::string_view help, std::string_view labels, double value);
+    void Counter(std::string_view name, std::string_view help, std::string_view labels, double value);
+
+    void Render(std::string &out) const;
+
+private:
+    struct Family
+    {
+        std::string help;
+        const char *type;
+        std::vector<std::pair<std::string, double>> samples;
+    };
+
+    void Add(const char *type, std::string_view name, std::string_view help, std::string_view labels, double value);
+
+    std::map<std::string, Family, std::less<>> _families;
+};
+
+/**
+ * @class   Metrics
+ * @brief   指标注册表 (Singleton)
+ */
+class Metrics : public Singleton<Metrics>
+{
+    friend class Singleton<Metrics>;
+
+public:
+    using Collector = std::function<void(MetricsWriter &)>;
+
+    /**
+     * @class   CollectorHandle
+     * @brief   采集回调的注册凭据，析构时注销
+     */
+    class CollectorHandle
+    {
+    public:
+        CollectorHandle() = default;
+        CollectorHandle(std::shared_ptr<Metrics> owner, std::uint64_t id);
+        ~CollectorHandle();
+
+        CollectorHandle(CollectorHandle &&other) noexcept;
+        CollectorHandle &operator=(CollectorHandle &&other) noexcept;
+        CollectorHandle(const CollectorHandle &) = delete;
+        CollectorHandle &operator=(const CollectorHandle &) = delete;
+
+    private:
+        std::shared_ptr<Metrics> _owner; ///< 保证注销时注册表仍然存活
+        std::uint64_t _id = 0;
+    };
+
+    /**
+     * @brief   注册一个路由的指标
+     * @return  引用在进程内一直有效
+     */
+    RouteMetrics &AddRoute(std::string method, std::string route);
+
+    /**
+     * @brief   未匹配到路由 (404 / 405) 的请求
+     */
+    RouteMetrics &Unmatched();
+
+    /**
+     * @brief   注册采集回调，抓取时在调用 Render() 的线程上执行
+     */
+    static CollectorHandle AddCollector(Collector collector);
+
+    /**
+     * @brief   按 Prometheus 文本格式 (0.0.4) 输出全部指标
+     */
+    void Render(std::string &out);
+
+    /**
+     * @brief   计时用的单调时钟 (纳秒)
+     */
+    static std::uint64_t Now()
+    {
+        return static_cast<std::uint64_t>(
+            std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch())
+                .count());
+    }
+
+private:
+    Metrics();
+
+    void RemoveCollector(std::uint64_t id);
+
+    std::mutex _mtx;
+    std::deque<RouteMetrics> _routes; ///< deque 追加不移动已有元素
+    RouteMetrics *_unmatched = nullptr;
+    std::map<std::uint64_t, Collector> _collectors;
+    std::uint64_t _next_collector = 0;
+};
@@ -6,9 +6,10 @@
 
 #pragma once
 
+#include "Logger.h"
+#include "Metrics.h"
 #include <atomic>             // std::atomic
 #include <condition_variable> // std::condition_variable
-#include <iostream>           // std::cout, std::endl
 #include <memory>             // std::unique_ptr
 #include <mutex>              // std::mutex, std::unique_lock
 #include <queue>              // std::queue
@@ -65,8 +66,21 @@ public:
         catch (sql::SQLException &e)
         {
             // 处理异常
-            std::cout << "mysql pool init failed: " << e.what() << std::endl;
+            LOG_ERROR("mysql pool init failed").Field("what", e.what());
         }
+
+        collector_ = Metrics::AddCollector(
+            [this](MetricsWriter &writer)
+            {
+                std::size_t idle = Available();
+                std::size_t size = static_cast<std::size_t>(poolSize_);
+                writer.Gauge("gate_mysql_pool_size", "Configured MySQL connections.", "", size);
+                writer.Gauge("gate_mysql_pool_connections", "MySQL connections by state.", "state=\"idle\"", idle);
+                writer.Gauge("gate_mysql_pool_connections", "MySQL connections by state.", "state=\"in_use\"",
+                             size > idle ? size - idle : 0);
+                writer.Gauge("gate_mysql_pool_waiters", "Threads blocked waiting for a MySQL connection.", "",
+                             waiters_.load(std::memory_order_relaxed));
+            });
     }
 
     /**
@@ -90,6 +104,7 @@ public:
     std::unique_ptr<sql::Connection> getConnection()
     {
         std::unique_lock<std::mutex> lock(mutex_);
+        waiters_.fetch_add(1, std::memory_order_relaxed);
         cond_.wait(
             lock,
             [this]
@@ -100,6 +115,7 @@ public:
                 }
                 return !pool_.empty();
             });
+        waiters_.fetch_sub(1, std::memory_order_relaxed);
         if (b_stop_)
         {
             return nullptr;
@@ -124,6 +140,15 @@ public:
         cond_.notify_one();
     }
 
+    /**
+     * @brief   当前空闲的连接数 (构造时连接失败则为 0)
+     */
+    std::size_t Available()
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return pool_.size();
+    }
+
     /**
      * @brief   关闭连接池
      * @details 唤醒所有等待的线程，并停止分配新连接。
@@ -144,4 +169,6 @@ private:
     std::mutex mutex_;                                  ///< 互斥锁
     std::condition_variable cond_;                      ///< 条件变量
     std::atomic<bool> b_stop_;                          ///< 停止标志
+    std::atomic<int> waiters_{0};                       ///< 正在等待连接的线程数
+    Metrics::CollectorHandle collector_;                ///< /metrics 采集回调 (最后声明，最先注销)
 };
\ No newline at end of file
@@ -0,0 +1,137 @@
+/**
+ * @file    NearCache.h
+ * @brief   RedisMgr 前面的进程内近端缓存 (GET / EXISTS 结果)
+ * @author  msr
+ *
+ * @details
+ * 热点键 (如刚查过的用户名) 每次都去 Redis 要一个 RTT。近端缓存把 GET / EXISTS 的结果留在进程内:
+ * - 有界: 按键哈希分片，每个分片一把锁、一条 LRU 链，条目数超过上限时淘汰最久未用的；
+ * - TTL 上限: 命中的值最多存活 TtlMs，不存在的结果 (负缓存) 最多 NegativeTtlMs，
+ *   即使失效消息丢失，陈旧数据也不会超过该时长；
+ * - 失效: RedisMgr 通过 Redis 的客户端缓存 (CLIENT TRACKING ... REDIRECT 到订阅 __redis__:invalidate
+ *   的专用连接) 收到其他客户端修改过的键并调用 Invalidate；本进程发出的写命令在发出时即失效。
+ *
+ * 读 - 失效竞争: 读命令发出前取 Token (所在分片的失效序号)，回复到达时若分片期间有过失效则不回填，
+ * 避免“失效先到、旧回复后到”把旧值写回缓存。
+ *
+ * 未就绪 (失效通道尚未建立或断开) 时查找一律未命中、回填一律丢弃。
+ */
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * @class   NearCache
+ * @brief   分片 LRU 近端缓存，公有接口线程安全
+ */
+class NearCache
+{
+    struct Shard;
+
+public:
+    using Clock = std::chrono::steady_clock;
+
+    /**
+     * @struct  Options
+     * @brief   缓存参数，对应 config.ini 的 [NearCache] 段
+     */
+    struct Options
+    {
+        std::size_t max_entries = 100000;             ///< 条目上限 (按分片均摊)
+        std::size_t shards = 0;                       ///< 分片数，向上取 2 的幂；0 表示 4 x 硬件线程数
+        std::chrono::milliseconds ttl{5000};          ///< 值的最长存活时间，0 表示不缓存值
+        std::chrono::milliseconds negative_ttl{1000}; ///< “键不存在”的最长存活时间，0 表示不做负缓存
+    };
+
+    /**
+     * @enum    State
+     * @brief   缓存中关于一个键的已知信息
+     */
+    enum class State
+    {
+        Miss,    ///< 没有缓存
+        Missing, ///< 键不存在 (负缓存)
+        Exists,  ///< 键存在，值未知 (来自 EXISTS)
+        Value    ///< 键存在且值已知 (来自 GET)
+    };
+
+    /**
+     * @struct  Stats
+     * @brief   全部分片的计数之和
+     */
+    struct Stats
+    {
+        std::uint64_t hits = 0;          ///< 命中 (Value / Exists)
+        std::uint64_t negative_hits = 0; ///< 命中负缓存
+        std::uint64_t misses = 0;        ///< 未命中 (含已过期)
+        std::uint64_t fills = 0;         ///< 回填成功
+        std::uint64_t stale_fills = 0;   ///< 因期间有失效而放弃的回填
+        std::uint64_t evictions = 0;     ///< 因容量淘汰
+        std::uint64_t invalidations = 0; ///< 失效的键 (本地写 + 服务端通知)
+        std::uint64_t entries = 0;
+        std::uint64_t memory = 0; ///< 估算内存 (字节)
+    };
+
+    explicit NearCache(Options options);
+    ~NearCache();
+
+    NearCache(const NearCache &) = delete;
+    NearCache &operator=(const NearCache &) = delete;
+
+    /**
+     * @brief   查找
+     * @param   key   键
+     * @param   value 输出参数，State::Value 时写入值 (可为 nullptr)
+     * @param   want_value 为 true 时 (GET) 只有 Value / Missing 算命中
+     */
+    State Find(const std::string &key, std::string *value, bool want_value);
+
+    /**
+     * @brief   读命令发出前调用，回填时原样传回
+     */
+    std::uint64_t Token(const std::string &key) const;
+
+    /**
+     * @brief   用读命令的结果回填；自 Token 以来该分片有过失效、或缓存未就绪时丢弃
+     */
+    void Fill(const std::string &key, State state, std::string value, std::uint64_t token);
+
+    /**
+     * @brief   使一个键失效
+     */
+    void Invalidate(const std::string &key);
+
+    /**
+     * @brief   清空全部条目，并使所有在途回填失效
+     */
+    void Clear();
+
+    /**
+     * @brief   设置是否就绪 (失效通道可用)；变为未就绪时同时清空
+     */
+    void SetReady(bool ready);
+
+    bool Ready() const
+    {
+        return _ready.load(std::memory_order_acquire);
+    }
+
+    Stats GetStats() const;
+
+private:
+    Shard &ShardOf(const std::string &key) const;
+
+    Options _options;
+    std::size_t _shard_capacity = 1;
+    std::vector<std::unique_ptr<Shard>> _shards;
+    std::atomic<bool> _ready{false};
+};
@@ -0,0 +1,83 @@
+/**
+ * @file    QueryParams.h
+ * @brief   查询串 (Query String) 参数视图
+ * @author  msr
+ *
+ * @details
+ * 解析 "a=1&b=hello+world" 时不为每个键值创建 std::string：
+ * - 不含 '%' / '+' 的键值直接以 string_view 指向请求的 target()；
+ * - 需要解码的键值解码到本对象持有的 Arena (一块按查询串长度预留的连续内存) 中。
+ * 连接复用时 Arena 与参数数组保留容量，稳态下解析不产生内存分配。
+ * '%' / '+' 的扫描使用 SIMD (SSE2 / NEON)，每次检查 16 字节，未启用时退回逐字节扫描。
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+#include <vector>
+
+/**
+ * @class   QueryParams
+ * @brief   一次请求的查询参数 (已 URL 解码)
+ * @warning 返回的 string_view 指向请求 target() 或内部 Arena，只在该请求处理期间有效。
+ */
+class QueryParams
+{
+public:
+    struct Param
+    {
+        std::string_view key;
+        std::string_view value;
+    };
+
+    using const_iterator = std::vector<Param>::const_iterator;
+
+    /**
+     * @brief   解析查询串 (不含 '?')，覆盖之前的结果
+     * @details 没有 '=' 的段被忽略；非法的 %xx 原样保留。
+     */
+    void Parse(std::string_view query);
+
+    /**
+     * @brief   按键取值，同名参数取最后一个 (与原 unordered_map 覆盖语义一致)；不存在时返回空
+     */
+    std::string_view Get(std::string_view key) const;
+
+    /**
+     * @brief   是否存在该参数 (值可以为空)
+     */
+    bool Has(std::string_view key) const;
+
+    std::size_t Size() const { return _params.size(); }
+    bool Empty() const { return _params.empty(); }
+    const_iterator begin() const { return _params.begin(); }
+    const_iterator end() const { return _params.end(); }
+
+    /**
+     * @brief   清空参数，保留容量
+     */
+    void Clear();
+
+    /**
+     * @brief   释放超过 limit 字节的 Arena (连接复用时避免个别大请求长期占用内存)
+     */
+    void ShrinkTo(std::size_t limit);
+
+    /**
+     * @brief   URL 解码 (%xx 与 '+')，结果追加到 out
+     */
+    static void Decode(std::string_view in, std::string &out);
+
+    /**
+     * @brief   第一个 '%' 或 '+' 的位置，没有时返回 size (SIMD 扫描)
+     */
+    static std::size_t FindEscape(const char *data, std::size_t size);
+
+private:
+    std::string_view Materialize(std::string_view raw);
+
+    std::vector<Param> _params;
+    std::string _arena; ///< 解码结果，Parse 时按查询串长度预留，解析期间不会重新分配
+};
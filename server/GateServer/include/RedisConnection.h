@@ -0,0 +1,256 @@
+/**
+ * @file    RedisConnection.h
+ * @brief   挂在 Asio io_context 上的 hiredis 异步连接
+ * @author  msr
+ *
+ * @details
+ * hiredis 的异步接口 (redisAsyncContext) 本身不做 IO，而是通过 ev.addRead / addWrite 等钩子
+ * 请求事件循环在 fd 可读 / 可写时回调 redisAsyncHandleRead / redisAsyncHandleWrite。
+ * 这里把这些钩子接到 boost::asio::posix::stream_descriptor::async_wait 上，
+ * 使 Redis 连接与 HTTP 连接共用同一个 io_context 线程:
+ * - 建连 (非阻塞 connect)、发送、接收都不会阻塞 IO 线程；
+ * - 同一连接上的命令按发送顺序流水线化，回复按顺序回调；
+ * - 自动批量 (Options::auto_batch): 同一轮事件循环内发出的命令先进入 hiredis 输出缓冲，
+ *   本轮结束时一次 write 发出；其他线程发来的命令先暂存，整批只投递一次。
+ *   关闭时每条命令单独投递、单独 write，用于对比；
+ * - 连接断开时未完成的命令以错误回调，随后按 ReconnectInterval 退避重连 (重连后自动 AUTH)。
+ *
+ * @note    公有接口线程安全，其余成员只在所属 io_context 线程上访问。
+ *          回调在该线程上执行，不得阻塞。
+ */
+
+#pragma once
+
+#include <atomic>
+#include <boost/asio.hpp>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+struct redisAsyncContext;
+
+/**
+ * @struct  RedisReply
+ * @brief   Redis 回复 (从 hiredis 的 redisReply 复制，可跨线程传递)
+ */
+struct RedisReply
+{
+    enum class Type
+    {
+        Error,   ///< 服务端返回的错误，或连接 / 超时等本地错误 (见 str)
+        Nil,     ///< 空回复 (键不存在)
+        String,  ///< Bulk String
+        Status,  ///< 简单字符串 (如 OK)
+        Integer, ///< 整数
+        Array    ///< 数组 (见 elements)
+    };
+
+    Type type = Type::Nil;
+    std::string str;   ///< String / Status / Error 的内容
+    long long integer = 0;
+    std::vector<RedisReply> elements;
+
+    bool IsError() const
+    {
+        return type == Type::Error;
+    }
+
+    static RedisReply Error(std::string message)
+    {
+        RedisReply reply;
+        reply.type = Type::Error;
+        reply.str = std::move(message);
+        return reply;
+    }
+};
+
+/**
+ * @brief   命令完成回调，在连接所属的 IO 线程上执行
+ */
+using RedisCallback = std::function<void(RedisReply)>;
+
+/**
+ * @brief   一条命令及其参数，如 {"SET", key, value}
+ */
+using RedisCommand = std::vector<std::string>;
+
+/**
+ * @brief   批量命令完成回调，回复与命令一一对应 (按提交顺序)
+ */
+using RedisBatchCallback = std::function<void(std::vector<RedisReply>)>;
+
+/**
+ * @class   RedisConnection
+ * @brief   单个 Redis 连接，生命周期由 shared_ptr 管理 (挂起的 async_wait 持有引用)
+ */
+class RedisConnection : public std::enable_shared_from_this<RedisConnection>
+{
+public:
+    /**
+     * @struct  Options
+     * @brief   连接参数，对应 config.ini 的 [Redis] 段
+     */
+    struct Options
+    {
+        std::string host = "127.0.0.1";
+        int port = 6379;
+        std::string password;                               ///< 为空时不 AUTH
+        std::chrono::milliseconds reconnect_interval{1000}; ///< 断线后重连的间隔
+        bool auto_batch = true;                             ///< 同一轮事件循环内的命令合并为一次 write
+
+        /**
+         * 每次 (重) 建连时在 IO 线程上调用 (AUTH 之后)，其中发出的命令先于其他任何命令发送，
+         * 用于 CLIENT TRACKING / SUBSCRIBE 等连接级状态的恢复
+         */
+        std::function<void(RedisConnection &)> on_connect;
+        std::function<void()> on_disconnect; ///< 连接断开 / 建连失败时在 IO 线程上调用
+    };
+
+    /**
+     * @struct  Stats
+     * @brief   累计计数 (可在任意线程读取)，commands / writes 即平均每次 write 携带的命令数
+     */
+    struct Stats
+    {
+        std::uint64_t commands = 0; ///< 交给 hiredis 的命令数
+        std::uint64_t writes = 0;   ///< redisAsyncHandleWrite 调用次数
+    };
+
+    RedisConnection(boost::asio::io_context &ioc, Options options);
+    ~RedisConnection();
+
+    RedisConnection(const RedisConnection &) = delete;
+    RedisConnection &operator=(const RedisConnection &) = delete;
+
+    /**
+     * @brief   开始建连 (线程安全，投递到所属 io_context)
+     */
+    void Start();
+
+    /**
+     * @brief   释放连接且不再重连 (线程安全)；未完成的命令以错误回调
+     * @param   on_stopped 释放完成后在 IO 线程上调用
+     */
+    void Stop(std::function<void()> on_stopped = nullptr);
+
+    /**
+     * @brief   设置之后 (重) 连接时使用的密码 (线程安全)
+     */
+    void SetPassword(std::string password);
+
+    /**
+     * @brief   发送一条命令 (线程安全)
+     * @param   args     命令与参数，二进制安全
+     * @param   callback 完成回调；未连接时以 Error 回调 (不会在本函数返回前执行)
+     */
+    void Command(RedisCommand args, RedisCallback callback);
+
+    /**
+     * @brief   订阅 (线程安全)，如 {"SUBSCRIBE", channel}
+     * @param   callback 订阅确认与之后的每条消息各回调一次；连接断开时以 Error 回调一次后失效，
+     *                   重连后需要重新订阅 (通常在 Options::on_connect 中)
+     * @note    订阅后该连接只能再收发订阅类命令，应专用
+     */
+    void Subscribe(RedisCommand args, RedisCallback callback);
+
+    /**
+     * @brief   在本连接上连续发送一组命令 (线程安全)
+     * @details 各命令在连接上相邻、一次 write 发出，相互依赖的查询只花一个 RTT；
+     *          不是事务，单条命令失败不影响其他命令。
+     * @param   commands 命令列表，不能为空
+     * @param   callback 全部回复到达后回调一次，单条失败时对应位置为 Error
+     */
+    void Batch(std::vector<RedisCommand> commands, RedisBatchCallback callback);
+
+    /**
+     * @brief   运行时开关自动批量 (线程安全，对之后提交的命令生效)
+     */
+    void SetAutoBatch(bool enabled)
+    {
+        _auto_batch.store(enabled, std::memory_order_relaxed);
+    }
+
+    Stats GetStats() const
+    {
+        return {_commands.load(std::memory_order_relaxed), _writes.load(std::memory_order_relaxed)};
+    }
+
+    /**
+     * @brief   当前是否已建连 (可在任意线程读取)
+     */
+    bool Connected() const
+    {
+        return _connected.load(std::memory_order_relaxed);
+    }
+
+    /**
+     * @brief   调用线程是否为本连接所属的 IO 线程
+     */
+    bool RunningInThisThread() const
+    {
+        return _ioc.get_executor().running_in_this_thread();
+    }
+
+private:
+    /**
+     * @struct  Staged
+     * @brief   其他线程提交、尚未交给 hiredis 的命令
+     */
+    struct Staged
+    {
+        RedisCommand args;
+        RedisCallback callback;
+    };
+
+    void Connect();
+    void ScheduleReconnect();
+    void Submit(Staged *items, std::size_t count);
+    void FlushStaged();
+    void AfterSend();
+    void Flush();
+    void Send(RedisCommand &args, RedisCallback &callback, bool persistent = false);
+    void Fail(RedisCallback callback, const char *message);
+
+    void WaitRead();
+    void WaitWrite();
+
+    // hiredis 回调 (privdata / ac->data 指向 RedisConnection)
+    static void OnConnect(const redisAsyncContext *context, int status);
+    static void OnDisconnect(const redisAsyncContext *context, int status);
+    static void OnReply(redisAsyncContext *context, void *reply, void *privdata);
+    static void OnAuth(redisAsyncContext *context, void *reply, void *privdata);
+
+    // hiredis 事件钩子
+    static void AddRead(void *privdata);
+    static void DelRead(void *privdata);
+    static void AddWrite(void *privdata);
+    static void DelWrite(void *privdata);
+    static void Cleanup(void *privdata);
+
+    boost::asio::io_context &_ioc;
+    Options _options;
+    redisAsyncContext *_context = nullptr;
+    std::unique_ptr<boost::asio::posix::stream_descriptor> _socket; ///< 只借用 fd，关闭由 hiredis 负责
+    boost::asio::steady_timer _reconnect_timer;
+    std::uint64_t _generation = 0; ///< 每个 redisAsyncContext 一代，区分旧连接上挂起的 async_wait
+    bool _reading = false;         ///< hiredis 要求监听可读
+    bool _writing = false;         ///< hiredis 要求监听可写
+    bool _read_waiting = false;    ///< 已挂起 async_wait(wait_read)
+    bool _write_waiting = false;   ///< 已挂起 async_wait(wait_write)
+    bool _reconnect_pending = false;
+    bool _stopped = false;
+    bool _flush_posted = false;    ///< 本轮结束时的 Flush 已投递
+    bool _in_callback = false;     ///< 正在 hiredis 回复回调内 (不重入 hiredis，交给可写事件)
+    std::atomic<bool> _connected{false};
+    std::atomic<bool> _auto_batch{true};
+    std::atomic<std::uint64_t> _commands{0};
+    std::atomic<std::uint64_t> _writes{0};
+
+    std::mutex _staged_mutex;
+    std::vector<Staged> _staged;   ///< 其他线程提交的命令，非空时已投递一次 FlushStaged
+    std::vector<Staged> _draining; ///< IO 线程上与 _staged 交换，复用容量
+};
@@ -1,24 +1,45 @@
 /**
  * @file RedisMgr.h
- * @brief Redis 管理器定义 (Mock 实现)
+ * @brief Redis 管理器定义
  * @author msr
  */
 
 #pragma once
 
+#include "LocalKv.h"
+#include "Metrics.h"
+#include "NearCache.h"
+#include "RedisConnection.h"
 #include "Singleton.h"
-#include <iostream>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
 #include <memory>
 #include <mutex>
 #include <string>
-#include <unordered_map>
+#include <vector>
 
 /**
  * @class   RedisMgr
  * @brief   Redis 管理器 (Singleton)
  *
- * @details 封装 Redis 操作接口。当前为 Mock 实现，使用内存 map 模拟 Redis 行为。
- *          主要用于开发测试阶段，无需真实 Redis 服务。
+ * @details 在 AsioIOServicePool 的每个 io_context 上各维护一个 RedisConnection (hiredis 异步接口)，
+ *          命令的收发都在 IO 线程上以非阻塞方式完成。提供两组接口:
+ *          - 完成回调接口 (带 RedisCallback 参数): 立即返回，回调在连接所属的 IO 线程上执行，不得阻塞；
+ *            在 IO 线程上调用时优先使用本线程的连接，不跨线程投递。
+ *          - 同步接口: 阻塞调用线程直到收到回复或超过 [Redis] Timeout，供 BlockingIO 线程池中的业务使用；
+ *            在 IO 线程上调用会直接失败 (否则会卡住该线程上的所有连接)。
+ *          另有批量接口 Batch / ExecuteBatch: 一组命令在同一连接上一次写出，相互依赖的查询只花一个 RTT。
+ *          连接参数读取 config.ini 的 [Redis] 段，断线后自动重连；[Redis] AutoBatch 控制同一轮事件循环内
+ *          的命令是否合并为一次 write (默认开启)。
+ *          [Redis] Backend = local 时不连接 Redis，所有命令由进程内的 LocalKv 执行 (分片、TTL)，
+ *          接口与回调语义不变，用于本地开发与压测。
+ *          [NearCache] Enabled = on 时 GET / EXISTS (Get / ExistsKey) 先查进程内近端缓存 (见 NearCache)，
+ *          一致性依靠 Redis 6 的客户端缓存: 数据连接开启 CLIENT TRACKING 并把失效消息重定向到
+ *          专用的订阅连接 (__redis__:invalidate)；本进程的写命令在发出时即使本地条目失效。
+ *          订阅连接断开期间缓存停用，重新建立跟踪后再启用。
+ *
+ * @note    Connect / Auth / Close 会替换连接表，只应在启动与退出阶段调用 (不与命令并发)。
  */
 class RedisMgr : public Singleton<RedisMgr>, public std::enable_shared_from_this<RedisMgr>
 {
@@ -28,17 +49,17 @@ public:
     ~RedisMgr();
 
     /**
-     * @brief   连接 Redis
-     * @param   host 主机地址
+     * @brief   (重新) 连接 Redis，每个 IO 线程一个连接
+     * @param   host 主机地址 (应为 IP，主机名解析会阻塞 IO 线程)
      * @param   port 端口号
-     * @return  bool 连接是否成功 (Mock 永远返回 true)
+     * @return  bool 在 [Redis] Timeout 内是否至少有一个连接建立成功 (失败的连接会在后台重连)
      */
     bool Connect(const std::string &host, int port);
 
     /**
-     * @brief   认证
+     * @brief   认证，同时作为之后重连时的密码
      * @param   password 密码
-     * @return  bool 认证是否成功 (Mock 永远返回 true)
+     * @return  bool 所有已建立的连接是否认证成功
      */
     bool Auth(const std::string &password);
 
@@ -46,7 +67,7 @@ public:
      * @brief   获取 Key 对应的值
      * @param   key   键
      * @param   value 输出参数，存储获取到的值
-     * @return  bool  获取是否成功
+     * @return  bool  键存在且获取成功
      */
     bool Get(const std::string &key, std::string &value);
 
@@ -70,7 +91,7 @@ public:
      * @brief   列表左弹出
      * @param   key   键
      * @param   value 输出参数，存储弹出的值
-     * @return  bool  操作是否成功
+     * @return  bool  列表非空且弹出成功
      */
     bool LPop(const std::string &key, std::string &value);
 
@@ -87,14 +108,14 @@ public:
      * @brief   哈希获取
      * @param   key   键
      * @param   hkey  哈希键
-     * @return  std::string 获取到的值
+     * @return  std::string 获取到的值，不存在或失败时为空
      */
     std::string HGet(const std::string &key, const std::string &hkey);
 
     /**
      * @brief   删除 Key
      * @param   key   键
-     * @return  bool  删除是否成功
+     * @return  bool  命令是否执行成功 (键不存在也算成功)
      */
     bool Del(const std::string &key);
 
@@ -106,13 +127,148 @@ public:
     bool ExistsKey(const std::string &key);
 
     /**
-     * @brief   关闭连接
+     * @brief   GET 的完成回调版本: String 为值，Nil 为不存在
+     */
+    void Get(const std::string &key, RedisCallback callback);
+
+    /**
+     * @brief   SET 的完成回调版本: 成功时为 Status "OK"
+     */
+    void Set(const std::string &key, const std::string &value, RedisCallback callback);
+
+    /**
+     * @brief   DEL 的完成回调版本: Integer 为删除的键数
+     */
+    void Del(const std::string &key, RedisCallback callback);
+
+    /**
+     * @brief   HSET 的完成回调版本: Integer 为新增的字段数
+     */
+    void HSet(const std::string &key, const std::string &hkey, const std::string &value, RedisCallback callback);
+
+    /**
+     * @brief   LPUSH 的完成回调版本: Integer 为推入后的列表长度
+     */
+    void LPush(const std::string &key, const std::string &value, RedisCallback callback);
+
+    /**
+     * @brief   发送任意命令 (完成回调)
+     * @param   args     命令与参数，如 {"EXPIRE", key, "60"}
+     * @param   callback 完成回调，在 IO 线程上执行
+     */
+    void Command(RedisCommand args, RedisCallback callback);
+
+    /**
+     * @brief   发送任意命令并等待回复 (同步)
+     * @return  RedisReply 超时 / 未连接 / 在 IO 线程上调用时为 Error
+     */
+    RedisReply Execute(RedisCommand args);
+
+    /**
+     * @brief   在同一连接上一次发出一组命令 (完成回调)
+     * @param   commands 命令列表
+     * @param   callback 全部回复到达后在 IO 线程上回调，回复与命令按下标对应
+     */
+    void Batch(std::vector<RedisCommand> commands, RedisBatchCallback callback);
+
+    /**
+     * @brief   Batch 的同步版本
+     * @return  与 commands 等长的回复；超时 / 未连接 / 在 IO 线程上调用时每一项都为 Error
+     */
+    std::vector<RedisReply> ExecuteBatch(std::vector<RedisCommand> commands);
+
+    /**
+     * @brief   运行时开关自动批量，作用于所有连接 (线程安全)
+     */
+    void SetAutoBatch(bool enabled);
+
+    /**
+     * @brief   所有连接的累计计数之和 (本地后端时 writes 为 0)
+     */
+    RedisConnection::Stats GetStats() const;
+
+    /**
+     * @brief   是否使用进程内后端 ([Redis] Backend = local)
+     */
+    bool IsLocal() const
+    {
+        return _local != nullptr;
+    }
+
+    /**
+     * @brief   为本地后端注册脚本的 C++ 实现，使 SCRIPT LOAD / EVAL / EVALSHA 该脚本可用
+     * @note    Backend = redis 时无操作
+     */
+    void RegisterLocalScript(const std::string &body, LocalKv::Script script);
+
+    /**
+     * @brief   近端缓存，未启用 ([NearCache] Enabled = off 或本地后端) 时为 nullptr
+     */
+    NearCache *GetNearCache() const
+    {
+        return _near.get();
+    }
+
+    /**
+     * @brief   关闭所有连接 (未完成的命令以错误回调)，之后不再重连
      */
     void Close();
 
 private:
     RedisMgr();
 
-    std::unordered_map<std::string, std::string> _string_cache; ///< 模拟 Redis 存储
-    std::mutex _mtx;                                            ///< 保护 map 线程安全
-};
\ No newline at end of file
+    /**
+     * @brief   选择连接: 调用线程是 IO 线程时用该线程的连接，否则轮转 (优先已连接的)
+     * @return  连接表为空 (已 Close) 时为 nullptr
+     */
+    std::shared_ptr<RedisConnection> Pick();
+
+    /**
+     * @brief   调用线程是否为 IO 线程池中的线程
+     */
+    bool OnIOThread() const;
+
+    /**
+     * @brief   等待至少一个连接建立，最多 _timeout
+     */
+    bool WaitConnected() const;
+
+    /**
+     * @brief   近端缓存的连接钩子: 数据连接建连时开启跟踪、断开时清空缓存
+     */
+    void InstallTrackingHooks();
+
+    /**
+     * @brief   创建并启动失效订阅连接 (CLIENT ID + SUBSCRIBE __redis__:invalidate)
+     */
+    void StartInvalidator();
+
+    /**
+     * @brief   在给定连接上开启跟踪 (CLIENT TRACKING on REDIRECT)
+     * @param   activate 为 true 时 (订阅确认后对全部数据连接) 全部成功后启用缓存；任一失败则停用
+     */
+    void EnableTracking(std::vector<std::shared_ptr<RedisConnection>> connections, long long redirect_id,
+                        bool activate);
+
+    /**
+     * @brief   处理订阅连接收到的订阅确认与失效消息
+     */
+    void OnInvalidation(const RedisReply &reply);
+
+    /**
+     * @brief   写命令发出前使其涉及的键在近端缓存中失效
+     * @note    只在启用近端缓存 (_near 非空) 时调用
+     */
+    void InvalidateFor(const RedisCommand &args);
+
+    RedisConnection::Options _options;
+    std::chrono::milliseconds _timeout{1000}; ///< 同步接口的等待上限
+    std::vector<std::shared_ptr<RedisConnection>> _connections;
+    std::atomic<std::size_t> _next{0};
+    std::unique_ptr<LocalKv> _local; ///< Backend = local 时非空，此时 _connections 为空
+    std::unique_ptr<NearCache> _near; ///< [NearCache] Enabled = on 时非空
+    std::shared_ptr<RedisConnection> _invalidator; ///< 订阅失效消息的专用连接 (_near 非空时)
+    std::atomic<long long> _tracking_id{-1}; ///< 订阅连接的 CLIENT ID，未建立时为 -1
+    std::mutex _tracking_mutex; ///< 串行化缓存的启用与停用 (跟踪完成 vs 订阅连接断开)
+    Metrics::CollectorHandle _collector; ///< /metrics 采集回调 (最后声明，最先注销)
+};
@@ -0,0 +1,187 @@
+/**
+ * @file    RequestTrace.h
+ * @brief   请求级分段计时 (Span) 与慢请求日志
+ * @author  msr
+ *
+ * @details
+ * - 每个 HttpConnection 内嵌一个 RequestTrace，请求解析完成时 Begin()，分配进程内递增的请求 ID。
+ * - Handler 执行期间由 TraceScope 把它绑定为本线程的“当前请求”：
+ *   期间各层 (LogicSystem / RedisMgr / MysqlDao / VerifyGrpcClient) 的 TRACE_SPAN 记录到该请求，
+ *   本线程写的日志自动带上 req=ID。
+ * - 响应就绪时 Finish()：总耗时超过 [Log] SlowRequestMs 时输出一条 WARN，列出各阶段耗时 (微秒)。
+ * - 开销: 未绑定请求 (阈值为 0 或不在 Handler 内) 时一个 Span 只有一次 thread_local 读；
+ *   绑定时为两次时钟读取，写入连接内的定长数组，不分配内存。
+ * - Handler 调用 Send() 之后本线程即解除绑定，其后结束的 Span 不再记录，
+ *   避免与 IO 线程上的 Finish() 并发访问。异步回调线程上的调用不计入 (没有绑定)。
+ */
+
+#pragma once
+
+#include "Logger.h"
+#include "Metrics.h"
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <string_view>
+
+/**
+ * @class   RequestTrace
+ * @brief   一次请求的 ID 与各阶段耗时
+ */
+class RequestTrace
+{
+public:
+    /// 单个请求最多记录的 Span 数，超出的丢弃并在慢日志中标记
+    static constexpr std::size_t kMaxSpans = 16;
+
+    /**
+     * @brief   慢请求阈值 (毫秒)，0 关闭分段计时与慢日志 (请求 ID 照常分配)
+     */
+    static void SetSlowThreshold(std::uint64_t ms);
+    static std::uint64_t GetSlowThreshold();
+
+    /**
+     * @brief   本线程当前绑定的请求，未绑定时为 nullptr
+     */
+    static RequestTrace *Current()
+    {
+        return _current;
+    }
+
+    /**
+     * @brief   若本线程绑定的是 trace 则解除绑定 (HttpResponder 完成请求时调用)
+     */
+    static void Detach(const RequestTrace *trace)
+    {
+        if (_current == trace)
+        {
+            _current = nullptr;
+        }
+    }
+
+    /**
+     * @brief   开始一次请求: 分配请求 ID，清空 Span
+     * @param   start_ns 请求开始时刻 (Metrics::Now)
+     */
+    void Begin(std::uint64_t start_ns);
+
+    /**
+     * @brief   记录一个阶段
+     * @param   stage 阶段名，须为字符串字面量 (只保存指针)
+     */
+    void Add(const char *stage, std::uint64_t begin_ns, std::uint64_t end_ns)
+    {
+        if (_count < kMaxSpans)
+        {
+            _spans[_count] = Span{stage, begin_ns, end_ns};
+        }
+        ++_count;
+    }
+
+    /**
+     * @brief   结束请求，超过阈值时输出慢请求日志
+     */
+    void Finish(std::string_view method, std::string_view target, unsigned status, std::uint64_t end_ns);
+
+    std::uint64_t Id() const
+    {
+        return _id;
+    }
+
+    /**
+     * @brief   是否在记录 Span (Begin 时阈值非 0，Finish 前有效)
+     */
+    bool Active() const
+    {
+        return _active;
+    }
+
+private:
+    friend class TraceScope;
+
+    struct Span
+    {
+        const char *stage;
+        std::uint64_t begin_ns;
+        std::uint64_t end_ns;
+    };
+
+    inline static thread_local RequestTrace *_current = nullptr;
+    inline static std::atomic<std::uint64_t> _slow_ns{0};
+    inline static std::atomic<std::uint64_t> _next_id{0};
+
+    std::uint64_t _id = 0;
+    std::uint64_t _start_ns = 0;
+    std::size_t _count = 0;
+    bool _active = false;
+    std::array<Span, kMaxSpans> _spans{};
+};
+
+/**
+ * @class   TraceScope
+ * @brief   在作用域内把请求绑定到本线程 (RAII)，退出时恢复之前的绑定
+ */
+class TraceScope
+{
+public:
+    explicit TraceScope(RequestTrace &trace)
+        : _previous(RequestTrace::_current),
+          _previous_id(Logger::RequestId())
+    {
+        RequestTrace::_current = trace.Active() ? &trace : nullptr;
+        Logger::SetRequestId(trace.Id());
+    }
+
+    ~TraceScope()
+    {
+        RequestTrace::_current = _previous;
+        Logger::SetRequestId(_previous_id);
+    }
+
+    TraceScope(const TraceScope &) = delete;
+    TraceScope &operator=(const TraceScope &) = delete;
+
+private:
+    RequestTrace *_previous;
+    std::uint64_t _previous_id;
+};
+
+/**
+ * @class   TraceSpan
+ * @brief   作用域计时 (RAII)，结束时计入本线程当前请求
+ */
+class TraceSpan
+{
+public:
+    explicit TraceSpan(const char *stage)
+        : _trace(RequestTrace::Current()),
+          _stage(stage),
+          _begin(_trace != nullptr ? Metrics::Now() : 0)
+    {
+    }
+
+    ~TraceSpan()
+    {
+        // 期间已 Send() 时绑定被解除，不再写入
+        if (_trace != nullptr && RequestTrace::Current() == _trace)
+        {
+            _trace->Add(_stage, _begin, Metrics::Now());
+        }
+    }
+
+    TraceSpan(const TraceSpan &) = delete;
+    TraceSpan &operator=(const TraceSpan &) = delete;
+
+private:
+    RequestTrace *_trace;
+    const char *_stage;
+    std::uint64_t _begin;
+};
+
+#define GATE_TRACE_CONCAT_IMPL(a, b) a##b
+#define GATE_TRACE_CONCAT(a, b) GATE_TRACE_CONCAT_IMPL(a, b)
+
+/**
+ * @brief   为当前作用域计时: TRACE_SPAN("redis.get");
+ */
+#define TRACE_SPAN(stage) TraceSpan GATE_TRACE_CONCAT(_trace_span_, __LINE__)(stage)
@@ -0,0 +1,32 @@
+/**
+ * @file    ResponseHeaderCache.h
+ * @brief   预渲染的响应头模板
+ * @author  msr
+ *
+ * @details
+ * 网关的响应头几乎只由 (版本, 状态码, Content-Type, Keep-Alive, 是否带 Server) 决定。
+ * 按这几个维度把响应头预先渲染成字符串缓存起来，写回时只需追加 Content-Length 数字，
+ * 不必每个请求都让 Beast 重新序列化 Server / Content-Type 等字段。
+ */
+
+#pragma once
+
+#include <boost/beast/http.hpp>
+#include <string>
+
+/**
+ * @class   ResponseHeaderCache
+ * @brief   响应头模板缓存 (每个线程一份，无锁)
+ */
+class ResponseHeaderCache
+{
+public:
+    /**
+     * @brief   查找 (或渲染) header 对应的模板
+     * @details 模板内容为状态行与各字段，以 "Content-Length: " 结尾，调用方追加 "<长度>\r\n\r\n"。
+     * @param   keep_alive 响应的 keep_alive() (Connection 字段由模板按版本语义生成)
+     * @return  模板字符串，地址在线程生命周期内不变；
+     *          header 含模板之外的字段 (或缓存已满) 时返回 nullptr，调用方应走 Beast 通用序列化。
+     */
+    static const std::string *Lookup(const boost::beast::http::response_header<> &header, bool keep_alive);
+};
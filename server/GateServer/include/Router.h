@@ -0,0 +1,137 @@
+/**
+ * @file    Router.h
+ * @brief   基于路径段前缀树 (Radix Trie) 的路由表
+ * @author  msr
+ *
+ * @details
+ * 路由在启动时注册，按 '/' 切分的路径段建成一棵树，每条边是一个完整路径段：
+ * - 静态段 (如 "user") 按字典序存放，查找时二分；
+ * - 参数段 (如 "{uid}") 每个节点至多一个，静态段优先匹配，失败时回溯到参数段；
+ * - 方法分派 (GET / POST / ...) 挂在终点节点上，与路径在同一结构里完成。
+ * 不含参数段的路由另外放进一张注册时构建的开放寻址哈希表 (按规范路径)，
+ * 绝大多数请求一次哈希即可命中，未命中再走前缀树。
+ * 查找只使用 string_view，参数值直接指向请求行，不产生任何内存分配。
+ */
+
+#pragma once
+
+#include <array>
+#include <boost/beast/http/verb.hpp>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+/**
+ * @class   PathParams
+ * @brief   一次匹配得到的路径参数 (定长数组，不分配内存)
+ * @warning 名称指向 Router 内部，值指向请求的 target()，只在该请求处理期间有效；值未做 URL 解码。
+ */
+class PathParams
+{
+public:
+    static constexpr std::size_t kMaxParams = 8;
+
+    /**
+     * @brief   按名称取参数值，不存在时返回空
+     */
+    std::string_view Get(std::string_view name) const;
+
+    std::size_t Size() const { return _size; }
+    std::string_view Name(std::size_t i) const { return _names[i]; }
+    std::string_view Value(std::size_t i) const { return _values[i]; }
+
+    void Clear() { _size = 0; }
+
+private:
+    friend class Router;
+
+    std::array<std::string_view, kMaxParams> _names;
+    std::array<std::string_view, kMaxParams> _values;
+    std::size_t _size = 0;
+};
+
+/**
+ * @class   Router
+ * @brief   (方法, 路径模式) -> 路由编号
+ *
+ * @details
+ * 路由编号由调用方解释 (LogicSystem 中为 Route 数组下标)，Router 本身不关心 Handler 类型。
+ * 注册只能在对外服务之前进行；之后只读，可被多个 IO 线程并发查找。
+ */
+class Router
+{
+public:
+    enum class Result
+    {
+        Found,           ///< 路径与方法都匹配
+        NotFound,        ///< 路径不存在 (404)
+        MethodNotAllowed ///< 路径存在但没有注册该方法 (405)
+    };
+
+    Router();
+
+    /**
+     * @brief   注册路由
+     * @param   method  HTTP 方法
+     * @param   pattern 路径模式，如 "/user/{uid}/avatar"；空路径段会被忽略
+     * @param   value   匹配成功时返回的路由编号
+     * @return  false 该 (方法, 路径) 已注册，或参数段超过 PathParams::kMaxParams 个
+     */
+    bool Add(boost::beast::http::verb method, std::string_view pattern, std::size_t value);
+
+    /**
+     * @brief   查找路由 (不含查询串的路径)
+     * @param   value  Found 时写入路由编号
+     * @param   params Found 时写入路径参数
+     */
+    Result Find(boost::beast::http::verb method, std::string_view path, std::size_t &value, PathParams &params) const;
+
+private:
+    static constexpr std::uint32_t kNone = UINT32_MAX;
+
+    struct Handler
+    {
+        boost::beast::http::verb method;
+        std::size_t value;
+        std::vector<std::string> names; ///< 沿途参数段的名称，按出现顺序
+    };
+
+    struct Node
+    {
+        std::string segment;                ///< 进入该节点的静态段 (参数节点为空)
+        std::vector<std::uint32_t> children; ///< 静态子节点，按 segment 字典序
+        std::uint32_t param = kNone;         ///< 参数子节点
+        std::vector<Handler> handlers;       ///< 终点节点上各方法的路由
+    };
+
+    /**
+     * @brief   从 index 节点开始匹配剩余路径，静态段优先，失败回溯到参数段
+     * @return  匹配到的终点节点 (至少注册了一个方法)，未匹配为 nullptr
+     */
+    const Node *Walk(std::uint32_t index, std::string_view rest, PathParams &params) const;
+
+    /**
+     * @brief   按规范路径 (如 "/user/login") 精确查找静态路由的终点节点
+     */
+    const Node *FindStatic(std::string_view path) const;
+
+    /**
+     * @brief   新增静态路由后重建哈希表，负载因子不超过 1/2
+     */
+    void RebuildStatic();
+
+    struct StaticSlot
+    {
+        std::size_t hash = 0;
+        std::uint32_t node = kNone; ///< kNone 表示空槽
+    };
+
+    std::vector<Node> _nodes; ///< _nodes[0] 为根节点
+
+    std::vector<std::pair<std::string, std::uint32_t>> _static_paths; ///< 规范路径 -> 终点节点
+    std::vector<StaticSlot> _static_slots;                             ///< 线性探测，容量为 2 的幂
+    std::vector<std::string> _static_keys;                             ///< 与 _static_slots 一一对应
+};
@@ -8,7 +8,7 @@
 
 #pragma once
 
-#include <iostream>
+#include "Logger.h"
 #include <memory>
 #include <mutex>
 
@@ -45,7 +45,7 @@ public:
      */
     void PrintDestructor()
     {
-        std::cout << "this is singleton destruct" << std::endl;
+        LOG_DEBUG("this is singleton destruct");
     }
 
 protected:
@@ -69,6 +69,6 @@ protected:
      */
     virtual ~Singleton()
     {
-        std::cout << " this is ~Singleton() " << std::endl;
+        LOG_DEBUG("this is ~Singleton()");
     }
 };
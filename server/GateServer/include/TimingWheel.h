@@ -0,0 +1,129 @@
+/**
+ * @file    TimingWheel.h
+ * @brief   哈希时间轮 (每个 io_context 一个)
+ * @author  msr
+ *
+ * @details
+ * 以 Asio Service 的形式挂在 io_context 上 (`net::use_service<TimingWheel>(ioc)`)。
+ * 每个连接一个 steady_timer 时，Keep-Alive 每个请求都要 cancel + expires_after + async_wait，
+ * 连接数上来后定时器堆 (O(log n)) 与被取消 handler 的投递成为热点。
+ * 时间轮只用一个 steady_timer 按固定 tick 推进，Arm / 重新 Arm / Cancel 都是侵入式链表的 O(1) 操作。
+ */
+
+#pragma once
+
+#include <boost/asio.hpp>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+namespace net = boost::asio;
+
+/**
+ * @class   TimingWheel
+ * @brief   单线程哈希时间轮 (Asio Service)
+ *
+ * @details
+ * 1. slot 数固定，超时超过一圈的条目记录剩余圈数 (rounds)，tick 扫到时递减。
+ * 2. 精度为一个 tick: 回调不会早于设定的超时，最多晚一个 tick。
+ * 3. 没有已 Arm 的条目时停止 tick，空闲的 io_context 不会被周期性唤醒。
+ * 4. tick 间隔读取 config.ini 的 `[GateServer] TimerTick` (毫秒)，默认 100。
+ *
+ * @warning 非线程安全: Entry 的 Arm / Cancel 与超时回调都必须在所属 io_context 的线程上执行。
+ */
+class TimingWheel : public net::execution_context::service
+{
+    /// 侵入式双向循环链表节点，slot 头节点为哨兵
+    struct Node
+    {
+        Node *prev = this;
+        Node *next = this;
+    };
+
+public:
+    using key_type = TimingWheel;
+    static net::execution_context::id id;
+
+    using Clock = std::chrono::steady_clock;
+
+    /**
+     * @class   Entry
+     * @brief   时间轮中的一个定时项，嵌入在使用者对象内 (如 HttpConnection)
+     * @note    时间轮不持有使用者的引用计数；使用者析构 (或回收) 前必须 Cancel，析构函数会自动 Cancel。
+     */
+    class Entry : private Node
+    {
+    public:
+        Entry(TimingWheel &wheel, std::function<void()> on_expire);
+        ~Entry();
+
+        Entry(const Entry &) = delete;
+        Entry &operator=(const Entry &) = delete;
+
+        /**
+         * @brief   从现在起 timeout 后触发回调；已 Arm 时先摘下再重新挂入 (O(1))
+         */
+        void Arm(Clock::duration timeout);
+
+        /**
+         * @brief   取消定时，未 Arm 时无操作 (O(1))
+         */
+        void Cancel();
+
+        bool Armed() const;
+
+    private:
+        friend class TimingWheel;
+
+        TimingWheel &_wheel;
+        std::function<void()> _on_expire;
+        std::uint64_t _rounds = 0;
+        bool _armed = false;
+    };
+
+    /**
+     * @struct  Stats
+     * @brief   时间轮计数
+     */
+    struct Stats
+    {
+        std::uint64_t armed = 0;   ///< 当前挂在轮上的条目数
+        std::uint64_t expired = 0; ///< 累计触发的超时回调数
+        std::uint64_t ticks = 0;   ///< 累计处理的 tick 数
+    };
+
+    explicit TimingWheel(net::execution_context &ctx);
+    ~TimingWheel() override;
+
+    /**
+     * @brief   修改 tick 间隔，仅影响之后 Arm 的条目
+     */
+    void SetTick(Clock::duration tick);
+
+    Clock::duration Tick() const;
+
+    Stats GetStats() const;
+
+private:
+    void shutdown() override;
+
+    void Link(Entry &entry, Clock::duration timeout);
+    static void Unlink(Node &node);
+    static void PushBack(Node &head, Node &node);
+
+    void StartTicking();
+    void OnTick(const boost::system::error_code &ec);
+    void Advance();
+
+    static constexpr std::size_t kSlots = 512;
+
+    net::steady_timer _timer;
+    std::vector<Node> _slots;
+    std::size_t _cursor = 0;
+    Clock::duration _tick;
+    Clock::time_point _next_tick;
+    bool _ticking = false;
+    bool _stopped = false;
+    Stats _stats;
+};
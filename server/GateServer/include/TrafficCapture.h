@@ -0,0 +1,143 @@
+/**
+ * @file    TrafficCapture.h
+ * @brief   请求流量录制 (二进制 Capture 文件) 与读取
+ * @author  msr
+ *
+ * @details
+ * 开启 [Capture] File 后，HttpConnection 在每个请求解析完成时调用 TrafficCapture::Record()，
+ * 录下到达时刻、方法、target、全部请求头与 Body，供 tools/gate_replay 离线回放。
+ *
+ * - 写入: 请求先在调用线程的 thread_local 缓冲中编码，再连同到达时刻追加到该线程自己的活动缓冲
+ *   (只有一次 memcpy，IO 线程之间没有共享的锁)；后台线程每 10ms (或某个线程缓冲过半时) 换出各线程缓冲，
+ *   按到达时刻归并后 write 到文件。IO 线程从不等待磁盘，线程缓冲写满时丢弃该请求并计数。
+ * - 文件格式 (整数为小端，varint 为 LEB128):
+ *   @code
+ *   文件头: "GATECAP1" | u64 录制开始的 Unix 时间 (ns) | u8 flags (bit0: 含 Body)
+ *   记录:   varint 距上一条的间隔 (ns) | varint 记录长度 | 记录
+ *   记录:   u8 method (http::verb) | u8 version (11 = HTTP/1.1) | varint target 长度 | target
+ *           | varint 头部个数 | { varint 名称长度 | 名称 | varint 值长度 | 值 } | varint Body 长度 | Body
+ *   @endcode
+ *   间隔由写线程归并后计算，记录顺序即到达顺序，时刻单调。
+ *
+ * @warning Capture 含完整的请求头与 Body (包括密码等字段)，只应在受控环境开启；
+ *          不需要 Body 时设置 [Capture] Bodies = off。
+ */
+
+#pragma once
+
+#include <boost/beast/http.hpp>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+/**
+ * @class   TrafficCapture
+ * @brief   进程级的请求录制 (静态接口，默认关闭)
+ */
+class TrafficCapture
+{
+public:
+    /**
+     * @struct  Options
+     * @brief   录制参数，对应 config.ini 的 [Capture] 段
+     */
+    struct Options
+    {
+        std::string path;                          ///< 输出文件 (覆盖写)
+        bool bodies = true;                        ///< 是否录制 Body
+        std::size_t buffer_bytes = 4 * 1024 * 1024; ///< 每个录制线程的缓冲容量
+    };
+
+    /**
+     * @brief   打开文件、写文件头并启动写线程
+     * @return  false 文件打开失败或已在录制
+     */
+    static bool Start(const Options &options);
+
+    /**
+     * @brief   写出剩余数据并关闭文件 (未开启时无操作)
+     */
+    static void Stop();
+
+    /**
+     * @brief   是否在录制，关闭时请求路径上只有这一次 relaxed 原子读
+     */
+    static bool Enabled();
+
+    /**
+     * @brief   录制一个请求 (线程安全)
+     */
+    static void Record(const boost::beast::http::request_header<> &header, std::string_view body);
+
+    static std::uint64_t Captured(); ///< 已写入缓冲的请求数
+    static std::uint64_t Dropped();  ///< 因缓冲写满被丢弃的请求数
+};
+
+/**
+ * @struct  CapturedRequest
+ * @brief   Capture 文件中的一条请求
+ */
+struct CapturedRequest
+{
+    std::uint64_t offset_ns = 0; ///< 距录制开始的时间
+    boost::beast::http::verb method = boost::beast::http::verb::unknown;
+    unsigned version = 11;
+    std::string target;
+    std::vector<std::pair<std::string, std::string>> headers;
+    std::string body;
+};
+
+/**
+ * @class   CaptureReader
+ * @brief   顺序读取 Capture 文件
+ */
+class CaptureReader
+{
+public:
+    CaptureReader() = default;
+    ~CaptureReader();
+
+    CaptureReader(const CaptureReader &) = delete;
+    CaptureReader &operator=(const CaptureReader &) = delete;
+
+    /**
+     * @brief   打开文件并校验文件头
+     * @param   error 失败原因
+     */
+    bool Open(const std::string &path, std::string &error);
+
+    /**
+     * @brief   读取下一条
+     * @return  false 到达文件末尾或记录损坏 (Failed() 区分)
+     */
+    bool Next(CapturedRequest &request);
+
+    /**
+     * @brief   是否因记录损坏 / 截断而停止
+     */
+    bool Failed() const
+    {
+        return _failed;
+    }
+
+    std::uint64_t StartUnixNs() const
+    {
+        return _start_unix_ns;
+    }
+
+    bool HasBodies() const
+    {
+        return _has_bodies;
+    }
+
+private:
+    std::FILE *_file = nullptr;
+    std::uint64_t _start_unix_ns = 0;
+    std::uint64_t _offset_ns = 0;
+    bool _has_bodies = false;
+    bool _failed = false;
+    std::string _record;
+};
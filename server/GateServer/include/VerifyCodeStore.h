@@ -0,0 +1,99 @@
+/**
+ * @file    VerifyCodeStore.h
+ * @brief   验证码存储: 写入，以及注册时的原子校验并消费
+ * @author  msr
+ *
+ * @details
+ * 注册需要三个判断: 验证码存在、与提交的一致、用户名未被占用，通过后验证码作废。
+ * 分成多条命令时每次判断一个 RTT，且并发重试的两个请求可能同时通过校验。
+ * 这里把三个判断与消费写成一段 Lua 脚本在 Redis 服务端原子执行:
+ * - 启动时 SCRIPT LOAD 缓存脚本，之后只发 EVALSHA (只带 SHA1，一个 RTT)；
+ * - Redis 重启 / SCRIPT FLUSH 后 EVALSHA 返回 NOSCRIPT，此时改用 EVAL 执行一次 (同时重新缓存)；
+ * - 启动时 Redis 不可用则首次调用走 EVAL，并在后台补一次 SCRIPT LOAD；
+ * - 本地后端 ([Redis] Backend = local) 不执行 Lua，构造时为同一脚本注册等价的 C++ 实现。
+ *
+ * 键布局: 验证码以邮箱为键 (与获取验证码接口写入的一致)，用户名以自身为键。
+ */
+
+#pragma once
+
+#include "RedisConnection.h"
+#include "Singleton.h"
+#include <functional>
+#include <mutex>
+#include <string>
+
+/**
+ * @class   VerifyCodeStore
+ * @brief   验证码存储 (Singleton)，构造时缓存校验脚本
+ */
+class VerifyCodeStore : public Singleton<VerifyCodeStore>
+{
+    friend class Singleton<VerifyCodeStore>;
+
+public:
+    /**
+     * @enum    Result
+     * @brief   校验结果，除 Ok 外验证码都不会被消费
+     */
+    enum class Result
+    {
+        Ok,         ///< 校验通过，验证码已删除
+        Expired,    ///< 验证码不存在 (过期或已被使用)
+        Mismatch,   ///< 验证码不一致
+        UserExists, ///< 用户名已被占用
+        Error       ///< Redis 不可用 / 超时 / 脚本错误
+    };
+
+    using ResultCallback = std::function<void(Result)>;
+
+    ~VerifyCodeStore();
+
+    /**
+     * @brief   写入邮箱对应的验证码 (同步)，[Redis] VerifyCodeTtl 大于 0 时带过期时间
+     * @return  bool 是否写入成功
+     */
+    bool Save(const std::string &email, const std::string &code);
+
+    /**
+     * @brief   原子地校验验证码与用户名，通过时消费验证码 (同步，一个 RTT)
+     * @param   email 邮箱 (验证码的键)
+     * @param   code  用户提交的验证码
+     * @param   user  待注册的用户名
+     * @note    与 RedisMgr 的同步接口一样，不能在 IO 线程上调用
+     */
+    Result VerifyAndConsume(const std::string &email, const std::string &code, const std::string &user);
+
+    /**
+     * @brief   VerifyAndConsume 的完成回调版本，回调在 IO 线程上执行
+     */
+    void VerifyAndConsume(const std::string &email, const std::string &code, const std::string &user,
+                          ResultCallback callback);
+
+    /**
+     * @brief   结果的简短名称，用于日志
+     */
+    static const char *Name(Result result);
+
+private:
+    VerifyCodeStore();
+
+    /**
+     * @brief   SCRIPT LOAD 并记录 SHA1 (同步)
+     */
+    bool Load();
+
+    /**
+     * @brief   SCRIPT LOAD 的完成回调版本，用于 EVAL 兜底之后补缓存
+     */
+    void LoadAsync();
+
+    std::string Sha() const;
+
+    static Result ToResult(const RedisReply &reply);
+    static bool IsNoScript(const RedisReply &reply);
+
+    mutable std::mutex _mutex;
+    std::string _sha; ///< 脚本的 SHA1，为空表示尚未缓存
+    int _ttl_seconds = 0; ///< 验证码有效期 (秒)，0 表示不过期
+};
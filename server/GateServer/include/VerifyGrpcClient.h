@@ -8,6 +8,7 @@
 
 #pragma once
 
+#include "Metrics.h"
 #include "Singleton.h"
 #include "message.grpc.pb.h"
 #include <atomic>
@@ -48,6 +49,19 @@ public:
             // 创建 Stub 并存入队列
             connections_.push(VerifyService::NewStub(channel));
         }
+
+        collector_ = Metrics::AddCollector(
+            [this](MetricsWriter &writer)
+            {
+                std::size_t idle = Available();
+                writer.Gauge("gate_grpc_pool_size", "Configured gRPC stubs.", "pool=\"verify\"", poolSize_);
+                writer.Gauge("gate_grpc_pool_connections", "gRPC stubs by state.", "pool=\"verify\",state=\"idle\"",
+                             idle);
+                writer.Gauge("gate_grpc_pool_connections", "gRPC stubs by state.",
+                             "pool=\"verify\",state=\"in_use\"", poolSize_ > idle ? poolSize_ - idle : 0);
+                writer.Gauge("gate_grpc_pool_waiters", "Threads blocked waiting for a gRPC stub.", "pool=\"verify\"",
+                             waiters_.load(std::memory_order_relaxed));
+            });
     }
 
     ~RPConPool()
@@ -63,6 +77,7 @@ public:
     std::unique_ptr<VerifyService::Stub> getConnection()
     {
         std::unique_lock<std::mutex> lock(mutex_);
+        waiters_.fetch_add(1, std::memory_order_relaxed);
         cond_.wait(
             lock,
             [this]
@@ -71,6 +86,7 @@ public:
                     return true;
                 return !connections_.empty();
             });
+        waiters_.fetch_sub(1, std::memory_order_relaxed);
         if (b_stop_)
             return nullptr;
         auto context = std::move(connections_.front());
@@ -87,6 +103,15 @@ public:
         cond_.notify_one();
     }
 
+    /**
+     * @brief   当前空闲的 Stub 数
+     */
+    std::size_t Available()
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return connections_.size();
+    }
+
     void Close()
     {
         b_stop_ = true;
@@ -101,6 +126,8 @@ private:
     std::queue<std::unique_ptr<VerifyService::Stub>> connections_;
     std::mutex mutex_;
     std::condition_variable cond_;
+    std::atomic<int> waiters_{0};
+    Metrics::CollectorHandle collector_; ///< 最后声明，最先注销
 };
 
 /**
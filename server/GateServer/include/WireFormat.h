@@ -0,0 +1,49 @@
+/**
+ * @file    WireFormat.h
+ * @brief   请求 / 响应的编码格式协商 (JSON 或 protobuf)
+ * @author  msr
+ *
+ * @details
+ * - 请求格式看 Content-Type: application/x-protobuf 为 protobuf，其余按 JSON 处理；
+ * - 响应格式看 Accept: 明确列出 application/x-protobuf 或 JSON 类型时按其选择，
+ *   未指定 (缺失或 * / *) 时与请求格式相同。
+ */
+
+#pragma once
+
+#include <string_view>
+
+enum class WireFormat
+{
+    Json,
+    Protobuf
+};
+
+/// protobuf 的 Content-Type
+constexpr std::string_view kProtobufContentType = "application/x-protobuf";
+
+/// JSON 响应沿用原有的 Content-Type，避免影响现有客户端
+constexpr std::string_view kJsonContentType = "text/json";
+
+/**
+ * @struct  WireNegotiation
+ * @brief   一次请求协商出的两个方向的格式
+ */
+struct WireNegotiation
+{
+    WireFormat request = WireFormat::Json;
+    WireFormat response = WireFormat::Json;
+};
+
+/**
+ * @brief   根据 Content-Type 与 Accept 头协商格式
+ */
+WireNegotiation NegotiateWireFormat(std::string_view content_type, std::string_view accept);
+
+/**
+ * @brief   格式对应的响应 Content-Type
+ */
+constexpr std::string_view ContentTypeOf(WireFormat format)
+{
+    return format == WireFormat::Protobuf ? kProtobufContentType : kJsonContentType;
+}
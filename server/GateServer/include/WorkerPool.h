@@ -0,0 +1,97 @@
+/**
+ * @file    WorkerPool.h
+ * @brief   有界业务线程池声明
+ * @author  msr
+ *
+ * @details 供 LogicSystem 把 JSON 解析、Redis / MySQL / gRPC 等阻塞调用移出 IO 线程。
+ */
+
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+/**
+ * @class   WorkerPool
+ * @brief   固定线程数 + 有界任务队列
+ *
+ * @details
+ * 1. 队列是预分配的环形数组，容量固定；满时 TryPost 直接返回 false，由调用方降级 (如回 503)，
+ *    不会无限堆积请求拖垮内存和延迟。
+ * 2. 队列深度、峰值、拒绝数等计数用原子变量维护，可在任意线程读取。
+ * 3. Stop() 后丢弃尚未执行的任务并回收线程，可重复调用。
+ */
+class WorkerPool
+{
+public:
+    using Task = std::function<void()>;
+
+    /**
+     * @struct  Stats
+     * @brief   队列指标
+     */
+    struct Stats
+    {
+        std::uint64_t depth = 0;      ///< 当前排队的任务数
+        std::uint64_t peak_depth = 0; ///< 排队数峰值
+        std::uint64_t capacity = 0;   ///< 队列容量
+        std::uint64_t busy = 0;       ///< 正在执行任务的线程数
+        std::uint64_t threads = 0;    ///< 线程数
+        std::uint64_t submitted = 0;  ///< 累计入队数
+        std::uint64_t rejected = 0;   ///< 队列满被拒绝的次数
+        std::uint64_t completed = 0;  ///< 累计执行完成数
+    };
+
+    /**
+     * @param   name     线程池名称 (日志 / 指标使用)
+     * @param   threads  线程数，0 时取硬件并发数
+     * @param   capacity 队列容量，至少为 1
+     */
+    WorkerPool(std::string name, std::size_t threads, std::size_t capacity);
+    ~WorkerPool();
+
+    WorkerPool(const WorkerPool &) = delete;
+    WorkerPool &operator=(const WorkerPool &) = delete;
+
+    /**
+     * @brief   提交任务
+     * @return  false 队列已满或线程池已停止，任务未被接收
+     * @note    线程安全。
+     */
+    bool TryPost(Task task);
+
+    /**
+     * @brief   停止线程池，丢弃未执行的任务
+     */
+    void Stop();
+
+    const std::string &Name() const;
+
+    Stats GetStats() const;
+
+private:
+    void Run();
+
+    std::string _name;
+    std::vector<std::thread> _threads;
+
+    std::mutex _mtx;
+    std::condition_variable _cv;
+    std::vector<Task> _ring;
+    std::size_t _head = 0;
+    std::size_t _size = 0;
+    bool _stopped = false;
+
+    std::atomic<std::uint64_t> _depth{0};
+    std::atomic<std::uint64_t> _peak_depth{0};
+    std::atomic<std::uint64_t> _busy{0};
+    std::atomic<std::uint64_t> _submitted{0};
+    std::atomic<std::uint64_t> _rejected{0};
+    std::atomic<std::uint64_t> _completed{0};
+};
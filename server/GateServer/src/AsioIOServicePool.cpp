@@ -5,28 +5,316 @@
  */
 
 #include "AsioIOServicePool.h"
-#include <iostream>
+#include "ConfigMgr.h"
+#include "HttpConnectionSlab.h"
+#include "Logger.h"
+#include <algorithm>
+#include <charconv>
+#include <condition_variable>
+#include <cstdlib>
 #include <memory>
+#include <mutex>
+#include <sstream>
 
-AsioIOServicePool::AsioIOServicePool(std::size_t size)
-    : nextIOService_(0)
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+#ifdef GATE_HAVE_NUMA
+#include <numa.h>
+#endif
+
+namespace
+{
+/**
+ * @brief   当前进程允许运行的 CPU 列表 (受 taskset / cgroup 限制)
+ */
+std::vector<int> AllowedCpus()
+{
+    std::vector<int> cpus;
+#ifdef __linux__
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    if (sched_getaffinity(0, sizeof(set), &set) == 0)
+    {
+        for (int cpu = 0; cpu < CPU_SETSIZE; ++cpu)
+        {
+            if (CPU_ISSET(cpu, &set))
+            {
+                cpus.push_back(cpu);
+            }
+        }
+    }
+#endif
+    return cpus;
+}
+
+bool NumaUsable()
+{
+#ifdef GATE_HAVE_NUMA
+    return numa_available() >= 0;
+#else
+    return false;
+#endif
+}
+
+int NodeOfCpu([[maybe_unused]] int cpu)
+{
+#ifdef GATE_HAVE_NUMA
+    if (cpu >= 0 && NumaUsable())
+    {
+        return numa_node_of_cpu(cpu);
+    }
+#endif
+    return -1;
+}
+
+int CurrentCpu()
+{
+#ifdef __linux__
+    return sched_getcpu();
+#else
+    return -1;
+#endif
+}
+} // namespace
+
+IOPoolTopology IOPoolTopology::FromConfig()
+{
+    auto &cfg = ConfigMgr::GetInstance();
+    IOPoolTopology topology;
+
+    std::string threads = cfg["IOPool"]["Threads"];
+    if (!threads.empty())
+    {
+        topology.threads = static_cast<std::size_t>(std::max(0, std::atoi(threads.c_str())));
+    }
+
+    std::string pinning = cfg["IOPool"]["Pinning"];
+    if (pinning == "compact")
+    {
+        topology.pinning = Pinning::Compact;
+    }
+    else if (pinning == "list")
+    {
+        topology.pinning = Pinning::List;
+    }
+
+    // 与 NumaNode 相同按整串解析: atoi 会把 "a"、"3x" 之类的笔误当成 0 或截断，静默绑错核
+    std::string cpu_list = cfg["IOPool"]["Cpus"];
+    std::stringstream cpus(cpu_list);
+    std::string item;
+    while (std::getline(cpus, item, ','))
+    {
+        std::size_t first = item.find_first_not_of(" \t");
+        if (first == std::string::npos)
+        {
+            continue;
+        }
+        std::size_t last = item.find_last_not_of(" \t");
+        int cpu = -1;
+        auto [end, ec] = std::from_chars(item.data() + first, item.data() + last + 1, cpu);
+        if (ec != std::errc() || end != item.data() + last + 1 || cpu < 0)
+        {
+            LOG_ERROR("IOPool Cpus invalid, list ignored").Field("value", cpu_list).Field("item", item);
+            topology.cpus.clear();
+            break;
+        }
+        topology.cpus.push_back(cpu);
+    }
+    if (topology.pinning == Pinning::List && topology.cpus.empty())
+    {
+        LOG_ERROR("IOPool Pinning=list without valid Cpus, pinning disabled").Field("value", cpu_list);
+        topology.pinning = Pinning::None;
+    }
+
+    std::string numa = cfg["IOPool"]["NumaNode"];
+    if (numa == "local")
+    {
+        topology.numa = NumaPolicy::Local;
+    }
+    else if (!numa.empty())
+    {
+        // 整串必须是整数: atoi 会把 "node1" 之类的笔误当成 0，静默绑定到节点 0
+        int node = -1;
+        auto [end, ec] = std::from_chars(numa.data(), numa.data() + numa.size(), node);
+        if (ec != std::errc() || end != numa.data() + numa.size())
+        {
+            LOG_WARN("IOPool NumaNode invalid, NUMA policy disabled").Field("value", numa);
+        }
+        else if (node >= 0)
+        {
+            topology.numa = NumaPolicy::Bind;
+            topology.numa_node = node;
+        }
+    }
+    return topology;
+}
+
+AsioIOServicePool::AsioIOServicePool(const IOPoolTopology &topology)
+    : topology_(topology),
+      nextIOService_(0)
 {
+    if ((topology_.numa != IOPoolTopology::NumaPolicy::None) && !NumaUsable())
+    {
+        LOG_WARN("IOPool NumaNode ignored: libnuma not available");
+        topology_.numa = IOPoolTopology::NumaPolicy::None;
+    }
+
+    // 1. 可用 CPU: 进程亲和性掩码，绑定节点时只保留该节点的 CPU
+    std::vector<int> usable;
+    for (int cpu : AllowedCpus())
+    {
+        if (topology_.numa != IOPoolTopology::NumaPolicy::Bind || NodeOfCpu(cpu) == topology_.numa_node)
+        {
+            usable.push_back(cpu);
+        }
+    }
+
+    // 2. 计算每个线程绑定的 CPU
+    std::vector<int> candidates;
+    if (topology_.pinning == IOPoolTopology::Pinning::List)
+    {
+        candidates = topology_.cpus;
+    }
+    else if (topology_.pinning == IOPoolTopology::Pinning::Compact)
+    {
+        candidates = usable;
+    }
+
+    std::size_t size = topology_.threads;
+    if (size == 0)
+    {
+        if (!candidates.empty())
+        {
+            size = candidates.size();
+        }
+        else if (topology_.numa == IOPoolTopology::NumaPolicy::Bind && !usable.empty())
+        {
+            size = usable.size();
+        }
+        else
+        {
+            size = std::thread::hardware_concurrency();
+        }
+    }
     if (size == 0)
     {
         size = 2;
     }
+    for (std::size_t i = 0; i < size && !candidates.empty(); ++i)
+    {
+        cpuPlan_.push_back(candidates[i % candidates.size()]);
+    }
+
+    // 3. 每个线程先应用拓扑，再在本线程构造 io_context，构造完成后主线程才返回
+    ioServices_.resize(size);
+    works_.resize(size);
+    contextInfo_.resize(size);
+
+    std::mutex mtx;
+    std::condition_variable cv;
+    std::size_t ready = 0;
     for (std::size_t i = 0; i < size; ++i)
     {
-        ioServices_.emplace_back(std::make_shared<IOService>());
-        works_.emplace_back(boost::asio::make_work_guard(ioServices_[i]->get_executor()));
-        threads_.emplace_back([this, i]() { ioServices_[i]->run(); });
+        threads_.emplace_back(
+            [this, i, &mtx, &cv, &ready]()
+            {
+                int pinned = ApplyTopology(i);
+                auto service = std::make_shared<IOService>();
+                auto work = std::make_unique<WorkGuard>(boost::asio::make_work_guard(service->get_executor()));
+
+                IOContextInfo info;
+                info.index = i;
+                info.pinned_cpu = pinned;
+                info.start_cpu = CurrentCpu();
+                info.numa_node = NodeOfCpu(info.start_cpu);
+                {
+                    std::lock_guard<std::mutex> lock(mtx);
+                    ioServices_[i] = service;
+                    works_[i] = std::move(work);
+                    contextInfo_[i] = info;
+                    ++ready;
+                    // 持锁通知: 构造函数返回后 mtx/cv 即失效
+                    cv.notify_one();
+                }
+                service->run();
+            });
     }
+
+    std::unique_lock<std::mutex> lock(mtx);
+    cv.wait(lock, [&ready, size]() { return ready == size; });
+    lock.unlock();
+
+    // 4. /metrics: 每个 io_context 上连接对象池的状态
+    metricsCollector_ = Metrics::AddCollector(
+        [this](MetricsWriter &writer)
+        {
+            writer.Gauge("gate_iopool_contexts", "Number of io_context threads.", "", ioServices_.size());
+            for (std::size_t i = 0; i < ioServices_.size(); ++i)
+            {
+                auto stats = boost::asio::use_service<HttpConnectionSlab>(*ioServices_[i]).GetStats();
+                std::string labels = "context=\"" + std::to_string(i) + "\"";
+                std::uint64_t live = stats.created - stats.destroyed;
+                writer.Gauge("gate_iopool_connections", "Connection objects on this context that are not cached.",
+                             labels, live > stats.cached ? live - stats.cached : 0);
+                writer.Gauge("gate_iopool_slab_cached", "Idle connection objects cached by the slab.", labels,
+                             stats.cached);
+                writer.Counter("gate_iopool_slab_created_total", "Connection objects allocated.", labels,
+                               stats.created);
+                writer.Counter("gate_iopool_slab_reused_total", "Accepts served from the slab cache.", labels,
+                               stats.reused);
+            }
+        });
+}
+
+int AsioIOServicePool::ApplyTopology(std::size_t index)
+{
+    int pinned = -1;
+#ifdef __linux__
+    if (index < cpuPlan_.size())
+    {
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        CPU_SET(cpuPlan_[index], &set);
+        if (pthread_setaffinity_np(pthread_self(), sizeof(set), &set) == 0)
+        {
+            pinned = cpuPlan_[index];
+        }
+        else
+        {
+            LOG_WARN("IOPool pin thread failed").Field("thread", index).Field("cpu", cpuPlan_[index]);
+        }
+    }
+#endif
+
+#ifdef GATE_HAVE_NUMA
+    if (topology_.numa == IOPoolTopology::NumaPolicy::Local)
+    {
+        // 之后本线程分配的内存 (io_context、Session、读写缓冲) 都落在当前 CPU 的节点上
+        numa_set_localalloc();
+    }
+    else if (topology_.numa == IOPoolTopology::NumaPolicy::Bind)
+    {
+        if (pinned < 0)
+        {
+            numa_run_on_node(topology_.numa_node);
+        }
+        // 严格绑定: 节点内存不足时分配失败，而不是像 numa_set_preferred 那样退回其他节点
+        struct bitmask *nodes = numa_allocate_nodemask();
+        numa_bitmask_setbit(nodes, static_cast<unsigned int>(topology_.numa_node));
+        numa_set_membind(nodes);
+        numa_bitmask_free(nodes);
+    }
+#endif
+    return pinned;
 }
 
 AsioIOServicePool::~AsioIOServicePool()
 {
     Stop();
-    std::cout << "AsioIOServicePool destruct" << std::endl;
+    LOG_DEBUG("AsioIOServicePool destruct");
 }
 
 std::shared_ptr<AsioIOServicePool::IOService> AsioIOServicePool::GetIOService()
@@ -37,6 +325,21 @@ std::shared_ptr<AsioIOServicePool::IOService> AsioIOServicePool::GetIOService()
     return ioServices_[index % ioServices_.size()];
 }
 
+std::shared_ptr<AsioIOServicePool::IOService> AsioIOServicePool::GetIOService(std::size_t index)
+{
+    return ioServices_[index % ioServices_.size()];
+}
+
+std::size_t AsioIOServicePool::Size() const
+{
+    return ioServices_.size();
+}
+
+const std::vector<IOContextInfo> &AsioIOServicePool::GetContextInfo() const
+{
+    return contextInfo_;
+}
+
 void AsioIOServicePool::Stop()
 {
     // 因为仅仅执行work.reset并不能让iocontext从run的状态中退出
@@ -51,6 +354,9 @@ void AsioIOServicePool::Stop()
     }
     for (auto &t : threads_)
     {
-        t.join();
+        if (t.joinable())
+        {
+            t.join();
+        }
     }
 }
@@ -7,7 +7,26 @@
 #include "CServer.h"
 #include "AsioIOServicePool.h"
 #include "HttpConnection.h"
-#include <iostream>
+#include "HttpConnectionSlab.h"
+#include "Logger.h"
+#include <algorithm>
+#include <cctype>
+#include <stdexcept>
+
+#ifdef SO_REUSEPORT
+using reuse_port = net::detail::socket_option::boolean<SOL_SOCKET, SO_REUSEPORT>;
+#endif
+
+AcceptMode ParseAcceptMode(const std::string &name)
+{
+    std::string lower(name);
+    std::transform(lower.begin(), lower.end(), lower.begin(), [](unsigned char c) { return std::tolower(c); });
+    if (lower == "reuseport")
+    {
+        return AcceptMode::ReusePort;
+    }
+    return AcceptMode::Single;
+}
 
 /**
  * @brief   构造函数
@@ -15,14 +34,29 @@
  * _acceptor执行序列:
  * 1. socket(AF_INET, SOCK_STREAM, 0) -> 创建文件描述符
  * 2. setsockopt(SO_REUSEADDR) -> 允许地址复用 (Beast 默认开启)
- * 3. bind(port) -> 绑定端口
- * 4. listen() -> 标记为被动套接字
+ * 3. setsockopt(SO_REUSEPORT) -> 仅 ReusePort 模式。多个 Socket 绑定同一端口，内核按四元组哈希分流
+ * 4. bind(port) -> 绑定端口
+ * 5. listen() -> 标记为被动套接字
  */
-CServer::CServer(net::io_context &ioc, unsigned short &port)
+CServer::CServer(net::io_context &ioc, unsigned short &port, AcceptMode mode)
     : _ioc(ioc),
-      _acceptor(ioc, tcp::endpoint(tcp::v4(), port)), // endpoint相当于填充了 C 语言中的 struct sockaddr_in 结构体
+      _acceptor(ioc),
+      _mode(mode),
       _socket(ioc)
 {
+    tcp::endpoint endpoint(tcp::v4(), port); // endpoint相当于填充了 C 语言中的 struct sockaddr_in 结构体
+    _acceptor.open(endpoint.protocol());
+    _acceptor.set_option(tcp::acceptor::reuse_address(true));
+    if (_mode == AcceptMode::ReusePort)
+    {
+#ifdef SO_REUSEPORT
+        _acceptor.set_option(reuse_port(true));
+#else
+        throw std::runtime_error("SO_REUSEPORT is not supported on this platform");
+#endif
+    }
+    _acceptor.bind(endpoint);
+    _acceptor.listen(net::socket_base::max_listen_connections);
 }
 
 void CServer::HandleAccept()
@@ -31,21 +65,32 @@ void CServer::HandleAccept()
     // 确保异步回调执行时，CServer 对象没有被析构。
     auto self = shared_from_this();
 
-    auto ioc_ptr = AsioIOServicePool::GetInstance()->GetIOService();
+    // Single: 轮询选一个 IO 线程，Accept 完成后连接在该线程上运行 (跨线程移交)
+    // ReusePort: 直接使用 Acceptor 自己的 io_context，连接全程不离开当前线程
+    net::io_context &target =
+        (_mode == AcceptMode::ReusePort) ? _ioc : *AsioIOServicePool::GetInstance()->GetIOService();
 
-    auto new_socket = std::make_shared<tcp::socket>(*ioc_ptr);
+    // 从目标 io_context 的对象池取一个 Session，直接 Accept 到它的 socket 上，稳态下不再分配内存
+    auto connection = net::use_service<HttpConnectionSlab>(target).Acquire();
 
     /**
      * @brief 提交异步 Accept 请求到内核 (Epoll/IOCP)
-     * @param _socket 用于存放新连接 fd 的对象 (即使它现在可能是空的/无效的)
+     * @param connection->Socket() 用于存放新连接 fd 的对象 (复用对象的 socket 此时处于关闭状态)
      * @param callback 当三次握手完成 (SYN Queue -> Accept Queue)，内核触发此回调
      */
     _acceptor.async_accept(
-        *new_socket,
-        [self, new_socket](beast::error_code ec)
+        connection->Socket(),
+        MakeCustomAllocHandler(connection->AcceptHandlerMemory(),
+                               [self, connection, executor = target.get_executor()](beast::error_code ec)
         {
             try
             {
+                // Close() 之后 Acceptor 已关闭，pending 的 Accept 以 operation_aborted 返回，此时结束循环
+                if (!self->_acceptor.is_open())
+                {
+                    return;
+                }
+
                 // [Error Handling] 即使 Accept 失败（如文件描述符耗尽 EMFILE），也要继续监听，否则服务器会停止服务。
                 if (ec)
                 {
@@ -53,15 +98,43 @@ void CServer::HandleAccept()
                     return;
                 }
 
-                std::make_shared<HttpConnection>(std::move(*new_socket))->Start();
+                self->_accepted.fetch_add(1, std::memory_order_relaxed);
+                if (self->_mode == AcceptMode::ReusePort)
+                {
+                    connection->Start();
+                }
+                else
+                {
+                    // 投递到连接所属的 IO 线程再启动 Session，定时器等状态只被该线程访问
+                    // 注意使用 io_context 的具体 executor：socket 的 any_io_executor 会忽略 handler 的分配器
+                    net::post(executor,
+                              MakeCustomAllocHandler(connection->AcceptHandlerMemory(),
+                                                     [connection]() { connection->Start(); }));
+                }
 
                 // [Recursion] 继续监听下一个连接
                 self->HandleAccept();
             }
             catch (std::exception &exp)
             {
-                std::cout << "exception is" << exp.what() << std::endl;
+                LOG_ERROR("accept exception").Field("what", exp.what());
                 self->HandleAccept();
             }
-        });
+        }));
+}
+
+void CServer::Close()
+{
+    auto self = shared_from_this();
+    net::post(_acceptor.get_executor(),
+              [self]()
+              {
+                  beast::error_code ec;
+                  self->_acceptor.close(ec);
+              });
+}
+
+std::uint64_t CServer::AcceptedCount() const
+{
+    return _accepted.load(std::memory_order_relaxed);
 }
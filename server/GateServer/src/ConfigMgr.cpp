@@ -5,10 +5,10 @@
  */
 
 #include "ConfigMgr.h"
+#include "Logger.h"
 #include <boost/property_tree/ini_parser.hpp>
 #include <boost/property_tree/ptree.hpp>
 #include <filesystem>
-#include <iostream>
 
 /**
  * @brief 构造函数
@@ -28,7 +28,7 @@ ConfigMgr::ConfigMgr()
         config_path = "e:/Study/Project/Chat/msrchat/server/GateServer/config.ini";
     }
 
-    std::cout << "Loading Config from: " << config_path << std::endl;
+    LOG_INFO("loading config").Field("path", config_path.string());
 
     boost::property_tree::ptree pt;
     try
@@ -37,7 +37,7 @@ ConfigMgr::ConfigMgr()
     }
     catch (std::exception &e)
     {
-        std::cerr << "Config load failed: " << e.what() << std::endl;
+        LOG_ERROR("config load failed").Field("what", e.what());
         return;
     }
 
@@ -0,0 +1,61 @@
+/**
+ * @file    GateMessages.cpp
+ * @brief   预序列化的错误响应
+ * @author  msr
+ */
+
+#include "GateMessages.h"
+#include <array>
+#include <boost/beast/core/buffers_to_string.hpp>
+
+namespace
+{
+using ChatApp::ErrorCode;
+
+constexpr ErrorCode kErrorCodes[] = {
+    ErrorCode::Success,       ErrorCode::Error_Json,    ErrorCode::RPCFailed, ErrorCode::VarifyExpired,
+    ErrorCode::VarifyCodeErr, ErrorCode::UserExist,     ErrorCode::PasswdErr,
+};
+constexpr std::size_t kErrorCount = sizeof(kErrorCodes) / sizeof(kErrorCodes[0]);
+
+std::string Serialize(ErrorCode code, WireFormat format)
+{
+    if (format == WireFormat::Protobuf)
+    {
+        message::GetVerifyResponse response;
+        response.set_error(static_cast<int>(code));
+        return response.SerializeAsString();
+    }
+    boost::beast::flat_buffer buffer;
+    JsonWriter(buffer).BeginObject().Field("error", static_cast<int>(code)).EndObject();
+    return boost::beast::buffers_to_string(buffer.data());
+}
+
+/// 静态初始化阶段 (main 之前) 完成序列化，之后只读；[0] 为 JSON，[1] 为 protobuf
+const std::array<std::array<std::string, kErrorCount>, 2> g_error_bodies = []()
+{
+    std::array<std::array<std::string, kErrorCount>, 2> bodies;
+    for (std::size_t i = 0; i < kErrorCount; ++i)
+    {
+        bodies[0][i] = Serialize(kErrorCodes[i], WireFormat::Json);
+        bodies[1][i] = Serialize(kErrorCodes[i], WireFormat::Protobuf);
+    }
+    return bodies;
+}();
+} // namespace
+
+std::string_view ErrorBody(ErrorCode code, WireFormat format)
+{
+    const auto &bodies = g_error_bodies[format == WireFormat::Protobuf ? 1 : 0];
+    for (std::size_t i = 0; i < kErrorCount; ++i)
+    {
+        if (kErrorCodes[i] == code)
+        {
+            return bodies[i];
+        }
+    }
+    // 新增错误码但忘了加进表里：退回即时序列化 (保持正确，只是慢一些)
+    thread_local std::string fallback;
+    fallback = Serialize(code, format);
+    return fallback;
+}
@@ -5,45 +5,93 @@
  * @author msr
  */
 
+#include "AsioIOServicePool.h"
 #include "CServer.h"
 #include "ConfigMgr.h"
+#include "HttpConnection.h"
+#include "HttpConnectionSlab.h"
+#include "JsonCodec.h"
+#include "Logger.h"
 #include "LogicSystem.h"
-#include <iostream>
+#include "RedisMgr.h"
+#include "VerifyCodeStore.h"
+#include "RequestTrace.h"
+#include "TrafficCapture.h"
+#include <algorithm>
 #include <jsoncpp/json/json.h>
 #include <jsoncpp/json/reader.h>
 #include <jsoncpp/json/value.h>
+#include <vector>
 
 /**
  * @brief 应用程序主入口
  * @return int 程序退出状态码
  * * @note 架构设计说明 (Architectural Notes):
  * 1. **IO 模型**: 采用 Proactor 模式 (Boost.Asio 默认模型)。
- * 2. **事件循环**: 单线程运行 `io_context::run()`，避免了多线程锁竞争，适合 CPU 密集度低的 IO 密集型场景。
+ * 2. **事件循环**: 主线程运行 `io_context::run()` 负责信号处理 (Single 模式下同时负责 Accept)，
+ *    连接的读写在 AsioIOServicePool 的 IO 线程上执行。
+ *    `[GateServer] AcceptMode = reuseport` 时每个 IO 线程各自 Accept，主线程不再参与连接建立。
  * 3. **信号处理**: 必须捕获 SIGINT/SIGTERM，否则 socket 可能会处于 TIME_WAIT 状态或导致资源泄漏。
  */
 int main()
 {
-    std::cout << "========================================" << std::endl;
-    std::cout << "GateServer Starting..." << std::endl;
-    std::cout << "========================================" << std::endl;
+    LOG_INFO("GateServer starting");
 
     auto &gCfgMgr = ConfigMgr::GetInstance();
+
+    // 日志: 级别、输出目标与每线程缓冲大小 (只影响之后才开始写日志的线程)
+    Logger::SetLevel(ParseLogLevel(gCfgMgr["Log"]["Level"]));
+    std::string log_file = gCfgMgr["Log"]["File"];
+    if (!Logger::SetOutput(log_file))
+    {
+        LOG_WARN("log file open failed, keep stdout").Field("file", log_file);
+    }
+    std::string log_ring_str = gCfgMgr["Log"]["RingSize"];
+    if (!log_ring_str.empty())
+    {
+        Logger::SetRingSize(static_cast<std::size_t>(std::max(0, atoi(log_ring_str.c_str()))));
+    }
+    std::string slow_ms_str = gCfgMgr["Log"]["SlowRequestMs"];
+    RequestTrace::SetSlowThreshold(
+        static_cast<std::uint64_t>(slow_ms_str.empty() ? 200 : std::max(0, atoi(slow_ms_str.c_str()))));
+    LOG_INFO("slow request log").Field("threshold_ms", RequestTrace::GetSlowThreshold());
+
+    // 请求录制: [Capture] File 为空时关闭
+    TrafficCapture::Options capture;
+    capture.path = gCfgMgr["Capture"]["File"];
+    if (!capture.path.empty())
+    {
+        capture.bodies = gCfgMgr["Capture"]["Bodies"] != "off";
+        std::string capture_buffer_str = gCfgMgr["Capture"]["BufferSize"];
+        if (!capture_buffer_str.empty())
+        {
+            capture.buffer_bytes = static_cast<std::size_t>(std::max(0, atoi(capture_buffer_str.c_str())));
+        }
+        if (TrafficCapture::Start(capture))
+        {
+            LOG_WARN("traffic capture on").Field("file", capture.path).Field("bodies", capture.bodies);
+        }
+        else
+        {
+            LOG_WARN("traffic capture file open failed").Field("file", capture.path);
+        }
+    }
     std::string gate_port_str = gCfgMgr["GateServer"]["Port"];
     unsigned short gate_port = atoi(gate_port_str.c_str());
     
     if (gate_port == 0)
     {
         gate_port = 8080;
-        std::cout << "[Warning] Config load failed or port invalid. Using default port: 8080" << std::endl;
+        LOG_WARN("config load failed or port invalid, using default").Field("port", gate_port);
     }
     else
     {
-        std::cout << "[Info] GateServer will listen on port: " << gate_port << std::endl;
+        LOG_INFO("GateServer will listen").Field("port", gate_port);
     }
 
     // 初始化 LogicSystem（触发路由注册）
     LogicSystem::GetInstance();
-    std::cout << "[Info] LogicSystem initialized, routes registered." << std::endl;
+    LOG_INFO("LogicSystem initialized, routes registered");
 
     try
     {
@@ -74,14 +122,88 @@ int main()
         });
 
 
+        // 初始化 IO 线程池 (读取 [IOPool] 拓扑) 并打印各 io_context 的运行位置
+        for (const auto &info : AsioIOServicePool::GetInstance()->GetContextInfo())
+        {
+            LOG_INFO("IOPool context")
+                .Field("index", info.index)
+                .Field("pinned_cpu", info.pinned_cpu)
+                .Field("running_cpu", info.start_cpu)
+                .Field("numa_node", info.numa_node);
+        }
+
+        // 在各 IO 线程上建立 Redis 连接；连不上时后台重连，不阻止启动
+        RedisMgr::GetInstance();
+        // 缓存注册校验脚本，之后注册只发 EVALSHA
+        VerifyCodeStore::GetInstance();
+
+        // 在各 IO 线程上预创建连接对象，使其内存落在该线程的 NUMA 节点上
+        std::string slab_prewarm_str = gCfgMgr["GateServer"]["ConnectionSlabPrewarm"];
+        std::size_t slab_prewarm = static_cast<std::size_t>(std::max(0, atoi(slab_prewarm_str.c_str())));
+        if (slab_prewarm > 0)
+        {
+            auto pool = AsioIOServicePool::GetInstance();
+            for (std::size_t i = 0; i < pool->Size(); ++i)
+            {
+                auto service = pool->GetIOService(i);
+                net::post(*service, [service, slab_prewarm]()
+                          { net::use_service<HttpConnectionSlab>(*service).Reserve(slab_prewarm); });
+            }
+        }
+
+        SessionEngine session_engine = ParseSessionEngine(gCfgMgr["GateServer"]["SessionEngine"]);
+        if (!HttpConnection::SetSessionEngine(session_engine))
+        {
+            LOG_WARN("SessionEngine coroutine not compiled in (GATE_COROUTINE_SESSION=OFF), fallback to callback");
+        }
+        LOG_INFO("SessionEngine")
+            .Field("engine",
+                   HttpConnection::GetSessionEngine() == SessionEngine::Coroutine ? "coroutine" : "callback");
+
+        JsonBackend json_backend = ParseJsonBackend(gCfgMgr["GateServer"]["JsonCodec"]);
+        if (!JsonDocument::SetBackend(json_backend))
+        {
+            LOG_WARN("JsonCodec simdjson not compiled in (simdjson not found), fallback to jsoncpp");
+        }
+        LOG_INFO("JsonCodec").Field("backend",
+                                    JsonDocument::GetBackend() == JsonBackend::Simdjson ? "simdjson" : "jsoncpp");
+
+        AcceptMode accept_mode = ParseAcceptMode(gCfgMgr["GateServer"]["AcceptMode"]);
+#ifndef SO_REUSEPORT
+        if (accept_mode == AcceptMode::ReusePort)
+        {
+            LOG_WARN("SO_REUSEPORT not supported, fallback to single acceptor");
+            accept_mode = AcceptMode::Single;
+        }
+#endif
+
         /**
          * @brief 创建服务器实例 (RAII)
          * @note 使用 shared_ptr 管理生命周期，引用计数 ref_count = 1。
+         * - Single:    一个 CServer 挂在主线程 ioc 上。
+         * - ReusePort: 每个 IO 上下文一个 CServer，监听同一端口。
          */
-        auto server = std::make_shared<CServer>(ioc, port);
-
-        // @brief 启动异步 Accept 链条 (The First Domino)
-        server->HandleAccept();
+        std::vector<std::shared_ptr<CServer>> servers;
+        if (accept_mode == AcceptMode::ReusePort)
+        {
+            auto pool = AsioIOServicePool::GetInstance();
+            for (std::size_t i = 0; i < pool->Size(); ++i)
+            {
+                auto server = std::make_shared<CServer>(*pool->GetIOService(i), port, AcceptMode::ReusePort);
+                // Acceptor 属于 IO 线程，投递过去启动，避免跨线程直接操作
+                net::post(*pool->GetIOService(i), [server]() { server->HandleAccept(); });
+                servers.push_back(server);
+            }
+            LOG_INFO("AcceptMode").Field("mode", "reuseport").Field("acceptors", servers.size());
+        }
+        else
+        {
+            auto server = std::make_shared<CServer>(ioc, port);
+            // @brief 启动异步 Accept 链条 (The First Domino)
+            server->HandleAccept();
+            servers.push_back(server);
+            LOG_INFO("AcceptMode").Field("mode", "single");
+        }
 
         /**
          * @brief 进入事件循环 (Event Loop)
@@ -91,10 +213,26 @@ int main()
          * 严禁在回调中使用 `sleep()` 或执行耗时计算，否则会阻塞整个服务器的网络吞吐。
          */
         ioc.run();
+
+        // Redis 连接挂在 IO 线程上，先在各线程上释放，再停 IO 线程池
+        RedisMgr::GetInstance()->Close();
+        // 先停掉 IO 线程，再析构挂在其上的 Acceptor
+        AsioIOServicePool::GetInstance()->Stop();
+        // IO 线程已退出，此时丢弃业务线程池中排队的请求不会与 IO 线程竞争连接对象
+        LogicSystem::GetInstance()->Stop();
+        // 不再有新请求，写出录制缓冲中剩余的请求
+        TrafficCapture::Stop();
+        LOG_INFO("traffic capture stopped")
+            .Field("captured", TrafficCapture::Captured())
+            .Field("dropped", TrafficCapture::Dropped());
+        // 所有写日志的线程都已停止，写出剩余日志；之后的日志 (静态对象析构) 同步写出
+        Logger::Shutdown();
     }
     catch (std::exception const &exp)
     {
-        std::cerr << "Error: " << exp.what() << std::endl;
+        LOG_ERROR("GateServer exit on exception").Field("what", exp.what());
+        TrafficCapture::Stop();
+        Logger::Shutdown();
         return EXIT_FAILURE;
     }
 }
\ No newline at end of file
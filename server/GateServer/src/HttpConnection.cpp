@@ -5,25 +5,191 @@
  */
 
 #include "HttpConnection.h"
+#include "ConfigMgr.h"
+#include "JsonCodec.h"
+#include "Logger.h"
 #include "LogicSystem.h"
-#include <iostream>
+#include "Metrics.h"
+#include "ResponseHeaderCache.h"
+#include "TrafficCapture.h"
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cctype>
+#include <charconv>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
 #include <string>
 #include <string_view>
 
+namespace
+{
+/// 复用连接时超过该容量的缓冲区释放掉，避免个别大请求让池里的对象长期占用内存
+constexpr std::size_t kMaxRetainedBuffer = 64 * 1024;
+
+/**
+ * @brief   空闲超时，读取 config.ini 的 `[GateServer] IdleTimeout` (秒)，默认 60
+ */
+std::chrono::seconds IdleTimeout()
+{
+    static const std::chrono::seconds timeout = []()
+    {
+        std::string configured = ConfigMgr::GetInstance()["GateServer"]["IdleTimeout"];
+        int seconds = configured.empty() ? 60 : std::atoi(configured.c_str());
+        return std::chrono::seconds(seconds > 0 ? seconds : 60);
+    }();
+    return timeout;
+}
+
+/**
+ * @brief   流水线深度：一次写回最多攒多少个响应，读取 `[GateServer] PipelineDepth`，默认 16，1 = 关闭
+ */
+std::size_t PipelineDepth()
+{
+    static const std::size_t depth = []()
+    {
+        std::string configured = ConfigMgr::GetInstance()["GateServer"]["PipelineDepth"];
+        int value = configured.empty() ? 16 : std::atoi(configured.c_str());
+        return static_cast<std::size_t>(std::max(1, value));
+    }();
+    return depth;
+}
+
+std::atomic<SessionEngine> g_session_engine{SessionEngine::Callback};
+
+net::io_context &ContextOf(tcp::socket &socket)
+{
+    return static_cast<net::io_context &>(net::query(socket.get_executor(), net::execution::context));
+}
+} // namespace
+
+SessionEngine ParseSessionEngine(const std::string &name)
+{
+    std::string lower(name);
+    std::transform(lower.begin(), lower.end(), lower.begin(), [](unsigned char c) { return std::tolower(c); });
+    return (lower == "coroutine") ? SessionEngine::Coroutine : SessionEngine::Callback;
+}
+
+bool HttpConnection::SetSessionEngine(SessionEngine engine)
+{
+#ifndef GATE_HAVE_COROUTINES
+    if (engine == SessionEngine::Coroutine)
+    {
+        return false;
+    }
+#endif
+    g_session_engine.store(engine, std::memory_order_relaxed);
+    return true;
+}
+
+SessionEngine HttpConnection::GetSessionEngine()
+{
+    return g_session_engine.load(std::memory_order_relaxed);
+}
+
 HttpConnection::HttpConnection(tcp::socket &&socket)
-    : _socket(std::move(socket))
+    : _socket(std::move(socket)),
+      _idle_timer(net::use_service<TimingWheel>(ContextOf(_socket)), [this]() { OnIdleTimeout(); })
+{
+}
+
+HttpConnection::HttpConnection(net::io_context &ioc)
+    : _socket(ioc),
+      _idle_timer(net::use_service<TimingWheel>(ioc), [this]() { OnIdleTimeout(); })
+{
+}
+
+tcp::socket &HttpConnection::Socket()
+{
+    return _socket;
+}
+
+HandlerMemory &HttpConnection::AcceptHandlerMemory()
+{
+    return _accept_memory;
+}
+
+void HttpConnection::Reset()
+{
+    beast::error_code ec;
+    _socket.close(ec);
+    _idle_timer.Cancel();
+#ifdef GATE_HAVE_COROUTINES
+    _coroutine = false;
+    _response_ready = false;
+#endif
+
+    _buffer.clear();
+    if (_buffer.capacity() > kMaxRetainedBuffer)
+    {
+        _buffer.shrink_to_fit();
+    }
+    _out.clear();
+    if (_out.capacity() > kMaxRetainedBuffer)
+    {
+        _out.shrink_to_fit();
+    }
+    _pipelined = 0;
+    _close_after_write = false;
+    ResetMessages();
+    _get_url = std::string_view();
+}
+
+void HttpConnection::ResetMessages()
 {
+    _request.clear();
+    _request.body().clear();
+    if (_request.body().capacity() > kMaxRetainedBuffer)
+    {
+        _request.body().shrink_to_fit();
+    }
+    ResetResponse();
+}
+
+void HttpConnection::ResetResponse()
+{
+    _response.clear();
+    _response.body().clear();
+    _response.result(http::status::ok);
+    _get_params.Clear();
+    _get_params.ShrinkTo(kMaxRetainedBuffer);
+    _path_params.Clear();
+    _head.clear();
+    _head_template = nullptr;
+    if (_response.body().capacity() > kMaxRetainedBuffer)
+    {
+        _response.body().shrink_to_fit();
+    }
 }
 
 void HttpConnection::Start()
 {
-    auto self = shared_from_this();
+    // [Pipelining] 一批请求被读取边界截断时，前后两次写回背靠背发出；
+    // 关闭 Nagle，否则第二次写要等对端对第一次的延迟 ACK (约 40ms)
+    beast::error_code ec;
+    _socket.set_option(tcp::no_delay(true), ec);
 
-    // [Heartbeat] 更新超时时间：倒计时60秒(此时还没开始计时)
-    deadline_.expires_after(std::chrono::seconds(60));
+#ifdef GATE_HAVE_COROUTINES
+    if (GetSessionEngine() == SessionEngine::Coroutine)
+    {
+        _coroutine = true;
+        net::co_spawn(_socket.get_executor(), CoroutineSession(shared_from_this()), net::detached);
+        return;
+    }
+#endif
+    ReadRequest();
+}
+
+void HttpConnection::ReadRequest()
+{
+    auto self = shared_from_this();
 
-    // 启动/检测超时定时器
-    self->CheckDeadline();
+    // [Heartbeat] 重新 Arm 空闲超时：已挂在时间轮上时直接移到新的 slot，不产生被取消的 handler
+    _idle_timer.Arm(IdleTimeout());
+    // [Pipelining] 每次 read_some 最多读 capacity - size 字节：一次预留到上限，连发的一批请求一次读进来，
+    // 否则缓冲区只按需增长，一批请求会被截成多次读取与多次写回。连接对象复用时容量保留，只分配一次
+    _buffer.reserve(_buffer.max_size());
 
     /**
      * @brief 异步读取并解析 HTTP 请求
@@ -44,14 +210,15 @@ void HttpConnection::Start()
                 if (ec)
                 {
                     // EOF (End of File) 表示对端关闭了连接，是正常流程
-                    std::cout << "http read is" << ec.what() << std::endl;
+                    LOG_DEBUG("http read end").Field("reason", ec.message());
+                    self->_idle_timer.Cancel();
                     return;
                 }
                 self->HandleRequest();
             }
             catch (std::exception &exp)
             {
-                std::cout << "exception is" << exp.what() << std::endl;
+                LOG_ERROR("session exception").Field("what", exp.what());
                 return;
             }
         });
@@ -59,9 +226,17 @@ void HttpConnection::Start()
 
 void HttpConnection::HandleRequest()
 {
-    // 打印请求信息（调试用）
-    std::cout << "[HTTP Request] Method: " << _request.method_string() << ", Target: " << _request.target()
-              << std::endl;
+    _request_start = Metrics::Now();
+    _trace.Begin(_request_start);
+    if (TrafficCapture::Enabled())
+    {
+        const auto &body = _request.body();
+        TrafficCapture::Record(_request, std::string_view(static_cast<const char *>(body.data().data()), body.size()));
+    }
+    LOG_DEBUG("http request")
+        .Field("req", _trace.Id())
+        .Field("method", _request.method_string())
+        .Field("target", _request.target());
 
     // [Protocol Compliance]
     // 设置 HTTP 版本 (1.0 或 1.1)
@@ -70,153 +245,259 @@ void HttpConnection::HandleRequest()
     bool keep_alive = _request.keep_alive();
     _response.keep_alive(keep_alive);
 
-    if (_request.method() == http::verb::get)
+    PreParseGetParam();
+    // simdjson 需要 Body 之后有可读的 padding，在这里预留即可原地解析
+    JsonDocument::ReservePadding(_request.body());
+
+    // [Routing] 路由分发：路径与方法在同一棵前缀树里匹配
+    // 找到路由时由 LogicSystem 在 Handler 完成后调用 CompleteResponse()
+    switch (LogicSystem::GetInstance()->Handle(_request.method(), _get_url, shared_from_this()))
     {
-        PreParseGetParam();
-        std::cout << "[Routing] GET request to: " << _get_url << std::endl;
-        // [Routing] 路由分发
-        bool success = LogicSystem::GetInstance()->HandleGet(_get_url, shared_from_this());
-        if (!success)
-        {
-            std::cout << "[Routing] Route not found: " << _get_url << std::endl;
-            _response.result(http::status::not_found);
-            _response.set(http::field::content_type, "text/plain");
-            beast::ostream(_response.body()) << "url not found \r\n";
-            WriteResponse();
-            return;
-        }
-        _response.result(http::status::ok);
-        _response.set(http::field::server, "GateServer");
-        WriteResponse();
+    case Router::Result::Found:
         return;
+    case Router::Result::NotFound:
+        LOG_DEBUG("route not found").Field("path", _get_url);
+        _response.result(http::status::not_found);
+        _response.set(http::field::content_type, "text/plain");
+        beast::ostream(_response.body()) << "url not found\r\n";
+        break;
+    case Router::Result::MethodNotAllowed:
+        // 协程引擎会一直等待本次请求的响应，因此必须回一个响应
+        _response.result(http::status::method_not_allowed);
+        _response.set(http::field::content_type, "text/plain");
+        beast::ostream(_response.body()) << "method not allowed\r\n";
+        break;
     }
+    SendResponse();
+}
 
-    if (_request.method() == http::verb::post)
+void HttpConnection::CompleteResponse()
+{
+    _response.set(http::field::server, "GateServer");
+    SendResponse();
+}
+
+void HttpConnection::SendResponse()
+{
+    std::uint64_t now = Metrics::Now();
+    _trace.Finish(_request.method_string(), _request.target(), _response.result_int(), now);
+    if (_metrics != nullptr)
     {
-        std::cout << "[Routing] POST request to: " << _request.target() << std::endl;
-        bool success = LogicSystem::GetInstance()->HandlePost(_request.target(), shared_from_this());
-        if (!success)
+        _metrics->Record(_response.result_int(), now - _request_start);
+        _metrics = nullptr;
+    }
+#ifdef GATE_HAVE_COROUTINES
+    if (_coroutine)
+    {
+        _response_ready = true;
+        _response_signal.cancel();
+        return;
+    }
+#endif
+    bool keep_alive = _response.keep_alive();
+
+    // [Pipelining] 客户端连发的请求已经在 _buffer 里：当前响应拷进 _out，直接处理下一个，最后一起写
+    // Handler 同步完成时会经 CompleteResponse() 重入这里，重入深度不超过 PipelineDepth
+    if (keep_alive && _pipelined + 1 < PipelineDepth() && ParseBuffered(_buffer))
+    {
+        AppendResponse();
+        ++_pipelined;
+        HandleRequest();
+        return;
+    }
+
+    _close_after_write = !keep_alive;
+    WriteResponse();
+}
+
+void HttpConnection::RenderHead()
+{
+    _head.clear();
+    std::size_t length = _response.body().size();
+    _head_template = ResponseHeaderCache::Lookup(_response.base(), _response.keep_alive());
+    if (_head_template != nullptr)
+    {
+        // 模板以 "Content-Length: " 结尾，这里只补长度与头部结束的空行
+        char digits[24];
+        std::size_t n = static_cast<std::size_t>(std::to_chars(digits, digits + sizeof(digits), length).ptr - digits);
+        auto out = _head.prepare(n + 4);
+        std::memcpy(out.data(), digits, n);
+        std::memcpy(static_cast<char *>(out.data()) + n, "\r\n\r\n", 4);
+        _head.commit(n + 4);
+        return;
+    }
+
+    // 含模板之外的字段：走 Beast 通用序列化
+    // 必须显式设置 Content-Length，否则客户端可能不知道响应何时结束
+    _response.content_length(length);
+    beast::ostream(_head) << _response.base();
+}
+
+std::array<net::const_buffer, 4> HttpConnection::ResponseBuffers() const
+{
+    net::const_buffer prefix;
+    if (_head_template != nullptr)
+    {
+        prefix = net::buffer(*_head_template);
+    }
+    return {_out.data(), prefix, _head.data(), _response.body().data()};
+}
+
+void HttpConnection::AppendResponse()
+{
+    RenderHead();
+    auto buffers = ResponseBuffers();
+    // buffers[0] 是 _out 本身，只追加模板、Content-Length 与 Body
+    for (std::size_t i = 1; i < buffers.size(); ++i)
+    {
+        _out.commit(net::buffer_copy(_out.prepare(buffers[i].size()), buffers[i]));
+    }
+    ResetResponse();
+}
+
+bool HttpConnection::ParseBuffered(beast::flat_buffer &buffer)
+{
+    if (buffer.size() == 0)
+    {
+        return false;
+    }
+
+    // 只在缓冲区里已经有一个完整请求时才取出；不完整或格式错误都交给 async_read 按正常流程处理。
+    // 解析器接管 _request (连同 Body 已有的容量)，结束后移回，与 async_read 一样复用同一块缓冲
+    _request.clear();
+    _request.body().clear();
+    http::request_parser<HttpBody> parser(std::move(_request));
+    beast::error_code ec;
+    const char *data = static_cast<const char *>(buffer.data().data());
+    std::size_t size = buffer.size();
+    std::size_t used = 0;
+    while (!parser.is_done())
+    {
+        std::size_t n = parser.put(net::buffer(data + used, size - used), ec);
+        used += n;
+        if (ec || n == 0)
         {
-            std::cout << "[Routing] Route not found: " << _request.target() << std::endl;
-            _response.result(http::status::not_found);
-            _response.set(http::field::content_type, "text/plain");
-            beast::ostream(_response.body()) << "url not found\r\n";
-            WriteResponse();
-            return;
+            break;
         }
+    }
 
-        _response.result(http::status::ok);
-        _response.set(http::field::server, "GateServer");
-        WriteResponse();
-        return;
+    bool done = parser.is_done();
+    _request = parser.release();
+    if (!done)
+    {
+        _request.clear();
+        _request.body().clear();
+        return false;
     }
+    buffer.consume(used);
+    return true;
 }
 
 void HttpConnection::WriteResponse()
 {
     auto self = shared_from_this();
-    // 必须显式设置 Content-Length，否则客户端可能不知道响应何时结束
-    _response.content_length(_response.body().size());
+    RenderHead();
 
     /**
      * @brief 异步写回响应
-     * @details 将用户态 buffer 的数据拷贝到内核态 socket 发送缓冲区。
+     * @details
+     * Scatter-Gather (writev)：流水线中之前攒下的响应 (_out)、头部模板、Content-Length 与 Body 四段一次写出，
+     * 最后一个响应的 Body 不经过任何拷贝。
      */
-    http::async_write(
-        _socket, _response,
+    net::async_write(
+        _socket, ResponseBuffers(),
         [self](beast::error_code ec, std::size_t)
         {
+            self->_out.consume(self->_out.size());
+            self->_pipelined = 0;
+            self->ResetMessages();
             if (ec)
             {
-                // 发送失败，关闭连接
+                // 发送失败，关闭连接；同时摘下空闲定时器，时间轮不会再对已关闭 (或已回收) 的连接触发
                 self->_socket.shutdown(tcp::socket::shutdown_send, ec);
-                std::cout << "socket shutdown" << std::endl;
+                LOG_DEBUG("socket shutdown");
+                self->_idle_timer.Cancel();
                 return;
             }
 
             // [Keep-Alive Handling]
-            // 如果协议支持长连接，则清空 Request/Response 对象，递归调用 ReadRequest 等待下一个请求。
+            // 如果协议支持长连接，递归调用 ReadRequest 等待下一个请求。
             // 否则，主动关闭连接。
-            if (self->_response.keep_alive())
+            if (!self->_close_after_write)
             {
-                self->_request = {};
-                self->_response = {};
-                self->Start();
+                self->ReadRequest();
             }
             else
             {
                 self->_socket.shutdown(tcp::socket::shutdown_send, ec);
-                std::cout << "socket shutdown" << std::endl;
-                self->deadline_.cancel();
+                LOG_DEBUG("socket shutdown");
+                self->_idle_timer.Cancel();
             }
         });
 }
 
-void HttpConnection::CheckDeadline()
+#ifdef GATE_HAVE_COROUTINES
+// self 只是保活: 协程帧持有这份引用，会话结束、帧销毁前连接不会被回收
+net::awaitable<void> HttpConnection::CoroutineSession([[maybe_unused]] std::shared_ptr<HttpConnection> self)
 {
-    auto self = shared_from_this();
+    beast::flat_buffer buffer{8192};
+    buffer.reserve(buffer.max_size()); // 与 ReadRequest 相同，让一批流水线请求一次读进来
+    beast::error_code ec;
 
-    /**
-     * @brief 异步等待定时器
-     * @details
-     * - 情况1: 超时。ec == 0。调用 close() 关闭 socket。
-     * - 情况2: 定时器被取消 (cancel)。ec == operation_aborted。什么都不做。
-     * - 情况3: 定时器重新设置 (expires_after)。也会触发 operation_aborted。
-     */
-    deadline_.async_wait(
-        [self](beast::error_code ec)
+    for (;;)
+    {
+        // 与回调版一致：每个请求开始读取时重新 Arm；超时回调关闭 socket，挂起的 co_await 以错误返回
+        _idle_timer.Arm(IdleTimeout());
+        co_await http::async_read(_socket, buffer, _request, net::redirect_error(net::use_awaitable, ec));
+        if (ec)
+        {
+            LOG_DEBUG("http read end").Field("reason", ec.message());
+            break;
+        }
+
+        // [Pipelining] 逐个处理缓冲区里已完整的请求，之前的响应攒到 _out，最后一起写
+        bool keep_alive = true;
+        std::size_t batched = 0;
+        for (;;)
         {
-            if (!ec)
+            _response_ready = false;
+            HandleRequest();
+            if (!_response_ready)
             {
-                // 真正的超时发生了，硬关闭 Socket
-                // 这会导致任何正在进行的 read/write 操作立即返回 error，从而中断连接
-                std::cout << "socket close" << std::endl;
-                self->_socket.close();
+                // Handler 在线程池或异步回调中完成，等待 SendResponse() 唤醒
+                _response_signal.expires_at(net::steady_timer::time_point::max());
+                co_await _response_signal.async_wait(net::redirect_error(net::use_awaitable, ec));
             }
-        });
-}
-
-// 这是一个标准的 URL 解码函数，能处理 %20 和 + 号
-unsigned char ToHex(unsigned char x)
-{
-    return x > 9 ? x + 55 : x + 48;
-}
-
-unsigned char FromHex(unsigned char x)
-{
-    unsigned char y;
-    if (x >= 'A' && x <= 'Z')
-        y = x - 'A' + 10;
-    else if (x >= 'a' && x <= 'z')
-        y = x - 'a' + 10;
-    else if (x >= '0' && x <= '9')
-        y = x - '0';
-    else
-        assert(0);
-    return y;
-}
+            keep_alive = _response.keep_alive();
+            if (!keep_alive || ++batched >= PipelineDepth() || !ParseBuffered(buffer))
+            {
+                break;
+            }
+            AppendResponse();
+        }
 
-std::string UrlDecode(const std::string &str)
-{
-    std::string strTemp = "";
-    size_t length = str.length();
-    for (size_t i = 0; i < length; i++)
-    {
-        // 处理 + 号为空格的情况（视标准而定，有时候需要，有时候不需要，通常保留比较安全）
-        if (str[i] == '+')
-            strTemp += ' ';
-        // 处理 %xx 格式
-        else if (str[i] == '%')
+        RenderHead();
+        co_await net::async_write(_socket, ResponseBuffers(), net::redirect_error(net::use_awaitable, ec));
+        _out.consume(_out.size());
+        ResetMessages();
+        if (ec || !keep_alive)
         {
-            assert(i + 2 < length);
-            unsigned char high = FromHex((unsigned char)str[++i]);
-            unsigned char low = FromHex((unsigned char)str[++i]);
-            strTemp += high * 16 + low;
+            _socket.shutdown(tcp::socket::shutdown_send, ec);
+            LOG_DEBUG("socket shutdown");
+            break;
         }
-        else
-            strTemp += str[i];
     }
-    return strTemp;
+    _idle_timer.Cancel();
+}
+#endif
+
+void HttpConnection::OnIdleTimeout()
+{
+    // 真正的超时发生了，硬关闭 Socket
+    // 这会导致任何正在进行的 read/write 操作立即返回 error，从而中断连接
+    LOG_DEBUG("idle timeout, socket close");
+    beast::error_code ec;
+    _socket.close(ec);
 }
 
 void HttpConnection::PreParseGetParam()
@@ -224,51 +505,14 @@ void HttpConnection::PreParseGetParam()
     // 1. 使用 string_view 避免拷贝
     std::string_view uri = _request.target(); // Beast 也是返回 string_view
 
-    // 2. 查找 ?
+    // 2. 查找 ?，路径直接引用 target()，_request 在本次请求处理期间不会变化
     auto query_pos = uri.find('?');
-    if (query_pos == std::string_view::npos)
+    _get_url = uri.substr(0, query_pos);
+    if (query_pos == std::string_view::npos || _request.method() != http::verb::get)
     {
-        _get_url = std::string(uri); // 这里必须拷贝，因为 _get_url 拥有所有权
         return;
     }
 
-    _get_url = std::string(uri.substr(0, query_pos));
-
-    // 获取参数部分视图
-    std::string_view query_string = uri.substr(query_pos + 1);
-
-    // 3. 零拷贝切割 loop
-    while (!query_string.empty())
-    {
-        // 找 &
-        auto amp_pos = query_string.find('&');
-
-        // 拿到当前的 kv 段 (例如 "id=1")
-        // 如果找不到 &，说明是最后一段
-        auto segment = (amp_pos == std::string_view::npos) ? query_string : query_string.substr(0, amp_pos);
-
-        // 找 =
-        auto eq_pos = segment.find('=');
-        if (eq_pos != std::string_view::npos)
-        {
-            // 拿到 key 和 value 的视图 (还在原始 buffer 里，没发生拷贝)
-            auto key_view = segment.substr(0, eq_pos);
-            auto val_view = segment.substr(eq_pos + 1);
-
-            // 只有在最后存入 Map 且需要解码时，才真正发生拷贝和内存分配
-            // 假设 UrlDecode 接收 string_view 返回 string
-            _get_params[UrlDecode(std::string(key_view))] = UrlDecode(std::string(val_view));
-        }
-
-        // 移动视图窗口，而不是移动内存 (erase)
-        if (amp_pos == std::string_view::npos)
-        {
-            break;
-        }
-        else
-        {
-            // 指针向后跳，O(1) 操作
-            query_string.remove_prefix(amp_pos + 1);
-        }
-    }
+    // 3. 键值以 string_view 保存，只有含 %xx / '+' 的键值解码到 _get_params 的 Arena
+    _get_params.Parse(uri.substr(query_pos + 1));
 }
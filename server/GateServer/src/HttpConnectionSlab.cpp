@@ -0,0 +1,299 @@
+/**
+ * @file    HttpConnectionSlab.cpp
+ * @brief   HttpConnection 对象池实现
+ * @author  msr
+ */
+
+#include "HttpConnectionSlab.h"
+#include "ConfigMgr.h"
+#include "HttpConnection.h"
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <mutex>
+#include <new>
+#include <string>
+#include <vector>
+
+net::execution_context::id HttpConnectionSlab::id;
+
+/**
+ * @struct  HttpConnectionSlab::State
+ * @brief   空闲链表 + 控制块定长块链表
+ */
+struct HttpConnectionSlab::State
+{
+    State(net::io_context &ioc_, std::size_t capacity_)
+        : ioc(ioc_),
+          capacity(capacity_)
+    {
+        // 预留容量，稳态下 push_back 不会触发扩容
+        free_list.reserve(capacity);
+        blocks.reserve(capacity + 1);
+    }
+
+    ~State()
+    {
+        for (void *block : blocks)
+        {
+            ::operator delete(block);
+        }
+    }
+
+    /**
+     * @brief   Deleter 回调：引用计数归零时清空连接并放回空闲链表
+     */
+    void Recycle(HttpConnection *conn)
+    {
+        conn->Reset();
+        {
+            std::lock_guard<std::mutex> lock(mtx);
+            if (!stopped && free_list.size() < capacity)
+            {
+                free_list.push_back(conn);
+                recycled.fetch_add(1, std::memory_order_relaxed);
+                return;
+            }
+        }
+        destroyed.fetch_add(1, std::memory_order_relaxed);
+        delete conn;
+    }
+
+    bool Stopped()
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        return stopped;
+    }
+
+    /**
+     * @brief   shared_ptr 控制块分配：同一类型的控制块大小固定，按定长块复用
+     */
+    void *AllocateBlock(std::size_t size)
+    {
+        {
+            std::lock_guard<std::mutex> lock(mtx);
+            if (size == block_size && !blocks.empty())
+            {
+                void *block = blocks.back();
+                blocks.pop_back();
+                return block;
+            }
+        }
+        return ::operator new(size);
+    }
+
+    void DeallocateBlock(void *block, std::size_t size)
+    {
+        {
+            std::lock_guard<std::mutex> lock(mtx);
+            if (block_size == 0)
+            {
+                block_size = size;
+            }
+            if (size == block_size && blocks.size() <= capacity)
+            {
+                blocks.push_back(block);
+                return;
+            }
+        }
+        ::operator delete(block);
+    }
+
+    net::io_context &ioc;
+    std::size_t capacity;
+    bool stopped = false;
+    std::mutex mtx;
+    std::vector<HttpConnection *> free_list;
+    std::vector<void *> blocks;
+    std::size_t block_size = 0;
+
+    std::atomic<std::uint64_t> created{0};
+    std::atomic<std::uint64_t> reused{0};
+    std::atomic<std::uint64_t> recycled{0};
+    std::atomic<std::uint64_t> destroyed{0};
+};
+
+/**
+ * @brief   引用计数归零时回收而不是析构
+ *
+ * @details
+ * 最后一个引用可能在 Worker 线程 (Handler 任务析构) 或主线程 (WorkerPool::Stop 丢弃排队任务) 上释放，
+ * 而 Reset() 会关闭 socket、从本 io_context 的时间轮上摘下定时器，只能在该 io_context 的线程上执行：
+ * 不在其线程上时投递过去。投递的 Handler 未执行就被销毁 (io_context 停止) 时同样回收，不会泄漏。
+ */
+struct HttpConnectionSlab::Deleter
+{
+    std::shared_ptr<State> state;
+
+    void operator()(HttpConnection *conn) const
+    {
+        if (state->ioc.get_executor().running_in_this_thread() || state->Stopped())
+        {
+            state->Recycle(conn);
+            return;
+        }
+        net::post(state->ioc, [pending = Pending(conn, Recycler{state})]() mutable { pending.reset(); });
+    }
+
+private:
+    struct Recycler
+    {
+        std::shared_ptr<State> state;
+
+        void operator()(HttpConnection *conn) const
+        {
+            state->Recycle(conn);
+        }
+    };
+    using Pending = std::unique_ptr<HttpConnection, Recycler>;
+};
+
+/**
+ * @brief   控制块分配器，持有 State 保证释放控制块时池仍然有效
+ */
+template <typename T>
+struct HttpConnectionSlab::ControlBlockAllocator
+{
+    using value_type = T;
+
+    explicit ControlBlockAllocator(std::shared_ptr<State> s)
+        : state(std::move(s))
+    {
+    }
+
+    template <typename U>
+    ControlBlockAllocator(const ControlBlockAllocator<U> &other)
+        : state(other.state)
+    {
+    }
+
+    T *allocate(std::size_t n)
+    {
+        return static_cast<T *>(state->AllocateBlock(sizeof(T) * n));
+    }
+
+    void deallocate(T *p, std::size_t n)
+    {
+        state->DeallocateBlock(p, sizeof(T) * n);
+    }
+
+    template <typename U>
+    bool operator==(const ControlBlockAllocator<U> &other) const
+    {
+        return state == other.state;
+    }
+
+    template <typename U>
+    bool operator!=(const ControlBlockAllocator<U> &other) const
+    {
+        return state != other.state;
+    }
+
+    std::shared_ptr<State> state;
+};
+
+HttpConnectionSlab::HttpConnectionSlab(net::execution_context &ctx)
+    : net::execution_context::service(ctx)
+{
+    std::size_t capacity = 1024;
+    std::string configured = ConfigMgr::GetInstance()["GateServer"]["ConnectionSlab"];
+    if (!configured.empty())
+    {
+        capacity = static_cast<std::size_t>(std::max(0, std::atoi(configured.c_str())));
+    }
+    _state = std::make_shared<State>(static_cast<net::io_context &>(ctx), capacity);
+}
+
+HttpConnectionSlab::~HttpConnectionSlab() = default;
+
+std::shared_ptr<HttpConnection> HttpConnectionSlab::Acquire()
+{
+    HttpConnection *conn = nullptr;
+    {
+        std::lock_guard<std::mutex> lock(_state->mtx);
+        // LIFO: 最近归还的对象缓存最热
+        if (!_state->free_list.empty())
+        {
+            conn = _state->free_list.back();
+            _state->free_list.pop_back();
+        }
+    }
+
+    if (conn != nullptr)
+    {
+        _state->reused.fetch_add(1, std::memory_order_relaxed);
+    }
+    else
+    {
+        conn = new HttpConnection(_state->ioc);
+        _state->created.fetch_add(1, std::memory_order_relaxed);
+    }
+    // 不能在持锁时构造：重新绑定 weak_this 会释放旧控制块，DeallocateBlock 需要再次加锁
+    return std::shared_ptr<HttpConnection>(conn, Deleter{_state}, ControlBlockAllocator<HttpConnection>(_state));
+}
+
+void HttpConnectionSlab::Reserve(std::size_t count)
+{
+    std::vector<HttpConnection *> fresh;
+    {
+        std::lock_guard<std::mutex> lock(_state->mtx);
+        std::size_t room = _state->capacity - std::min(_state->capacity, _state->free_list.size());
+        count = std::min(count, room);
+    }
+    for (std::size_t i = 0; i < count; ++i)
+    {
+        fresh.push_back(new HttpConnection(_state->ioc));
+    }
+    _state->created.fetch_add(count, std::memory_order_relaxed);
+
+    std::lock_guard<std::mutex> lock(_state->mtx);
+    _state->free_list.insert(_state->free_list.end(), fresh.begin(), fresh.end());
+}
+
+void HttpConnectionSlab::SetCapacity(std::size_t capacity)
+{
+    std::vector<HttpConnection *> evicted;
+    {
+        std::lock_guard<std::mutex> lock(_state->mtx);
+        _state->capacity = capacity;
+        _state->free_list.reserve(capacity);
+        _state->blocks.reserve(capacity + 1);
+        while (_state->free_list.size() > capacity)
+        {
+            evicted.push_back(_state->free_list.back());
+            _state->free_list.pop_back();
+        }
+    }
+    _state->destroyed.fetch_add(evicted.size(), std::memory_order_relaxed);
+    for (HttpConnection *conn : evicted)
+    {
+        delete conn;
+    }
+}
+
+HttpConnectionSlab::Stats HttpConnectionSlab::GetStats() const
+{
+    Stats stats;
+    stats.created = _state->created.load(std::memory_order_relaxed);
+    stats.reused = _state->reused.load(std::memory_order_relaxed);
+    stats.recycled = _state->recycled.load(std::memory_order_relaxed);
+    stats.destroyed = _state->destroyed.load(std::memory_order_relaxed);
+    std::lock_guard<std::mutex> lock(_state->mtx);
+    stats.cached = _state->free_list.size();
+    return stats;
+}
+
+void HttpConnectionSlab::shutdown()
+{
+    // io_context 析构前调用：此后归还的连接直接 delete
+    std::vector<HttpConnection *> cached;
+    {
+        std::lock_guard<std::mutex> lock(_state->mtx);
+        _state->stopped = true;
+        cached.swap(_state->free_list);
+    }
+    for (HttpConnection *conn : cached)
+    {
+        delete conn;
+    }
+}
@@ -0,0 +1,112 @@
+/**
+ * @file    HttpResponder.cpp
+ * @brief   异步 Handler 的响应句柄实现
+ * @author  msr
+ */
+
+#include "HttpResponder.h"
+#include "Logger.h"
+#include <utility>
+
+/**
+ * @struct  HttpResponder::State
+ * @brief   所有拷贝共享的完成状态
+ */
+struct HttpResponder::State
+{
+    explicit State(std::shared_ptr<HttpConnection> conn)
+        : connection(std::move(conn))
+    {
+    }
+
+    ~State()
+    {
+        if (!done.exchange(true))
+        {
+            LOG_ERROR("handler dropped request without response").Field("target", connection->_request.target());
+            Complete(http::status::internal_server_error, "handler did not respond\r\n");
+        }
+    }
+
+    /**
+     * @brief   投递到 IO 线程写回；status 非 ok 时先改写为错误响应
+     */
+    void Complete(http::status status, const std::string &message)
+    {
+        auto conn = connection;
+        bool failed = (status != http::status::ok);
+        // 此后本线程上结束的 Span 不再写入，由 IO 线程 Finish()
+        RequestTrace::Detach(&conn->_trace);
+        net::dispatch(conn->_socket.get_executor(),
+                      [conn, failed, status, message]()
+                      {
+                          if (failed)
+                          {
+                              conn->_response.result(status);
+                              conn->_response.set(http::field::content_type, "text/plain");
+                              conn->_response.body().clear();
+                              beast::ostream(conn->_response.body()) << message;
+                          }
+                          conn->CompleteResponse();
+                      });
+    }
+
+    std::shared_ptr<HttpConnection> connection;
+    std::atomic<bool> done{false};
+};
+
+HttpResponder::HttpResponder(std::shared_ptr<HttpConnection> connection)
+    : _state(std::make_shared<State>(std::move(connection)))
+{
+}
+
+const http::request<HttpBody> &HttpResponder::Request() const
+{
+    return _state->connection->_request;
+}
+
+const QueryParams &HttpResponder::GetParams() const
+{
+    return _state->connection->_get_params;
+}
+
+std::string_view HttpResponder::PathParam(std::string_view name) const
+{
+    return _state->connection->_path_params.Get(name);
+}
+
+http::response<HttpBody> &HttpResponder::Response() const
+{
+    return _state->connection->_response;
+}
+
+net::any_io_executor HttpResponder::GetExecutor() const
+{
+    return _state->connection->_socket.get_executor();
+}
+
+void HttpResponder::Send() const
+{
+    if (!_state->done.exchange(true))
+    {
+        _state->Complete(http::status::ok, std::string());
+    }
+}
+
+void HttpResponder::Fail(http::status status, const std::string &message) const
+{
+    if (!_state->done.exchange(true))
+    {
+        _state->Complete(status, message);
+    }
+}
+
+bool HttpResponder::Done() const
+{
+    return _state->done.load();
+}
+
+const std::shared_ptr<HttpConnection> &HttpResponder::Connection() const
+{
+    return _state->connection;
+}
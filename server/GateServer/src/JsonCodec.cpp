@@ -0,0 +1,399 @@
+/**
+ * @file    JsonCodec.cpp
+ * @brief   JSON 编解码层实现
+ * @author  msr
+ */
+
+#include "JsonCodec.h"
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <charconv>
+#include <cstring>
+#include <jsoncpp/json/json.h>
+#include <memory>
+
+#ifdef GATE_HAVE_SIMDJSON
+#include <simdjson.h>
+static_assert(JsonDocument::kPadding >= simdjson::SIMDJSON_PADDING, "JsonDocument::kPadding too small for simdjson");
+#endif
+
+namespace
+{
+#ifdef GATE_HAVE_SIMDJSON
+std::atomic<JsonBackend> g_json_backend{JsonBackend::Simdjson};
+#else
+std::atomic<JsonBackend> g_json_backend{JsonBackend::JsonCpp};
+#endif
+
+/**
+ * @brief   每个线程复用一个 CharReader，避免每次解析都 new
+ */
+Json::CharReader &ThreadJsonReader()
+{
+    thread_local std::unique_ptr<Json::CharReader> reader = []()
+    {
+        Json::CharReaderBuilder builder;
+        builder["collectComments"] = false;
+        return std::unique_ptr<Json::CharReader>(builder.newCharReader());
+    }();
+    return *reader;
+}
+} // namespace
+
+JsonBackend ParseJsonBackend(const std::string &name)
+{
+    std::string lower(name);
+    std::transform(lower.begin(), lower.end(), lower.begin(), [](unsigned char c) { return std::tolower(c); });
+    if (lower == "jsoncpp")
+    {
+        return JsonBackend::JsonCpp;
+    }
+#ifdef GATE_HAVE_SIMDJSON
+    return JsonBackend::Simdjson;
+#else
+    return (lower == "simdjson") ? JsonBackend::Simdjson : JsonBackend::JsonCpp;
+#endif
+}
+
+bool JsonDocument::SetBackend(JsonBackend backend)
+{
+#ifndef GATE_HAVE_SIMDJSON
+    if (backend == JsonBackend::Simdjson)
+    {
+        return false;
+    }
+#endif
+    g_json_backend.store(backend, std::memory_order_relaxed);
+    return true;
+}
+
+JsonBackend JsonDocument::GetBackend()
+{
+    return g_json_backend.load(std::memory_order_relaxed);
+}
+
+void JsonDocument::ReservePadding(boost::beast::flat_buffer &buffer)
+{
+    if (GetBackend() == JsonBackend::Simdjson && buffer.size() > 0 && buffer.capacity() - buffer.size() < kPadding)
+    {
+        buffer.prepare(kPadding);
+    }
+}
+
+bool JsonDocument::Parse(const boost::beast::flat_buffer &buffer)
+{
+    auto data = buffer.data();
+    const char *begin = static_cast<const char *>(data.data());
+    if (GetBackend() == JsonBackend::Simdjson)
+    {
+        return ParseSimdjson(begin, data.size(), buffer.capacity());
+    }
+    return ParseJsonCpp(std::string_view(begin, data.size()));
+}
+
+bool JsonDocument::Parse(std::string_view text)
+{
+    if (GetBackend() == JsonBackend::Simdjson)
+    {
+        // 不知道 text 之后是否可读，capacity 按无 padding 处理
+        return ParseSimdjson(text.data(), text.size(), text.size());
+    }
+    return ParseJsonCpp(text);
+}
+
+std::string_view JsonDocument::Store(std::string_view text)
+{
+    std::size_t begin = _arena.size();
+    _arena.append(text.data(), text.size());
+    return std::string_view(_arena.data() + begin, text.size());
+}
+
+bool JsonDocument::ParseJsonCpp(std::string_view text)
+{
+    _fields.clear();
+    _arena.clear();
+    _arena.reserve(text.size());
+
+    Json::Value root;
+    if (!ThreadJsonReader().parse(text.data(), text.data() + text.size(), &root, nullptr) || !root.isObject())
+    {
+        return false;
+    }
+    for (auto it = root.begin(); it != root.end(); ++it)
+    {
+        const char *key_end = nullptr;
+        const char *key_begin = it.memberName(&key_end);
+        Member field{Store(std::string_view(key_begin, static_cast<std::size_t>(key_end - key_begin))), Kind::Other,
+                     std::string_view(), 0};
+        const Json::Value &value = *it;
+        const char *str_begin = nullptr;
+        const char *str_end = nullptr;
+        if (value.isString() && value.getString(&str_begin, &str_end))
+        {
+            field.kind = Kind::String;
+            field.text = Store(std::string_view(str_begin, static_cast<std::size_t>(str_end - str_begin)));
+        }
+        else if (value.isInt64())
+        {
+            field.kind = Kind::Int;
+            field.number = value.asInt64();
+        }
+        _fields.push_back(field);
+    }
+    return true;
+}
+
+#ifdef GATE_HAVE_SIMDJSON
+bool JsonDocument::ParseSimdjson(const char *data, std::size_t size, std::size_t capacity)
+{
+    _fields.clear();
+    _arena.clear();
+    _arena.reserve(size);
+
+    // 解析器内部缓冲区按最大文档长度分配，每个线程复用一个
+    thread_local simdjson::ondemand::parser parser;
+    simdjson::padded_string copy;
+    if (capacity < size + simdjson::SIMDJSON_PADDING)
+    {
+        copy = simdjson::padded_string(data, size);
+        data = copy.data();
+        capacity = size + simdjson::SIMDJSON_PADDING;
+    }
+
+    simdjson::ondemand::document doc;
+    simdjson::ondemand::object object;
+    if (parser.iterate(data, size, capacity).get(doc) || doc.get_object().get(object))
+    {
+        return false;
+    }
+    for (auto member : object)
+    {
+        std::string_view key;
+        simdjson::ondemand::value value;
+        simdjson::ondemand::json_type type;
+        if (member.unescaped_key().get(key) || member.value().get(value) || value.type().get(type))
+        {
+            return false;
+        }
+        Member field{Store(key), Kind::Other, std::string_view(), 0};
+        if (type == simdjson::ondemand::json_type::string)
+        {
+            std::string_view text;
+            if (value.get_string().get(text))
+            {
+                return false;
+            }
+            field.kind = Kind::String;
+            field.text = Store(text);
+        }
+        else if (type == simdjson::ondemand::json_type::number)
+        {
+            std::int64_t number = 0;
+            if (!value.get_int64().get(number))
+            {
+                field.kind = Kind::Int;
+                field.number = number;
+            }
+        }
+        // 其余类型不读取，On-Demand 在前进到下一个字段时自动跳过
+        _fields.push_back(field);
+    }
+    return doc.at_end();
+}
+#else
+bool JsonDocument::ParseSimdjson(const char *data, std::size_t size, std::size_t)
+{
+    // SetBackend() 不允许未编译时选择 Simdjson，这里只为链接完整
+    return ParseJsonCpp(std::string_view(data, size));
+}
+#endif
+
+const JsonDocument::Member *JsonDocument::Find(std::string_view key) const
+{
+    for (auto it = _fields.rbegin(); it != _fields.rend(); ++it)
+    {
+        if (it->key == key)
+        {
+            return &*it;
+        }
+    }
+    return nullptr;
+}
+
+std::string_view JsonDocument::GetString(std::string_view key) const
+{
+    const Member *field = Find(key);
+    return (field != nullptr && field->kind == Kind::String) ? field->text : std::string_view();
+}
+
+bool JsonDocument::GetInt(std::string_view key, std::int64_t &value) const
+{
+    const Member *field = Find(key);
+    if (field == nullptr || field->kind != Kind::Int)
+    {
+        return false;
+    }
+    value = field->number;
+    return true;
+}
+
+bool JsonDocument::Has(std::string_view key) const
+{
+    return Find(key) != nullptr;
+}
+
+JsonWriter::JsonWriter(boost::beast::flat_buffer &out)
+    : _out(out)
+{
+}
+
+void JsonWriter::Raw(const char *data, std::size_t size)
+{
+    auto buffer = _out.prepare(size);
+    std::memcpy(buffer.data(), data, size);
+    _out.commit(size);
+}
+
+void JsonWriter::Separate()
+{
+    if (_after_key)
+    {
+        _after_key = false;
+        return;
+    }
+    std::uint64_t bit = std::uint64_t{1} << (_depth & 63);
+    if (_depth > 0 && (_has_element & bit) != 0)
+    {
+        Raw(",", 1);
+    }
+    _has_element |= bit;
+}
+
+void JsonWriter::Open(char c)
+{
+    Separate();
+    Raw(&c, 1);
+    ++_depth;
+    _has_element &= ~(std::uint64_t{1} << (_depth & 63));
+}
+
+void JsonWriter::Close(char c)
+{
+    --_depth;
+    Raw(&c, 1);
+}
+
+JsonWriter &JsonWriter::BeginObject()
+{
+    Open('{');
+    return *this;
+}
+
+JsonWriter &JsonWriter::EndObject()
+{
+    Close('}');
+    return *this;
+}
+
+JsonWriter &JsonWriter::BeginArray()
+{
+    Open('[');
+    return *this;
+}
+
+JsonWriter &JsonWriter::EndArray()
+{
+    Close(']');
+    return *this;
+}
+
+JsonWriter &JsonWriter::Key(std::string_view key)
+{
+    Separate();
+    Escaped(key);
+    Raw(":", 1);
+    _after_key = true;
+    return *this;
+}
+
+JsonWriter &JsonWriter::String(std::string_view value)
+{
+    Separate();
+    Escaped(value);
+    return *this;
+}
+
+JsonWriter &JsonWriter::Int(std::int64_t value)
+{
+    Separate();
+    char digits[24];
+    auto result = std::to_chars(digits, digits + sizeof(digits), value);
+    Raw(digits, static_cast<std::size_t>(result.ptr - digits));
+    return *this;
+}
+
+JsonWriter &JsonWriter::Bool(bool value)
+{
+    Separate();
+    if (value)
+    {
+        Raw("true", 4);
+    }
+    else
+    {
+        Raw("false", 5);
+    }
+    return *this;
+}
+
+JsonWriter &JsonWriter::Null()
+{
+    Separate();
+    Raw("null", 4);
+    return *this;
+}
+
+void JsonWriter::Escaped(std::string_view text)
+{
+    static const char kHex[] = "0123456789abcdef";
+    Raw("\"", 1);
+    std::size_t run = 0;
+    for (std::size_t i = 0; i < text.size(); ++i)
+    {
+        auto c = static_cast<unsigned char>(text[i]);
+        if (c >= 0x20 && c != '"' && c != '\\')
+        {
+            continue;
+        }
+        // 不需要转义的连续字节一次拷贝
+        Raw(text.data() + run, i - run);
+        run = i + 1;
+        switch (c)
+        {
+        case '"':
+            Raw("\\\"", 2);
+            break;
+        case '\\':
+            Raw("\\\\", 2);
+            break;
+        case '\n':
+            Raw("\\n", 2);
+            break;
+        case '\r':
+            Raw("\\r", 2);
+            break;
+        case '\t':
+            Raw("\\t", 2);
+            break;
+        default:
+        {
+            char escape[6] = {'\\', 'u', '0', '0', kHex[c >> 4], kHex[c & 0xF]};
+            Raw(escape, sizeof(escape));
+            break;
+        }
+        }
+    }
+    Raw(text.data() + run, text.size() - run);
+    Raw("\"", 1);
+}
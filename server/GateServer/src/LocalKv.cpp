@@ -0,0 +1,926 @@
+/**
+ * @file    LocalKv.cpp
+ * @brief   进程内分片 TTL KV 引擎实现
+ * @author  msr
+ */
+
+#include "LocalKv.h"
+#include <algorithm>
+#include <cctype>
+#include <charconv>
+#include <cstdio>
+#include <deque>
+#include <stdexcept>
+
+namespace
+{
+constexpr std::size_t kWheelSlots = 256;
+constexpr std::size_t kEntryOverhead = 64;   ///< map 节点、桶指针与 Entry 本身 (估算)
+constexpr std::size_t kElementOverhead = 32; ///< 列表元素 / 哈希字段的额外开销 (估算)
+constexpr std::size_t kWheelItemOverhead = sizeof(std::string) + sizeof(std::uint64_t);
+
+const char *const kWrongType = "WRONGTYPE Operation against a key holding the wrong kind of value";
+const char *const kNotInteger = "ERR value is not an integer or out of range";
+const char *const kOom = "OOM command not allowed when used memory > 'maxmemory'";
+
+/// 过期时长上限 (ms): 过期时间点是 steady_clock 的纳秒计数，留一半范围给 now，相加不会溢出 (约 146 年)
+constexpr long long kMaxExpireMs =
+    std::chrono::duration_cast<std::chrono::milliseconds>(LocalKv::Clock::duration::max()).count() / 2;
+
+/**
+ * @struct  WheelItem
+ * @brief   时间轮上的一个待检查键；键被删除或 TTL 改变后变为过期条目，扫到时丢弃
+ */
+struct WheelItem
+{
+    std::string key;
+    std::uint64_t tick; ///< 到达该 tick 时检查
+};
+
+RedisReply Status(const char *status)
+{
+    RedisReply reply;
+    reply.type = RedisReply::Type::Status;
+    reply.str = status;
+    return reply;
+}
+
+RedisReply Integer(long long value)
+{
+    RedisReply reply;
+    reply.type = RedisReply::Type::Integer;
+    reply.integer = value;
+    return reply;
+}
+
+RedisReply Bulk(std::string value)
+{
+    RedisReply reply;
+    reply.type = RedisReply::Type::String;
+    reply.str = std::move(value);
+    return reply;
+}
+
+RedisReply WrongArgs(const std::string &command)
+{
+    return RedisReply::Error("ERR wrong number of arguments for '" + command + "' command");
+}
+
+RedisReply InvalidExpire(const std::string &command)
+{
+    return RedisReply::Error("ERR invalid expire time in '" + command + "' command");
+}
+
+/**
+ * @brief   把 EX / EXPIRE (秒) 或 PX / PEXPIRE (毫秒) 的参数换算为毫秒
+ * @return  绝对值超过 kMaxExpireMs 时返回 false (换算或与 now 相加会溢出)，与 Redis 一样回复 invalid expire time
+ */
+bool ExpireMs(long long amount, bool seconds, long long &ms)
+{
+    long long limit = seconds ? kMaxExpireMs / 1000 : kMaxExpireMs;
+    if (amount > limit || amount < -limit)
+    {
+        return false;
+    }
+    ms = seconds ? amount * 1000 : amount;
+    return true;
+}
+
+/// 命令名比较，不区分大小写
+bool Is(const std::string &arg, const char *name)
+{
+    std::size_t i = 0;
+    for (; name[i] != '\0'; ++i)
+    {
+        if (i >= arg.size() || std::toupper(static_cast<unsigned char>(arg[i])) != name[i])
+        {
+            return false;
+        }
+    }
+    return i == arg.size();
+}
+
+bool ParseInt(const std::string &text, long long &value)
+{
+    auto [end, ec] = std::from_chars(text.data(), text.data() + text.size(), value);
+    return ec == std::errc() && end == text.data() + text.size() && !text.empty();
+}
+} // namespace
+
+/**
+ * @struct  LocalKv::Entry
+ * @brief   一个键的值，kind 决定使用哪个字段
+ */
+struct LocalKv::Entry
+{
+    enum class Kind : std::uint8_t
+    {
+        String,
+        List,
+        Hash
+    };
+
+    Kind kind = Kind::String;
+    std::string str;
+    std::unique_ptr<std::deque<std::string>> list;
+    std::unique_ptr<std::unordered_map<std::string, std::string>> hash;
+    Clock::time_point expire_at{}; ///< 默认值表示不过期
+    std::size_t bytes = 0;         ///< 键 + 值 + 开销的估算，计入分片的 memory
+};
+
+/**
+ * @struct  LocalKv::Shard
+ * @brief   一个分片: 一把锁保护 map 与时间轮；计数在锁内更新、GetStats 不加锁读取
+ */
+struct alignas(64) LocalKv::Shard
+{
+    std::mutex mutex;
+    std::unordered_map<std::string, Entry> map;
+    std::vector<std::vector<WheelItem>> wheel = std::vector<std::vector<WheelItem>>(kWheelSlots);
+    std::uint64_t reaped_tick = 0; ///< 时间轮已处理到的 tick
+    std::size_t wheel_items = 0;
+
+    std::atomic<std::uint64_t> keys{0};
+    std::atomic<std::uint64_t> memory{0};
+    std::atomic<std::uint64_t> commands{0};
+    std::atomic<std::uint64_t> expired{0};
+    std::atomic<std::uint64_t> reaped{0};
+    std::atomic<std::uint64_t> oom{0};
+};
+
+LocalKv::LocalKv(Options options) : _options(options), _epoch(Clock::now())
+{
+    std::size_t shards = _options.shards;
+    if (shards == 0)
+    {
+        shards = 4 * std::max(1u, std::thread::hardware_concurrency());
+    }
+    std::size_t count = 1;
+    while (count < shards)
+    {
+        count <<= 1;
+    }
+    _shards.reserve(count);
+    for (std::size_t i = 0; i < count; ++i)
+    {
+        _shards.push_back(std::make_unique<Shard>());
+    }
+    if (_options.tick.count() <= 0)
+    {
+        _options.tick = std::chrono::milliseconds(100);
+    }
+    if (_options.max_memory > 0)
+    {
+        _shard_budget = std::max<std::size_t>(1, _options.max_memory / count);
+    }
+    _reaper = std::thread([this]() { ReaperLoop(); });
+}
+
+LocalKv::~LocalKv()
+{
+    {
+        std::lock_guard<std::mutex> lock(_reaper_mutex);
+        _stopping = true;
+    }
+    _reaper_cv.notify_all();
+    if (_reaper.joinable())
+    {
+        _reaper.join();
+    }
+}
+
+RedisReply LocalKv::Execute(const RedisCommand &args)
+{
+    if (args.empty())
+    {
+        return RedisReply::Error("ERR empty command");
+    }
+    const std::string &command = args[0];
+    try
+    {
+        // 计数记在首个键所在的分片上，避免所有线程争用同一个计数器
+        ShardOf(args.size() > 1 ? args[1] : command).commands.fetch_add(1, std::memory_order_relaxed);
+        Clock::time_point now = Clock::now();
+
+        if (Is(command, "PING"))
+        {
+            return args.size() > 1 ? Bulk(args[1]) : Status("PONG");
+        }
+        if (Is(command, "AUTH"))
+        {
+            return Status("OK");
+        }
+        if (Is(command, "DEL") || Is(command, "EXISTS"))
+        {
+            if (args.size() < 2)
+            {
+                return WrongArgs(command);
+            }
+            bool del = Is(command, "DEL");
+            long long count = 0;
+            for (std::size_t i = 1; i < args.size(); ++i)
+            {
+                Shard &shard = ShardOf(args[i]);
+                std::lock_guard<std::mutex> lock(shard.mutex);
+                if (Find(shard, args[i], now) != nullptr)
+                {
+                    if (del)
+                    {
+                        Erase(shard, args[i]);
+                    }
+                    ++count;
+                }
+            }
+            return Integer(count);
+        }
+        if (Is(command, "DBSIZE"))
+        {
+            return Integer(static_cast<long long>(GetStats().keys));
+        }
+        if (Is(command, "FLUSHALL") || Is(command, "FLUSHDB"))
+        {
+            for (auto &shard : _shards)
+            {
+                std::lock_guard<std::mutex> lock(shard->mutex);
+                shard->map.clear();
+                for (auto &slot : shard->wheel)
+                {
+                    slot.clear();
+                }
+                shard->wheel_items = 0;
+                shard->keys.store(0, std::memory_order_relaxed);
+                shard->memory.store(0, std::memory_order_relaxed);
+            }
+            return Status("OK");
+        }
+        if (Is(command, "SCRIPT"))
+        {
+            return Scripting(args);
+        }
+        if (Is(command, "EVAL") || Is(command, "EVALSHA"))
+        {
+            if (args.size() < 3)
+            {
+                return WrongArgs(command);
+            }
+            std::shared_ptr<Script> script;
+            {
+                std::lock_guard<std::mutex> lock(_script_mutex);
+                auto it = _scripts.find(Is(command, "EVAL") ? ScriptId(args[1]) : args[1]);
+                if (it != _scripts.end())
+                {
+                    script = it->second;
+                }
+            }
+            if (!script)
+            {
+                return Is(command, "EVAL")
+                           ? RedisReply::Error("ERR local backend has no implementation for this script")
+                           : RedisReply::Error("NOSCRIPT No matching script. Please use EVAL.");
+            }
+            return Eval(*script, args, now);
+        }
+
+        if (args.size() < 2)
+        {
+            return WrongArgs(command);
+        }
+        Shard &shard = ShardOf(args[1]);
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        return ExecuteKey(shard, args, now);
+    }
+    catch (std::exception &exp)
+    {
+        return RedisReply::Error(std::string("ERR ") + exp.what());
+    }
+}
+
+RedisReply LocalKv::ExecuteKey(Shard &shard, const RedisCommand &args, Clock::time_point now)
+{
+    const std::string &command = args[0];
+    const std::string &key = args[1];
+    const std::size_t argc = args.size();
+
+    if (Is(command, "GET"))
+    {
+        if (argc != 2)
+        {
+            return WrongArgs(command);
+        }
+        Entry *entry = Find(shard, key, now);
+        if (entry == nullptr)
+        {
+            return RedisReply{};
+        }
+        return entry->kind == Entry::Kind::String ? Bulk(entry->str) : RedisReply::Error(kWrongType);
+    }
+    if (Is(command, "SET") || Is(command, "SETEX"))
+    {
+        const std::string *value = nullptr;
+        long long ttl_ms = 0;
+        bool has_ttl = false;
+        bool nx = false;
+        bool xx = false;
+        if (Is(command, "SETEX"))
+        {
+            long long seconds = 0;
+            if (argc != 4)
+            {
+                return WrongArgs(command);
+            }
+            if (!ParseInt(args[2], seconds))
+            {
+                return RedisReply::Error(kNotInteger);
+            }
+            if (!ExpireMs(seconds, true, ttl_ms))
+            {
+                return InvalidExpire(command);
+            }
+            has_ttl = true;
+            value = &args[3];
+        }
+        else
+        {
+            if (argc < 3)
+            {
+                return WrongArgs(command);
+            }
+            value = &args[2];
+            for (std::size_t i = 3; i < argc; ++i)
+            {
+                long long amount = 0;
+                if ((Is(args[i], "EX") || Is(args[i], "PX")) && i + 1 < argc)
+                {
+                    if (!ParseInt(args[i + 1], amount))
+                    {
+                        return RedisReply::Error(kNotInteger);
+                    }
+                    if (!ExpireMs(amount, Is(args[i], "EX"), ttl_ms))
+                    {
+                        return InvalidExpire(command);
+                    }
+                    has_ttl = true;
+                    ++i;
+                }
+                else if (Is(args[i], "NX"))
+                {
+                    nx = true;
+                }
+                else if (Is(args[i], "XX"))
+                {
+                    xx = true;
+                }
+                else
+                {
+                    return RedisReply::Error("ERR syntax error");
+                }
+            }
+        }
+        if (has_ttl && ttl_ms <= 0)
+        {
+            return InvalidExpire(command);
+        }
+
+        Entry *existing = Find(shard, key, now);
+        if ((nx && existing != nullptr) || (xx && existing == nullptr))
+        {
+            return RedisReply{};
+        }
+        if (OverBudget(shard))
+        {
+            return RedisReply::Error(kOom);
+        }
+        Entry &entry = Upsert(shard, key);
+        entry.list.reset();
+        entry.hash.reset();
+        entry.kind = Entry::Kind::String;
+        entry.str = *value;
+        Account(shard, entry, static_cast<std::int64_t>(key.size() + kEntryOverhead + value->size()) -
+                                  static_cast<std::int64_t>(entry.bytes));
+        entry.expire_at = Clock::time_point{};
+        if (ttl_ms > 0)
+        {
+            SetExpire(shard, key, entry, now + std::chrono::milliseconds(ttl_ms));
+        }
+        return Status("OK");
+    }
+    if (Is(command, "INCR"))
+    {
+        if (argc != 2)
+        {
+            return WrongArgs(command);
+        }
+        Entry *existing = Find(shard, key, now);
+        long long value = 0;
+        if (existing != nullptr)
+        {
+            if (existing->kind != Entry::Kind::String)
+            {
+                return RedisReply::Error(kWrongType);
+            }
+            if (!ParseInt(existing->str, value))
+            {
+                return RedisReply::Error(kNotInteger);
+            }
+        }
+        long long next = 0;
+        if (__builtin_add_overflow(value, 1LL, &next))
+        {
+            return RedisReply::Error("ERR increment or decrement would overflow");
+        }
+        Entry &entry = Upsert(shard, key);
+        std::string text = std::to_string(next);
+        Account(shard, entry, static_cast<std::int64_t>(text.size()) - static_cast<std::int64_t>(entry.str.size()));
+        entry.str = std::move(text);
+        return Integer(next);
+    }
+    if (Is(command, "EXPIRE") || Is(command, "PEXPIRE"))
+    {
+        long long amount = 0;
+        if (argc != 3)
+        {
+            return WrongArgs(command);
+        }
+        long long ms = 0;
+        if (!ParseInt(args[2], amount))
+        {
+            return RedisReply::Error(kNotInteger);
+        }
+        if (!ExpireMs(amount, Is(command, "EXPIRE"), ms))
+        {
+            return InvalidExpire(command);
+        }
+        Entry *entry = Find(shard, key, now);
+        if (entry == nullptr)
+        {
+            return Integer(0);
+        }
+        if (ms <= 0)
+        {
+            Erase(shard, key);
+        }
+        else
+        {
+            SetExpire(shard, key, *entry, now + std::chrono::milliseconds(ms));
+        }
+        return Integer(1);
+    }
+    if (Is(command, "TTL") || Is(command, "PTTL"))
+    {
+        if (argc != 2)
+        {
+            return WrongArgs(command);
+        }
+        Entry *entry = Find(shard, key, now);
+        if (entry == nullptr)
+        {
+            return Integer(-2);
+        }
+        if (entry->expire_at == Clock::time_point{})
+        {
+            return Integer(-1);
+        }
+        long long ms = std::chrono::duration_cast<std::chrono::milliseconds>(entry->expire_at - now).count();
+        return Integer(Is(command, "TTL") ? (ms + 500) / 1000 : ms);
+    }
+    if (Is(command, "LPUSH") || Is(command, "RPUSH"))
+    {
+        if (argc < 3)
+        {
+            return WrongArgs(command);
+        }
+        Entry *existing = Find(shard, key, now);
+        if (existing != nullptr && existing->kind != Entry::Kind::List)
+        {
+            return RedisReply::Error(kWrongType);
+        }
+        if (OverBudget(shard))
+        {
+            return RedisReply::Error(kOom);
+        }
+        Entry &entry = Upsert(shard, key);
+        if (existing == nullptr)
+        {
+            entry.kind = Entry::Kind::List;
+            entry.list = std::make_unique<std::deque<std::string>>();
+        }
+        bool front = Is(command, "LPUSH");
+        std::size_t added = 0;
+        for (std::size_t i = 2; i < argc; ++i)
+        {
+            front ? entry.list->push_front(args[i]) : entry.list->push_back(args[i]);
+            added += args[i].size() + kElementOverhead;
+        }
+        Account(shard, entry, static_cast<std::int64_t>(added));
+        return Integer(static_cast<long long>(entry.list->size()));
+    }
+    if (Is(command, "LPOP") || Is(command, "LLEN"))
+    {
+        if (argc != 2)
+        {
+            return WrongArgs(command);
+        }
+        Entry *entry = Find(shard, key, now);
+        bool pop = Is(command, "LPOP");
+        if (entry == nullptr)
+        {
+            return pop ? RedisReply{} : Integer(0);
+        }
+        if (entry->kind != Entry::Kind::List)
+        {
+            return RedisReply::Error(kWrongType);
+        }
+        if (!pop)
+        {
+            return Integer(static_cast<long long>(entry->list->size()));
+        }
+        std::string value = std::move(entry->list->front());
+        entry->list->pop_front();
+        Account(shard, *entry, -static_cast<std::int64_t>(value.size() + kElementOverhead));
+        if (entry->list->empty())
+        {
+            Erase(shard, key);
+        }
+        return Bulk(std::move(value));
+    }
+    if (Is(command, "HSET"))
+    {
+        if (argc < 4 || argc % 2 != 0)
+        {
+            return WrongArgs(command);
+        }
+        Entry *existing = Find(shard, key, now);
+        if (existing != nullptr && existing->kind != Entry::Kind::Hash)
+        {
+            return RedisReply::Error(kWrongType);
+        }
+        if (OverBudget(shard))
+        {
+            return RedisReply::Error(kOom);
+        }
+        Entry &entry = Upsert(shard, key);
+        if (existing == nullptr)
+        {
+            entry.kind = Entry::Kind::Hash;
+            entry.hash = std::make_unique<std::unordered_map<std::string, std::string>>();
+        }
+        long long added = 0;
+        std::int64_t delta = 0;
+        for (std::size_t i = 2; i < argc; i += 2)
+        {
+            auto [it, inserted] = entry.hash->try_emplace(args[i]);
+            if (inserted)
+            {
+                ++added;
+                delta += static_cast<std::int64_t>(args[i].size() + kElementOverhead);
+            }
+            delta += static_cast<std::int64_t>(args[i + 1].size()) - static_cast<std::int64_t>(it->second.size());
+            it->second = args[i + 1];
+        }
+        Account(shard, entry, delta);
+        return Integer(added);
+    }
+    if (Is(command, "HGET"))
+    {
+        if (argc != 3)
+        {
+            return WrongArgs(command);
+        }
+        Entry *entry = Find(shard, key, now);
+        if (entry == nullptr)
+        {
+            return RedisReply{};
+        }
+        if (entry->kind != Entry::Kind::Hash)
+        {
+            return RedisReply::Error(kWrongType);
+        }
+        auto it = entry->hash->find(args[2]);
+        return it == entry->hash->end() ? RedisReply{} : Bulk(it->second);
+    }
+    if (Is(command, "HDEL"))
+    {
+        if (argc < 3)
+        {
+            return WrongArgs(command);
+        }
+        Entry *entry = Find(shard, key, now);
+        if (entry == nullptr)
+        {
+            return Integer(0);
+        }
+        if (entry->kind != Entry::Kind::Hash)
+        {
+            return RedisReply::Error(kWrongType);
+        }
+        long long removed = 0;
+        for (std::size_t i = 2; i < argc; ++i)
+        {
+            auto it = entry->hash->find(args[i]);
+            if (it != entry->hash->end())
+            {
+                Account(shard, *entry, -static_cast<std::int64_t>(it->first.size() + it->second.size() +
+                                                                  kElementOverhead));
+                entry->hash->erase(it);
+                ++removed;
+            }
+        }
+        if (entry->hash->empty())
+        {
+            Erase(shard, key);
+        }
+        return Integer(removed);
+    }
+    return RedisReply::Error("ERR unknown command '" + command + "'");
+}
+
+RedisReply LocalKv::Eval(const Script &script, const RedisCommand &args, Clock::time_point now)
+{
+    long long numkeys = 0;
+    if (!ParseInt(args[2], numkeys) || numkeys < 0)
+    {
+        return RedisReply::Error(kNotInteger);
+    }
+    if (static_cast<std::size_t>(numkeys) > args.size() - 3)
+    {
+        return RedisReply::Error("ERR Number of keys can't be greater than number of args");
+    }
+    std::vector<std::string> keys(args.begin() + 3, args.begin() + 3 + numkeys);
+    std::vector<std::string> argv(args.begin() + 3 + numkeys, args.end());
+
+    // 按地址排序后依次加锁，多个脚本并发时不会死锁
+    std::vector<Shard *> shards;
+    for (const auto &key : keys)
+    {
+        shards.push_back(&ShardOf(key));
+    }
+    std::sort(shards.begin(), shards.end());
+    shards.erase(std::unique(shards.begin(), shards.end()), shards.end());
+    std::vector<std::unique_lock<std::mutex>> locks;
+    locks.reserve(shards.size());
+    for (Shard *shard : shards)
+    {
+        locks.emplace_back(shard->mutex);
+    }
+    Transaction txn(*this, std::move(shards), now);
+    RedisReply reply = script(txn, keys, argv);
+    return txn._oom ? RedisReply::Error(kOom) : reply;
+}
+
+RedisReply LocalKv::Scripting(const RedisCommand &args)
+{
+    if (args.size() < 2)
+    {
+        return WrongArgs(args[0]);
+    }
+    const std::string &sub = args[1];
+    if (Is(sub, "LOAD") && args.size() == 3)
+    {
+        std::string id = ScriptId(args[2]);
+        std::lock_guard<std::mutex> lock(_script_mutex);
+        if (_scripts.count(id) == 0)
+        {
+            return RedisReply::Error("ERR local backend has no implementation for this script");
+        }
+        return Bulk(std::move(id));
+    }
+    if (Is(sub, "EXISTS"))
+    {
+        RedisReply reply;
+        reply.type = RedisReply::Type::Array;
+        std::lock_guard<std::mutex> lock(_script_mutex);
+        for (std::size_t i = 2; i < args.size(); ++i)
+        {
+            reply.elements.push_back(Integer(_scripts.count(args[i]) > 0 ? 1 : 0));
+        }
+        return reply;
+    }
+    if (Is(sub, "FLUSH"))
+    {
+        // 本地实现编译在程序里，不随 FLUSH 丢失
+        return Status("OK");
+    }
+    return RedisReply::Error("ERR unknown subcommand '" + sub + "'");
+}
+
+std::string LocalKv::RegisterScript(const std::string &body, Script script)
+{
+    std::string id = ScriptId(body);
+    std::lock_guard<std::mutex> lock(_script_mutex);
+    _scripts[id] = std::make_shared<Script>(std::move(script));
+    return id;
+}
+
+LocalKv::Stats LocalKv::GetStats() const
+{
+    Stats stats;
+    for (const auto &shard : _shards)
+    {
+        stats.keys += shard->keys.load(std::memory_order_relaxed);
+        stats.memory += shard->memory.load(std::memory_order_relaxed);
+        stats.commands += shard->commands.load(std::memory_order_relaxed);
+        stats.expired += shard->expired.load(std::memory_order_relaxed);
+        stats.reaped += shard->reaped.load(std::memory_order_relaxed);
+        stats.oom += shard->oom.load(std::memory_order_relaxed);
+    }
+    return stats;
+}
+
+LocalKv::Shard &LocalKv::ShardOf(const std::string &key)
+{
+    // 分片用哈希高位，map 内部的桶用低位，两者不相关
+    std::size_t hash = std::hash<std::string>{}(key);
+    return *_shards[(hash ^ (hash >> 32)) * 0x9E3779B97F4A7C15ull >> 40 & (_shards.size() - 1)];
+}
+
+LocalKv::Entry *LocalKv::Find(Shard &shard, const std::string &key, Clock::time_point now)
+{
+    auto it = shard.map.find(key);
+    if (it == shard.map.end())
+    {
+        return nullptr;
+    }
+    Entry &entry = it->second;
+    if (entry.expire_at != Clock::time_point{} && entry.expire_at <= now)
+    {
+        shard.memory.fetch_sub(entry.bytes, std::memory_order_relaxed);
+        shard.keys.fetch_sub(1, std::memory_order_relaxed);
+        shard.expired.fetch_add(1, std::memory_order_relaxed);
+        shard.map.erase(it);
+        return nullptr;
+    }
+    return &entry;
+}
+
+LocalKv::Entry &LocalKv::Upsert(Shard &shard, const std::string &key)
+{
+    auto [it, inserted] = shard.map.try_emplace(key);
+    if (inserted)
+    {
+        shard.keys.fetch_add(1, std::memory_order_relaxed);
+        Account(shard, it->second, static_cast<std::int64_t>(key.size() + kEntryOverhead));
+    }
+    return it->second;
+}
+
+void LocalKv::Erase(Shard &shard, const std::string &key)
+{
+    auto it = shard.map.find(key);
+    if (it == shard.map.end())
+    {
+        return;
+    }
+    shard.memory.fetch_sub(it->second.bytes, std::memory_order_relaxed);
+    shard.keys.fetch_sub(1, std::memory_order_relaxed);
+    shard.map.erase(it);
+}
+
+void LocalKv::SetExpire(Shard &shard, const std::string &key, Entry &entry, Clock::time_point expire_at)
+{
+    entry.expire_at = expire_at;
+    // 下取整再加一: 扫到该 tick 时一定已经过期；不早于时间轮已处理的位置
+    std::uint64_t tick = std::max(TickOf(expire_at) + 1, shard.reaped_tick + 1);
+    shard.wheel[tick % kWheelSlots].push_back({key, tick});
+    ++shard.wheel_items;
+    shard.memory.fetch_add(key.size() + kWheelItemOverhead, std::memory_order_relaxed);
+}
+
+void LocalKv::Account(Shard &shard, Entry &entry, std::int64_t delta)
+{
+    entry.bytes = static_cast<std::size_t>(static_cast<std::int64_t>(entry.bytes) + delta);
+    shard.memory.fetch_add(static_cast<std::uint64_t>(delta), std::memory_order_relaxed);
+}
+
+bool LocalKv::OverBudget(Shard &shard)
+{
+    if (_shard_budget == 0 || shard.memory.load(std::memory_order_relaxed) < _shard_budget)
+    {
+        return false;
+    }
+    shard.oom.fetch_add(1, std::memory_order_relaxed);
+    return true;
+}
+
+std::uint64_t LocalKv::TickOf(Clock::time_point time) const
+{
+    return static_cast<std::uint64_t>((time - _epoch) / _options.tick);
+}
+
+void LocalKv::Reap(Shard &shard, std::uint64_t now_tick, Clock::time_point now)
+{
+    if (now_tick <= shard.reaped_tick)
+    {
+        return;
+    }
+    // 落后超过一圈时每个 slot 只需扫一遍
+    std::uint64_t steps = std::min<std::uint64_t>(now_tick - shard.reaped_tick, kWheelSlots);
+    for (std::uint64_t step = 1; step <= steps && shard.wheel_items > 0; ++step)
+    {
+        auto &slot = shard.wheel[(shard.reaped_tick + step) % kWheelSlots];
+        for (std::size_t i = 0; i < slot.size();)
+        {
+            WheelItem &item = slot[i];
+            if (item.tick > now_tick)
+            {
+                ++i; // 之后的圈
+                continue;
+            }
+            auto it = shard.map.find(item.key);
+            if (it != shard.map.end() && it->second.expire_at != Clock::time_point{} && it->second.expire_at <= now)
+            {
+                shard.memory.fetch_sub(it->second.bytes, std::memory_order_relaxed);
+                shard.keys.fetch_sub(1, std::memory_order_relaxed);
+                shard.expired.fetch_add(1, std::memory_order_relaxed);
+                shard.reaped.fetch_add(1, std::memory_order_relaxed);
+                shard.map.erase(it);
+            }
+            shard.memory.fetch_sub(item.key.size() + kWheelItemOverhead, std::memory_order_relaxed);
+            --shard.wheel_items;
+            item = std::move(slot.back());
+            slot.pop_back();
+        }
+    }
+    shard.reaped_tick = now_tick;
+}
+
+void LocalKv::ReaperLoop()
+{
+    std::unique_lock<std::mutex> lock(_reaper_mutex);
+    while (!_reaper_cv.wait_for(lock, _options.tick, [this]() { return _stopping; }))
+    {
+        lock.unlock();
+        Clock::time_point now = Clock::now();
+        std::uint64_t now_tick = TickOf(now);
+        for (auto &shard : _shards)
+        {
+            std::lock_guard<std::mutex> shard_lock(shard->mutex);
+            Reap(*shard, now_tick, now);
+        }
+        lock.lock();
+    }
+}
+
+std::string LocalKv::ScriptId(const std::string &body)
+{
+    char id[17];
+    std::snprintf(id, sizeof(id), "%016zx", std::hash<std::string>{}(body));
+    return id;
+}
+
+LocalKv::Transaction::Transaction(LocalKv &kv, std::vector<Shard *> shards, Clock::time_point now)
+    : _kv(kv), _shards(std::move(shards)), _now(now)
+{
+}
+
+LocalKv::Shard &LocalKv::Transaction::ShardOf(const std::string &key)
+{
+    Shard &shard = _kv.ShardOf(key);
+    if (std::find(_shards.begin(), _shards.end(), &shard) == _shards.end())
+    {
+        throw std::invalid_argument("script accessed undeclared key " + key);
+    }
+    return shard;
+}
+
+const std::string *LocalKv::Transaction::Get(const std::string &key)
+{
+    Entry *entry = _kv.Find(ShardOf(key), key, _now);
+    return entry != nullptr && entry->kind == Entry::Kind::String ? &entry->str : nullptr;
+}
+
+bool LocalKv::Transaction::Set(const std::string &key, std::string value)
+{
+    Shard &shard = ShardOf(key);
+    _kv.Find(shard, key, _now);
+    // 与非脚本的写命令一样受 MaxMemory 约束
+    if (_kv.OverBudget(shard))
+    {
+        _oom = true;
+        return false;
+    }
+    Entry &entry = _kv.Upsert(shard, key);
+    entry.list.reset();
+    entry.hash.reset();
+    entry.kind = Entry::Kind::String;
+    _kv.Account(shard, entry, static_cast<std::int64_t>(key.size() + kEntryOverhead + value.size()) -
+                                  static_cast<std::int64_t>(entry.bytes));
+    entry.str = std::move(value);
+    entry.expire_at = Clock::time_point{};
+    return true;
+}
+
+bool LocalKv::Transaction::Del(const std::string &key)
+{
+    Shard &shard = ShardOf(key);
+    if (_kv.Find(shard, key, _now) == nullptr)
+    {
+        return false;
+    }
+    _kv.Erase(shard, key);
+    return true;
+}
+
+bool LocalKv::Transaction::Exists(const std::string &key)
+{
+    return _kv.Find(ShardOf(key), key, _now) != nullptr;
+}
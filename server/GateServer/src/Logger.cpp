@@ -0,0 +1,690 @@
+/**
+ * @file    Logger.cpp
+ * @brief   异步日志实现
+ * @author  msr
+ */
+
+#include "Logger.h"
+#include <algorithm>
+#include <cctype>
+#include <cerrno>
+#include <chrono>
+#include <condition_variable>
+#include <cstring>
+#include <ctime>
+#include <fcntl.h>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+namespace
+{
+/// 写线程空闲时的轮询间隔；生产者不做唤醒 (Error 级别除外)，最坏延迟即此值
+constexpr auto kWriterIdleWait = std::chrono::milliseconds(5);
+
+/// 写线程攒批的上限，超过即写出
+constexpr std::size_t kWriterBatch = 64 * 1024;
+
+constexpr std::size_t kDefaultRingSize = 256 * 1024;
+
+std::uint64_t NowNs()
+{
+    return static_cast<std::uint64_t>(
+        std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::system_clock::now().time_since_epoch())
+            .count());
+}
+
+constexpr std::size_t Align8(std::size_t n)
+{
+    return (n + 7) & ~static_cast<std::size_t>(7);
+}
+
+/**
+ * @struct  EntryHeader
+ * @brief   环中每条记录的头，后接 size 字节文本，整体按 8 字节对齐
+ */
+struct EntryHeader
+{
+    std::uint64_t time_ns;
+    std::uint32_t size;
+    LogLevel level;
+};
+
+/**
+ * @class   LogRing
+ * @brief   单生产者 (所属线程) / 单消费者 (写线程) 的字节环
+ *
+ * @details _head / _tail 单调递增，取模定位；记录可能跨越环尾，拷贝时分两段。
+ */
+class LogRing
+{
+public:
+    LogRing(std::size_t capacity, std::uint32_t id)
+        : _data(new char[capacity]),
+          _capacity(capacity),
+          _id(id)
+    {
+    }
+
+    bool TryPush(LogLevel level, std::uint64_t time_ns, std::string_view text)
+    {
+        std::size_t need = Align8(sizeof(EntryHeader) + text.size());
+        std::size_t head = _head.load(std::memory_order_relaxed);
+        std::size_t tail = _tail.load(std::memory_order_acquire);
+        if (need > _capacity - (head - tail))
+        {
+            _dropped.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+        EntryHeader header{time_ns, static_cast<std::uint32_t>(text.size()), level};
+        CopyIn(head, &header, sizeof(header));
+        CopyIn(head + sizeof(header), text.data(), text.size());
+        _head.store(head + need, std::memory_order_release);
+        return true;
+    }
+
+    /**
+     * @brief   取出当前可见的全部记录，逐条回调 fn(header, text)
+     * @return  取出的条数
+     */
+    template <typename Fn>
+    std::size_t Drain(Fn &&fn)
+    {
+        std::size_t tail = _tail.load(std::memory_order_relaxed);
+        std::size_t head = _head.load(std::memory_order_acquire);
+        std::size_t count = 0;
+        char text[kMaxLogRecord];
+        while (tail != head)
+        {
+            EntryHeader header;
+            CopyOut(tail, &header, sizeof(header));
+            std::size_t size = std::min<std::size_t>(header.size, sizeof(text));
+            CopyOut(tail + sizeof(header), text, size);
+            fn(header, std::string_view(text, size));
+            tail += Align8(sizeof(header) + header.size);
+            ++count;
+        }
+        _tail.store(tail, std::memory_order_release);
+        return count;
+    }
+
+    std::uint32_t Id() const { return _id; }
+
+    std::uint64_t Dropped() const { return _dropped.load(std::memory_order_relaxed); }
+
+    void Retire() { _retired.store(true, std::memory_order_release); }
+
+    bool Retired() const { return _retired.load(std::memory_order_acquire); }
+
+    bool Empty() const
+    {
+        return _head.load(std::memory_order_acquire) == _tail.load(std::memory_order_relaxed);
+    }
+
+private:
+    void CopyIn(std::size_t position, const void *src, std::size_t size)
+    {
+        std::size_t offset = position & (_capacity - 1);
+        std::size_t first = std::min(size, _capacity - offset);
+        std::memcpy(_data.get() + offset, src, first);
+        std::memcpy(_data.get(), static_cast<const char *>(src) + first, size - first);
+    }
+
+    void CopyOut(std::size_t position, void *dst, std::size_t size) const
+    {
+        std::size_t offset = position & (_capacity - 1);
+        std::size_t first = std::min(size, _capacity - offset);
+        std::memcpy(dst, _data.get() + offset, first);
+        std::memcpy(static_cast<char *>(dst) + first, _data.get(), size - first);
+    }
+
+    std::unique_ptr<char[]> _data;
+    std::size_t _capacity;
+    std::uint32_t _id;
+    alignas(64) std::atomic<std::size_t> _head{0};
+    alignas(64) std::atomic<std::size_t> _tail{0};
+    std::atomic<std::uint64_t> _dropped{0};
+    std::atomic<bool> _retired{false};
+};
+
+/**
+ * @class   LineFormatter
+ * @brief   把记录格式化为一行文本，缓存当前秒的日期前缀
+ */
+class LineFormatter
+{
+public:
+    void Append(std::string &out, LogLevel level, std::uint64_t time_ns, std::string_view thread,
+                std::string_view text)
+    {
+        std::time_t seconds = static_cast<std::time_t>(time_ns / 1000000000);
+        if (seconds != _second)
+        {
+            std::tm tm{};
+            localtime_r(&seconds, &tm);
+            _prefix_size = std::strftime(_prefix, sizeof(_prefix), "%Y-%m-%d %H:%M:%S", &tm);
+            _second = seconds;
+        }
+        char micros[8];
+        unsigned value = static_cast<unsigned>((time_ns / 1000) % 1000000);
+        micros[0] = '.';
+        for (int i = 6; i >= 1; --i)
+        {
+            micros[i] = static_cast<char>('0' + value % 10);
+            value /= 10;
+        }
+        micros[7] = ' ';
+
+        out.append(_prefix, _prefix_size);
+        out.append(micros, sizeof(micros));
+        out.append(LogLevelName(level));
+        out.append(" [");
+        out.append(thread);
+        out.append("] ");
+        out.append(text);
+        out.push_back('\n');
+    }
+
+private:
+    std::time_t _second = -1;
+    char _prefix[32];
+    std::size_t _prefix_size = 0;
+};
+
+/**
+ * @class   LoggerBackend
+ * @brief   环的注册表、输出目标与写线程
+ */
+class LoggerBackend
+{
+public:
+    LoggerBackend()
+    {
+        _running.store(true, std::memory_order_release);
+        _writer = std::thread([this]() { Run(); });
+    }
+
+    std::shared_ptr<LogRing> Register()
+    {
+        std::lock_guard<std::mutex> lock(_rings_mutex);
+        auto ring = std::make_shared<LogRing>(_ring_size.load(std::memory_order_relaxed), ++_next_id);
+        _rings.push_back(ring);
+        return ring;
+    }
+
+    bool Running() const { return _running.load(std::memory_order_acquire); }
+
+    void Wake() { _wake.notify_one(); }
+
+    void SetRingSize(std::size_t bytes)
+    {
+        std::size_t capacity = 4096;
+        while (capacity < bytes)
+        {
+            capacity <<= 1;
+        }
+        _ring_size.store(capacity, std::memory_order_relaxed);
+    }
+
+    bool SetOutput(const std::string &path)
+    {
+        int fd = STDOUT_FILENO;
+        if (!path.empty())
+        {
+            fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+            if (fd < 0)
+            {
+                return false;
+            }
+        }
+        std::lock_guard<std::mutex> lock(_sink_mutex);
+        if (_fd != STDOUT_FILENO)
+        {
+            ::close(_fd);
+        }
+        _fd = fd;
+        return true;
+    }
+
+    /**
+     * @brief   同步写一条 (写线程已停止或本线程的环已析构)
+     */
+    void WriteSync(LogLevel level, std::uint64_t time_ns, std::string_view text)
+    {
+        std::lock_guard<std::mutex> lock(_sink_mutex);
+        _sync_line.clear();
+        _sync_formatter.Append(_sync_line, level, time_ns, "-", text);
+        WriteLocked(_sync_line);
+    }
+
+    void Flush()
+    {
+        if (!Running())
+        {
+            return;
+        }
+        std::unique_lock<std::mutex> lock(_wake_mutex);
+        std::uint64_t ticket = ++_flush_requested;
+        _wake.notify_one();
+        _flushed_cv.wait(lock, [this, ticket]() { return _flush_done >= ticket || !Running(); });
+    }
+
+    void Shutdown()
+    {
+        {
+            std::lock_guard<std::mutex> lock(_wake_mutex);
+            if (!_running.exchange(false, std::memory_order_acq_rel))
+            {
+                return;
+            }
+        }
+        _wake.notify_one();
+        _writer.join();
+        _flushed_cv.notify_all();
+    }
+
+    std::uint64_t Dropped()
+    {
+        std::lock_guard<std::mutex> lock(_rings_mutex);
+        std::uint64_t total = _retired_dropped;
+        for (const auto &ring : _rings)
+        {
+            total += ring->Dropped();
+        }
+        return total;
+    }
+
+private:
+    void Run()
+    {
+        std::string batch;
+        batch.reserve(kWriterBatch + kMaxLogRecord * 2);
+        std::vector<std::shared_ptr<LogRing>> rings;
+        std::uint64_t reported_dropped = 0;
+
+        while (true)
+        {
+            bool running = Running();
+            std::uint64_t flush_ticket;
+            {
+                std::lock_guard<std::mutex> lock(_wake_mutex);
+                flush_ticket = _flush_requested;
+            }
+
+            std::size_t drained = DrainAll(rings, batch);
+
+            std::uint64_t dropped = Dropped();
+            if (dropped != reported_dropped)
+            {
+                char count[24];
+                auto result = std::to_chars(count, count + sizeof(count), dropped - reported_dropped);
+                std::string text = "log ring full, records dropped count=";
+                text.append(count, static_cast<std::size_t>(result.ptr - count));
+                _formatter.Append(batch, LogLevel::Warn, NowNs(), "log", text);
+                reported_dropped = dropped;
+            }
+            WriteBatch(batch);
+
+            {
+                std::lock_guard<std::mutex> lock(_wake_mutex);
+                _flush_done = flush_ticket;
+            }
+            _flushed_cv.notify_all();
+
+            if (!running)
+            {
+                // 停止前最后一轮已在上面完成
+                return;
+            }
+            if (drained == 0)
+            {
+                std::unique_lock<std::mutex> lock(_wake_mutex);
+                _wake.wait_for(lock, kWriterIdleWait,
+                               [this]() { return _flush_requested != _flush_done || !Running(); });
+            }
+        }
+    }
+
+    std::size_t DrainAll(std::vector<std::shared_ptr<LogRing>> &rings, std::string &batch)
+    {
+        {
+            std::lock_guard<std::mutex> lock(_rings_mutex);
+            rings = _rings;
+        }
+
+        std::size_t total = 0;
+        bool any_retired = false;
+        for (const auto &ring : rings)
+        {
+            // 先读退休标记再读空：线程退休前的最后一条记录一定在这次 Drain 中
+            bool retired = ring->Retired();
+            char thread[12] = {'T'};
+            auto result = std::to_chars(thread + 1, thread + sizeof(thread), ring->Id());
+            std::string_view thread_name(thread, static_cast<std::size_t>(result.ptr - thread));
+            total += ring->Drain(
+                [&](const EntryHeader &header, std::string_view text)
+                {
+                    _formatter.Append(batch, header.level, header.time_ns, thread_name, text);
+                    if (batch.size() >= kWriterBatch)
+                    {
+                        WriteBatch(batch);
+                    }
+                });
+            any_retired = any_retired || retired;
+        }
+
+        if (any_retired)
+        {
+            // 线程已退出且已读空的环在这里回收
+            std::lock_guard<std::mutex> lock(_rings_mutex);
+            for (auto it = _rings.begin(); it != _rings.end();)
+            {
+                auto seen = std::find(rings.begin(), rings.end(), *it);
+                if (seen != rings.end() && (*it)->Retired() && (*it)->Empty())
+                {
+                    _retired_dropped += (*it)->Dropped();
+                    it = _rings.erase(it);
+                }
+                else
+                {
+                    ++it;
+                }
+            }
+        }
+        rings.clear();
+        return total;
+    }
+
+    void WriteBatch(std::string &batch)
+    {
+        if (batch.empty())
+        {
+            return;
+        }
+        std::lock_guard<std::mutex> lock(_sink_mutex);
+        WriteLocked(batch);
+        batch.clear();
+    }
+
+    void WriteLocked(std::string_view data)
+    {
+        while (!data.empty())
+        {
+            ssize_t written = ::write(_fd, data.data(), data.size());
+            if (written < 0)
+            {
+                if (errno == EINTR)
+                {
+                    continue;
+                }
+                return;
+            }
+            data.remove_prefix(static_cast<std::size_t>(written));
+        }
+    }
+
+    std::mutex _rings_mutex;
+    std::vector<std::shared_ptr<LogRing>> _rings;
+    std::uint32_t _next_id = 0;
+    std::uint64_t _retired_dropped = 0;
+    std::atomic<std::size_t> _ring_size{kDefaultRingSize};
+
+    std::mutex _sink_mutex;
+    int _fd = STDOUT_FILENO;
+    LineFormatter _sync_formatter;
+    std::string _sync_line;
+
+    std::mutex _wake_mutex;
+    std::condition_variable _wake;
+    std::condition_variable _flushed_cv;
+    std::uint64_t _flush_requested = 0;
+    std::uint64_t _flush_done = 0;
+
+    std::atomic<bool> _running{false};
+    LineFormatter _formatter;
+    std::thread _writer;
+};
+
+/// 永不析构：静态对象析构期间的日志仍然可用
+LoggerBackend &Backend()
+{
+    static LoggerBackend *backend = new LoggerBackend;
+    return *backend;
+}
+
+/// 本线程的环已析构 (线程退出阶段)；平凡析构，析构后读取仍然安全
+thread_local bool t_ring_released = false;
+
+struct ThreadRing
+{
+    std::shared_ptr<LogRing> ring;
+
+    ~ThreadRing()
+    {
+        if (ring)
+        {
+            ring->Retire();
+        }
+        t_ring_released = true;
+    }
+};
+
+thread_local ThreadRing t_ring;
+
+bool NeedsQuoting(std::string_view value)
+{
+    if (value.empty())
+    {
+        return true;
+    }
+    for (char c : value)
+    {
+        if (static_cast<unsigned char>(c) <= ' ' || c == '"' || c == '=' || c == '\\' || c == 0x7f)
+        {
+            return true;
+        }
+    }
+    return false;
+}
+} // namespace
+
+LogLevel ParseLogLevel(const std::string &name)
+{
+    std::string lower(name);
+    std::transform(lower.begin(), lower.end(), lower.begin(), [](unsigned char c) { return std::tolower(c); });
+    if (lower == "trace")
+    {
+        return LogLevel::Trace;
+    }
+    if (lower == "debug")
+    {
+        return LogLevel::Debug;
+    }
+    if (lower == "warn" || lower == "warning")
+    {
+        return LogLevel::Warn;
+    }
+    if (lower == "error")
+    {
+        return LogLevel::Error;
+    }
+    if (lower == "off")
+    {
+        return LogLevel::Off;
+    }
+    return LogLevel::Info;
+}
+
+std::string_view LogLevelName(LogLevel level)
+{
+    switch (level)
+    {
+    case LogLevel::Trace:
+        return "TRACE";
+    case LogLevel::Debug:
+        return "DEBUG";
+    case LogLevel::Info:
+        return "INFO ";
+    case LogLevel::Warn:
+        return "WARN ";
+    case LogLevel::Error:
+        return "ERROR";
+    default:
+        return "OFF  ";
+    }
+}
+
+void Logger::SetLevel(LogLevel level)
+{
+    _level.store(static_cast<std::uint8_t>(level), std::memory_order_relaxed);
+}
+
+LogLevel Logger::GetLevel()
+{
+    return static_cast<LogLevel>(_level.load(std::memory_order_relaxed));
+}
+
+bool Logger::SetOutput(const std::string &path)
+{
+    return Backend().SetOutput(path);
+}
+
+void Logger::SetRingSize(std::size_t bytes)
+{
+    Backend().SetRingSize(bytes);
+}
+
+void Logger::Commit(LogLevel level, std::uint64_t time_ns, std::string_view text)
+{
+    LoggerBackend &backend = Backend();
+    if (t_ring_released || !backend.Running())
+    {
+        backend.WriteSync(level, time_ns, text);
+        return;
+    }
+    if (!t_ring.ring)
+    {
+        t_ring.ring = backend.Register();
+    }
+    t_ring.ring->TryPush(level, time_ns, text);
+    if (level >= LogLevel::Error)
+    {
+        backend.Wake();
+    }
+}
+
+void Logger::Flush()
+{
+    Backend().Flush();
+}
+
+void Logger::Shutdown()
+{
+    Backend().Shutdown();
+}
+
+std::uint64_t Logger::Dropped()
+{
+    return Backend().Dropped();
+}
+
+LogRecord::LogRecord(LogLevel level, std::string_view message)
+    : _level(level),
+      _time_ns(NowNs())
+{
+    Append(message);
+    if (Logger::RequestId() != 0)
+    {
+        Field("req", Logger::RequestId());
+    }
+}
+
+LogRecord::~LogRecord()
+{
+    if (_truncated)
+    {
+        std::memcpy(_text + _size - 3, "...", 3);
+    }
+    Logger::Commit(_level, _time_ns, std::string_view(_text, _size));
+}
+
+LogRecord &LogRecord::Field(std::string_view key, std::string_view value)
+{
+    AppendKey(key);
+    if (NeedsQuoting(value))
+    {
+        AppendQuoted(value);
+    }
+    else
+    {
+        Append(value);
+    }
+    return *this;
+}
+
+void LogRecord::AppendKey(std::string_view key)
+{
+    Append(" ");
+    Append(key);
+    Append("=");
+}
+
+void LogRecord::Append(std::string_view text)
+{
+    std::size_t room = kMaxLogRecord - _size;
+    if (text.size() > room)
+    {
+        _truncated = true;
+        text = text.substr(0, room);
+    }
+    std::memcpy(_text + _size, text.data(), text.size());
+    _size += text.size();
+}
+
+void LogRecord::AppendQuoted(std::string_view value)
+{
+    static constexpr char kHex[] = "0123456789abcdef";
+    Append("\"");
+    std::size_t start = 0;
+    for (std::size_t i = 0; i < value.size() && !_truncated; ++i)
+    {
+        unsigned char c = static_cast<unsigned char>(value[i]);
+        if (c >= 0x20 && c != '"' && c != '\\' && c != 0x7f)
+        {
+            continue;
+        }
+        Append(value.substr(start, i - start));
+        start = i + 1;
+        switch (c)
+        {
+        case '"':
+            Append("\\\"");
+            break;
+        case '\\':
+            Append("\\\\");
+            break;
+        case '\n':
+            Append("\\n");
+            break;
+        case '\r':
+            Append("\\r");
+            break;
+        case '\t':
+            Append("\\t");
+            break;
+        default:
+        {
+            char escaped[4] = {'\\', 'x', kHex[c >> 4], kHex[c & 0xf]};
+            Append(std::string_view(escaped, sizeof(escaped)));
+            break;
+        }
+        }
+    }
+    if (start < value.size())
+    {
+        Append(value.substr(start));
+    }
+    Append("\"");
+}
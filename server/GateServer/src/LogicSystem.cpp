@@ -5,195 +5,407 @@
  */
 
 #include "LogicSystem.h"
+#include "ConfigMgr.h"
 #include "HttpConnection.h"
+#include "HttpResponder.h"
+#include "DtoProto.h"
+#include "GateMessages.h"
+#include "JsonCodec.h"
+#include "Logger.h"
 #include "MysqlMgr.h"
-#include "RedisMgr.h"
+#include "VerifyCodeStore.h"
+#include "RequestTrace.h"
 #include "VerifyGrpcClient.h"
 #include "const.h"
-#include <iostream>
-#include <jsoncpp/json/json.h>
-#include <jsoncpp/json/reader.h>
-#include <jsoncpp/json/value.h>
+#include <algorithm>
+#include <cstdlib>
+
+namespace
+{
+std::size_t ConfigSize(const std::string &key, std::size_t fallback)
+{
+    std::string configured = ConfigMgr::GetInstance()["Workers"][key];
+    if (configured.empty())
+    {
+        return fallback;
+    }
+    return static_cast<std::size_t>(std::max(0, std::atoi(configured.c_str())));
+}
+
+/**
+ * @brief   按 Content-Type / Accept 协商本次请求的编码格式，并设置响应的 Content-Type
+ */
+WireNegotiation Negotiate(const HttpResponder &responder)
+{
+    const auto &request = responder.Request();
+    WireNegotiation wire = NegotiateWireFormat(request[http::field::content_type], request[http::field::accept]);
+    responder.Response().set(http::field::content_type, ContentTypeOf(wire.response));
+    return wire;
+}
+
+/**
+ * @brief   打印请求 Body；protobuf 是二进制，只打印长度
+ */
+void LogRequestBody(const HttpResponder &responder, WireFormat format)
+{
+    const auto &body = responder.Request().body();
+    if (format == WireFormat::Protobuf)
+    {
+        LOG_DEBUG("receive protobuf body").Field("bytes", body.size());
+        return;
+    }
+    LOG_DEBUG("receive body")
+        .Field("body", std::string_view(static_cast<const char *>(body.data().data()), body.size()));
+}
+
+/**
+ * @brief   回复预先序列化好的错误码并完成请求
+ */
+void ReplyError(const HttpResponder &responder, WireFormat format, ChatApp::ErrorCode code)
+{
+    std::string_view body = ErrorBody(code, format);
+    auto &buffer = responder.Response().body();
+    buffer.commit(net::buffer_copy(buffer.prepare(body.size()), net::buffer(body.data(), body.size())));
+    responder.Send();
+}
+
+/**
+ * @brief   按协商的格式编码响应 DTO 并完成请求
+ */
+template <typename T>
+void Reply(const HttpResponder &responder, WireFormat format, const T &response)
+{
+    {
+        // Send() 之后本线程的 Span 不再记录，编码单独计时
+        TRACE_SPAN("encode");
+        if (format == WireFormat::Protobuf)
+        {
+            DtoEncodeProto(response, responder.Response().body());
+        }
+        else
+        {
+            JsonWriter writer(responder.Response().body());
+            DtoEncode(writer, response);
+        }
+    }
+    responder.Send();
+}
+
+/**
+ * @brief   按协商的格式解码请求 Body 并按 DTO 的 Schema 校验，失败时回 Error_Json
+ * @return  false 已回复错误，Handler 直接返回
+ */
+template <typename T>
+bool DecodeRequest(const HttpResponder &responder, const WireNegotiation &wire, T &request)
+{
+    TRACE_SPAN("decode");
+    const auto &body = responder.Request().body();
+    DtoStatus status;
+    if (wire.request == WireFormat::Protobuf)
+    {
+        status = DtoDecodeProto(std::string_view(static_cast<const char *>(body.data().data()), body.size()), request);
+    }
+    else
+    {
+        JsonDocument document;
+        if (!document.Parse(body))
+        {
+            LOG_WARN("failed to parse JSON body");
+            ReplyError(responder, wire.response, ChatApp::ErrorCode::Error_Json);
+            return false;
+        }
+        status = DtoDecode(document, request);
+    }
+    if (!status)
+    {
+        LOG_WARN("invalid request").Field("field", status.field).Field("reason", status.reason);
+        ReplyError(responder, wire.response, ChatApp::ErrorCode::Error_Json);
+        return false;
+    }
+    return true;
+}
+} // namespace
 
 LogicSystem::LogicSystem()
 {
+    _cpuPool = std::make_unique<WorkerPool>("cpu", ConfigSize("CpuThreads", 0), ConfigSize("CpuQueue", 1024));
+    _ioPool = std::make_unique<WorkerPool>("blocking-io", ConfigSize("IoThreads", 16), ConfigSize("IoQueue", 4096));
+
+    _unmatched = &Metrics::GetInstance()->Unmatched();
+    _pool_collector = Metrics::AddCollector(
+        [this](MetricsWriter &writer)
+        {
+            for (const WorkerPool *pool : {_cpuPool.get(), _ioPool.get()})
+            {
+                WorkerPool::Stats stats = pool->GetStats();
+                std::string labels = "pool=\"" + pool->Name() + "\"";
+                writer.Gauge("gate_worker_pool_threads", "Worker pool threads.", labels, stats.threads);
+                writer.Gauge("gate_worker_pool_busy", "Worker pool threads running a task.", labels, stats.busy);
+                writer.Gauge("gate_worker_pool_queue_depth", "Tasks waiting in the worker pool queue.", labels,
+                             stats.depth);
+                writer.Gauge("gate_worker_pool_queue_capacity", "Worker pool queue capacity.", labels, stats.capacity);
+                writer.Counter("gate_worker_pool_rejected_total", "Tasks rejected because the queue was full.", labels,
+                               stats.rejected);
+                writer.Counter("gate_worker_pool_completed_total", "Tasks completed by the worker pool.", labels,
+                               stats.completed);
+            }
+        });
+
+    // 注册 /metrics 路由 (Prometheus 抓取)；遍历各分片有一定计算量，放到 CPU 线程池
+    RegisterGet(
+        "/metrics",
+        [](HttpResponder responder)
+        {
+            std::string text;
+            Metrics::GetInstance()->Render(text);
+            responder.Response().set(http::field::content_type, "text/plain; version=0.0.4");
+            auto &body = responder.Response().body();
+            body.commit(net::buffer_copy(body.prepare(text.size()), net::buffer(text)));
+            responder.Send();
+        },
+        ExecPolicy::Cpu);
+
     // 注册 /get_test 路由
     RegisterGet(
         "/get_test",
-        [](std::shared_ptr<HttpConnection> connection)
+        [](HttpResponder responder)
         {
-            beast::ostream(connection->_response.body()) << "receive get_test req " << std::endl;
+            beast::ostream(responder.Response().body()) << "receive get_test req " << std::endl;
             int i = 0;
-            for (auto &elem : connection->_get_params)
+            for (const auto &param : responder.GetParams())
             {
                 i++;
-                beast::ostream(connection->_response.body()) << "param" << i << " key is " << elem.first;
-                beast::ostream(connection->_response.body()) << ", " << " value is " << elem.second << std::endl;
+                beast::ostream(responder.Response().body()) << "param" << i << " key is " << param.key;
+                beast::ostream(responder.Response().body()) << ", " << " value is " << param.value << std::endl;
             }
+            responder.Send();
         });
 
     // 注册 /get_varifycode 路由
     RegisterPost(
         "/get_varifycode",
-        [](std::shared_ptr<HttpConnection> connection)
+        [](HttpResponder responder)
         {
             /**
-             * @note [Memory Copy]
-             * buffers_to_string 会将分散在 buffer 中的数据拷贝并拼接成一个 std::string。
+             * @note [Zero Copy]
+             * Body 是连续的 flat_buffer，JsonDocument / protobuf 直接在其上解析，不再 buffers_to_string 拷贝一份。
              */
-            auto body_str = boost::beast::buffers_to_string(connection->_request.body().data());
-            std::cout << "receive body is " << body_str << std::endl;
-
-            connection->_response.set(http::field::content_type, "text/json");
-            Json::Value response_json;
-            Json::Value request_json;
-            Json::Reader reader;
+            WireNegotiation wire = Negotiate(responder);
+            LogRequestBody(responder, wire.request);
 
             /**
-             * @warning [PERFORMANCE BOTTLENECK] (性能瓶颈)
-             * 此处的 JSON 解析是在主 IO 线程 (Reactor Thread) 中同步执行的。
-             * 1. 这是一个 CPU 密集型操作。
-             * 2. 如果 JSON 数据很大，或者并发很高，会阻塞 io_context，导致无法处理其他 socket 的 accept/read。
-             * 3. 架构建议：将此类业务逻辑投递 (post) 到 Worker 线程池中处理。
+             * @note JSON 解析与后面的 gRPC / Redis 调用都是同步的，
+             *       该路由注册为 BlockingIO，在线程池中执行，不阻塞 io_context。
              */
-            bool parse_success = reader.parse(body_str, request_json);
-            if (!parse_success)
+            VerifyCodeRequest request;
+            if (!DecodeRequest(responder, wire, request))
             {
-                std::cout << "Failed to parse JSON data!" << std::endl;
-                response_json["error"] = static_cast<int>(ChatApp::ErrorCode::Error_Json);
-                std::string jsonstr = response_json.toStyledString();
-                beast::ostream(connection->_response.body()) << jsonstr;
-                return true;
+                return;
             }
 
-            // 提取 email 字段
-            auto email = request_json["email"].asString();
-            std::cout << "email is " << email << std::endl;
             // 调用 gRPC 客户端获取验证码
-            GetVerifyResponse rsp = VerifyGrpcClient::GetInstance()->GetVerifyCode(email);
-            std::string code = rsp.code();
-            std::cout << "get varify code is " << code << std::endl;
-            response_json["code"] = code;
-            response_json["email"] = email;
-            
-            // 将验证码写入 Redis (无 TTL，符合“一直有效”的需求)
-            RedisMgr::GetInstance()->Set(email, code);
-
-            response_json["error"] = static_cast<int>(ChatApp::ErrorCode::Success);
-            std::string jsonstr = response_json.toStyledString();
-            beast::ostream(connection->_response.body()) << jsonstr;
-            return true;
-        });
+            GetVerifyResponse rsp = VerifyGrpcClient::GetInstance()->GetVerifyCode(request.email);
+            LOG_DEBUG("get varify code").Field("email", request.email).Field("code", rsp.code());
+
+            // 将验证码写入 Redis (有效期见 [Redis] VerifyCodeTtl，默认一直有效)
+            VerifyCodeStore::GetInstance()->Save(request.email, rsp.code());
+
+            VerifyCodeResponse response{rsp.code(), std::move(request.email),
+                                        static_cast<int>(ChatApp::ErrorCode::Success)};
+            Reply(responder, wire.response, response);
+            return;
+        },
+        ExecPolicy::BlockingIO);
 
+    // 注册走 MySQL 同步写入，同样放到阻塞 IO 线程池
     RegisterPost(
         "/user_register",
-        [](std::shared_ptr<HttpConnection> connection)
+        [](HttpResponder responder)
         {
-            auto body_str = boost::beast::buffers_to_string(connection->_request.body().data());
-            std::cout << "receive body is " << body_str << std::endl;
-            connection->_response.set(http::field::content_type, "text/json");
-            Json::Value response_json;
-            Json::Value request_json;
-            Json::Reader reader;
-            bool parse_success = reader.parse(body_str, request_json);
-            if (!parse_success)
-            {
-                std::cout << "Failed to parse JSON data!" << std::endl;
-                response_json["error"] = static_cast<int>(ChatApp::ErrorCode::Error_Json);
-                std::string jsonstr = response_json.toStyledString();
-                beast::ostream(connection->_response.body()) << jsonstr;
-                return true;
-            }
-            // 验证码校验 (走 Mock Redis)
-            std::string varify_code;
-            bool b_get_varify = RedisMgr::GetInstance()->Get(request_json["email"].asString(), varify_code);
-            if (!b_get_varify)
-            {
-                // Mock 版其实不会进这里，因为 Get 永远返回 true
-                std::cout << " get varify code expired" << std::endl;
-                response_json["error"] = static_cast<int>(ChatApp::ErrorCode::VarifyExpired);
-                std::string jsonstr = response_json.toStyledString();
-                beast::ostream(connection->_response.body()) << jsonstr;
-                return true;
-            }
-            if (varify_code != request_json["varifycode"].asString())
+            WireNegotiation wire = Negotiate(responder);
+            LogRequestBody(responder, wire.request);
+            RegisterRequest request;
+            if (!DecodeRequest(responder, wire, request))
             {
-                std::cout << " varify code error" << std::endl;
-                response_json["error"] = static_cast<int>(ChatApp::ErrorCode::VarifyCodeErr);
-                std::string jsonstr = response_json.toStyledString();
-                beast::ostream(connection->_response.body()) << jsonstr;
-                return true;
+                return;
             }
-            // 访问redis查找
-            bool b_usr_exist = RedisMgr::GetInstance()->ExistsKey(request_json["user"].asString());
-            if (b_usr_exist)
+
+            // 验证码存在 / 一致 / 用户名未占用在 Redis 端一次原子判断，通过时验证码作废 (一个 RTT)
+            auto verify = VerifyCodeStore::GetInstance()->VerifyAndConsume(request.email, request.varifycode,
+                                                                           request.user);
+            switch (verify)
             {
-                std::cout << " user exist" << std::endl;
-                response_json["error"] = static_cast<int>(ChatApp::ErrorCode::UserExist);
-                std::string jsonstr = response_json.toStyledString();
-                beast::ostream(connection->_response.body()) << jsonstr;
-                return true;
+            case VerifyCodeStore::Result::Ok:
+                break;
+            case VerifyCodeStore::Result::Mismatch:
+                LOG_INFO("varify code error").Field("email", request.email);
+                ReplyError(responder, wire.response, ChatApp::ErrorCode::VarifyCodeErr);
+                return;
+            case VerifyCodeStore::Result::UserExists:
+                LOG_INFO("user exist").Field("user", request.user);
+                ReplyError(responder, wire.response, ChatApp::ErrorCode::UserExist);
+                return;
+            case VerifyCodeStore::Result::Expired:
+            case VerifyCodeStore::Result::Error:
+                LOG_INFO("varify code expired")
+                    .Field("email", request.email)
+                    .Field("result", VerifyCodeStore::Name(verify));
+                ReplyError(responder, wire.response, ChatApp::ErrorCode::VarifyExpired);
+                return;
             }
             // 查找数据库判断用户是否存在
             // 5. 【核心修正】真正写入 MySQL
-            int uid = MysqlMgr::GetInstance()->RegUser(
-                request_json["user"].asString(), request_json["email"].asString(), request_json["passwd"].asString(),
-                "" // icon 默认为空
+            int uid = MysqlMgr::GetInstance()->RegUser(request.user, request.email, request.passwd,
+                                                        "" // icon 默认为空
             );
 
             // 如果 MySQL 返回 0 或 -1，说明用户名或邮箱已存在
             if (uid == 0 || uid == -1)
             {
-                std::cout << "User or email exist in DB" << std::endl;
-                response_json["error"] = static_cast<int>(ChatApp::ErrorCode::UserExist);
-                beast::ostream(connection->_response.body()) << response_json.toStyledString();
-                return true;
+                LOG_INFO("user or email exist in DB").Field("user", request.user).Field("email", request.email);
+                ReplyError(responder, wire.response, ChatApp::ErrorCode::UserExist);
+                return;
             }
 
             // 6. 返回成功 (带上生成的 uid)
-            std::cout << "Register Success, uid: " << uid << std::endl;
-            response_json["error"] = 0;
-            response_json["uid"] = uid; // 把 uid 给客户端
-            response_json["email"] = request_json["email"];
-            response_json["user"] = request_json["user"];
+            LOG_INFO("register success").Field("uid", uid).Field("user", request.user);
             // 不要返回密码
-            beast::ostream(connection->_response.body()) << response_json.toStyledString();
-            return true;
-        });
+            RegisterResponse response{std::move(request.email), static_cast<int>(ChatApp::ErrorCode::Success), uid,
+                                      std::move(request.user)};
+            Reply(responder, wire.response, response);
+            return;
+        },
+        ExecPolicy::BlockingIO);
+}
+
+namespace
+{
+/**
+ * @brief   同步 Handler 适配为完成式 Handler
+ */
+HttpHandler AdaptSync(SyncHttpHandler handler)
+{
+    return [handler = std::move(handler)](HttpResponder responder)
+    {
+        handler(responder.Connection());
+        responder.Send();
+    };
+}
+
+/**
+ * @brief   调用 Handler，同步抛出的异常转为 500
+ */
+void Invoke(const HttpHandler &handler, std::shared_ptr<HttpConnection> connection)
+{
+    HttpResponder responder(std::move(connection));
+    try
+    {
+        handler(responder);
+    }
+    catch (std::exception &exp)
+    {
+        LOG_ERROR("handler exception").Field("what", exp.what());
+        responder.Fail(http::status::internal_server_error, "internal error\r\n");
+    }
+}
+} // namespace
+
+void LogicSystem::Register(http::verb method, std::string url, HttpHandler handler, ExecPolicy policy)
+{
+    if (!_router.Add(method, url, _routes.size()))
+    {
+        LOG_WARN("duplicate or invalid route ignored").Field("method", http::to_string(method)).Field("url", url);
+        return;
+    }
+    RouteMetrics &metrics = Metrics::GetInstance()->AddRoute(std::string(http::to_string(method)), std::move(url));
+    _routes.push_back(Route{std::move(handler), policy, &metrics});
+}
+
+void LogicSystem::RegisterGet(std::string url, HttpHandler handler, ExecPolicy policy)
+{
+    Register(http::verb::get, std::move(url), std::move(handler), policy);
 }
 
-void LogicSystem::RegisterGet(std::string url, HttpHandler handler)
+void LogicSystem::RegisterGet(std::string url, SyncHttpHandler handler, ExecPolicy policy)
 {
-    _registerGet.emplace(url, handler);
+    RegisterGet(std::move(url), AdaptSync(std::move(handler)), policy);
 }
 
-void LogicSystem::RegisterPost(std::string url, HttpHandler handler)
+void LogicSystem::RegisterPost(std::string url, HttpHandler handler, ExecPolicy policy)
 {
-    _registerPost.emplace(url, handler);
+    Register(http::verb::post, std::move(url), std::move(handler), policy);
 }
 
-bool LogicSystem::HandleGet(std::string path, std::shared_ptr<HttpConnection> connection)
+void LogicSystem::RegisterPost(std::string url, SyncHttpHandler handler, ExecPolicy policy)
 {
-    if (_registerGet.find(path) != _registerGet.end())
+    RegisterPost(std::move(url), AdaptSync(std::move(handler)), policy);
+}
+
+Router::Result LogicSystem::Handle(http::verb method, std::string_view path,
+                                   std::shared_ptr<HttpConnection> connection)
+{
+    std::size_t index = 0;
+    Router::Result result = _router.Find(method, path, index, connection->_path_params);
+    if (result == Router::Result::Found)
     {
-        _registerGet[path](connection);
-        return true;
+        connection->_metrics = _routes[index].metrics;
+        Dispatch(_routes[index], std::move(connection));
     }
     else
     {
-        return false;
+        connection->_metrics = _unmatched;
     }
+    return result;
 }
 
-bool LogicSystem::HandlePost(std::string path, std::shared_ptr<HttpConnection> connection)
+const WorkerPool *LogicSystem::GetPool(ExecPolicy policy) const
 {
-    if (_registerPost.find(path) != _registerPost.end())
+    switch (policy)
     {
-        _registerPost[path](connection);
-        return true;
+    case ExecPolicy::Cpu:
+        return _cpuPool.get();
+    case ExecPolicy::BlockingIO:
+        return _ioPool.get();
+    default:
+        return nullptr;
     }
-    else
+}
+
+void LogicSystem::Stop()
+{
+    _cpuPool->Stop();
+    _ioPool->Stop();
+}
+
+void LogicSystem::Dispatch(const Route &route, std::shared_ptr<HttpConnection> connection)
+{
+    if (route.policy == ExecPolicy::Inline)
     {
-        return false;
+        TraceScope scope(connection->_trace);
+        Invoke(route.handler, std::move(connection));
+        return;
+    }
+
+    // Handler 执行期间 IO 线程不会访问该连接的 request / response (没有挂起的读写)
+    WorkerPool &pool = (route.policy == ExecPolicy::Cpu) ? *_cpuPool : *_ioPool;
+    const HttpHandler *handler = &route.handler;
+    std::uint64_t queued = connection->_trace.Active() ? Metrics::Now() : 0;
+    bool accepted = pool.TryPost(
+        [handler, connection, queued]()
+        {
+            TraceScope scope(connection->_trace);
+            if (RequestTrace::Current() != nullptr)
+            {
+                connection->_trace.Add("queue", queued, Metrics::Now());
+            }
+            Invoke(*handler, connection);
+        });
+
+    if (!accepted)
+    {
+        LOG_WARN("worker queue full, reject")
+            .Field("pool", pool.Name())
+            .Field("target", connection->_request.target());
+        HttpResponder(std::move(connection)).Fail(http::status::service_unavailable, "server busy\r\n");
     }
 }
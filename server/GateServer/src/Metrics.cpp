@@ -0,0 +1,325 @@
+/**
+ * @file    Metrics.cpp
+ * @brief   指标注册表与 Prometheus 文本格式导出
+ * @author  msr
+ */
+
+#include "Metrics.h"
+#include <charconv>
+#include <cstdio>
+
+namespace
+{
+/// 导出直方图时的 le 边界: 1us .. 2^25us (约 33 秒)，均落在桶边界上，累计值精确
+constexpr int kExportOctaves = 26;
+
+constexpr double kQuantiles[] = {0.5, 0.9, 0.99, 0.999};
+
+void AppendNumber(std::string &out, double value)
+{
+    char text[32];
+    int n = std::snprintf(text, sizeof(text), "%.9g", value);
+    out.append(text, static_cast<std::size_t>(n));
+}
+
+void AppendInteger(std::string &out, std::uint64_t value)
+{
+    char text[24];
+    auto result = std::to_chars(text, text + sizeof(text), value);
+    out.append(text, static_cast<std::size_t>(result.ptr - text));
+}
+
+/**
+ * @brief   标签值转义 (\\ " 换行)
+ */
+void AppendLabelValue(std::string &out, std::string_view value)
+{
+    for (char c : value)
+    {
+        if (c == '\\' || c == '"')
+        {
+            out.push_back('\\');
+            out.push_back(c);
+        }
+        else if (c == '\n')
+        {
+            out.append("\\n");
+        }
+        else
+        {
+            out.push_back(c);
+        }
+    }
+}
+
+void AppendRouteLabels(std::string &out, const RouteMetrics &route)
+{
+    out.append("method=\"");
+    AppendLabelValue(out, route.Method());
+    out.append("\",route=\"");
+    AppendLabelValue(out, route.Route());
+    out.push_back('"');
+}
+
+void AppendHeader(std::string &out, std::string_view name, std::string_view help, std::string_view type)
+{
+    out.append("# HELP ").append(name).append(" ").append(help).append("\n");
+    out.append("# TYPE ").append(name).append(" ").append(type).append("\n");
+}
+} // namespace
+
+RouteMetrics::RouteMetrics(std::string method, std::string route)
+    : _method(std::move(method)),
+      _route(std::move(route)),
+      _shards(new Shard[kShards])
+{
+}
+
+std::size_t RouteMetrics::ShardIndex()
+{
+    static std::atomic<std::size_t> next{0};
+    thread_local std::size_t index = next.fetch_add(1, std::memory_order_relaxed) % kShards;
+    return index;
+}
+
+RouteMetrics::Snapshot RouteMetrics::Collect() const
+{
+    Snapshot snapshot;
+    for (std::size_t s = 0; s < kShards; ++s)
+    {
+        const Shard &shard = _shards[s];
+        for (std::size_t i = 0; i < LatencyHistogram::kBuckets; ++i)
+        {
+            snapshot.buckets[i] += shard.buckets[i].load(std::memory_order_relaxed);
+        }
+        for (std::size_t i = 0; i < snapshot.status.size(); ++i)
+        {
+            snapshot.status[i] += shard.status[i].load(std::memory_order_relaxed);
+        }
+        snapshot.sum_us += shard.sum_us.load(std::memory_order_relaxed);
+    }
+    // count 取桶的合计，保证与 _bucket{le="+Inf"} 一致 (各计数器之间不是原子快照)
+    for (std::uint64_t n : snapshot.buckets)
+    {
+        snapshot.count += n;
+    }
+    return snapshot;
+}
+
+std::uint64_t RouteMetrics::Snapshot::Quantile(double q) const
+{
+    if (count == 0)
+    {
+        return 0;
+    }
+    auto rank = static_cast<std::uint64_t>(q * static_cast<double>(count));
+    std::uint64_t seen = 0;
+    for (std::size_t i = 0; i < buckets.size(); ++i)
+    {
+        seen += buckets[i];
+        if (seen > rank)
+        {
+            return i < 2 * LatencyHistogram::kSubCount ? i : LatencyHistogram::Upper(i);
+        }
+    }
+    return LatencyHistogram::Upper(buckets.size() - 1);
+}
+
+void MetricsWriter::Gauge(std::string_view name, std::string_view help, std::string_view labels, double value)
+{
+    Add("gauge", name, help, labels, value);
+}
+
+void MetricsWriter::Counter(std::string_view name, std::string_view help, std::string_view labels, double value)
+{
+    Add("counter", name, help, labels, value);
+}
+
+void MetricsWriter::Add(const char *type, std::string_view name, std::string_view help, std::string_view labels,
+                        double value)
+{
+    auto it = _families.find(name);
+    if (it == _families.end())
+    {
+        it = _families.emplace(std::string(name), Family{std::string(help), type, {}}).first;
+    }
+    it->second.samples.emplace_back(std::string(labels), value);
+}
+
+void MetricsWriter::Render(std::string &out) const
+{
+    for (const auto &[name, family] : _families)
+    {
+        AppendHeader(out, name, family.help, family.type);
+        for (const auto &[labels, value] : family.samples)
+        {
+            out.append(name);
+            if (!labels.empty())
+            {
+                out.append("{").append(labels).append("}");
+            }
+            out.push_back(' ');
+            AppendNumber(out, value);
+            out.push_back('\n');
+        }
+    }
+}
+
+Metrics::CollectorHandle::CollectorHandle(std::shared_ptr<Metrics> owner, std::uint64_t id)
+    : _owner(std::move(owner)),
+      _id(id)
+{
+}
+
+Metrics::CollectorHandle::~CollectorHandle()
+{
+    if (_owner)
+    {
+        _owner->RemoveCollector(_id);
+    }
+}
+
+Metrics::CollectorHandle::CollectorHandle(CollectorHandle &&other) noexcept
+    : _owner(std::move(other._owner)),
+      _id(other._id)
+{
+}
+
+Metrics::CollectorHandle &Metrics::CollectorHandle::operator=(CollectorHandle &&other) noexcept
+{
+    if (this != &other)
+    {
+        if (_owner)
+        {
+            _owner->RemoveCollector(_id);
+        }
+        _owner = std::move(other._owner);
+        _id = other._id;
+    }
+    return *this;
+}
+
+Metrics::Metrics()
+{
+    _unmatched = &_routes.emplace_back("", "unmatched");
+}
+
+RouteMetrics &Metrics::AddRoute(std::string method, std::string route)
+{
+    std::lock_guard<std::mutex> lock(_mtx);
+    return _routes.emplace_back(std::move(method), std::move(route));
+}
+
+RouteMetrics &Metrics::Unmatched()
+{
+    return *_unmatched;
+}
+
+Metrics::CollectorHandle Metrics::AddCollector(Collector collector)
+{
+    auto self = GetInstance();
+    std::lock_guard<std::mutex> lock(self->_mtx);
+    std::uint64_t id = ++self->_next_collector;
+    self->_collectors.emplace(id, std::move(collector));
+    return CollectorHandle(self, id);
+}
+
+void Metrics::RemoveCollector(std::uint64_t id)
+{
+    std::lock_guard<std::mutex> lock(_mtx);
+    _collectors.erase(id);
+}
+
+void Metrics::Render(std::string &out)
+{
+    std::lock_guard<std::mutex> lock(_mtx);
+
+    std::vector<RouteMetrics::Snapshot> snapshots;
+    snapshots.reserve(_routes.size());
+    for (const auto &route : _routes)
+    {
+        snapshots.push_back(route.Collect());
+    }
+
+    AppendHeader(out, "gate_http_requests_total", "HTTP requests by route and status class.", "counter");
+    static constexpr const char *kClasses[] = {"invalid", "1xx", "2xx", "3xx", "4xx", "5xx"};
+    for (std::size_t r = 0; r < _routes.size(); ++r)
+    {
+        for (std::size_t c = 0; c < snapshots[r].status.size(); ++c)
+        {
+            if (snapshots[r].status[c] == 0)
+            {
+                continue;
+            }
+            out.append("gate_http_requests_total{");
+            AppendRouteLabels(out, _routes[r]);
+            out.append(",code=\"").append(kClasses[c]).append("\"} ");
+            AppendInteger(out, snapshots[r].status[c]);
+            out.push_back('\n');
+        }
+    }
+
+    AppendHeader(out, "gate_http_request_duration_seconds",
+                 "Time from request parsed to response ready, by route.", "histogram");
+    for (std::size_t r = 0; r < _routes.size(); ++r)
+    {
+        const auto &snapshot = snapshots[r];
+        std::uint64_t cumulative = 0;
+        std::size_t bucket = 0;
+        for (int octave = 0; octave < kExportOctaves; ++octave)
+        {
+            std::uint64_t le_us = std::uint64_t{1} << octave;
+            while (bucket < snapshot.buckets.size() && LatencyHistogram::Upper(bucket) <= le_us)
+            {
+                cumulative += snapshot.buckets[bucket++];
+            }
+            out.append("gate_http_request_duration_seconds_bucket{");
+            AppendRouteLabels(out, _routes[r]);
+            out.append(",le=\"");
+            AppendNumber(out, static_cast<double>(le_us) / 1e6);
+            out.append("\"} ");
+            AppendInteger(out, cumulative);
+            out.push_back('\n');
+        }
+        out.append("gate_http_request_duration_seconds_bucket{");
+        AppendRouteLabels(out, _routes[r]);
+        out.append(",le=\"+Inf\"} ");
+        AppendInteger(out, snapshot.count);
+        out.append("\ngate_http_request_duration_seconds_sum{");
+        AppendRouteLabels(out, _routes[r]);
+        out.append("} ");
+        AppendNumber(out, static_cast<double>(snapshot.sum_us) / 1e6);
+        out.append("\ngate_http_request_duration_seconds_count{");
+        AppendRouteLabels(out, _routes[r]);
+        out.append("} ");
+        AppendInteger(out, snapshot.count);
+        out.push_back('\n');
+    }
+
+    AppendHeader(out, "gate_http_request_duration_quantile_seconds",
+                 "Latency quantiles from the HDR histogram (upper bound of the bucket).", "gauge");
+    for (std::size_t r = 0; r < _routes.size(); ++r)
+    {
+        if (snapshots[r].count == 0)
+        {
+            continue;
+        }
+        for (double q : kQuantiles)
+        {
+            out.append("gate_http_request_duration_quantile_seconds{");
+            AppendRouteLabels(out, _routes[r]);
+            out.append(",quantile=\"");
+            AppendNumber(out, q);
+            out.append("\"} ");
+            AppendNumber(out, static_cast<double>(snapshots[r].Quantile(q)) / 1e6);
+            out.push_back('\n');
+        }
+    }
+
+    MetricsWriter writer;
+    for (const auto &[id, collector] : _collectors)
+    {
+        collector(writer);
+    }
+    writer.Render(out);
+}
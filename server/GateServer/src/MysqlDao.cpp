@@ -1,4 +1,6 @@
 #include "MysqlDao.h"
+#include "Logger.h"
+#include "RequestTrace.h"
 
 MysqlDao::MysqlDao()
 {
@@ -20,7 +22,13 @@ MysqlDao::~MysqlDao()
 
 int MysqlDao::RegUser(const std::string &name, const std::string &email, const std::string &pwd, const std::string &icon)
 {
-    auto con = pool_->getConnection();
+    TRACE_SPAN("mysql.reg_user");
+    std::unique_ptr<sql::Connection> con;
+    {
+        // 连接池耗尽时在这里排队
+        TRACE_SPAN("mysql.acquire");
+        con = pool_->getConnection();
+    }
     if (con == nullptr)
     {
         return 0;
@@ -33,7 +41,11 @@ int MysqlDao::RegUser(const std::string &name, const std::string &email, const s
         stmt->setString(1, name);
         stmt->setString(2, email);
         
-        std::unique_ptr<sql::ResultSet> res(stmt->executeQuery());
+        std::unique_ptr<sql::ResultSet> res;
+        {
+            TRACE_SPAN("mysql.check_exists");
+            res.reset(stmt->executeQuery());
+        }
         if (res->next())
         {
             pool_->returnConnection(std::move(con));
@@ -46,16 +58,21 @@ int MysqlDao::RegUser(const std::string &name, const std::string &email, const s
         stmt->setString(2, email);
         stmt->setString(3, pwd);
         
-        int updateCount = stmt->executeUpdate();
+        int updateCount;
+        {
+            TRACE_SPAN("mysql.insert");
+            updateCount = stmt->executeUpdate();
+        }
         if (updateCount > 0)
         {
             // Get the generated uid
+            TRACE_SPAN("mysql.last_insert_id");
             std::unique_ptr<sql::Statement> stmtResult(con->createStatement());
             std::unique_ptr<sql::ResultSet> resUid(stmtResult->executeQuery("SELECT LAST_INSERT_ID()"));
             if (resUid->next())
             {
                 int uid = resUid->getInt(1);
-                std::cout << "RegUser Success, uid: " << uid << std::endl;
+                LOG_DEBUG("RegUser success").Field("uid", uid);
                 pool_->returnConnection(std::move(con));
                 return uid;
             }
@@ -67,7 +84,7 @@ int MysqlDao::RegUser(const std::string &name, const std::string &email, const s
     catch (sql::SQLException &e)
     {
         pool_->returnConnection(std::move(con));
-        std::cerr << "SQLException: " << e.what() << std::endl;
+        LOG_ERROR("SQLException").Field("code", e.getErrorCode()).Field("what", e.what());
         if (e.getErrorCode() == 1062) // Duplicate entry
         {
             return 0;
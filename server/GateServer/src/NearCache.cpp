@@ -0,0 +1,234 @@
+/**
+ * @file    NearCache.cpp
+ * @brief   分片 LRU 近端缓存实现
+ * @author  msr
+ */
+
+#include "NearCache.h"
+#include <algorithm>
+#include <thread>
+
+namespace
+{
+constexpr std::size_t kEntryOverhead = 96; ///< map 节点、LRU 链表节点与 Node 本身 (估算)
+} // namespace
+
+/**
+ * @struct  NearCache::Shard
+ * @brief   一个分片: 一把锁保护 map、LRU 链与失效序号；计数在锁内更新、GetStats 不加锁读取
+ */
+struct alignas(64) NearCache::Shard
+{
+    struct Node
+    {
+        State state = State::Miss;
+        std::string value;
+        Clock::time_point expire_at;
+        std::list<std::string>::iterator lru; ///< 在 lru 中的位置
+        std::size_t bytes = 0;
+    };
+
+    std::mutex mutex;
+    std::unordered_map<std::string, Node> map;
+    std::list<std::string> lru; ///< 头部最近使用
+    std::uint64_t epoch = 0;    ///< 每次失效加一，见 Token / Fill
+
+    std::atomic<std::uint64_t> hits{0};
+    std::atomic<std::uint64_t> negative_hits{0};
+    std::atomic<std::uint64_t> misses{0};
+    std::atomic<std::uint64_t> fills{0};
+    std::atomic<std::uint64_t> stale_fills{0};
+    std::atomic<std::uint64_t> evictions{0};
+    std::atomic<std::uint64_t> invalidations{0};
+    std::atomic<std::uint64_t> entries{0};
+    std::atomic<std::uint64_t> memory{0};
+
+    /// 删除一个条目，调用方持有 mutex
+    void Erase(std::unordered_map<std::string, Node>::iterator it)
+    {
+        memory.fetch_sub(it->second.bytes, std::memory_order_relaxed);
+        entries.fetch_sub(1, std::memory_order_relaxed);
+        lru.erase(it->second.lru);
+        map.erase(it);
+    }
+};
+
+NearCache::NearCache(Options options) : _options(options)
+{
+    std::size_t shards = _options.shards;
+    if (shards == 0)
+    {
+        shards = 4 * std::max(1u, std::thread::hardware_concurrency());
+    }
+    std::size_t count = 1;
+    while (count < shards)
+    {
+        count <<= 1;
+    }
+    _shards.reserve(count);
+    for (std::size_t i = 0; i < count; ++i)
+    {
+        _shards.push_back(std::make_unique<Shard>());
+    }
+    _shard_capacity = std::max<std::size_t>(1, _options.max_entries / count);
+}
+
+NearCache::~NearCache()
+{
+}
+
+NearCache::State NearCache::Find(const std::string &key, std::string *value, bool want_value)
+{
+    Shard &shard = ShardOf(key);
+    if (!Ready())
+    {
+        shard.misses.fetch_add(1, std::memory_order_relaxed);
+        return State::Miss;
+    }
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    auto it = shard.map.find(key);
+    if (it == shard.map.end())
+    {
+        shard.misses.fetch_add(1, std::memory_order_relaxed);
+        return State::Miss;
+    }
+    Shard::Node &node = it->second;
+    if (node.expire_at <= Clock::now())
+    {
+        shard.Erase(it);
+        shard.misses.fetch_add(1, std::memory_order_relaxed);
+        return State::Miss;
+    }
+    // EXISTS 的结果不含值，GET 不能用
+    if (want_value && node.state == State::Exists)
+    {
+        shard.misses.fetch_add(1, std::memory_order_relaxed);
+        return State::Miss;
+    }
+    shard.lru.splice(shard.lru.begin(), shard.lru, node.lru);
+    if (node.state == State::Missing)
+    {
+        shard.negative_hits.fetch_add(1, std::memory_order_relaxed);
+        return State::Missing;
+    }
+    shard.hits.fetch_add(1, std::memory_order_relaxed);
+    if (node.state == State::Value && value != nullptr)
+    {
+        *value = node.value;
+    }
+    return node.state;
+}
+
+std::uint64_t NearCache::Token(const std::string &key) const
+{
+    Shard &shard = ShardOf(key);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    return shard.epoch;
+}
+
+void NearCache::Fill(const std::string &key, State state, std::string value, std::uint64_t token)
+{
+    // TTL 为 0 表示该类结果不缓存：插入的条目已过期，只会占容量、挤掉有效条目
+    auto ttl = state == State::Missing ? _options.negative_ttl : _options.ttl;
+    if (state == State::Miss || ttl.count() <= 0 || !Ready())
+    {
+        return;
+    }
+    Shard &shard = ShardOf(key);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    if (shard.epoch != token)
+    {
+        shard.stale_fills.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+    Clock::time_point expire_at = Clock::now() + ttl;
+
+    auto it = shard.map.find(key);
+    if (it != shard.map.end())
+    {
+        Shard::Node &node = it->second;
+        // 已知值比“存在”信息更多，EXISTS 的回填不覆盖 GET 的结果
+        if (state == State::Exists && node.state == State::Value)
+        {
+            node.expire_at = std::min(node.expire_at, expire_at);
+            return;
+        }
+        shard.Erase(it);
+    }
+    else if (shard.map.size() >= _shard_capacity)
+    {
+        shard.Erase(shard.map.find(shard.lru.back()));
+        shard.evictions.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    shard.lru.push_front(key);
+    Shard::Node &node = shard.map[key];
+    node.state = state;
+    node.value = std::move(value);
+    node.expire_at = expire_at;
+    node.lru = shard.lru.begin();
+    node.bytes = 2 * key.size() + node.value.size() + kEntryOverhead;
+    shard.memory.fetch_add(node.bytes, std::memory_order_relaxed);
+    shard.entries.fetch_add(1, std::memory_order_relaxed);
+    shard.fills.fetch_add(1, std::memory_order_relaxed);
+}
+
+void NearCache::Invalidate(const std::string &key)
+{
+    Shard &shard = ShardOf(key);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    ++shard.epoch;
+    shard.invalidations.fetch_add(1, std::memory_order_relaxed);
+    auto it = shard.map.find(key);
+    if (it != shard.map.end())
+    {
+        shard.Erase(it);
+    }
+}
+
+void NearCache::Clear()
+{
+    for (auto &shard : _shards)
+    {
+        std::lock_guard<std::mutex> lock(shard->mutex);
+        ++shard->epoch;
+        shard->map.clear();
+        shard->lru.clear();
+        shard->entries.store(0, std::memory_order_relaxed);
+        shard->memory.store(0, std::memory_order_relaxed);
+    }
+}
+
+void NearCache::SetReady(bool ready)
+{
+    bool was = _ready.exchange(ready, std::memory_order_acq_rel);
+    if (was && !ready)
+    {
+        Clear();
+    }
+}
+
+NearCache::Stats NearCache::GetStats() const
+{
+    Stats stats;
+    for (const auto &shard : _shards)
+    {
+        stats.hits += shard->hits.load(std::memory_order_relaxed);
+        stats.negative_hits += shard->negative_hits.load(std::memory_order_relaxed);
+        stats.misses += shard->misses.load(std::memory_order_relaxed);
+        stats.fills += shard->fills.load(std::memory_order_relaxed);
+        stats.stale_fills += shard->stale_fills.load(std::memory_order_relaxed);
+        stats.evictions += shard->evictions.load(std::memory_order_relaxed);
+        stats.invalidations += shard->invalidations.load(std::memory_order_relaxed);
+        stats.entries += shard->entries.load(std::memory_order_relaxed);
+        stats.memory += shard->memory.load(std::memory_order_relaxed);
+    }
+    return stats;
+}
+
+NearCache::Shard &NearCache::ShardOf(const std::string &key) const
+{
+    // 与 LocalKv 相同: 分片用哈希高位，map 内部的桶用低位
+    std::size_t hash = std::hash<std::string>{}(key);
+    return *_shards[(hash ^ (hash >> 32)) * 0x9E3779B97F4A7C15ull >> 40 & (_shards.size() - 1)];
+}
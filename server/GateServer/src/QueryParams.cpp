@@ -0,0 +1,188 @@
+/**
+ * @file    QueryParams.cpp
+ * @brief   查询串参数视图实现
+ * @author  msr
+ */
+
+#include "QueryParams.h"
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+namespace
+{
+int FromHex(unsigned char x)
+{
+    if (x >= '0' && x <= '9')
+    {
+        return x - '0';
+    }
+    if (x >= 'A' && x <= 'F')
+    {
+        return x - 'A' + 10;
+    }
+    if (x >= 'a' && x <= 'f')
+    {
+        return x - 'a' + 10;
+    }
+    return -1;
+}
+
+bool IsEscape(char c)
+{
+    return c == '%' || c == '+';
+}
+} // namespace
+
+std::size_t QueryParams::FindEscape(const char *data, std::size_t size)
+{
+    std::size_t i = 0;
+#if defined(__SSE2__)
+    const __m128i percent = _mm_set1_epi8('%');
+    const __m128i plus = _mm_set1_epi8('+');
+    for (; i + 16 <= size; i += 16)
+    {
+        __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i *>(data + i));
+        __m128i hits = _mm_or_si128(_mm_cmpeq_epi8(chunk, percent), _mm_cmpeq_epi8(chunk, plus));
+        int mask = _mm_movemask_epi8(hits);
+        if (mask != 0)
+        {
+            return i + static_cast<std::size_t>(__builtin_ctz(static_cast<unsigned>(mask)));
+        }
+    }
+#elif defined(__ARM_NEON)
+    const uint8x16_t percent = vdupq_n_u8('%');
+    const uint8x16_t plus = vdupq_n_u8('+');
+    for (; i + 16 <= size; i += 16)
+    {
+        uint8x16_t chunk = vld1q_u8(reinterpret_cast<const uint8_t *>(data + i));
+        uint8x16_t hits = vorrq_u8(vceqq_u8(chunk, percent), vceqq_u8(chunk, plus));
+        if (vmaxvq_u8(hits) != 0)
+        {
+            break; // 命中的 16 字节内交给下面的逐字节扫描定位
+        }
+    }
+#endif
+    for (; i < size; ++i)
+    {
+        if (IsEscape(data[i]))
+        {
+            return i;
+        }
+    }
+    return size;
+}
+
+void QueryParams::Decode(std::string_view in, std::string &out)
+{
+    while (!in.empty())
+    {
+        // 整段没有转义字符的部分一次拷贝
+        std::size_t run = FindEscape(in.data(), in.size());
+        out.append(in.data(), run);
+        if (run == in.size())
+        {
+            return;
+        }
+        in.remove_prefix(run);
+
+        if (in.front() == '+')
+        {
+            out.push_back(' ');
+            in.remove_prefix(1);
+            continue;
+        }
+
+        int high = in.size() > 2 ? FromHex(static_cast<unsigned char>(in[1])) : -1;
+        int low = in.size() > 2 ? FromHex(static_cast<unsigned char>(in[2])) : -1;
+        if (high < 0 || low < 0)
+        {
+            // 非法的 %xx 原样保留，不能让客户端的畸形输入触发断言
+            out.push_back('%');
+            in.remove_prefix(1);
+            continue;
+        }
+        out.push_back(static_cast<char>(high * 16 + low));
+        in.remove_prefix(3);
+    }
+}
+
+std::string_view QueryParams::Materialize(std::string_view raw)
+{
+    if (FindEscape(raw.data(), raw.size()) == raw.size())
+    {
+        return raw;
+    }
+    // Arena 已按整个查询串长度预留，解码结果不会比原文长，append 不会重新分配，之前的视图保持有效
+    std::size_t begin = _arena.size();
+    Decode(raw, _arena);
+    return std::string_view(_arena.data() + begin, _arena.size() - begin);
+}
+
+void QueryParams::Parse(std::string_view query)
+{
+    Clear();
+    if (_arena.capacity() < query.size())
+    {
+        _arena.reserve(query.size());
+    }
+
+    while (!query.empty())
+    {
+        std::size_t amp = query.find('&');
+        std::string_view segment = query.substr(0, amp);
+        query.remove_prefix(amp == std::string_view::npos ? query.size() : amp + 1);
+
+        std::size_t eq = segment.find('=');
+        if (eq == std::string_view::npos)
+        {
+            continue;
+        }
+        Param param;
+        param.key = Materialize(segment.substr(0, eq));
+        param.value = Materialize(segment.substr(eq + 1));
+        _params.push_back(param);
+    }
+}
+
+std::string_view QueryParams::Get(std::string_view key) const
+{
+    for (auto it = _params.rbegin(); it != _params.rend(); ++it)
+    {
+        if (it->key == key)
+        {
+            return it->value;
+        }
+    }
+    return std::string_view();
+}
+
+bool QueryParams::Has(std::string_view key) const
+{
+    for (const auto &param : _params)
+    {
+        if (param.key == key)
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+void QueryParams::Clear()
+{
+    _params.clear();
+    _arena.clear();
+}
+
+void QueryParams::ShrinkTo(std::size_t limit)
+{
+    if (_arena.capacity() > limit)
+    {
+        _arena.clear();
+        _arena.shrink_to_fit();
+    }
+}
@@ -0,0 +1,557 @@
+/**
+ * @file    RedisConnection.cpp
+ * @brief   hiredis 异步连接与 Asio 事件循环的适配实现
+ * @author  msr
+ */
+
+#include "RedisConnection.h"
+#include "Logger.h"
+#include "async.h"
+#include "hiredis.h"
+#include <iterator>
+
+namespace
+{
+/**
+ * @struct  PendingCommand
+ * @brief   一条在途命令，作为 hiredis 的 privdata，回复到达 (或连接释放) 时删除
+ */
+struct PendingCommand
+{
+    RedisCallback callback;
+    bool persistent = false; ///< 订阅: 每条消息都回调，只在连接释放 (空回复) 时删除
+};
+
+/**
+ * @struct  BatchState
+ * @brief   一次 Batch 的回复收集状态，只在连接所属的 IO 线程上访问
+ */
+struct BatchState
+{
+    std::vector<RedisReply> replies;
+    std::size_t remaining = 0;
+    RedisBatchCallback callback;
+};
+
+RedisReply Convert(const redisReply *reply)
+{
+    RedisReply out;
+    switch (reply->type)
+    {
+    case REDIS_REPLY_STRING:
+        out.type = RedisReply::Type::String;
+        out.str.assign(reply->str, reply->len);
+        break;
+    case REDIS_REPLY_STATUS:
+        out.type = RedisReply::Type::Status;
+        out.str.assign(reply->str, reply->len);
+        break;
+    case REDIS_REPLY_ERROR:
+        out.type = RedisReply::Type::Error;
+        out.str.assign(reply->str, reply->len);
+        break;
+    case REDIS_REPLY_INTEGER:
+        out.type = RedisReply::Type::Integer;
+        out.integer = reply->integer;
+        break;
+    case REDIS_REPLY_NIL:
+        out.type = RedisReply::Type::Nil;
+        break;
+    case REDIS_REPLY_ARRAY:
+        out.type = RedisReply::Type::Array;
+        out.elements.reserve(reply->elements);
+        for (std::size_t i = 0; i < reply->elements; ++i)
+        {
+            out.elements.push_back(Convert(reply->element[i]));
+        }
+        break;
+    default:
+        out.type = RedisReply::Type::Error;
+        out.str = "unsupported reply type " + std::to_string(reply->type);
+        break;
+    }
+    return out;
+}
+
+void Invoke(RedisCallback &callback, RedisReply reply)
+{
+    // 回调在 hiredis 的调用栈内执行，异常不能穿过 C 代码
+    try
+    {
+        callback(std::move(reply));
+    }
+    catch (std::exception &exp)
+    {
+        LOG_ERROR("redis callback exception").Field("what", exp.what());
+    }
+}
+} // namespace
+
+RedisConnection::RedisConnection(boost::asio::io_context &ioc, Options options)
+    : _ioc(ioc), _options(std::move(options)), _reconnect_timer(ioc)
+{
+    _auto_batch.store(_options.auto_batch, std::memory_order_relaxed);
+}
+
+RedisConnection::~RedisConnection()
+{
+    // io_context 已停止、Stop 未来得及执行时在这里释放；此时不再重连
+    _stopped = true;
+    if (_context != nullptr)
+    {
+        redisAsyncFree(_context);
+    }
+}
+
+void RedisConnection::Start()
+{
+    boost::asio::dispatch(_ioc, [self = shared_from_this()]() { self->Connect(); });
+}
+
+void RedisConnection::Stop(std::function<void()> on_stopped)
+{
+    boost::asio::dispatch(_ioc,
+                          [self = shared_from_this(), on_stopped = std::move(on_stopped)]()
+                          {
+                              self->_stopped = true;
+                              self->_reconnect_timer.cancel();
+                              if (self->_context != nullptr)
+                              {
+                                  // 立即释放: 未完成的命令以错误回调，fd 由 hiredis 关闭
+                                  redisAsyncFree(self->_context);
+                              }
+                              self->_socket.reset();
+                              if (on_stopped)
+                              {
+                                  on_stopped();
+                              }
+                          });
+}
+
+void RedisConnection::SetPassword(std::string password)
+{
+    boost::asio::dispatch(_ioc, [self = shared_from_this(), password = std::move(password)]() mutable
+                          { self->_options.password = std::move(password); });
+}
+
+void RedisConnection::Command(RedisCommand args, RedisCallback callback)
+{
+    Staged item{std::move(args), std::move(callback)};
+    Submit(&item, 1);
+}
+
+void RedisConnection::Subscribe(RedisCommand args, RedisCallback callback)
+{
+    boost::asio::dispatch(_ioc, [self = shared_from_this(), args = std::move(args),
+                                 callback = std::move(callback)]() mutable
+                          {
+                              self->Send(args, callback, true);
+                              self->AfterSend();
+                          });
+}
+
+void RedisConnection::Batch(std::vector<RedisCommand> commands, RedisBatchCallback callback)
+{
+    if (commands.empty())
+    {
+        boost::asio::post(_ioc, [callback = std::move(callback)]() { callback({}); });
+        return;
+    }
+    auto state = std::make_shared<BatchState>();
+    state->replies.resize(commands.size());
+    state->remaining = commands.size();
+    state->callback = std::move(callback);
+
+    std::vector<Staged> items;
+    items.reserve(commands.size());
+    for (std::size_t i = 0; i < commands.size(); ++i)
+    {
+        items.push_back({std::move(commands[i]), [state, i](RedisReply reply)
+                         {
+                             state->replies[i] = std::move(reply);
+                             if (--state->remaining == 0)
+                             {
+                                 state->callback(std::move(state->replies));
+                             }
+                         }});
+    }
+    Submit(items.data(), items.size());
+}
+
+void RedisConnection::Submit(Staged *items, std::size_t count)
+{
+    if (RunningInThisThread())
+    {
+        for (std::size_t i = 0; i < count; ++i)
+        {
+            Send(items[i].args, items[i].callback);
+        }
+        AfterSend();
+        return;
+    }
+    if (!_auto_batch.load(std::memory_order_relaxed))
+    {
+        std::vector<Staged> batch(std::make_move_iterator(items), std::make_move_iterator(items + count));
+        boost::asio::post(_ioc,
+                          [self = shared_from_this(), batch = std::move(batch)]() mutable
+                          {
+                              for (auto &item : batch)
+                              {
+                                  self->Send(item.args, item.callback);
+                              }
+                              self->AfterSend();
+                          });
+        return;
+    }
+
+    // 暂存区由空变非空的提交者负责投递，同一批里的其他命令不再各自投递
+    bool first = false;
+    {
+        std::lock_guard<std::mutex> lock(_staged_mutex);
+        first = _staged.empty();
+        for (std::size_t i = 0; i < count; ++i)
+        {
+            _staged.push_back(std::move(items[i]));
+        }
+    }
+    if (first)
+    {
+        boost::asio::post(_ioc, [self = shared_from_this()]() { self->FlushStaged(); });
+    }
+}
+
+void RedisConnection::FlushStaged()
+{
+    {
+        std::lock_guard<std::mutex> lock(_staged_mutex);
+        _draining.swap(_staged);
+    }
+    for (auto &item : _draining)
+    {
+        Send(item.args, item.callback);
+    }
+    _draining.clear();
+    // 已是整批末尾，直接写出
+    Flush();
+}
+
+void RedisConnection::AfterSend()
+{
+    if (!_auto_batch.load(std::memory_order_relaxed))
+    {
+        if (!_in_callback)
+        {
+            Flush();
+        }
+        return;
+    }
+    // 本轮事件循环里之后的命令继续追加到 hiredis 输出缓冲，轮末一次写出
+    if (_flush_posted)
+    {
+        return;
+    }
+    _flush_posted = true;
+    boost::asio::post(_ioc,
+                      [self = shared_from_this()]()
+                      {
+                          self->_flush_posted = false;
+                          self->Flush();
+                      });
+}
+
+void RedisConnection::Flush()
+{
+    // 未连上时可写事件用于判断 connect 完成，仍交给 WaitWrite
+    if (_context == nullptr || !_writing || !Connected())
+    {
+        return;
+    }
+    _writes.fetch_add(1, std::memory_order_relaxed);
+    redisAsyncHandleWrite(_context);
+}
+
+void RedisConnection::Connect()
+{
+    if (_stopped || _context != nullptr)
+    {
+        return;
+    }
+    _reconnect_pending = false;
+
+    // 地址为 IP 时 connect 非阻塞；为主机名时 getaddrinfo 会阻塞本线程，生产配置应填 IP
+    redisAsyncContext *context = redisAsyncConnect(_options.host.c_str(), _options.port);
+    if (context == nullptr || context->err != 0)
+    {
+        LOG_WARN("redis connect failed")
+            .Field("host", _options.host)
+            .Field("port", _options.port)
+            .Field("error", context != nullptr ? context->errstr : "out of memory");
+        if (context != nullptr)
+        {
+            redisAsyncFree(context);
+        }
+        ScheduleReconnect();
+        return;
+    }
+
+    boost::system::error_code ec;
+    _socket = std::make_unique<boost::asio::posix::stream_descriptor>(_ioc);
+    _socket->assign(context->c.fd, ec);
+    if (ec)
+    {
+        LOG_ERROR("redis socket assign failed").Field("error", ec.message());
+        _socket.reset();
+        redisAsyncFree(context);
+        ScheduleReconnect();
+        return;
+    }
+
+    _context = context;
+    ++_generation;
+    context->data = this;
+    context->ev.data = this;
+    context->ev.addRead = &RedisConnection::AddRead;
+    context->ev.delRead = &RedisConnection::DelRead;
+    context->ev.addWrite = &RedisConnection::AddWrite;
+    context->ev.delWrite = &RedisConnection::DelWrite;
+    context->ev.cleanup = &RedisConnection::Cleanup;
+    // 设置建连回调时 hiredis 会 addWrite，以可写事件判断 connect 完成，因此必须在事件钩子之后
+    redisAsyncSetConnectCallback(context, &RedisConnection::OnConnect);
+    redisAsyncSetDisconnectCallback(context, &RedisConnection::OnDisconnect);
+
+    if (!_options.password.empty())
+    {
+        // 建连前发出的命令由 hiredis 缓冲，连上后最先发送
+        const char *argv[] = {"AUTH", _options.password.data()};
+        const std::size_t lengths[] = {4, _options.password.size()};
+        redisAsyncCommandArgv(context, &RedisConnection::OnAuth, this, 2, argv, lengths);
+    }
+    if (_options.on_connect)
+    {
+        _options.on_connect(*this);
+    }
+}
+
+void RedisConnection::ScheduleReconnect()
+{
+    if (_stopped || _reconnect_pending)
+    {
+        return;
+    }
+    _reconnect_pending = true;
+    _reconnect_timer.expires_after(_options.reconnect_interval);
+    _reconnect_timer.async_wait(
+        [self = shared_from_this()](const boost::system::error_code &ec)
+        {
+            if (!ec)
+            {
+                self->Connect();
+            }
+        });
+}
+
+void RedisConnection::Send(RedisCommand &args, RedisCallback &callback, bool persistent)
+{
+    if (_context == nullptr)
+    {
+        Fail(std::move(callback), "redis not connected");
+        return;
+    }
+
+    thread_local std::vector<const char *> argv;
+    thread_local std::vector<std::size_t> lengths;
+    argv.clear();
+    lengths.clear();
+    for (const auto &arg : args)
+    {
+        argv.push_back(arg.data());
+        lengths.push_back(arg.size());
+    }
+
+    auto *pending = new PendingCommand{std::move(callback), persistent};
+    if (redisAsyncCommandArgv(_context, &RedisConnection::OnReply, pending, static_cast<int>(argv.size()),
+                              argv.data(), lengths.data()) != REDIS_OK)
+    {
+        // 连接正在断开 / 释放
+        RedisCallback rejected = std::move(pending->callback);
+        delete pending;
+        Fail(std::move(rejected), "redis connection closing");
+        return;
+    }
+    _commands.fetch_add(1, std::memory_order_relaxed);
+}
+
+void RedisConnection::Fail(RedisCallback callback, const char *message)
+{
+    // 投递而不是直接回调，保证回调不会在 Command 返回前执行
+    boost::asio::post(_ioc, [callback = std::move(callback), message]() mutable
+                      { Invoke(callback, RedisReply::Error(message)); });
+}
+
+void RedisConnection::WaitRead()
+{
+    _read_waiting = true;
+    _socket->async_wait(
+        boost::asio::posix::stream_descriptor::wait_read,
+        [self = shared_from_this(), generation = _generation](const boost::system::error_code &ec)
+        {
+            if (generation != self->_generation)
+            {
+                return;
+            }
+            self->_read_waiting = false;
+            if (ec == boost::asio::error::operation_aborted || !self->_reading)
+            {
+                return;
+            }
+            redisAsyncHandleRead(self->_context);
+            // 回调中连接可能已释放 (_generation 改变)，或 AddRead 已重新挂起
+            if (generation == self->_generation && self->_reading && !self->_read_waiting)
+            {
+                self->WaitRead();
+            }
+        });
+}
+
+void RedisConnection::WaitWrite()
+{
+    _write_waiting = true;
+    _socket->async_wait(
+        boost::asio::posix::stream_descriptor::wait_write,
+        [self = shared_from_this(), generation = _generation](const boost::system::error_code &ec)
+        {
+            if (generation != self->_generation)
+            {
+                return;
+            }
+            self->_write_waiting = false;
+            if (ec == boost::asio::error::operation_aborted || !self->_writing)
+            {
+                return;
+            }
+            self->_writes.fetch_add(1, std::memory_order_relaxed);
+            redisAsyncHandleWrite(self->_context);
+            if (generation == self->_generation && self->_writing && !self->_write_waiting)
+            {
+                self->WaitWrite();
+            }
+        });
+}
+
+void RedisConnection::OnConnect(const redisAsyncContext *context, int status)
+{
+    auto *self = static_cast<RedisConnection *>(context->data);
+    if (status != REDIS_OK)
+    {
+        // 返回后 hiredis 释放该上下文 (Cleanup)
+        LOG_WARN("redis connect failed")
+            .Field("host", self->_options.host)
+            .Field("port", self->_options.port)
+            .Field("error", context->errstr);
+        if (self->_options.on_disconnect)
+        {
+            self->_options.on_disconnect();
+        }
+        self->ScheduleReconnect();
+        return;
+    }
+    self->_connected.store(true, std::memory_order_relaxed);
+    LOG_INFO("redis connected").Field("host", self->_options.host).Field("port", self->_options.port);
+}
+
+void RedisConnection::OnDisconnect(const redisAsyncContext *context, int status)
+{
+    auto *self = static_cast<RedisConnection *>(context->data);
+    self->_connected.store(false, std::memory_order_relaxed);
+    if (status != REDIS_OK)
+    {
+        LOG_WARN("redis disconnected").Field("error", context->errstr);
+    }
+    else
+    {
+        LOG_INFO("redis disconnected");
+    }
+    if (self->_options.on_disconnect)
+    {
+        self->_options.on_disconnect();
+    }
+    self->ScheduleReconnect();
+}
+
+void RedisConnection::OnReply(redisAsyncContext *context, void *reply, void *privdata)
+{
+    auto *pending = static_cast<PendingCommand *>(privdata);
+    auto *self = static_cast<RedisConnection *>(context->data);
+    self->_in_callback = true;
+    if (reply == nullptr)
+    {
+        // 连接断开或释放时，未完成的命令 (以及订阅) 以空回复回调
+        Invoke(pending->callback, RedisReply::Error(context->err != 0 ? context->errstr : "redis connection closed"));
+        delete pending;
+    }
+    else
+    {
+        Invoke(pending->callback, Convert(static_cast<const redisReply *>(reply)));
+        if (!pending->persistent)
+        {
+            delete pending;
+        }
+    }
+    self->_in_callback = false;
+}
+
+void RedisConnection::OnAuth(redisAsyncContext *, void *reply, void *)
+{
+    auto *r = static_cast<const redisReply *>(reply);
+    if (r != nullptr && r->type == REDIS_REPLY_ERROR)
+    {
+        LOG_ERROR("redis auth failed").Field("error", std::string(r->str, r->len));
+    }
+}
+
+void RedisConnection::AddRead(void *privdata)
+{
+    auto *self = static_cast<RedisConnection *>(privdata);
+    self->_reading = true;
+    if (!self->_read_waiting)
+    {
+        self->WaitRead();
+    }
+}
+
+void RedisConnection::DelRead(void *privdata)
+{
+    static_cast<RedisConnection *>(privdata)->_reading = false;
+}
+
+void RedisConnection::AddWrite(void *privdata)
+{
+    auto *self = static_cast<RedisConnection *>(privdata);
+    self->_writing = true;
+    if (!self->_write_waiting)
+    {
+        self->WaitWrite();
+    }
+}
+
+void RedisConnection::DelWrite(void *privdata)
+{
+    static_cast<RedisConnection *>(privdata)->_writing = false;
+}
+
+void RedisConnection::Cleanup(void *privdata)
+{
+    // hiredis 释放上下文 (断线 / 建连失败 / Stop)；fd 由 hiredis 关闭，这里只归还
+    auto *self = static_cast<RedisConnection *>(privdata);
+    self->_context = nullptr;
+    self->_connected.store(false, std::memory_order_relaxed);
+    self->_reading = false;
+    self->_writing = false;
+    self->_read_waiting = false;
+    self->_write_waiting = false;
+    ++self->_generation;
+    if (self->_socket)
+    {
+        self->_socket->release();
+    }
+}
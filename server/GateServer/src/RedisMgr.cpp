@@ -1,73 +1,810 @@
 #include "RedisMgr.h"
+#include "AsioIOServicePool.h"
+#include "ConfigMgr.h"
+#include "RequestTrace.h"
+#include <algorithm>
+#include <future>
+#include <strings.h>
+#include <thread>
+
+namespace
+{
+/**
+ * @brief   命令失败时记录日志
+ * @return  bool 回复不是 Error
+ */
+bool CheckReply(const RedisReply &reply, const char *command)
+{
+    if (reply.IsError())
+    {
+        LOG_WARN("redis command failed").Field("cmd", command).Field("error", reply.str);
+        return false;
+    }
+    return true;
+}
+
+/**
+ * @brief   本地后端的完成回调投递到调用线程所在的 io_context，不是 IO 线程时轮转
+ */
+std::shared_ptr<AsioIOServicePool::IOService> CallbackContext()
+{
+    auto pool = AsioIOServicePool::GetInstance();
+    for (std::size_t i = 0; i < pool->Size(); ++i)
+    {
+        auto ioc = pool->GetIOService(i);
+        if (ioc->get_executor().running_in_this_thread())
+        {
+            return ioc;
+        }
+    }
+    return pool->GetIOService();
+}
+
+/// 客户端缓存的失效消息所在频道 (RESP2 下 CLIENT TRACKING ... REDIRECT 的投递方式)
+const char *const kInvalidateChannel = "__redis__:invalidate";
+
+bool IsCommand(const std::string &command, const char *name)
+{
+    return strcasecmp(command.c_str(), name) == 0;
+}
+
+/**
+ * @brief   不修改数据的命令，发出时无需使近端缓存失效；每条命令都会经过这里，逐个比较、不分配
+ */
+bool IsReadOnly(const std::string &command)
+{
+    static const char *const kReadOnly[] = {"GET", "MGET", "EXISTS", "TTL", "PTTL", "HGET",
+                                            "HGETALL", "HEXISTS", "LLEN", "LRANGE", "PING", "AUTH",
+                                            "SELECT", "SCRIPT", "CLIENT", "DBSIZE", "INFO", "SUBSCRIBE"};
+    return std::any_of(std::begin(kReadOnly), std::end(kReadOnly),
+                       [&command](const char *name) { return IsCommand(command, name); });
+}
+
+/**
+ * @brief   用 GET 的回复回填近端缓存: 值或不存在，错误不回填
+ */
+void FillGet(NearCache &near, const std::string &key, const RedisReply &reply, std::uint64_t token)
+{
+    if (reply.type == RedisReply::Type::String)
+    {
+        near.Fill(key, NearCache::State::Value, reply.str, token);
+    }
+    else if (reply.type == RedisReply::Type::Nil)
+    {
+        near.Fill(key, NearCache::State::Missing, "", token);
+    }
+}
+} // namespace
 
 RedisMgr::RedisMgr()
 {
+    auto &cfg = ConfigMgr::GetInstance();
+    std::string host = cfg["Redis"]["Host"];
+    std::string port = cfg["Redis"]["Port"];
+    std::string timeout_ms = cfg["Redis"]["Timeout"];
+    std::string reconnect_ms = cfg["Redis"]["ReconnectMs"];
+    std::string auto_batch = cfg["Redis"]["AutoBatch"];
+    _options.password = cfg["Redis"]["Passwd"];
+    if (!timeout_ms.empty())
+    {
+        _timeout = std::chrono::milliseconds(std::max(1, atoi(timeout_ms.c_str())));
+    }
+    if (!reconnect_ms.empty())
+    {
+        _options.reconnect_interval = std::chrono::milliseconds(std::max(1, atoi(reconnect_ms.c_str())));
+    }
+    _options.auto_batch = !(auto_batch == "off" || auto_batch == "0" || auto_batch == "false");
+
+    std::string backend = cfg["Redis"]["Backend"];
+    if (backend == "local")
+    {
+        std::string shards = cfg["LocalKv"]["Shards"];
+        std::string tick_ms = cfg["LocalKv"]["TickMs"];
+        std::string max_memory_mb = cfg["LocalKv"]["MaxMemoryMb"];
+        LocalKv::Options options;
+        options.shards = static_cast<std::size_t>(std::max(0, atoi(shards.c_str())));
+        if (!tick_ms.empty())
+        {
+            options.tick = std::chrono::milliseconds(std::max(1, atoi(tick_ms.c_str())));
+        }
+        options.max_memory = static_cast<std::size_t>(std::max(0, atoi(max_memory_mb.c_str()))) << 20;
+        _local = std::make_unique<LocalKv>(options);
+        LOG_INFO("redis backend: local kv")
+            .Field("shards", _local->ShardCount())
+            .Field("tick_ms", options.tick.count())
+            .Field("max_memory_mb", options.max_memory >> 20);
+    }
+    else
+    {
+        std::string near_enabled = cfg["NearCache"]["Enabled"];
+        if (near_enabled == "on" || near_enabled == "1" || near_enabled == "true")
+        {
+            std::string max_entries = cfg["NearCache"]["MaxEntries"];
+            std::string shards = cfg["NearCache"]["Shards"];
+            std::string ttl_ms = cfg["NearCache"]["TtlMs"];
+            std::string negative_ttl_ms = cfg["NearCache"]["NegativeTtlMs"];
+            NearCache::Options options;
+            if (!max_entries.empty())
+            {
+                options.max_entries = static_cast<std::size_t>(std::max(1, atoi(max_entries.c_str())));
+            }
+            options.shards = static_cast<std::size_t>(std::max(0, atoi(shards.c_str())));
+            if (!ttl_ms.empty())
+            {
+                options.ttl = std::chrono::milliseconds(std::max(0, atoi(ttl_ms.c_str())));
+            }
+            if (!negative_ttl_ms.empty())
+            {
+                options.negative_ttl = std::chrono::milliseconds(std::max(0, atoi(negative_ttl_ms.c_str())));
+            }
+            _near = std::make_unique<NearCache>(options);
+            InstallTrackingHooks();
+            LOG_INFO("near cache enabled")
+                .Field("max_entries", options.max_entries)
+                .Field("ttl_ms", options.ttl.count())
+                .Field("negative_ttl_ms", options.negative_ttl.count());
+        }
+        if (!Connect(host.empty() ? "127.0.0.1" : host, port.empty() ? 6379 : atoi(port.c_str())))
+        {
+            LOG_WARN("redis unavailable, retrying in background")
+                .Field("host", _options.host)
+                .Field("port", _options.port);
+        }
+    }
+
+    _collector = Metrics::AddCollector(
+        [this](MetricsWriter &writer)
+        {
+            if (_local)
+            {
+                auto stats = _local->GetStats();
+                writer.Gauge("gate_kv_shards", "Lock-striped shards of the local KV engine.", "",
+                             _local->ShardCount());
+                writer.Gauge("gate_kv_keys", "Keys in the local KV engine (including expired, not yet reaped).", "",
+                             stats.keys);
+                writer.Gauge("gate_kv_memory_bytes", "Estimated memory of keys, values and TTL wheel entries.", "",
+                             stats.memory);
+                writer.Counter("gate_kv_commands_total", "Commands executed by the local KV engine.", "",
+                               stats.commands);
+                writer.Counter("gate_kv_expired_total", "Expired keys removed (on access or by the timing wheel).",
+                               "", stats.expired);
+                writer.Counter("gate_kv_reaped_total", "Expired keys removed by the timing wheel.", "", stats.reaped);
+                writer.Counter("gate_kv_oom_total", "Writes rejected by the memory limit.", "", stats.oom);
+                return;
+            }
+            std::size_t connected = 0;
+            for (const auto &connection : _connections)
+            {
+                connected += connection->Connected() ? 1 : 0;
+            }
+            auto stats = GetStats();
+            writer.Gauge("gate_redis_connections", "Redis connections (one per io_context).", "",
+                         _connections.size());
+            writer.Gauge("gate_redis_connected", "Redis connections currently established.", "", connected);
+            writer.Counter("gate_redis_commands_total", "Commands handed to hiredis.", "", stats.commands);
+            writer.Counter("gate_redis_writes_total", "Socket flushes; commands/writes is the batching factor.", "",
+                           stats.writes);
+            if (!_near)
+            {
+                return;
+            }
+            auto near = _near->GetStats();
+            const char *requests_help = "Near cache lookups (GET / EXISTS) by result.";
+            writer.Counter("gate_nearcache_requests_total", requests_help, "result=\"hit\"", near.hits);
+            writer.Counter("gate_nearcache_requests_total", requests_help, "result=\"negative_hit\"",
+                           near.negative_hits);
+            writer.Counter("gate_nearcache_requests_total", requests_help, "result=\"miss\"", near.misses);
+            writer.Gauge("gate_nearcache_ready", "1 while invalidation tracking is established.", "",
+                         _near->Ready() ? 1 : 0);
+            writer.Gauge("gate_nearcache_entries", "Entries in the near cache.", "", near.entries);
+            writer.Gauge("gate_nearcache_memory_bytes", "Estimated memory of near cache entries.", "", near.memory);
+            writer.Counter("gate_nearcache_fills_total", "Read replies stored in the near cache.", "", near.fills);
+            writer.Counter("gate_nearcache_stale_fills_total",
+                           "Read replies dropped because an invalidation raced with the read.", "", near.stale_fills);
+            writer.Counter("gate_nearcache_evictions_total", "Entries evicted by the size limit.", "", near.evictions);
+            writer.Counter("gate_nearcache_invalidations_total",
+                           "Keys invalidated by local writes or server invalidation messages.", "", near.invalidations);
+        });
 }
 
 RedisMgr::~RedisMgr()
 {
 }
 
-// Mock 连接：永远返回成功
 bool RedisMgr::Connect(const std::string &host, int port)
 {
-    std::cout << "[Mock Redis] Connect to " << host << ":" << port << " Success." << std::endl;
-    return true;
+    if (_local)
+    {
+        return true;
+    }
+    Close();
+    _options.host = host;
+    _options.port = port;
+
+    auto pool = AsioIOServicePool::GetInstance();
+    std::vector<std::shared_ptr<RedisConnection>> connections;
+    for (std::size_t i = 0; i < pool->Size(); ++i)
+    {
+        connections.push_back(std::make_shared<RedisConnection>(*pool->GetIOService(i), _options));
+        connections.back()->Start();
+    }
+    _connections = std::move(connections);
+    if (_near)
+    {
+        StartInvalidator();
+    }
+    return WaitConnected();
 }
 
-// Mock Auth：永远通过
 bool RedisMgr::Auth(const std::string &password)
 {
-    std::cout << "[Mock Redis] Auth Success." << std::endl;
-    return true;
+    _options.password = password;
+    if (_local)
+    {
+        return true;
+    }
+    bool ok = true;
+    for (auto &connection : _connections)
+    {
+        connection->SetPassword(password);
+        if (!connection->Connected() || OnIOThread())
+        {
+            continue;
+        }
+        auto promise = std::make_shared<std::promise<RedisReply>>();
+        auto future = promise->get_future();
+        connection->Command({"AUTH", password}, [promise](RedisReply reply) { promise->set_value(std::move(reply)); });
+        if (future.wait_for(_timeout) != std::future_status::ready || !CheckReply(future.get(), "AUTH"))
+        {
+            ok = false;
+        }
+    }
+    return ok;
 }
 
 bool RedisMgr::Get(const std::string &key, std::string &value)
 {
-    // 【万能后门】
-    // 只要是查验证码，不管什么邮箱，永远告诉 LogicSystem：Redis 里存的是 "123456"
-    value = "123456";
-    std::cout << "[Mock Redis] Get " << key << " -> always return 123456" << std::endl;
-    return true;
+    TRACE_SPAN("redis.get");
+    std::uint64_t token = 0;
+    if (_near)
+    {
+        NearCache::State state = _near->Find(key, &value, true);
+        if (state != NearCache::State::Miss)
+        {
+            return state == NearCache::State::Value;
+        }
+        token = _near->Token(key);
+    }
+    RedisReply reply = Execute({"GET", key});
+    if (_near)
+    {
+        FillGet(*_near, key, reply, token);
+    }
+    if (reply.type == RedisReply::Type::String)
+    {
+        value = std::move(reply.str);
+        return true;
+    }
+    CheckReply(reply, "GET");
+    return false;
 }
 
-// 核心功能：用 map 模拟 SET
 bool RedisMgr::Set(const std::string &key, const std::string &value)
 {
-    std::lock_guard<std::mutex> lock(_mtx);
-    _string_cache[key] = value;
-    std::cout << "[Mock Redis] SET " << key << " = " << value << std::endl;
-    return true;
+    TRACE_SPAN("redis.set");
+    return CheckReply(Execute({"SET", key, value}), "SET");
 }
 
-// 还有其他接口，暂时给个空实现，用到再补
 bool RedisMgr::LPush(const std::string &key, const std::string &value)
 {
-    return true;
+    TRACE_SPAN("redis.lpush");
+    return CheckReply(Execute({"LPUSH", key, value}), "LPUSH");
 }
+
 bool RedisMgr::LPop(const std::string &key, std::string &value)
 {
-    return true;
+    TRACE_SPAN("redis.lpop");
+    RedisReply reply = Execute({"LPOP", key});
+    if (reply.type == RedisReply::Type::String)
+    {
+        value = std::move(reply.str);
+        return true;
+    }
+    CheckReply(reply, "LPOP");
+    return false;
 }
+
 bool RedisMgr::HSet(const std::string &key, const std::string &hkey, const std::string &value)
 {
-    return true;
+    TRACE_SPAN("redis.hset");
+    return CheckReply(Execute({"HSET", key, hkey, value}), "HSET");
 }
+
 std::string RedisMgr::HGet(const std::string &key, const std::string &hkey)
 {
+    TRACE_SPAN("redis.hget");
+    RedisReply reply = Execute({"HGET", key, hkey});
+    if (reply.type == RedisReply::Type::String)
+    {
+        return std::move(reply.str);
+    }
+    CheckReply(reply, "HGET");
     return "";
 }
+
 bool RedisMgr::Del(const std::string &key)
 {
-    std::lock_guard<std::mutex> lock(_mtx);
-    _string_cache.erase(key);
-    return true;
+    TRACE_SPAN("redis.del");
+    return CheckReply(Execute({"DEL", key}), "DEL");
 }
+
 bool RedisMgr::ExistsKey(const std::string &key)
 {
-    std::lock_guard<std::mutex> lock(_mtx);
-    return _string_cache.find(key) != _string_cache.end();
+    TRACE_SPAN("redis.exists");
+    std::uint64_t token = 0;
+    if (_near)
+    {
+        NearCache::State state = _near->Find(key, nullptr, false);
+        if (state != NearCache::State::Miss)
+        {
+            return state != NearCache::State::Missing;
+        }
+        token = _near->Token(key);
+    }
+    RedisReply reply = Execute({"EXISTS", key});
+    if (!CheckReply(reply, "EXISTS") || reply.type != RedisReply::Type::Integer)
+    {
+        return false;
+    }
+    if (_near)
+    {
+        _near->Fill(key, reply.integer > 0 ? NearCache::State::Exists : NearCache::State::Missing, "", token);
+    }
+    return reply.integer > 0;
+}
+
+void RedisMgr::Get(const std::string &key, RedisCallback callback)
+{
+    if (!_near)
+    {
+        Command({"GET", key}, std::move(callback));
+        return;
+    }
+    RedisReply cached;
+    NearCache::State state = _near->Find(key, &cached.str, true);
+    if (state != NearCache::State::Miss)
+    {
+        cached.type = state == NearCache::State::Value ? RedisReply::Type::String : RedisReply::Type::Nil;
+        boost::asio::post(*CallbackContext(), [cached = std::move(cached), callback = std::move(callback)]() mutable
+                          { callback(std::move(cached)); });
+        return;
+    }
+    std::uint64_t token = _near->Token(key);
+    Command({"GET", key},
+            [this, key, token, callback = std::move(callback)](RedisReply reply)
+            {
+                FillGet(*_near, key, reply, token);
+                callback(std::move(reply));
+            });
+}
+
+void RedisMgr::Set(const std::string &key, const std::string &value, RedisCallback callback)
+{
+    Command({"SET", key, value}, std::move(callback));
+}
+
+void RedisMgr::Del(const std::string &key, RedisCallback callback)
+{
+    Command({"DEL", key}, std::move(callback));
+}
+
+void RedisMgr::HSet(const std::string &key, const std::string &hkey, const std::string &value,
+                    RedisCallback callback)
+{
+    Command({"HSET", key, hkey, value}, std::move(callback));
+}
+
+void RedisMgr::LPush(const std::string &key, const std::string &value, RedisCallback callback)
+{
+    Command({"LPUSH", key, value}, std::move(callback));
+}
+
+void RedisMgr::Command(RedisCommand args, RedisCallback callback)
+{
+    if (_local)
+    {
+        boost::asio::post(*CallbackContext(), [reply = _local->Execute(args), callback = std::move(callback)]() mutable
+                          { callback(std::move(reply)); });
+        return;
+    }
+    if (_near)
+    {
+        InvalidateFor(args);
+    }
+    auto connection = Pick();
+    if (!connection)
+    {
+        boost::asio::post(*AsioIOServicePool::GetInstance()->GetIOService(), [callback = std::move(callback)]()
+                  { callback(RedisReply::Error("redis closed")); });
+        return;
+    }
+    connection->Command(std::move(args), std::move(callback));
+}
+
+RedisReply RedisMgr::Execute(RedisCommand args)
+{
+    if (OnIOThread())
+    {
+        // 等待回复会卡住本线程上的全部连接 (包括 Redis 连接自身)
+        LOG_ERROR("redis sync call on IO thread, use the callback API").Field("cmd", args.front());
+        return RedisReply::Error("redis sync call on IO thread");
+    }
+    if (_local)
+    {
+        return _local->Execute(args);
+    }
+    if (_near)
+    {
+        InvalidateFor(args);
+    }
+    auto connection = Pick();
+    if (!connection)
+    {
+        return RedisReply::Error("redis closed");
+    }
+    auto promise = std::make_shared<std::promise<RedisReply>>();
+    auto future = promise->get_future();
+    connection->Command(std::move(args), [promise](RedisReply reply) { promise->set_value(std::move(reply)); });
+    if (future.wait_for(_timeout) != std::future_status::ready)
+    {
+        return RedisReply::Error("redis timeout");
+    }
+    return future.get();
+}
+
+void RedisMgr::Batch(std::vector<RedisCommand> commands, RedisBatchCallback callback)
+{
+    if (_local)
+    {
+        std::vector<RedisReply> replies;
+        replies.reserve(commands.size());
+        for (const auto &command : commands)
+        {
+            replies.push_back(_local->Execute(command));
+        }
+        boost::asio::post(*CallbackContext(), [replies = std::move(replies), callback = std::move(callback)]() mutable
+                          { callback(std::move(replies)); });
+        return;
+    }
+    if (_near)
+    {
+        for (const auto &command : commands)
+        {
+            InvalidateFor(command);
+        }
+    }
+    auto connection = Pick();
+    if (!connection)
+    {
+        boost::asio::post(*AsioIOServicePool::GetInstance()->GetIOService(),
+                          [size = commands.size(), callback = std::move(callback)]()
+                          { callback(std::vector<RedisReply>(size, RedisReply::Error("redis closed"))); });
+        return;
+    }
+    connection->Batch(std::move(commands), std::move(callback));
+}
+
+std::vector<RedisReply> RedisMgr::ExecuteBatch(std::vector<RedisCommand> commands)
+{
+    TRACE_SPAN("redis.batch");
+    std::size_t size = commands.size();
+    if (OnIOThread())
+    {
+        LOG_ERROR("redis sync call on IO thread, use the callback API").Field("cmd", "batch");
+        return std::vector<RedisReply>(size, RedisReply::Error("redis sync call on IO thread"));
+    }
+    if (_local)
+    {
+        std::vector<RedisReply> replies;
+        replies.reserve(size);
+        for (const auto &command : commands)
+        {
+            replies.push_back(_local->Execute(command));
+        }
+        return replies;
+    }
+    if (_near)
+    {
+        for (const auto &command : commands)
+        {
+            InvalidateFor(command);
+        }
+    }
+    auto connection = Pick();
+    if (!connection)
+    {
+        return std::vector<RedisReply>(size, RedisReply::Error("redis closed"));
+    }
+    auto promise = std::make_shared<std::promise<std::vector<RedisReply>>>();
+    auto future = promise->get_future();
+    connection->Batch(std::move(commands),
+                      [promise](std::vector<RedisReply> replies) { promise->set_value(std::move(replies)); });
+    if (future.wait_for(_timeout) != std::future_status::ready)
+    {
+        return std::vector<RedisReply>(size, RedisReply::Error("redis timeout"));
+    }
+    return future.get();
+}
+
+void RedisMgr::SetAutoBatch(bool enabled)
+{
+    _options.auto_batch = enabled;
+    for (auto &connection : _connections)
+    {
+        connection->SetAutoBatch(enabled);
+    }
+}
+
+RedisConnection::Stats RedisMgr::GetStats() const
+{
+    RedisConnection::Stats total;
+    if (_local)
+    {
+        total.commands = _local->GetStats().commands;
+        return total;
+    }
+    for (const auto &connection : _connections)
+    {
+        auto stats = connection->GetStats();
+        total.commands += stats.commands;
+        total.writes += stats.writes;
+    }
+    return total;
+}
+
+void RedisMgr::RegisterLocalScript(const std::string &body, LocalKv::Script script)
+{
+    if (_local)
+    {
+        _local->RegisterScript(body, std::move(script));
+    }
 }
+
 void RedisMgr::Close()
 {
-}
\ No newline at end of file
+    bool wait = !OnIOThread();
+    std::vector<std::future<void>> stopped;
+    if (_invalidator)
+    {
+        _connections.push_back(std::move(_invalidator));
+    }
+    for (auto &connection : _connections)
+    {
+        auto promise = std::make_shared<std::promise<void>>();
+        stopped.push_back(promise->get_future());
+        connection->Stop([promise]() { promise->set_value(); });
+    }
+    // 等各 IO 线程释放 hiredis 上下文，之后再停 IO 线程池就不会残留挂在 fd 上的操作
+    for (auto &future : stopped)
+    {
+        if (wait)
+        {
+            future.wait_for(_timeout);
+        }
+    }
+    _connections.clear();
+}
+
+std::shared_ptr<RedisConnection> RedisMgr::Pick()
+{
+    for (auto &connection : _connections)
+    {
+        if (connection->RunningInThisThread())
+        {
+            return connection;
+        }
+    }
+    std::size_t count = _connections.size();
+    if (count == 0)
+    {
+        return nullptr;
+    }
+    std::size_t start = _next.fetch_add(1, std::memory_order_relaxed);
+    for (std::size_t i = 0; i < count; ++i)
+    {
+        const auto &connection = _connections[(start + i) % count];
+        if (connection->Connected())
+        {
+            return connection;
+        }
+    }
+    return _connections[start % count];
+}
+
+bool RedisMgr::OnIOThread() const
+{
+    auto pool = AsioIOServicePool::GetInstance();
+    for (std::size_t i = 0; i < pool->Size(); ++i)
+    {
+        if (pool->GetIOService(i)->get_executor().running_in_this_thread())
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool RedisMgr::WaitConnected() const
+{
+    auto deadline = std::chrono::steady_clock::now() + _timeout;
+    while (true)
+    {
+        for (const auto &connection : _connections)
+        {
+            if (connection->Connected())
+            {
+                return true;
+            }
+        }
+        // 在 IO 线程上等待会阻止本线程的连接完成建连
+        if (OnIOThread() || std::chrono::steady_clock::now() >= deadline)
+        {
+            return false;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+}
+
+void RedisMgr::InstallTrackingHooks()
+{
+    _options.on_connect = [this](RedisConnection &connection)
+    {
+        // 订阅连接尚未就绪时由其订阅确认统一开启；这里处理数据连接的重连
+        long long redirect_id = _tracking_id.load(std::memory_order_acquire);
+        if (redirect_id >= 0)
+        {
+            EnableTracking({connection.shared_from_this()}, redirect_id, false);
+        }
+    };
+    // 服务端不再跟踪该连接读过的键，缓存中的条目随之作废
+    _options.on_disconnect = [this]() { _near->Clear(); };
+}
+
+void RedisMgr::StartInvalidator()
+{
+    RedisConnection::Options options = _options;
+    options.on_connect = [this](RedisConnection &connection)
+    {
+        // CLIENT ID 在 SUBSCRIBE 之前: 进入订阅状态后连接只接受订阅类命令
+        connection.Command({"CLIENT", "ID"},
+                           [this](RedisReply reply)
+                           {
+                               if (reply.type != RedisReply::Type::Integer)
+                               {
+                                   LOG_WARN("near cache disabled, CLIENT ID failed").Field("error", reply.str);
+                                   return;
+                               }
+                               _tracking_id.store(reply.integer, std::memory_order_release);
+                           });
+        connection.Subscribe({"SUBSCRIBE", kInvalidateChannel}, [this](RedisReply reply) { OnInvalidation(reply); });
+    };
+    options.on_disconnect = [this]()
+    {
+        std::lock_guard<std::mutex> lock(_tracking_mutex);
+        _tracking_id.store(-1, std::memory_order_release);
+        _near->SetReady(false);
+    };
+    _invalidator = std::make_shared<RedisConnection>(*AsioIOServicePool::GetInstance()->GetIOService(), options);
+    _invalidator->Start();
+}
+
+void RedisMgr::EnableTracking(std::vector<std::shared_ptr<RedisConnection>> connections, long long redirect_id,
+                              bool activate)
+{
+    auto pending = std::make_shared<std::atomic<std::size_t>>(connections.size());
+    auto failed = std::make_shared<std::atomic<bool>>(false);
+    for (auto &connection : connections)
+    {
+        connection->Command(
+            {"CLIENT", "TRACKING", "on", "REDIRECT", std::to_string(redirect_id)},
+            [this, connection, pending, failed, redirect_id, activate](RedisReply reply)
+            {
+                // 未连接的连接会在建连时 (on_connect) 自行开启，不影响其他连接
+                if (reply.IsError() && connection->Connected())
+                {
+                    LOG_WARN("near cache disabled, CLIENT TRACKING failed").Field("error", reply.str);
+                    failed->store(true);
+                }
+                if (pending->fetch_sub(1) != 1)
+                {
+                    return;
+                }
+                std::lock_guard<std::mutex> lock(_tracking_mutex);
+                if (failed->load())
+                {
+                    _near->SetReady(false);
+                }
+                else if (activate && _tracking_id.load(std::memory_order_acquire) == redirect_id)
+                {
+                    // 跟踪开启之前发出的读不受保护，它们的回填由 Clear 作废
+                    _near->Clear();
+                    _near->SetReady(true);
+                    LOG_INFO("near cache ready").Field("redirect", redirect_id);
+                }
+            });
+    }
+}
+
+void RedisMgr::OnInvalidation(const RedisReply &reply)
+{
+    // 连接断开时的 Error 由订阅连接的 on_disconnect 处理
+    if (reply.type != RedisReply::Type::Array || reply.elements.size() < 3)
+    {
+        return;
+    }
+    const std::string &kind = reply.elements[0].str;
+    if (kind == "subscribe")
+    {
+        long long redirect_id = _tracking_id.load(std::memory_order_acquire);
+        if (redirect_id >= 0)
+        {
+            EnableTracking(_connections, redirect_id, true);
+        }
+        return;
+    }
+    if (kind != "message")
+    {
+        return;
+    }
+    const RedisReply &keys = reply.elements[2];
+    if (keys.type != RedisReply::Type::Array)
+    {
+        // 空数组位置为 Nil: FLUSHALL / FLUSHDB，全部作废
+        _near->Clear();
+        return;
+    }
+    for (const auto &key : keys.elements)
+    {
+        _near->Invalidate(key.str);
+    }
+}
+
+void RedisMgr::InvalidateFor(const RedisCommand &args)
+{
+    if (args.empty() || IsReadOnly(args[0]))
+    {
+        return;
+    }
+    const std::string &command = args[0];
+    if (IsCommand(command, "FLUSHALL") || IsCommand(command, "FLUSHDB"))
+    {
+        _near->Clear();
+    }
+    else if (IsCommand(command, "EVAL") || IsCommand(command, "EVALSHA"))
+    {
+        // 脚本只能访问声明的键 (KEYS)
+        std::size_t count = args.size() > 2 ? static_cast<std::size_t>(std::max(0, atoi(args[2].c_str()))) : 0;
+        for (std::size_t i = 3; i < args.size() && i < 3 + count; ++i)
+        {
+            _near->Invalidate(args[i]);
+        }
+    }
+    else if (IsCommand(command, "DEL") || IsCommand(command, "UNLINK"))
+    {
+        for (std::size_t i = 1; i < args.size(); ++i)
+        {
+            _near->Invalidate(args[i]);
+        }
+    }
+    else if (IsCommand(command, "MSET"))
+    {
+        for (std::size_t i = 1; i < args.size(); i += 2)
+        {
+            _near->Invalidate(args[i]);
+        }
+    }
+    else if (args.size() > 1)
+    {
+        _near->Invalidate(args[1]);
+    }
+}
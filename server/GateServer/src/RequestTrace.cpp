@@ -0,0 +1,64 @@
+/**
+ * @file    RequestTrace.cpp
+ * @brief   请求级分段计时与慢请求日志实现
+ * @author  msr
+ */
+
+#include "RequestTrace.h"
+#include <algorithm>
+
+void RequestTrace::SetSlowThreshold(std::uint64_t ms)
+{
+    _slow_ns.store(ms * 1000000, std::memory_order_relaxed);
+}
+
+std::uint64_t RequestTrace::GetSlowThreshold()
+{
+    return _slow_ns.load(std::memory_order_relaxed) / 1000000;
+}
+
+void RequestTrace::Begin(std::uint64_t start_ns)
+{
+    _id = _next_id.fetch_add(1, std::memory_order_relaxed) + 1;
+    _start_ns = start_ns;
+    _count = 0;
+    _active = _slow_ns.load(std::memory_order_relaxed) != 0;
+}
+
+void RequestTrace::Finish(std::string_view method, std::string_view target, unsigned status, std::uint64_t end_ns)
+{
+    if (!_active)
+    {
+        return;
+    }
+    _active = false;
+
+    std::uint64_t total = end_ns - _start_ns;
+    if (total < _slow_ns.load(std::memory_order_relaxed) || !Logger::IsEnabled(LogLevel::Warn))
+    {
+        return;
+    }
+
+    // Span 在结束时追加，嵌套的内层先结束；输出前按开始时刻排序
+    std::size_t recorded = _count < kMaxSpans ? _count : kMaxSpans;
+    std::sort(_spans.begin(), _spans.begin() + recorded,
+              [](const Span &a, const Span &b) { return a.begin_ns < b.begin_ns; });
+
+    // 在 IO 线程上输出，临时把日志的请求 ID 切到本请求
+    std::uint64_t previous_id = Logger::RequestId();
+    Logger::SetRequestId(_id);
+    {
+        // 各阶段的值为微秒；嵌套的阶段 (如 mysql.acquire 在 mysql.reg_user 内) 各自计时
+        LogRecord record(LogLevel::Warn, "slow request");
+        record.Field("method", method).Field("target", target).Field("status", status).Field("total_us", total / 1000);
+        for (std::size_t i = 0; i < recorded; ++i)
+        {
+            record.Field(_spans[i].stage, (_spans[i].end_ns - _spans[i].begin_ns) / 1000);
+        }
+        if (_count > kMaxSpans)
+        {
+            record.Field("spans_dropped", _count - kMaxSpans);
+        }
+    }
+    Logger::SetRequestId(previous_id);
+}
@@ -0,0 +1,111 @@
+/**
+ * @file    ResponseHeaderCache.cpp
+ * @brief   预渲染的响应头模板实现
+ * @author  msr
+ */
+
+#include "ResponseHeaderCache.h"
+#include <deque>
+
+namespace http = boost::beast::http;
+
+namespace
+{
+/// 模板数量上限：状态码 × Content-Type 的组合很少，超出说明 Content-Type 不可枚举，不再缓存
+constexpr std::size_t kMaxTemplates = 64;
+
+struct Template
+{
+    unsigned version;
+    unsigned status;
+    bool keep_alive;
+    bool server;
+    std::string server_value;
+    std::string content_type;
+    std::string text;
+};
+
+std::string Render(const Template &t)
+{
+    std::string text;
+    text.reserve(128);
+    text += (t.version == 10) ? "HTTP/1.0 " : "HTTP/1.1 ";
+    text += std::to_string(t.status);
+    text += ' ';
+    text += std::string(http::obsolete_reason(static_cast<http::status>(t.status)));
+    text += "\r\n";
+    if (t.server)
+    {
+        text += "Server: " + t.server_value + "\r\n";
+    }
+    if (!t.content_type.empty())
+    {
+        text += "Content-Type: " + t.content_type + "\r\n";
+    }
+    // 与 Beast 的 keep_alive() 语义一致: 1.1 默认长连接，1.0 默认短连接
+    if (t.version >= 11 && !t.keep_alive)
+    {
+        text += "Connection: close\r\n";
+    }
+    else if (t.version < 11 && t.keep_alive)
+    {
+        text += "Connection: keep-alive\r\n";
+    }
+    text += "Content-Length: ";
+    return text;
+}
+} // namespace
+
+const std::string *ResponseHeaderCache::Lookup(const http::response_header<> &header, bool keep_alive)
+{
+    // deque 追加元素不移动已有元素，返回的指针长期有效
+    thread_local std::deque<Template> templates;
+
+    boost::beast::string_view server;
+    boost::beast::string_view content_type;
+    bool has_server = false;
+    for (const auto &field : header)
+    {
+        switch (field.name())
+        {
+        case http::field::server:
+            has_server = true;
+            server = field.value();
+            break;
+        case http::field::content_type:
+            content_type = field.value();
+            break;
+        case http::field::connection:
+        case http::field::content_length:
+            // 由模板 / 调用方按 keep_alive() 与 Body 长度生成
+            break;
+        default:
+            return nullptr;
+        }
+    }
+
+    unsigned version = header.version();
+    unsigned status = header.result_int();
+    if (version != 10 && version != 11)
+    {
+        return nullptr;
+    }
+
+    for (const auto &t : templates)
+    {
+        if (t.status == status && t.version == version && t.keep_alive == keep_alive && t.server == has_server &&
+            t.content_type == content_type && (!has_server || t.server_value == server))
+        {
+            return &t.text;
+        }
+    }
+
+    if (templates.size() >= kMaxTemplates)
+    {
+        return nullptr;
+    }
+    Template t{version, status, keep_alive, has_server, std::string(server), std::string(content_type), {}};
+    t.text = Render(t);
+    templates.push_back(std::move(t));
+    return &templates.back().text;
+}
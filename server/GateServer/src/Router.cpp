@@ -0,0 +1,224 @@
+/**
+ * @file    Router.cpp
+ * @brief   路由前缀树实现
+ * @author  msr
+ */
+
+#include "Router.h"
+#include <algorithm>
+#include <functional>
+
+namespace http = boost::beast::http;
+
+namespace
+{
+/**
+ * @brief   取出 rest 的下一个路径段并前移 rest；连续的 '/' 视为一个
+ * @return  空表示路径已经结束
+ */
+std::string_view NextSegment(std::string_view &rest)
+{
+    std::size_t begin = rest.find_first_not_of('/');
+    if (begin == std::string_view::npos)
+    {
+        rest = std::string_view();
+        return std::string_view();
+    }
+    std::size_t end = rest.find('/', begin);
+    if (end == std::string_view::npos)
+    {
+        end = rest.size();
+    }
+    std::string_view segment = rest.substr(begin, end - begin);
+    rest.remove_prefix(end);
+    return segment;
+}
+
+bool IsParamSegment(std::string_view segment)
+{
+    return segment.size() > 2 && segment.front() == '{' && segment.back() == '}';
+}
+} // namespace
+
+std::string_view PathParams::Get(std::string_view name) const
+{
+    for (std::size_t i = 0; i < _size; ++i)
+    {
+        if (_names[i] == name)
+        {
+            return _values[i];
+        }
+    }
+    return std::string_view();
+}
+
+Router::Router()
+    : _nodes(1)
+{
+}
+
+bool Router::Add(http::verb method, std::string_view pattern, std::size_t value)
+{
+    std::uint32_t index = 0;
+    std::vector<std::string> names;
+    std::string canonical;
+    std::string_view rest = pattern;
+    for (std::string_view segment = NextSegment(rest); !segment.empty(); segment = NextSegment(rest))
+    {
+        canonical += '/';
+        canonical += segment;
+        if (IsParamSegment(segment))
+        {
+            if (names.size() == PathParams::kMaxParams)
+            {
+                return false;
+            }
+            names.emplace_back(segment.substr(1, segment.size() - 2));
+            if (_nodes[index].param == kNone)
+            {
+                // push_back 可能使 _nodes 中的引用失效，先取下标
+                auto child = static_cast<std::uint32_t>(_nodes.size());
+                _nodes.emplace_back();
+                _nodes[index].param = child;
+            }
+            index = _nodes[index].param;
+            continue;
+        }
+
+        auto &children = _nodes[index].children;
+        auto it = std::lower_bound(children.begin(), children.end(), segment,
+                                   [this](std::uint32_t child, std::string_view key)
+                                   { return std::string_view(_nodes[child].segment) < key; });
+        if (it != children.end() && _nodes[*it].segment == segment)
+        {
+            index = *it;
+            continue;
+        }
+        auto child = static_cast<std::uint32_t>(_nodes.size());
+        children.insert(it, child);
+        _nodes.emplace_back();
+        _nodes.back().segment = std::string(segment);
+        index = child;
+    }
+
+    auto &handlers = _nodes[index].handlers;
+    for (const auto &handler : handlers)
+    {
+        if (handler.method == method)
+        {
+            return false;
+        }
+    }
+    bool is_static = names.empty();
+    bool first_handler = handlers.empty();
+    handlers.push_back(Handler{method, value, std::move(names)});
+    if (is_static && first_handler)
+    {
+        _static_paths.emplace_back(canonical.empty() ? std::string("/") : std::move(canonical), index);
+        RebuildStatic();
+    }
+    return true;
+}
+
+void Router::RebuildStatic()
+{
+    std::size_t capacity = 8;
+    while (capacity < _static_paths.size() * 2)
+    {
+        capacity *= 2;
+    }
+    _static_slots.assign(capacity, StaticSlot{});
+    _static_keys.assign(capacity, std::string());
+    for (const auto &[path, node] : _static_paths)
+    {
+        std::size_t hash = std::hash<std::string_view>()(path);
+        std::size_t slot = hash & (capacity - 1);
+        while (_static_slots[slot].node != kNone)
+        {
+            slot = (slot + 1) & (capacity - 1);
+        }
+        _static_slots[slot] = StaticSlot{hash, node};
+        _static_keys[slot] = path;
+    }
+}
+
+const Router::Node *Router::FindStatic(std::string_view path) const
+{
+    if (_static_slots.empty())
+    {
+        return nullptr;
+    }
+    std::size_t mask = _static_slots.size() - 1;
+    std::size_t hash = std::hash<std::string_view>()(path);
+    for (std::size_t slot = hash & mask; _static_slots[slot].node != kNone; slot = (slot + 1) & mask)
+    {
+        if (_static_slots[slot].hash == hash && _static_keys[slot] == path)
+        {
+            return &_nodes[_static_slots[slot].node];
+        }
+    }
+    return nullptr;
+}
+
+Router::Result Router::Find(http::verb method, std::string_view path, std::size_t &value, PathParams &params) const
+{
+    params._size = 0;
+    // 静态路由在每一层都优先于参数段，因此规范路径精确命中时结果与前缀树一致
+    const Node *node = FindStatic(path);
+    if (node == nullptr)
+    {
+        node = Walk(0, path, params);
+    }
+    if (node == nullptr)
+    {
+        return Result::NotFound;
+    }
+    for (const auto &handler : node->handlers)
+    {
+        if (handler.method == method)
+        {
+            for (std::size_t i = 0; i < handler.names.size(); ++i)
+            {
+                params._names[i] = handler.names[i];
+            }
+            value = handler.value;
+            return Result::Found;
+        }
+    }
+    params._size = 0;
+    return Result::MethodNotAllowed;
+}
+
+const Router::Node *Router::Walk(std::uint32_t index, std::string_view rest, PathParams &params) const
+{
+    const Node &node = _nodes[index];
+    std::string_view segment = NextSegment(rest);
+    if (segment.empty())
+    {
+        return node.handlers.empty() ? nullptr : &node;
+    }
+
+    // 静态段优先
+    auto it = std::lower_bound(node.children.begin(), node.children.end(), segment,
+                               [this](std::uint32_t child, std::string_view key)
+                               { return std::string_view(_nodes[child].segment) < key; });
+    if (it != node.children.end() && _nodes[*it].segment == segment)
+    {
+        if (const Node *found = Walk(*it, rest, params))
+        {
+            return found;
+        }
+    }
+
+    // 回溯到参数段
+    if (node.param != kNone && params._size < PathParams::kMaxParams)
+    {
+        params._values[params._size++] = segment;
+        if (const Node *found = Walk(node.param, rest, params))
+        {
+            return found;
+        }
+        --params._size;
+    }
+    return nullptr;
+}
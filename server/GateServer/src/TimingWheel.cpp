@@ -0,0 +1,209 @@
+/**
+ * @file    TimingWheel.cpp
+ * @brief   哈希时间轮实现
+ * @author  msr
+ */
+
+#include "TimingWheel.h"
+#include "ConfigMgr.h"
+#include <algorithm>
+#include <cstdlib>
+#include <string>
+#include <utility>
+
+net::execution_context::id TimingWheel::id;
+
+TimingWheel::Entry::Entry(TimingWheel &wheel, std::function<void()> on_expire)
+    : _wheel(wheel),
+      _on_expire(std::move(on_expire))
+{
+}
+
+TimingWheel::Entry::~Entry()
+{
+    Cancel();
+}
+
+void TimingWheel::Entry::Arm(Clock::duration timeout)
+{
+    Cancel();
+    _wheel.Link(*this, timeout);
+}
+
+void TimingWheel::Entry::Cancel()
+{
+    if (!_armed)
+    {
+        return;
+    }
+    Unlink(*this);
+    _armed = false;
+    --_wheel._stats.armed;
+}
+
+bool TimingWheel::Entry::Armed() const
+{
+    return _armed;
+}
+
+TimingWheel::TimingWheel(net::execution_context &ctx)
+    : net::execution_context::service(ctx),
+      _timer(static_cast<net::io_context &>(ctx)),
+      _slots(kSlots),
+      _tick(std::chrono::milliseconds(100))
+{
+    std::string configured = ConfigMgr::GetInstance()["GateServer"]["TimerTick"];
+    if (!configured.empty())
+    {
+        _tick = std::chrono::milliseconds(std::max(1, std::atoi(configured.c_str())));
+    }
+}
+
+TimingWheel::~TimingWheel() = default;
+
+void TimingWheel::SetTick(Clock::duration tick)
+{
+    _tick = std::max<Clock::duration>(tick, std::chrono::milliseconds(1));
+}
+
+TimingWheel::Clock::duration TimingWheel::Tick() const
+{
+    return _tick;
+}
+
+TimingWheel::Stats TimingWheel::GetStats() const
+{
+    return _stats;
+}
+
+void TimingWheel::shutdown()
+{
+    // 之后连接在 Scheduler 销毁 handler 时才析构，其 Cancel 必须是无操作
+    _stopped = true;
+    for (Node &head : _slots)
+    {
+        while (head.next != &head)
+        {
+            Entry &entry = static_cast<Entry &>(*head.next);
+            Unlink(entry);
+            entry._armed = false;
+        }
+    }
+    _stats.armed = 0;
+    _timer.cancel();
+}
+
+void TimingWheel::Link(Entry &entry, Clock::duration timeout)
+{
+    if (_stopped)
+    {
+        return;
+    }
+
+    Clock::time_point now = Clock::now();
+    if (!_ticking)
+    {
+        _next_tick = now + _tick;
+    }
+
+    // 第 k 个 tick (k >= 1) 在 _next_tick + (k - 1) * _tick 处理 slot (_cursor + k)，取不早于截止时间的最小 k
+    Clock::time_point deadline = now + timeout;
+    std::uint64_t ticks = 1;
+    if (deadline > _next_tick)
+    {
+        ticks += static_cast<std::uint64_t>((deadline - _next_tick + _tick - Clock::duration(1)) / _tick);
+    }
+
+    entry._rounds = (ticks - 1) / kSlots;
+    entry._armed = true;
+    PushBack(_slots[(_cursor + ticks) % kSlots], entry);
+    ++_stats.armed;
+
+    StartTicking();
+}
+
+void TimingWheel::Unlink(Node &node)
+{
+    node.prev->next = node.next;
+    node.next->prev = node.prev;
+    node.prev = &node;
+    node.next = &node;
+}
+
+void TimingWheel::PushBack(Node &head, Node &node)
+{
+    node.prev = head.prev;
+    node.next = &head;
+    head.prev->next = &node;
+    head.prev = &node;
+}
+
+void TimingWheel::StartTicking()
+{
+    if (_ticking || _stopped)
+    {
+        return;
+    }
+    _ticking = true;
+    _timer.expires_at(_next_tick);
+    _timer.async_wait([this](const boost::system::error_code &ec) { OnTick(ec); });
+}
+
+void TimingWheel::OnTick(const boost::system::error_code &ec)
+{
+    if (ec || _stopped)
+    {
+        _ticking = false;
+        return;
+    }
+
+    // 处理期间保持 _ticking，回调里重新 Arm 的条目以当前 _next_tick 为基准计算位置
+    // 线程被阻塞而落后时逐个补齐错过的 tick
+    Clock::time_point now = Clock::now();
+    while (_next_tick <= now && _stats.armed > 0)
+    {
+        Advance();
+    }
+
+    _ticking = false;
+    if (_stats.armed > 0)
+    {
+        StartTicking();
+    }
+}
+
+void TimingWheel::Advance()
+{
+    _cursor = (_cursor + 1) % kSlots;
+    _next_tick += _tick;
+    ++_stats.ticks;
+
+    // 先把到期条目摘到局部链表再逐个回调：回调里 Cancel / Arm 其他条目不会破坏遍历
+    Node expired;
+    Node &head = _slots[_cursor];
+    for (Node *node = head.next; node != &head;)
+    {
+        Node *next = node->next;
+        Entry &entry = static_cast<Entry &>(*node);
+        if (entry._rounds > 0)
+        {
+            --entry._rounds;
+        }
+        else
+        {
+            Unlink(entry);
+            PushBack(expired, entry);
+        }
+        node = next;
+    }
+
+    while (expired.next != &expired)
+    {
+        Entry &entry = static_cast<Entry &>(*expired.next);
+        Unlink(entry);
+        entry._armed = false;
+        --_stats.armed;
+        ++_stats.expired;
+        entry._on_expire();
+    }
+}
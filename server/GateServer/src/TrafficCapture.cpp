@@ -0,0 +1,507 @@
+/**
+ * @file    TrafficCapture.cpp
+ * @brief   请求流量录制与读取实现
+ * @author  msr
+ */
+
+#include "TrafficCapture.h"
+#include "Logger.h"
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <condition_variable>
+#include <cstring>
+#include <fcntl.h>
+#include <iterator>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <unistd.h>
+
+namespace
+{
+constexpr char kMagic[8] = {'G', 'A', 'T', 'E', 'C', 'A', 'P', '1'};
+constexpr std::size_t kFileHeaderSize = sizeof(kMagic) + 8 + 1;
+constexpr std::uint8_t kFlagBodies = 1;
+/// 单条记录的上限，读取时超过即视为文件损坏
+constexpr std::uint64_t kMaxRecord = 64 * 1024 * 1024;
+
+std::uint64_t SteadyNs()
+{
+    return static_cast<std::uint64_t>(
+        std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch())
+            .count());
+}
+
+void PutVarint(std::string &out, std::uint64_t value)
+{
+    while (value >= 0x80)
+    {
+        out.push_back(static_cast<char>((value & 0x7F) | 0x80));
+        value >>= 7;
+    }
+    out.push_back(static_cast<char>(value));
+}
+
+void PutBytes(std::string &out, std::string_view bytes)
+{
+    PutVarint(out, bytes.size());
+    out.append(bytes.data(), bytes.size());
+}
+
+bool GetVarint(std::string_view &in, std::uint64_t &value)
+{
+    value = 0;
+    for (int shift = 0; shift < 64 && !in.empty(); shift += 7)
+    {
+        auto byte = static_cast<std::uint8_t>(in.front());
+        in.remove_prefix(1);
+        value |= static_cast<std::uint64_t>(byte & 0x7F) << shift;
+        if ((byte & 0x80) == 0)
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool GetBytes(std::string_view &in, std::string &out)
+{
+    std::uint64_t size = 0;
+    if (!GetVarint(in, size) || size > in.size())
+    {
+        return false;
+    }
+    out.assign(in.data(), static_cast<std::size_t>(size));
+    in.remove_prefix(static_cast<std::size_t>(size));
+    return true;
+}
+
+/**
+ * @brief   从文件读一个 varint
+ * @return  0 成功，1 文件在 varint 之前正好结束，-1 截断
+ */
+int ReadVarint(std::FILE *file, std::uint64_t &value)
+{
+    value = 0;
+    for (int shift = 0; shift < 64; shift += 7)
+    {
+        int c = std::fgetc(file);
+        if (c == EOF)
+        {
+            return shift == 0 ? 1 : -1;
+        }
+        value |= static_cast<std::uint64_t>(c & 0x7F) << shift;
+        if ((c & 0x80) == 0)
+        {
+            return 0;
+        }
+    }
+    return -1;
+}
+
+void WriteAll(int fd, const std::string &data)
+{
+    std::size_t written = 0;
+    while (written < data.size())
+    {
+        ssize_t n = ::write(fd, data.data() + written, data.size() - written);
+        if (n < 0)
+        {
+            if (errno == EINTR)
+            {
+                continue;
+            }
+            LOG_ERROR("capture write failed").Field("errno", errno);
+            return;
+        }
+        written += static_cast<std::size_t>(n);
+    }
+}
+
+/**
+ * @class   CaptureBackend
+ * @brief   每线程双缓冲 + 写线程；进程内永不析构，Stop 之后迟到的 Record 直接丢弃
+ *
+ * @details
+ * 每个录制线程追加到自己的 ThreadBuffer (记录前带到达时刻)，锁只在写线程换出缓冲时才有争用，
+ * IO 线程之间没有共享的锁或计数器。写线程每 10ms (或某个线程缓冲过半时) 换出全部线程缓冲，
+ * 按到达时刻归并后编码为文件中的间隔。
+ */
+class CaptureBackend
+{
+public:
+    bool Start(const TrafficCapture::Options &options)
+    {
+        std::lock_guard<std::mutex> lock(_mtx);
+        if (_fd >= 0)
+        {
+            return false;
+        }
+        int fd = ::open(options.path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+        if (fd < 0)
+        {
+            return false;
+        }
+
+        std::string header(kMagic, sizeof(kMagic));
+        auto unix_ns = static_cast<std::uint64_t>(
+            std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::system_clock::now().time_since_epoch())
+                .count());
+        for (int i = 0; i < 8; ++i)
+        {
+            header.push_back(static_cast<char>((unix_ns >> (8 * i)) & 0xFF));
+        }
+        header.push_back(static_cast<char>(options.bodies ? kFlagBodies : 0));
+        WriteAll(fd, header);
+
+        _fd = fd;
+        _capacity.store(std::max<std::size_t>(options.buffer_bytes, 64 * 1024), std::memory_order_relaxed);
+        _last_ns = SteadyNs();
+        _running.store(true);
+        bodies.store(options.bodies, std::memory_order_relaxed);
+        _writer = std::thread([this]() { Run(); });
+        enabled.store(true, std::memory_order_release);
+        return true;
+    }
+
+    void Stop()
+    {
+        enabled.store(false, std::memory_order_release);
+        {
+            std::lock_guard<std::mutex> lock(_mtx);
+            if (!_running.load())
+            {
+                return;
+            }
+            // 先于写线程最后一次换出: 之后拿到线程缓冲锁的 Append 都会看到 false
+            _running.store(false);
+        }
+        _wake.notify_one();
+        _writer.join();
+
+        std::lock_guard<std::mutex> lock(_mtx);
+        ::close(_fd);
+        _fd = -1;
+    }
+
+    void Append(std::string_view record)
+    {
+        ThreadBuffer &buffer = Local();
+        std::size_t capacity = _capacity.load(std::memory_order_relaxed);
+        bool urgent = false;
+        {
+            std::lock_guard<std::mutex> lock(buffer.mtx);
+            if (!_running.load())
+            {
+                return;
+            }
+            // 记录头: 8 字节到达时刻 + 最多 10 字节的长度 varint
+            if (buffer.active.size() + record.size() + 18 > capacity)
+            {
+                ++buffer.dropped;
+                return;
+            }
+            std::uint64_t now = SteadyNs();
+            buffer.active.append(reinterpret_cast<const char *>(&now), sizeof(now));
+            PutVarint(buffer.active, record.size());
+            buffer.active.append(record.data(), record.size());
+            ++buffer.captured;
+            urgent = buffer.active.size() >= capacity / 2;
+        }
+        if (urgent && !_urgent.exchange(true))
+        {
+            _wake.notify_one();
+        }
+    }
+
+    std::uint64_t Captured()
+    {
+        return Sum(&ThreadBuffer::captured);
+    }
+
+    std::uint64_t Dropped()
+    {
+        return Sum(&ThreadBuffer::dropped);
+    }
+
+    std::atomic<bool> enabled{false};
+    std::atomic<bool> bodies{true};
+
+private:
+    /**
+     * @struct  ThreadBuffer
+     * @brief   一个录制线程的活动缓冲；mtx 只在本线程追加与写线程换出之间争用
+     */
+    struct ThreadBuffer
+    {
+        std::mutex mtx;
+        std::string active; ///< { u64 到达时刻 | varint 长度 | 记录 }...
+        std::uint64_t captured = 0;
+        std::uint64_t dropped = 0;
+    };
+
+    /// 一条换出的记录: 到达时刻与指向换出缓冲的视图
+    struct Pending
+    {
+        std::uint64_t ns;
+        std::string_view record;
+    };
+
+    ThreadBuffer &Local()
+    {
+        thread_local ThreadBuffer *local = nullptr;
+        if (local == nullptr)
+        {
+            auto created = std::make_unique<ThreadBuffer>();
+            created->active.reserve(std::min<std::size_t>(_capacity.load(std::memory_order_relaxed), 256 * 1024));
+            local = created.get();
+            std::lock_guard<std::mutex> lock(_mtx);
+            _buffers.push_back(std::move(created));
+        }
+        return *local;
+    }
+
+    std::uint64_t Sum(std::uint64_t ThreadBuffer::*counter)
+    {
+        std::lock_guard<std::mutex> lock(_mtx);
+        std::uint64_t total = 0;
+        for (auto &buffer : _buffers)
+        {
+            std::lock_guard<std::mutex> buffer_lock(buffer->mtx);
+            total += (*buffer).*counter;
+        }
+        return total;
+    }
+
+    /**
+     * @brief   换出全部线程缓冲，按到达时刻归并后写出
+     */
+    void Flush()
+    {
+        {
+            std::lock_guard<std::mutex> lock(_mtx);
+            _drained.resize(_buffers.size());
+            for (std::size_t i = 0; i < _buffers.size(); ++i)
+            {
+                std::lock_guard<std::mutex> buffer_lock(_buffers[i]->mtx);
+                _drained[i].swap(_buffers[i]->active);
+            }
+        }
+
+        _pending.clear();
+        for (const std::string &drained : _drained)
+        {
+            std::string_view in(drained);
+            while (in.size() > sizeof(std::uint64_t))
+            {
+                Pending item{};
+                std::uint64_t size = 0;
+                std::memcpy(&item.ns, in.data(), sizeof(item.ns));
+                in.remove_prefix(sizeof(item.ns));
+                GetVarint(in, size);
+                item.record = in.substr(0, static_cast<std::size_t>(size));
+                in.remove_prefix(item.record.size());
+                _pending.push_back(item);
+            }
+        }
+        // 各线程内已按时刻有序，稳定排序保持同一时刻的先后
+        std::stable_sort(_pending.begin(), _pending.end(),
+                         [](const Pending &a, const Pending &b) { return a.ns < b.ns; });
+
+        _out.clear();
+        for (const Pending &item : _pending)
+        {
+            // 换出前取了时刻、换出后才追加的记录会落到下一批，其间隔记为 0，时刻仍单调
+            PutVarint(_out, item.ns > _last_ns ? item.ns - _last_ns : 0);
+            PutVarint(_out, item.record.size());
+            _out.append(item.record.data(), item.record.size());
+            _last_ns = std::max(_last_ns, item.ns);
+        }
+        if (!_out.empty())
+        {
+            WriteAll(_fd, _out);
+        }
+        for (std::string &drained : _drained)
+        {
+            drained.clear();
+        }
+    }
+
+    void Run()
+    {
+        while (true)
+        {
+            {
+                std::unique_lock<std::mutex> lock(_wake_mtx);
+                _wake.wait_for(lock, std::chrono::milliseconds(10),
+                               [this]() { return !_running.load() || _urgent.load(); });
+            }
+            _urgent.store(false);
+            bool stopping = !_running.load();
+            Flush();
+            if (stopping)
+            {
+                return;
+            }
+        }
+    }
+
+    std::mutex _mtx; ///< 保护 _buffers 与 _fd
+    std::vector<std::unique_ptr<ThreadBuffer>> _buffers;
+    std::atomic<std::size_t> _capacity{0}; ///< 单个线程缓冲的容量
+    std::atomic<bool> _running{false};
+    std::atomic<bool> _urgent{false}; ///< 有线程缓冲过半，写线程提前换出
+
+    std::mutex _wake_mtx;
+    std::condition_variable _wake;
+
+    // 以下只由写线程访问，容量跨批次复用
+    std::vector<std::string> _drained;
+    std::vector<Pending> _pending;
+    std::string _out;
+    std::uint64_t _last_ns = 0;
+    int _fd = -1;
+    std::thread _writer;
+};
+
+CaptureBackend &Backend()
+{
+    static auto *backend = new CaptureBackend();
+    return *backend;
+}
+} // namespace
+
+bool TrafficCapture::Start(const Options &options)
+{
+    return Backend().Start(options);
+}
+
+void TrafficCapture::Stop()
+{
+    Backend().Stop();
+}
+
+bool TrafficCapture::Enabled()
+{
+    return Backend().enabled.load(std::memory_order_relaxed);
+}
+
+void TrafficCapture::Record(const boost::beast::http::request_header<> &header, std::string_view body)
+{
+    thread_local std::string record;
+    record.clear();
+    record.push_back(static_cast<char>(header.method()));
+    record.push_back(static_cast<char>(header.version()));
+    PutBytes(record, header.target());
+    PutVarint(record, static_cast<std::uint64_t>(std::distance(header.begin(), header.end())));
+    for (const auto &field : header)
+    {
+        PutBytes(record, field.name_string());
+        PutBytes(record, field.value());
+    }
+    PutBytes(record, Backend().bodies.load(std::memory_order_relaxed) ? body : std::string_view());
+    Backend().Append(record);
+}
+
+std::uint64_t TrafficCapture::Captured()
+{
+    return Backend().Captured();
+}
+
+std::uint64_t TrafficCapture::Dropped()
+{
+    return Backend().Dropped();
+}
+
+CaptureReader::~CaptureReader()
+{
+    if (_file != nullptr)
+    {
+        std::fclose(_file);
+    }
+}
+
+bool CaptureReader::Open(const std::string &path, std::string &error)
+{
+    _file = std::fopen(path.c_str(), "rb");
+    if (_file == nullptr)
+    {
+        error = "cannot open " + path;
+        return false;
+    }
+    unsigned char header[kFileHeaderSize];
+    if (std::fread(header, 1, sizeof(header), _file) != sizeof(header) ||
+        std::memcmp(header, kMagic, sizeof(kMagic)) != 0)
+    {
+        error = "not a GateServer capture file";
+        return false;
+    }
+    for (int i = 0; i < 8; ++i)
+    {
+        _start_unix_ns |= static_cast<std::uint64_t>(header[sizeof(kMagic) + i]) << (8 * i);
+    }
+    _has_bodies = (header[kFileHeaderSize - 1] & kFlagBodies) != 0;
+    return true;
+}
+
+bool CaptureReader::Next(CapturedRequest &request)
+{
+    if (_file == nullptr || _failed)
+    {
+        return false;
+    }
+    std::uint64_t delta = 0;
+    std::uint64_t size = 0;
+    int status = ReadVarint(_file, delta);
+    if (status == 1)
+    {
+        return false;
+    }
+    if (status < 0 || ReadVarint(_file, size) != 0 || size > kMaxRecord)
+    {
+        _failed = true;
+        return false;
+    }
+    _record.resize(static_cast<std::size_t>(size));
+    if (std::fread(_record.data(), 1, _record.size(), _file) != _record.size())
+    {
+        _failed = true;
+        return false;
+    }
+
+    std::string_view in(_record);
+    std::uint64_t header_count = 0;
+    if (in.size() < 2)
+    {
+        _failed = true;
+        return false;
+    }
+    request.method = static_cast<boost::beast::http::verb>(static_cast<std::uint8_t>(in[0]));
+    request.version = static_cast<std::uint8_t>(in[1]);
+    in.remove_prefix(2);
+    if (!GetBytes(in, request.target) || !GetVarint(in, header_count) || header_count > in.size())
+    {
+        _failed = true;
+        return false;
+    }
+    request.headers.resize(static_cast<std::size_t>(header_count));
+    for (auto &[name, value] : request.headers)
+    {
+        if (!GetBytes(in, name) || !GetBytes(in, value))
+        {
+            _failed = true;
+            return false;
+        }
+    }
+    if (!GetBytes(in, request.body))
+    {
+        _failed = true;
+        return false;
+    }
+
+    _offset_ns += delta;
+    request.offset_ns = _offset_ns;
+    return true;
+}
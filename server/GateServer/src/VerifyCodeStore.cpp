@@ -0,0 +1,227 @@
+#include "VerifyCodeStore.h"
+#include "ConfigMgr.h"
+#include "Logger.h"
+#include "RedisMgr.h"
+#include "RequestTrace.h"
+#include <algorithm>
+
+namespace
+{
+/**
+ * KEYS[1] 验证码键 (邮箱)，KEYS[2] 用户名；ARGV[1] 提交的验证码。
+ * 返回 0 通过 (验证码已删除)，1 不存在，2 不一致，3 用户名已存在。
+ */
+const char *const kVerifyScript = R"lua(
+local code = redis.call('GET', KEYS[1])
+if not code then
+    return 1
+end
+if code ~= ARGV[1] then
+    return 2
+end
+if redis.call('EXISTS', KEYS[2]) == 1 then
+    return 3
+end
+redis.call('DEL', KEYS[1])
+return 0
+)lua";
+
+/**
+ * @brief   kVerifyScript 的 C++ 实现，供本地后端 ([Redis] Backend = local) 执行
+ */
+RedisReply VerifyLocally(LocalKv::Transaction &txn, const std::vector<std::string> &keys,
+                         const std::vector<std::string> &argv)
+{
+    RedisReply reply;
+    reply.type = RedisReply::Type::Integer;
+    if (keys.size() != 2 || argv.size() != 1)
+    {
+        return RedisReply::Error("ERR verify script expects 2 keys and 1 argument");
+    }
+    const std::string *code = txn.Get(keys[0]);
+    if (code == nullptr)
+    {
+        reply.integer = 1;
+    }
+    else if (*code != argv[0])
+    {
+        reply.integer = 2;
+    }
+    else if (txn.Exists(keys[1]))
+    {
+        reply.integer = 3;
+    }
+    else
+    {
+        txn.Del(keys[0]);
+        reply.integer = 0;
+    }
+    return reply;
+}
+} // namespace
+
+VerifyCodeStore::VerifyCodeStore()
+{
+    std::string ttl = ConfigMgr::GetInstance()["Redis"]["VerifyCodeTtl"];
+    _ttl_seconds = std::max(0, atoi(ttl.c_str()));
+    RedisMgr::GetInstance()->RegisterLocalScript(kVerifyScript, &VerifyLocally);
+    if (!Load())
+    {
+        LOG_WARN("verify script not cached, falling back to EVAL until redis is reachable");
+    }
+}
+
+VerifyCodeStore::~VerifyCodeStore()
+{
+}
+
+bool VerifyCodeStore::Save(const std::string &email, const std::string &code)
+{
+    if (_ttl_seconds <= 0)
+    {
+        return RedisMgr::GetInstance()->Set(email, code);
+    }
+    TRACE_SPAN("redis.set");
+    RedisReply reply = RedisMgr::GetInstance()->Execute({"SET", email, code, "EX", std::to_string(_ttl_seconds)});
+    if (reply.IsError())
+    {
+        LOG_WARN("redis command failed").Field("cmd", "SET").Field("error", reply.str);
+        return false;
+    }
+    return true;
+}
+
+VerifyCodeStore::Result VerifyCodeStore::VerifyAndConsume(const std::string &email, const std::string &code,
+                                                          const std::string &user)
+{
+    TRACE_SPAN("redis.verify");
+    auto redis = RedisMgr::GetInstance();
+    std::string sha = Sha();
+    RedisReply reply;
+    if (!sha.empty())
+    {
+        reply = redis->Execute({"EVALSHA", sha, "2", email, user, code});
+    }
+    if (sha.empty() || IsNoScript(reply))
+    {
+        reply = redis->Execute({"EVAL", kVerifyScript, "2", email, user, code});
+        if (sha.empty() && !reply.IsError())
+        {
+            LoadAsync();
+        }
+    }
+    return ToResult(reply);
+}
+
+void VerifyCodeStore::VerifyAndConsume(const std::string &email, const std::string &code, const std::string &user,
+                                       ResultCallback callback)
+{
+    auto redis = RedisMgr::GetInstance();
+    std::string sha = Sha();
+    if (sha.empty())
+    {
+        redis->Command({"EVAL", kVerifyScript, "2", email, user, code},
+                       [this, callback = std::move(callback)](RedisReply reply)
+                       {
+                           if (!reply.IsError())
+                           {
+                               LoadAsync();
+                           }
+                           callback(ToResult(reply));
+                       });
+        return;
+    }
+    redis->Command({"EVALSHA", sha, "2", email, user, code},
+                   [email, code, user, callback = std::move(callback)](RedisReply reply)
+                   {
+                       if (!IsNoScript(reply))
+                       {
+                           callback(ToResult(reply));
+                           return;
+                       }
+                       // EVAL 会让服务端重新缓存同一 SHA1，之后的 EVALSHA 恢复正常
+                       RedisMgr::GetInstance()->Command({"EVAL", kVerifyScript, "2", email, user, code},
+                                                        [callback](RedisReply retry)
+                                                        { callback(ToResult(retry)); });
+                   });
+}
+
+const char *VerifyCodeStore::Name(Result result)
+{
+    switch (result)
+    {
+    case Result::Ok:
+        return "ok";
+    case Result::Expired:
+        return "expired";
+    case Result::Mismatch:
+        return "mismatch";
+    case Result::UserExists:
+        return "user_exists";
+    case Result::Error:
+        break;
+    }
+    return "error";
+}
+
+bool VerifyCodeStore::Load()
+{
+    RedisReply reply = RedisMgr::GetInstance()->Execute({"SCRIPT", "LOAD", kVerifyScript});
+    if (reply.type != RedisReply::Type::String)
+    {
+        LOG_WARN("verify script load failed").Field("error", reply.str);
+        return false;
+    }
+    LOG_INFO("verify script cached").Field("sha", reply.str);
+    std::lock_guard<std::mutex> lock(_mutex);
+    _sha = std::move(reply.str);
+    return true;
+}
+
+void VerifyCodeStore::LoadAsync()
+{
+    RedisMgr::GetInstance()->Command({"SCRIPT", "LOAD", kVerifyScript},
+                                     [this](RedisReply reply)
+                                     {
+                                         if (reply.type != RedisReply::Type::String)
+                                         {
+                                             return;
+                                         }
+                                         std::lock_guard<std::mutex> lock(_mutex);
+                                         _sha = std::move(reply.str);
+                                     });
+}
+
+std::string VerifyCodeStore::Sha() const
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    return _sha;
+}
+
+VerifyCodeStore::Result VerifyCodeStore::ToResult(const RedisReply &reply)
+{
+    if (reply.type != RedisReply::Type::Integer)
+    {
+        LOG_WARN("verify script failed").Field("error", reply.IsError() ? reply.str : "unexpected reply");
+        return Result::Error;
+    }
+    switch (reply.integer)
+    {
+    case 0:
+        return Result::Ok;
+    case 1:
+        return Result::Expired;
+    case 2:
+        return Result::Mismatch;
+    case 3:
+        return Result::UserExists;
+    default:
+        LOG_WARN("verify script failed").Field("error", "unexpected result").Field("result", reply.integer);
+        return Result::Error;
+    }
+}
+
+bool VerifyCodeStore::IsNoScript(const RedisReply &reply)
+{
+    return reply.IsError() && reply.str.compare(0, 8, "NOSCRIPT") == 0;
+}
@@ -6,7 +6,8 @@
 
 #include "VerifyGrpcClient.h"
 #include "ConfigMgr.h" // 如果你还没有 ConfigMgr，可以先注释掉，看下面的代码
-#include <iostream>
+#include "Logger.h"
+#include "RequestTrace.h"
 
 VerifyGrpcClient::VerifyGrpcClient()
 {
@@ -21,15 +22,15 @@ VerifyGrpcClient::VerifyGrpcClient()
     if (host.empty())
     {
         host = "localhost";
-        std::cout << "[Warning] VerifyServer Host not found in config, using default: localhost" << std::endl;
+        LOG_WARN("VerifyServer Host not found in config, using default").Field("host", host);
     }
     if (port.empty())
     {
         port = "50051";
-        std::cout << "[Warning] VerifyServer Port not found in config, using default: 50051" << std::endl;
+        LOG_WARN("VerifyServer Port not found in config, using default").Field("port", port);
     }
 
-    std::cout << "VerifyGrpcClient config - Host: " << host << ", Port: " << port << std::endl;
+    LOG_INFO("VerifyGrpcClient config").Field("host", host).Field("port", port);
 
     // ---------------------------------------------------------
     // 2. 初始化连接池
@@ -38,11 +39,13 @@ VerifyGrpcClient::VerifyGrpcClient()
     // ---------------------------------------------------------
     pool_ = std::make_unique<RPConPool>(5, host, port);
 
-    std::cout << "VerifyGrpcClient initialized with connection pool." << std::endl;
+    LOG_INFO("VerifyGrpcClient initialized with connection pool");
 }
 
 GetVerifyResponse VerifyGrpcClient::GetVerifyCode(std::string email)
 {
+    TRACE_SPAN("grpc.get_verify_code");
+
     // =========================================================
     // 方案：既保留了高大上的代码，又能在没有服务器时运行
     // =========================================================
@@ -54,7 +57,11 @@ GetVerifyResponse VerifyGrpcClient::GetVerifyCode(std::string email)
     GetVerifyRequest request;
     request.set_email(email);
 
-    auto stub = pool_->getConnection();
+    std::unique_ptr<VerifyService::Stub> stub;
+    {
+        TRACE_SPAN("grpc.acquire");
+        stub = pool_->getConnection();
+    }
     Status status = stub->GetVerifyCode(&context, request, &reply);
 
     if (status.ok()) {
@@ -69,7 +76,7 @@ GetVerifyResponse VerifyGrpcClient::GetVerifyCode(std::string email)
 
     // 【现在用的 Mock 代码】
     // 假装 RPC 调用成功了
-    std::cout << "[Mock] GetVerifyCode called for " << email << std::endl;
+    LOG_DEBUG("[Mock] GetVerifyCode").Field("email", email);
 
     GetVerifyResponse reply;
     reply.set_error(0); // 成功
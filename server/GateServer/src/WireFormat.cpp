@@ -0,0 +1,64 @@
+/**
+ * @file    WireFormat.cpp
+ * @brief   编码格式协商实现
+ * @author  msr
+ */
+
+#include "WireFormat.h"
+#include <cctype>
+
+namespace
+{
+/**
+ * @brief   大小写不敏感地查找子串 (媒体类型不区分大小写)
+ */
+bool ContainsNoCase(std::string_view text, std::string_view pattern)
+{
+    if (pattern.size() > text.size())
+    {
+        return false;
+    }
+    for (std::size_t i = 0; i + pattern.size() <= text.size(); ++i)
+    {
+        std::size_t j = 0;
+        while (j < pattern.size() &&
+               std::tolower(static_cast<unsigned char>(text[i + j])) == static_cast<unsigned char>(pattern[j]))
+        {
+            ++j;
+        }
+        if (j == pattern.size())
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool StartsWithNoCase(std::string_view text, std::string_view prefix)
+{
+    return text.size() >= prefix.size() && ContainsNoCase(text.substr(0, prefix.size()), prefix);
+}
+} // namespace
+
+WireNegotiation NegotiateWireFormat(std::string_view content_type, std::string_view accept)
+{
+    WireNegotiation result;
+    if (StartsWithNoCase(content_type, kProtobufContentType))
+    {
+        result.request = WireFormat::Protobuf;
+    }
+
+    if (ContainsNoCase(accept, kProtobufContentType))
+    {
+        result.response = WireFormat::Protobuf;
+    }
+    else if (ContainsNoCase(accept, "json"))
+    {
+        result.response = WireFormat::Json;
+    }
+    else
+    {
+        result.response = result.request;
+    }
+    return result;
+}
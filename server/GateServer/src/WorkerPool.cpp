@@ -0,0 +1,136 @@
+/**
+ * @file    WorkerPool.cpp
+ * @brief   有界业务线程池实现
+ * @author  msr
+ */
+
+#include "WorkerPool.h"
+#include "Logger.h"
+#include <algorithm>
+#include <utility>
+
+WorkerPool::WorkerPool(std::string name, std::size_t threads, std::size_t capacity)
+    : _name(std::move(name)),
+      _ring(std::max<std::size_t>(capacity, 1))
+{
+    if (threads == 0)
+    {
+        threads = std::max(1u, std::thread::hardware_concurrency());
+    }
+    for (std::size_t i = 0; i < threads; ++i)
+    {
+        _threads.emplace_back([this]() { Run(); });
+    }
+}
+
+WorkerPool::~WorkerPool()
+{
+    Stop();
+}
+
+bool WorkerPool::TryPost(Task task)
+{
+    {
+        std::lock_guard<std::mutex> lock(_mtx);
+        if (_stopped || _size == _ring.size())
+        {
+            _rejected.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+        _ring[(_head + _size) % _ring.size()] = std::move(task);
+        ++_size;
+
+        _depth.store(_size, std::memory_order_relaxed);
+        if (_size > _peak_depth.load(std::memory_order_relaxed))
+        {
+            _peak_depth.store(_size, std::memory_order_relaxed);
+        }
+    }
+    _submitted.fetch_add(1, std::memory_order_relaxed);
+    _cv.notify_one();
+    return true;
+}
+
+void WorkerPool::Stop()
+{
+    {
+        std::lock_guard<std::mutex> lock(_mtx);
+        if (_stopped)
+        {
+            return;
+        }
+        _stopped = true;
+    }
+    _cv.notify_all();
+    for (auto &t : _threads)
+    {
+        if (t.joinable())
+        {
+            t.join();
+        }
+    }
+
+    // 未执行的任务在这里析构，其捕获的连接随之释放
+    std::vector<Task> dropped;
+    {
+        std::lock_guard<std::mutex> lock(_mtx);
+        for (; _size > 0; --_size)
+        {
+            dropped.push_back(std::move(_ring[_head]));
+            _head = (_head + 1) % _ring.size();
+        }
+        _depth.store(0, std::memory_order_relaxed);
+    }
+}
+
+const std::string &WorkerPool::Name() const
+{
+    return _name;
+}
+
+WorkerPool::Stats WorkerPool::GetStats() const
+{
+    Stats stats;
+    stats.depth = _depth.load(std::memory_order_relaxed);
+    stats.peak_depth = _peak_depth.load(std::memory_order_relaxed);
+    stats.capacity = _ring.size();
+    stats.busy = _busy.load(std::memory_order_relaxed);
+    stats.threads = _threads.size();
+    stats.submitted = _submitted.load(std::memory_order_relaxed);
+    stats.rejected = _rejected.load(std::memory_order_relaxed);
+    stats.completed = _completed.load(std::memory_order_relaxed);
+    return stats;
+}
+
+void WorkerPool::Run()
+{
+    for (;;)
+    {
+        Task task;
+        {
+            std::unique_lock<std::mutex> lock(_mtx);
+            _cv.wait(lock, [this]() { return _stopped || _size > 0; });
+            if (_stopped)
+            {
+                return;
+            }
+            task = std::move(_ring[_head]);
+            _ring[_head] = nullptr;
+            _head = (_head + 1) % _ring.size();
+            --_size;
+            _depth.store(_size, std::memory_order_relaxed);
+        }
+
+        _busy.fetch_add(1, std::memory_order_relaxed);
+        try
+        {
+            task();
+        }
+        catch (std::exception &exp)
+        {
+            LOG_ERROR("worker task exception").Field("pool", _name).Field("what", exp.what());
+        }
+        _busy.fetch_sub(1, std::memory_order_relaxed);
+        _completed.fetch_add(1, std::memory_order_relaxed);
+    }
+}
@@ -0,0 +1,72 @@
+/**
+ * @file    BenchReport.h
+ * @brief   压测工具 (gate_bench / gate_replay) 共用的结果输出函数: 分位数与 JSON 拼接
+ * @author  msr
+ *
+ * @details
+ * 两个工具的 JSON 结果格式一致 (数值保留三位小数、延迟单位为微秒)，便于用同一套脚本对比。
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+namespace report
+{
+/**
+ * @brief   最近秩分位数
+ * @param   sorted 已排序的延迟 (ns)
+ * @return  第 q 分位的延迟 (us)，为空时返回 0
+ */
+inline double Percentile(const std::vector<std::uint64_t> &sorted, double q)
+{
+    if (sorted.empty())
+    {
+        return 0;
+    }
+    auto rank = static_cast<std::size_t>(std::ceil(q * static_cast<double>(sorted.size())));
+    return static_cast<double>(sorted[std::min(sorted.size(), std::max<std::size_t>(rank, 1)) - 1]) / 1000.0;
+}
+
+/**
+ * @brief   追加一个带引号的 JSON 字符串，转义引号、反斜杠与控制字符
+ */
+inline void AppendJsonString(std::string &out, const std::string &value)
+{
+    out.push_back('"');
+    for (char c : value)
+    {
+        if (c == '"' || c == '\\')
+        {
+            out.push_back('\\');
+            out.push_back(c);
+        }
+        else if (static_cast<unsigned char>(c) < 0x20)
+        {
+            char escaped[8];
+            std::snprintf(escaped, sizeof(escaped), "\\u%04x", static_cast<unsigned char>(c));
+            out.append(escaped);
+        }
+        else
+        {
+            out.push_back(c);
+        }
+    }
+    out.push_back('"');
+}
+
+/**
+ * @brief   追加一个保留三位小数的数值
+ */
+inline void AppendNumber(std::string &out, double value)
+{
+    char text[32];
+    std::snprintf(text, sizeof(text), "%.3f", value);
+    out.append(text);
+}
+} // namespace report
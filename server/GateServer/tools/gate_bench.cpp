@@ -0,0 +1,767 @@
+/**
+ * @file    gate_bench.cpp
+ * @brief   GateServer HTTP 压测工具 (负载生成器)
+ * @author  msr
+ *
+ * @details
+ * - 每个线程一个 io_context，连接按轮转分到各线程；每个连接串行地 发请求 -> 读响应，
+ *   统计只在所属线程内累加，结束后合并，压测期间线程之间没有共享写。
+ * - 请求按权重从 /get_varifycode、/user_register、/get_test 中抽取 (--mix)。
+ * - --rate 为 0 时为闭环 (每个连接收到响应立即发下一个)；否则为开环，总速率均分到各连接，
+ *   延迟从“计划发出时刻”起算，服务端变慢时排队的时间也计入 (避免 Coordinated Omission)。
+ * - --keepalive=off 时每个请求新建连接，延迟包含建连时间。
+ * - 先预热 --warmup 秒 (不计入统计)，再统计 --duration 秒；结果以 JSON 输出，便于跨提交对比。
+ *
+ * 错误分类: connect (建连失败) / io (读写失败、对端关闭) / timeout (超过 --timeout 未收到响应) /
+ * http (非 2xx) / app (POST 路由的响应体中 error 不为 0)。
+ *
+ * 用法: gate_bench [--host=127.0.0.1] [--port=8080] [--threads=1] [--connections=16]
+ *                  [--duration=10] [--warmup=1] [--rate=0] [--keepalive=on|off] [--timeout=5000]
+ *                  [--mix=get_varifycode:50,get_test:50] [--varifycode=123456] [--label=...] [--output=file]
+ *
+ * @note    /user_register 会写 MySQL，且要求 Redis 中的验证码与 --varifycode 一致 (Mock 验证服务固定为 123456)，
+ *          默认权重为 0。
+ */
+
+#include "BenchReport.h"
+#include <boost/asio.hpp>
+#include <boost/beast.hpp>
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace net = boost::asio;
+namespace beast = boost::beast;
+namespace http = boost::beast::http;
+using tcp = boost::asio::ip::tcp;
+
+namespace
+{
+using Clock = std::chrono::steady_clock;
+
+/**
+ * @enum    RouteKind
+ * @brief   压测的路由，下标与 kRoutes 对应
+ */
+enum RouteKind : std::size_t
+{
+    VerifyCode = 0,
+    UserRegister = 1,
+    GetTest = 2,
+    RouteCount = 3
+};
+
+constexpr const char *kRoutes[RouteCount] = {"/get_varifycode", "/user_register", "/get_test"};
+
+/**
+ * @struct  Options
+ * @brief   命令行参数
+ */
+struct Options
+{
+    std::string host = "127.0.0.1";
+    std::string port = "8080";
+    unsigned threads = 1;
+    unsigned connections = 16;
+    double duration = 10.0;  ///< 统计时长 (秒)
+    double warmup = 1.0;     ///< 预热时长 (秒)
+    double rate = 0.0;       ///< 总请求速率 (req/s)，0 = 闭环
+    bool keep_alive = true;
+    unsigned timeout_ms = 5000;
+    std::array<unsigned, RouteCount> mix{50, 0, 50};
+    std::string varifycode = "123456";
+    std::string label;
+    std::string output;
+};
+
+/**
+ * @struct  RouteStats
+ * @brief   单个路由的结果 (单线程内累加)
+ */
+struct RouteStats
+{
+    std::uint64_t ok = 0;
+    std::uint64_t http_errors = 0;
+    std::uint64_t app_errors = 0;
+    std::uint64_t io_errors = 0;
+    std::uint64_t timeouts = 0;
+    std::uint64_t connect_errors = 0;
+    std::vector<std::uint64_t> latency_ns; ///< 收到响应的请求 (含 http / app 错误)
+
+    std::uint64_t Errors() const
+    {
+        return http_errors + app_errors + io_errors + timeouts + connect_errors;
+    }
+
+    void Merge(RouteStats &other)
+    {
+        ok += other.ok;
+        http_errors += other.http_errors;
+        app_errors += other.app_errors;
+        io_errors += other.io_errors;
+        timeouts += other.timeouts;
+        connect_errors += other.connect_errors;
+        latency_ns.insert(latency_ns.end(), other.latency_ns.begin(), other.latency_ns.end());
+    }
+};
+
+/**
+ * @struct  Window
+ * @brief   统计窗口: 在 [begin, end) 内完成的请求计入结果；end 之后不再发新请求
+ */
+struct Window
+{
+    Clock::time_point begin;
+    Clock::time_point end;
+};
+
+bool ParseBool(const std::string &value)
+{
+    return value == "on" || value == "1" || value == "true" || value == "yes";
+}
+
+/**
+ * @brief   解析 "get_varifycode:70,get_test:30" (路由名可带前导 /)
+ */
+bool ParseMix(const std::string &text, std::array<unsigned, RouteCount> &mix)
+{
+    std::array<unsigned, RouteCount> parsed{};
+    std::size_t pos = 0;
+    while (pos < text.size())
+    {
+        std::size_t comma = text.find(',', pos);
+        std::string item = text.substr(pos, comma == std::string::npos ? std::string::npos : comma - pos);
+        pos = (comma == std::string::npos) ? text.size() : comma + 1;
+
+        std::size_t colon = item.find(':');
+        if (colon == std::string::npos)
+        {
+            return false;
+        }
+        std::string name = item.substr(0, colon);
+        if (!name.empty() && name[0] == '/')
+        {
+            name.erase(0, 1);
+        }
+        std::size_t route = RouteCount;
+        for (std::size_t r = 0; r < RouteCount; ++r)
+        {
+            if (name == kRoutes[r] + 1)
+            {
+                route = r;
+            }
+        }
+        if (route == RouteCount)
+        {
+            return false;
+        }
+        parsed[route] = static_cast<unsigned>(std::atoi(item.c_str() + colon + 1));
+    }
+    if (parsed[VerifyCode] + parsed[UserRegister] + parsed[GetTest] == 0)
+    {
+        return false;
+    }
+    mix = parsed;
+    return true;
+}
+
+void PrintUsage()
+{
+    std::fprintf(stderr,
+                 "usage: gate_bench [--host=127.0.0.1] [--port=8080] [--threads=1] [--connections=16]\n"
+                 "                  [--duration=10] [--warmup=1] [--rate=0] [--keepalive=on|off] [--timeout=5000]\n"
+                 "                  [--mix=get_varifycode:50,user_register:0,get_test:50] [--varifycode=123456]\n"
+                 "                  [--label=text] [--output=result.json]\n");
+}
+
+bool ParseOptions(int argc, char *argv[], Options &options)
+{
+    for (int i = 1; i < argc; ++i)
+    {
+        std::string arg = argv[i];
+        if (arg == "-h" || arg == "--help" || arg.compare(0, 2, "--") != 0)
+        {
+            return false;
+        }
+        std::string key;
+        std::string value;
+        std::size_t eq = arg.find('=');
+        if (eq != std::string::npos)
+        {
+            key = arg.substr(2, eq - 2);
+            value = arg.substr(eq + 1);
+        }
+        else if (i + 1 < argc)
+        {
+            key = arg.substr(2);
+            value = argv[++i];
+        }
+        else
+        {
+            return false;
+        }
+
+        if (key == "host")
+        {
+            options.host = value;
+        }
+        else if (key == "port")
+        {
+            options.port = value;
+        }
+        else if (key == "threads")
+        {
+            options.threads = static_cast<unsigned>(std::max(1, std::atoi(value.c_str())));
+        }
+        else if (key == "connections")
+        {
+            options.connections = static_cast<unsigned>(std::max(1, std::atoi(value.c_str())));
+        }
+        else if (key == "duration")
+        {
+            options.duration = std::max(0.1, std::atof(value.c_str()));
+        }
+        else if (key == "warmup")
+        {
+            options.warmup = std::max(0.0, std::atof(value.c_str()));
+        }
+        else if (key == "rate")
+        {
+            options.rate = std::max(0.0, std::atof(value.c_str()));
+        }
+        else if (key == "keepalive")
+        {
+            options.keep_alive = ParseBool(value);
+        }
+        else if (key == "timeout")
+        {
+            options.timeout_ms = static_cast<unsigned>(std::max(1, std::atoi(value.c_str())));
+        }
+        else if (key == "mix")
+        {
+            if (!ParseMix(value, options.mix))
+            {
+                std::fprintf(stderr, "invalid --mix: %s\n", value.c_str());
+                return false;
+            }
+        }
+        else if (key == "varifycode")
+        {
+            options.varifycode = value;
+        }
+        else if (key == "label")
+        {
+            options.label = value;
+        }
+        else if (key == "output")
+        {
+            options.output = value;
+        }
+        else
+        {
+            std::fprintf(stderr, "unknown option: --%s\n", key.c_str());
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * @class   Client
+ * @brief   一个压测连接: 串行发送请求，统计写入所属线程的 RouteStats
+ *
+ * @details 所有回调都在同一个 io_context 线程上执行。
+ *          _deadline 同时用于建连与请求超时，_generation 区分过期的超时回调。
+ */
+class Client : public std::enable_shared_from_this<Client>
+{
+public:
+    Client(net::io_context &ioc, const Options &options, const tcp::resolver::results_type &endpoints,
+           const Window &window, std::array<RouteStats, RouteCount> &stats, std::uint32_t id, std::uint64_t nonce)
+        : _options(options),
+          _endpoints(endpoints),
+          _window(window),
+          _stats(stats),
+          _socket(ioc),
+          _deadline(ioc),
+          _pacer(ioc),
+          _id(id),
+          _nonce(nonce),
+          _rng(0x9E3779B97F4A7C15ull ^ (static_cast<std::uint64_t>(id) + 1) * 0xBF58476D1CE4E5B9ull)
+    {
+        if (_options.rate > 0)
+        {
+            _interval = std::chrono::duration_cast<Clock::duration>(
+                std::chrono::duration<double>(_options.connections / _options.rate));
+        }
+        unsigned total = 0;
+        for (std::size_t r = 0; r < RouteCount; ++r)
+        {
+            total += _options.mix[r];
+            _cumulative[r] = total;
+        }
+    }
+
+    void Start()
+    {
+        // 开环时各连接错开起始相位，避免所有连接同一时刻发请求
+        _next = Clock::now() + _interval * _id / std::max(1u, _options.connections);
+        Next();
+    }
+
+private:
+    /**
+     * @brief   安排下一个请求 (开环时等待到计划时刻)
+     */
+    void Next()
+    {
+        auto now = Clock::now();
+        if (now >= _window.end)
+        {
+            Stop();
+            return;
+        }
+        if (_options.rate <= 0)
+        {
+            _scheduled = now;
+            Issue();
+            return;
+        }
+        _scheduled = _next;
+        _next += _interval;
+        if (_scheduled <= now)
+        {
+            Issue();
+            return;
+        }
+        _pacer.expires_at(_scheduled);
+        _pacer.async_wait(
+            [self = shared_from_this()](beast::error_code ec)
+            {
+                if (!ec)
+                {
+                    self->Issue();
+                }
+            });
+    }
+
+    void Issue()
+    {
+        _route = Pick();
+        if (_socket.is_open())
+        {
+            Send();
+        }
+        else
+        {
+            Connect();
+        }
+    }
+
+    void Connect()
+    {
+        ArmDeadline();
+        net::async_connect(_socket, _endpoints,
+                           [self = shared_from_this()](beast::error_code ec, const tcp::endpoint &)
+                           {
+                               if (ec)
+                               {
+                                   self->Fail(self->_timed_out ? &RouteStats::timeouts : &RouteStats::connect_errors);
+                                   return;
+                               }
+                               self->_socket.set_option(tcp::no_delay(true));
+                               self->Send();
+                           });
+    }
+
+    void Send()
+    {
+        ArmDeadline();
+        BuildRequest();
+        net::async_write(_socket, net::buffer(_out),
+                         [self = shared_from_this()](beast::error_code ec, std::size_t)
+                         {
+                             if (ec)
+                             {
+                                 self->Fail(self->_timed_out ? &RouteStats::timeouts : &RouteStats::io_errors);
+                                 return;
+                             }
+                             self->_response = {};
+                             http::async_read(self->_socket, self->_buffer, self->_response,
+                                              [self](beast::error_code ec, std::size_t) { self->OnRead(ec); });
+                         });
+    }
+
+    void OnRead(beast::error_code ec)
+    {
+        if (ec)
+        {
+            Fail(_timed_out ? &RouteStats::timeouts : &RouteStats::io_errors);
+            return;
+        }
+        DisarmDeadline();
+
+        auto now = Clock::now();
+        if (InWindow(now))
+        {
+            RouteStats &stats = _stats[_route];
+            auto latency = std::chrono::duration_cast<std::chrono::nanoseconds>(now - _scheduled);
+            stats.latency_ns.push_back(static_cast<std::uint64_t>(latency.count()));
+            unsigned status = _response.result_int();
+            if (status < 200 || status >= 300)
+            {
+                ++stats.http_errors;
+            }
+            else if (_route != GetTest && _response.body().find("\"error\":0") == std::string::npos)
+            {
+                ++stats.app_errors;
+            }
+            else
+            {
+                ++stats.ok;
+            }
+        }
+
+        if (!_options.keep_alive || !_response.keep_alive())
+        {
+            Close();
+        }
+        Next();
+    }
+
+    /**
+     * @brief   记一次失败并关闭连接；建连失败时退避 10ms 再继续，避免空转
+     */
+    void Fail(std::uint64_t RouteStats::*counter)
+    {
+        DisarmDeadline();
+        if (InWindow(Clock::now()))
+        {
+            ++(_stats[_route].*counter);
+        }
+        Close();
+        if (counter == &RouteStats::connect_errors)
+        {
+            _pacer.expires_after(std::chrono::milliseconds(10));
+            _pacer.async_wait([self = shared_from_this()](beast::error_code) { self->Next(); });
+            return;
+        }
+        Next();
+    }
+
+    void ArmDeadline()
+    {
+        _timed_out = false;
+        std::uint64_t generation = ++_generation;
+        _deadline.expires_after(std::chrono::milliseconds(_options.timeout_ms));
+        _deadline.async_wait(
+            [self = shared_from_this(), generation](beast::error_code ec)
+            {
+                if (!ec && generation == self->_generation)
+                {
+                    self->_timed_out = true;
+                    beast::error_code ignored;
+                    self->_socket.close(ignored);
+                }
+            });
+    }
+
+    void DisarmDeadline()
+    {
+        ++_generation;
+        _deadline.cancel();
+    }
+
+    void Close()
+    {
+        beast::error_code ignored;
+        _socket.shutdown(tcp::socket::shutdown_both, ignored);
+        _socket.close(ignored);
+        _buffer.consume(_buffer.size());
+    }
+
+    void Stop()
+    {
+        DisarmDeadline();
+        _pacer.cancel();
+        Close();
+    }
+
+    bool InWindow(Clock::time_point now) const
+    {
+        return now >= _window.begin && now < _window.end;
+    }
+
+    RouteKind Pick()
+    {
+        // xorshift64*
+        _rng ^= _rng >> 12;
+        _rng ^= _rng << 25;
+        _rng ^= _rng >> 27;
+        unsigned roll = static_cast<unsigned>((_rng * 0x2545F4914F6CDD1Dull) >> 33) % _cumulative[RouteCount - 1];
+        for (std::size_t r = 0; r < RouteCount; ++r)
+        {
+            if (roll < _cumulative[r])
+            {
+                return static_cast<RouteKind>(r);
+            }
+        }
+        return GetTest;
+    }
+
+    void AppendHead(const char *method, const char *target, std::size_t content_length)
+    {
+        _out.append(method).append(" ").append(target).append(" HTTP/1.1\r\nHost: ").append(_options.host);
+        _out.append(_options.keep_alive ? "\r\nConnection: keep-alive" : "\r\nConnection: close");
+        if (content_length != 0)
+        {
+            _out.append("\r\nContent-Type: application/json\r\nContent-Length: ");
+            _out.append(std::to_string(content_length));
+        }
+        _out.append("\r\n\r\n");
+    }
+
+    void BuildRequest()
+    {
+        ++_sequence;
+        _out.clear();
+        std::string email = "bench" + std::to_string(_nonce) + "_" + std::to_string(_id) + "@example.com";
+        switch (_route)
+        {
+        case VerifyCode:
+        {
+            std::string body = "{\"email\":\"" + email + "\"}";
+            AppendHead("POST", kRoutes[VerifyCode], body.size());
+            _out.append(body);
+            break;
+        }
+        case UserRegister:
+        {
+            // 用户名每次不同，避免命中“用户已存在”
+            std::string user = "bench" + std::to_string(_nonce) + "_" + std::to_string(_id) + "_" +
+                               std::to_string(_sequence);
+            std::string body = "{\"email\":\"" + user + "@example.com\",\"user\":\"" + user +
+                               "\",\"passwd\":\"bench\",\"confirm\":\"bench\",\"varifycode\":\"" +
+                               _options.varifycode + "\"}";
+            AppendHead("POST", kRoutes[UserRegister], body.size());
+            _out.append(body);
+            break;
+        }
+        default:
+        {
+            std::string target = std::string(kRoutes[GetTest]) + "?conn=" + std::to_string(_id) +
+                                 "&seq=" + std::to_string(_sequence);
+            AppendHead("GET", target.c_str(), 0);
+            break;
+        }
+        }
+    }
+
+    const Options &_options;
+    const tcp::resolver::results_type &_endpoints;
+    const Window &_window;
+    std::array<RouteStats, RouteCount> &_stats;
+
+    tcp::socket _socket;
+    net::steady_timer _deadline;
+    net::steady_timer _pacer;
+    beast::flat_buffer _buffer;
+    http::response<http::string_body> _response;
+    std::string _out;
+
+    std::uint32_t _id;
+    std::uint64_t _nonce;
+    std::uint64_t _rng;
+    std::uint64_t _sequence = 0;
+    std::uint64_t _generation = 0;
+    bool _timed_out = false;
+    std::array<unsigned, RouteCount> _cumulative{};
+    RouteKind _route = GetTest;
+
+    Clock::duration _interval{0};
+    Clock::time_point _next;
+    Clock::time_point _scheduled;
+};
+
+/**
+ * @brief   输出一个路由 (或合计) 的结果对象
+ */
+void AppendStats(std::string &out, RouteStats &stats, double seconds)
+{
+    std::sort(stats.latency_ns.begin(), stats.latency_ns.end());
+    std::uint64_t requests = stats.ok + stats.Errors();
+    double mean = 0;
+    for (std::uint64_t ns : stats.latency_ns)
+    {
+        mean += static_cast<double>(ns);
+    }
+    mean = stats.latency_ns.empty() ? 0 : mean / static_cast<double>(stats.latency_ns.size()) / 1000.0;
+
+    out.append("{\"requests\":").append(std::to_string(requests));
+    out.append(",\"ok\":").append(std::to_string(stats.ok));
+    out.append(",\"throughput_rps\":");
+    report::AppendNumber(out, static_cast<double>(requests) / seconds);
+    out.append(",\"errors\":{\"total\":").append(std::to_string(stats.Errors()));
+    out.append(",\"connect\":").append(std::to_string(stats.connect_errors));
+    out.append(",\"io\":").append(std::to_string(stats.io_errors));
+    out.append(",\"timeout\":").append(std::to_string(stats.timeouts));
+    out.append(",\"http\":").append(std::to_string(stats.http_errors));
+    out.append(",\"app\":").append(std::to_string(stats.app_errors));
+    out.append("},\"latency_us\":{\"min\":");
+    report::AppendNumber(out, stats.latency_ns.empty() ? 0 : static_cast<double>(stats.latency_ns.front()) / 1000.0);
+    out.append(",\"mean\":");
+    report::AppendNumber(out, mean);
+    const std::pair<const char *, double> quantiles[] = {
+        {"p50", 0.5}, {"p90", 0.9}, {"p99", 0.99}, {"p999", 0.999}, {"max", 1.0}};
+    for (const auto &[name, q] : quantiles)
+    {
+        out.append(",\"").append(name).append("\":");
+        report::AppendNumber(out, report::Percentile(stats.latency_ns, q));
+    }
+    out.append("}}");
+}
+
+std::string RenderResult(const Options &options, std::array<RouteStats, RouteCount> &routes, double seconds)
+{
+    RouteStats total;
+    for (auto &route : routes)
+    {
+        total.Merge(route);
+    }
+
+    std::string out = "{\"tool\":\"gate_bench\",\"version\":1,\"label\":";
+    report::AppendJsonString(out, options.label);
+    out.append(",\"config\":{\"host\":");
+    report::AppendJsonString(out, options.host);
+    out.append(",\"port\":");
+    report::AppendJsonString(out, options.port);
+    out.append(",\"threads\":").append(std::to_string(options.threads));
+    out.append(",\"connections\":").append(std::to_string(options.connections));
+    out.append(",\"duration_s\":");
+    report::AppendNumber(out, options.duration);
+    out.append(",\"warmup_s\":");
+    report::AppendNumber(out, options.warmup);
+    out.append(",\"rate\":");
+    report::AppendNumber(out, options.rate);
+    out.append(",\"keepalive\":").append(options.keep_alive ? "true" : "false");
+    out.append(",\"timeout_ms\":").append(std::to_string(options.timeout_ms));
+    out.append(",\"mix\":{");
+    for (std::size_t r = 0; r < RouteCount; ++r)
+    {
+        out.append(r == 0 ? "" : ",");
+        report::AppendJsonString(out, kRoutes[r]);
+        out.append(":").append(std::to_string(options.mix[r]));
+    }
+    out.append("}},\"total\":");
+    AppendStats(out, total, seconds);
+    out.append(",\"routes\":{");
+    bool first = true;
+    for (std::size_t r = 0; r < RouteCount; ++r)
+    {
+        if (options.mix[r] == 0)
+        {
+            continue;
+        }
+        out.append(first ? "" : ",");
+        first = false;
+        report::AppendJsonString(out, kRoutes[r]);
+        out.push_back(':');
+        AppendStats(out, routes[r], seconds);
+    }
+    out.append("}}\n");
+    return out;
+}
+} // namespace
+
+int main(int argc, char *argv[])
+{
+    Options options;
+    if (!ParseOptions(argc, argv, options))
+    {
+        PrintUsage();
+        return 2;
+    }
+
+    net::io_context resolver_ioc;
+    tcp::resolver resolver(resolver_ioc);
+    beast::error_code ec;
+    tcp::resolver::results_type endpoints = resolver.resolve(options.host, options.port, ec);
+    if (ec)
+    {
+        std::fprintf(stderr, "resolve %s:%s failed: %s\n", options.host.c_str(), options.port.c_str(),
+                     ec.message().c_str());
+        return 1;
+    }
+
+    // 每个线程一个 io_context 与一份统计
+    std::vector<std::unique_ptr<net::io_context>> contexts;
+    std::vector<std::array<RouteStats, RouteCount>> stats(options.threads);
+    for (unsigned t = 0; t < options.threads; ++t)
+    {
+        contexts.push_back(std::make_unique<net::io_context>(1));
+    }
+
+    auto seconds = [](double value)
+    {
+        return std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(value));
+    };
+    Window window;
+    window.begin = Clock::now() + seconds(options.warmup);
+    window.end = window.begin + seconds(options.duration);
+    auto nonce = static_cast<std::uint64_t>(
+        std::chrono::duration_cast<std::chrono::seconds>(std::chrono::system_clock::now().time_since_epoch()).count());
+
+    for (unsigned c = 0; c < options.connections; ++c)
+    {
+        unsigned t = c % options.threads;
+        std::make_shared<Client>(*contexts[t], options, endpoints, window, stats[t], c, nonce)->Start();
+    }
+
+    std::fprintf(stderr, "gate_bench: %s:%s threads=%u connections=%u warmup=%.1fs duration=%.1fs rate=%s\n",
+                 options.host.c_str(), options.port.c_str(), options.threads, options.connections, options.warmup,
+                 options.duration, options.rate > 0 ? std::to_string(options.rate).c_str() : "max");
+
+    std::vector<std::thread> threads;
+    for (auto &ioc : contexts)
+    {
+        threads.emplace_back([&ioc]() { ioc->run(); });
+    }
+    for (auto &t : threads)
+    {
+        t.join();
+    }
+
+    std::array<RouteStats, RouteCount> merged;
+    for (auto &per_thread : stats)
+    {
+        for (std::size_t r = 0; r < RouteCount; ++r)
+        {
+            merged[r].Merge(per_thread[r]);
+        }
+    }
+
+    std::string result = RenderResult(options, merged, options.duration);
+    if (options.output.empty())
+    {
+        std::fwrite(result.data(), 1, result.size(), stdout);
+        return 0;
+    }
+    std::FILE *file = std::fopen(options.output.c_str(), "w");
+    if (file == nullptr)
+    {
+        std::fprintf(stderr, "cannot open %s\n", options.output.c_str());
+        return 1;
+    }
+    std::fwrite(result.data(), 1, result.size(), file);
+    std::fclose(file);
+    std::fprintf(stderr, "result written to %s\n", options.output.c_str());
+    return 0;
+}
@@ -0,0 +1,707 @@
+/**
+ * @file    gate_replay.cpp
+ * @brief   按 Capture 文件回放请求 (配合 [Capture] 录制)
+ * @author  msr
+ *
+ * @details
+ * - 启动时把 Capture 读入内存并预先序列化成请求报文，回放过程中不再读文件、不再编码。
+ * - 第 i 条请求的计划时刻 = 开始时刻 + 录制偏移 / --speed；--speed=max 时全部立即到期，
+ *   相当于用 --connections 个连接闭环地按录制顺序发完。
+ * - 到期的请求按文件顺序交给编号最小的空闲连接；没有空闲连接时排队，排队时间记为 lag，
+ *   延迟从计划时刻起算 (与 gate_bench 的开环模式一致，不受 Coordinated Omission 影响)。
+ * - 请求头原样回放 (含 Host / Connection)，只重写 Content-Length；
+ *   Capture 未录 Body 时按空 Body 发送。
+ * - 结果以 JSON 输出: 合计与按路径 (去掉查询串) 的吞吐、错误分类与延迟分位数。
+ *
+ * 用法: gate_replay --capture=gate.cap [--host=127.0.0.1] [--port=8080] [--speed=1|N|max]
+ *                   [--connections=16] [--timeout=5000] [--limit=0] [--label=...] [--output=file]
+ */
+
+#include "BenchReport.h"
+#include "TrafficCapture.h"
+#include <boost/asio.hpp>
+#include <boost/beast.hpp>
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <deque>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace net = boost::asio;
+namespace beast = boost::beast;
+namespace http = boost::beast::http;
+using tcp = boost::asio::ip::tcp;
+
+namespace
+{
+using Clock = std::chrono::steady_clock;
+
+/**
+ * @struct  Options
+ * @brief   命令行参数
+ */
+struct Options
+{
+    std::string capture;
+    std::string host = "127.0.0.1";
+    std::string port = "8080";
+    double speed = 1.0; ///< 回放倍速，0 = 不等待 (max)
+    unsigned connections = 16;
+    unsigned timeout_ms = 5000;
+    std::size_t limit = 0; ///< 最多回放的请求数，0 = 全部
+    std::string label;
+    std::string output;
+};
+
+/**
+ * @struct  ReplayRequest
+ * @brief   预先序列化好的一条请求
+ */
+struct ReplayRequest
+{
+    std::uint64_t offset_ns = 0;
+    std::string path; ///< 统计分组用 (不含查询串)
+    std::string wire;
+};
+
+/**
+ * @struct  PathStats
+ * @brief   单个路径的结果
+ */
+struct PathStats
+{
+    std::uint64_t ok = 0;
+    std::uint64_t http_errors = 0;
+    std::uint64_t io_errors = 0;
+    std::uint64_t timeouts = 0;
+    std::uint64_t connect_errors = 0;
+    std::vector<std::uint64_t> latency_ns; ///< 收到响应的请求 (含 http 错误)
+    std::vector<std::uint64_t> lag_ns;     ///< 计划时刻到实际发出的排队时间
+
+    std::uint64_t Errors() const
+    {
+        return http_errors + io_errors + timeouts + connect_errors;
+    }
+
+    void Merge(const PathStats &other)
+    {
+        ok += other.ok;
+        http_errors += other.http_errors;
+        io_errors += other.io_errors;
+        timeouts += other.timeouts;
+        connect_errors += other.connect_errors;
+        latency_ns.insert(latency_ns.end(), other.latency_ns.begin(), other.latency_ns.end());
+        lag_ns.insert(lag_ns.end(), other.lag_ns.begin(), other.lag_ns.end());
+    }
+};
+
+void PrintUsage()
+{
+    std::fprintf(stderr,
+                 "usage: gate_replay --capture=gate.cap [--host=127.0.0.1] [--port=8080] [--speed=1|N|max]\n"
+                 "                   [--connections=16] [--timeout=5000] [--limit=0] [--label=text]\n"
+                 "                   [--output=result.json]\n");
+}
+
+bool ParseOptions(int argc, char *argv[], Options &options)
+{
+    for (int i = 1; i < argc; ++i)
+    {
+        std::string arg = argv[i];
+        if (arg == "-h" || arg == "--help" || arg.compare(0, 2, "--") != 0)
+        {
+            return false;
+        }
+        std::string key;
+        std::string value;
+        std::size_t eq = arg.find('=');
+        if (eq != std::string::npos)
+        {
+            key = arg.substr(2, eq - 2);
+            value = arg.substr(eq + 1);
+        }
+        else if (i + 1 < argc)
+        {
+            key = arg.substr(2);
+            value = argv[++i];
+        }
+        else
+        {
+            return false;
+        }
+
+        if (key == "capture")
+        {
+            options.capture = value;
+        }
+        else if (key == "host")
+        {
+            options.host = value;
+        }
+        else if (key == "port")
+        {
+            options.port = value;
+        }
+        else if (key == "speed")
+        {
+            options.speed = (value == "max") ? 0.0 : std::atof(value.c_str());
+            if (value != "max" && options.speed <= 0)
+            {
+                std::fprintf(stderr, "invalid --speed: %s\n", value.c_str());
+                return false;
+            }
+        }
+        else if (key == "connections")
+        {
+            options.connections = static_cast<unsigned>(std::max(1, std::atoi(value.c_str())));
+        }
+        else if (key == "timeout")
+        {
+            options.timeout_ms = static_cast<unsigned>(std::max(1, std::atoi(value.c_str())));
+        }
+        else if (key == "limit")
+        {
+            options.limit = static_cast<std::size_t>(std::max(0, std::atoi(value.c_str())));
+        }
+        else if (key == "label")
+        {
+            options.label = value;
+        }
+        else if (key == "output")
+        {
+            options.output = value;
+        }
+        else
+        {
+            std::fprintf(stderr, "unknown option: --%s\n", key.c_str());
+            return false;
+        }
+    }
+    return !options.capture.empty();
+}
+
+bool EqualsIgnoreCase(const std::string &a, const char *b)
+{
+    std::size_t i = 0;
+    for (; i < a.size() && b[i] != '\0'; ++i)
+    {
+        if (std::tolower(static_cast<unsigned char>(a[i])) != std::tolower(static_cast<unsigned char>(b[i])))
+        {
+            return false;
+        }
+    }
+    return i == a.size() && b[i] == '\0';
+}
+
+/**
+ * @brief   把一条录制的请求序列化为 HTTP/1.x 报文
+ */
+void Serialize(const CapturedRequest &captured, ReplayRequest &out)
+{
+    out.offset_ns = captured.offset_ns;
+    out.path = captured.target.substr(0, captured.target.find('?'));
+
+    std::string &wire = out.wire;
+    wire.reserve(captured.target.size() + captured.body.size() + 256);
+    wire.append(http::to_string(captured.method)).append(" ").append(captured.target);
+    wire.append(captured.version == 10 ? " HTTP/1.0\r\n" : " HTTP/1.1\r\n");
+    bool had_length = false;
+    for (const auto &[name, value] : captured.headers)
+    {
+        if (EqualsIgnoreCase(name, "content-length") || EqualsIgnoreCase(name, "transfer-encoding"))
+        {
+            had_length = true;
+            continue;
+        }
+        wire.append(name).append(": ").append(value).append("\r\n");
+    }
+    if (had_length || !captured.body.empty())
+    {
+        wire.append("Content-Length: ").append(std::to_string(captured.body.size())).append("\r\n");
+    }
+    wire.append("\r\n").append(captured.body);
+}
+
+class Replayer;
+
+/**
+ * @class   Connection
+ * @brief   一个回放连接: 一次只有一个请求在途，完成后向 Replayer 取下一个
+ *
+ * @details 所有回调都在同一个 io_context 线程上执行；_generation 区分过期的超时回调。
+ */
+class Connection : public std::enable_shared_from_this<Connection>
+{
+public:
+    Connection(net::io_context &ioc, Replayer &replayer, const Options &options,
+               const tcp::resolver::results_type &endpoints, std::size_t id)
+        : _replayer(replayer), _options(options), _endpoints(endpoints), _socket(ioc), _deadline(ioc), _id(id)
+    {
+    }
+
+    /**
+     * @brief   发送第 index 条请求 (调用时连接必须空闲)
+     */
+    void Issue(std::size_t index, Clock::time_point due);
+
+private:
+    void Connect();
+    void Send();
+    void OnRead(beast::error_code ec);
+    void Fail(std::uint64_t PathStats::*counter);
+    void Done();
+
+    void ArmDeadline()
+    {
+        _timed_out = false;
+        std::uint64_t generation = ++_generation;
+        _deadline.expires_after(std::chrono::milliseconds(_options.timeout_ms));
+        _deadline.async_wait(
+            [self = shared_from_this(), generation](beast::error_code ec)
+            {
+                if (!ec && generation == self->_generation)
+                {
+                    self->_timed_out = true;
+                    beast::error_code ignored;
+                    self->_socket.close(ignored);
+                }
+            });
+    }
+
+    void DisarmDeadline()
+    {
+        ++_generation;
+        _deadline.cancel();
+    }
+
+    void Close()
+    {
+        beast::error_code ignored;
+        _socket.shutdown(tcp::socket::shutdown_both, ignored);
+        _socket.close(ignored);
+        _buffer.consume(_buffer.size());
+    }
+
+    Replayer &_replayer;
+    const Options &_options;
+    const tcp::resolver::results_type &_endpoints;
+
+    tcp::socket _socket;
+    net::steady_timer _deadline;
+    beast::flat_buffer _buffer;
+    http::response<http::string_body> _response;
+
+    std::size_t _id;        ///< 在 Replayer 中的编号
+    std::size_t _index = 0; ///< 在途请求的下标
+    Clock::time_point _due;
+    std::uint64_t _generation = 0;
+    bool _timed_out = false;
+};
+
+/**
+ * @class   Replayer
+ * @brief   按计划时刻派发请求，维护空闲连接与待发队列
+ */
+class Replayer
+{
+public:
+    Replayer(net::io_context &ioc, const Options &options, const std::vector<ReplayRequest> &requests,
+             const tcp::resolver::results_type &endpoints)
+        : _options(options), _requests(requests), _pacer(ioc)
+    {
+        for (unsigned i = 0; i < options.connections; ++i)
+        {
+            _connections.push_back(std::make_shared<Connection>(ioc, *this, options, endpoints, i));
+        }
+        // 倒序压栈，使空闲栈顶总是编号最小的连接
+        for (std::size_t i = _connections.size(); i > 0; --i)
+        {
+            _idle.push_back(i - 1);
+        }
+    }
+
+    void Start()
+    {
+        _start = Clock::now();
+        Dispatch();
+    }
+
+    /**
+     * @brief   连接完成一个请求后回到空闲，优先发排队中的请求
+     */
+    void Release(std::size_t connection)
+    {
+        if (!_pending.empty())
+        {
+            std::size_t index = _pending.front();
+            _pending.pop_front();
+            _connections[connection]->Issue(index, Due(index));
+            return;
+        }
+        _idle.push_back(connection);
+        if (_idle.size() == _connections.size() && _next == _requests.size())
+        {
+            _end = Clock::now();
+        }
+    }
+
+    const ReplayRequest &Request(std::size_t index) const
+    {
+        return _requests[index];
+    }
+
+    PathStats &Stats(std::size_t index)
+    {
+        return _stats[_requests[index].path];
+    }
+
+    std::map<std::string, PathStats> &AllStats()
+    {
+        return _stats;
+    }
+
+    double ElapsedSeconds() const
+    {
+        return std::chrono::duration<double>(_end - _start).count();
+    }
+
+    /**
+     * @brief   最后一条请求的计划时刻距开始的时间 (回放速度下的录制时长)
+     */
+    double ScheduledSeconds() const
+    {
+        return _requests.empty() ? 0 : std::chrono::duration<double>(Due(_requests.size() - 1) - _start).count();
+    }
+
+private:
+    Clock::time_point Due(std::size_t index) const
+    {
+        if (_options.speed <= 0)
+        {
+            return _start;
+        }
+        auto offset = std::chrono::duration<double, std::nano>(
+            static_cast<double>(_requests[index].offset_ns) / _options.speed);
+        return _start + std::chrono::duration_cast<Clock::duration>(offset);
+    }
+
+    /**
+     * @brief   派发所有已到期的请求，再等待下一条的计划时刻
+     */
+    void Dispatch()
+    {
+        auto now = Clock::now();
+        while (_next < _requests.size() && Due(_next) <= now)
+        {
+            if (_idle.empty())
+            {
+                _pending.push_back(_next);
+            }
+            else
+            {
+                std::size_t connection = _idle.back();
+                _idle.pop_back();
+                _connections[connection]->Issue(_next, Due(_next));
+            }
+            ++_next;
+        }
+        if (_next == _requests.size())
+        {
+            if (_idle.size() == _connections.size())
+            {
+                _end = Clock::now();
+            }
+            return;
+        }
+        _pacer.expires_at(Due(_next));
+        _pacer.async_wait(
+            [this](beast::error_code ec)
+            {
+                if (!ec)
+                {
+                    Dispatch();
+                }
+            });
+    }
+
+    const Options &_options;
+    const std::vector<ReplayRequest> &_requests;
+    net::steady_timer _pacer;
+    std::vector<std::shared_ptr<Connection>> _connections;
+    std::vector<std::size_t> _idle;
+    std::deque<std::size_t> _pending;
+    std::size_t _next = 0;
+    std::map<std::string, PathStats> _stats;
+    Clock::time_point _start;
+    Clock::time_point _end;
+};
+
+void Connection::Issue(std::size_t index, Clock::time_point due)
+{
+    _index = index;
+    _due = due;
+    auto lag = std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - due);
+    _replayer.Stats(index).lag_ns.push_back(static_cast<std::uint64_t>(std::max<std::int64_t>(0, lag.count())));
+    if (_socket.is_open())
+    {
+        Send();
+    }
+    else
+    {
+        Connect();
+    }
+}
+
+void Connection::Connect()
+{
+    ArmDeadline();
+    net::async_connect(_socket, _endpoints,
+                       [self = shared_from_this()](beast::error_code ec, const tcp::endpoint &)
+                       {
+                           if (ec)
+                           {
+                               self->Fail(self->_timed_out ? &PathStats::timeouts : &PathStats::connect_errors);
+                               return;
+                           }
+                           self->_socket.set_option(tcp::no_delay(true));
+                           self->Send();
+                       });
+}
+
+void Connection::Send()
+{
+    ArmDeadline();
+    net::async_write(_socket, net::buffer(_replayer.Request(_index).wire),
+                     [self = shared_from_this()](beast::error_code ec, std::size_t)
+                     {
+                         if (ec)
+                         {
+                             self->Fail(self->_timed_out ? &PathStats::timeouts : &PathStats::io_errors);
+                             return;
+                         }
+                         self->_response = {};
+                         http::async_read(self->_socket, self->_buffer, self->_response,
+                                          [self](beast::error_code ec, std::size_t) { self->OnRead(ec); });
+                     });
+}
+
+void Connection::OnRead(beast::error_code ec)
+{
+    if (ec)
+    {
+        Fail(_timed_out ? &PathStats::timeouts : &PathStats::io_errors);
+        return;
+    }
+    DisarmDeadline();
+
+    PathStats &stats = _replayer.Stats(_index);
+    auto latency = std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - _due);
+    stats.latency_ns.push_back(static_cast<std::uint64_t>(latency.count()));
+    unsigned status = _response.result_int();
+    if (status < 200 || status >= 300)
+    {
+        ++stats.http_errors;
+    }
+    else
+    {
+        ++stats.ok;
+    }
+    if (!_response.keep_alive())
+    {
+        Close();
+    }
+    Done();
+}
+
+void Connection::Fail(std::uint64_t PathStats::*counter)
+{
+    DisarmDeadline();
+    ++(_replayer.Stats(_index).*counter);
+    Close();
+    Done();
+}
+
+void Connection::Done()
+{
+    _replayer.Release(_id);
+}
+
+void AppendDistribution(std::string &out, std::vector<std::uint64_t> &values)
+{
+    std::sort(values.begin(), values.end());
+    double mean = 0;
+    for (std::uint64_t ns : values)
+    {
+        mean += static_cast<double>(ns);
+    }
+    mean = values.empty() ? 0 : mean / static_cast<double>(values.size()) / 1000.0;
+
+    out.append("{\"min\":");
+    report::AppendNumber(out, values.empty() ? 0 : static_cast<double>(values.front()) / 1000.0);
+    out.append(",\"mean\":");
+    report::AppendNumber(out, mean);
+    const std::pair<const char *, double> quantiles[] = {
+        {"p50", 0.5}, {"p90", 0.9}, {"p99", 0.99}, {"p999", 0.999}, {"max", 1.0}};
+    for (const auto &[name, q] : quantiles)
+    {
+        out.append(",\"").append(name).append("\":");
+        report::AppendNumber(out, report::Percentile(values, q));
+    }
+    out.push_back('}');
+}
+
+/**
+ * @brief   输出一个路径 (或合计) 的结果对象
+ */
+void AppendStats(std::string &out, PathStats &stats, double seconds)
+{
+    std::uint64_t requests = stats.ok + stats.Errors();
+    out.append("{\"requests\":").append(std::to_string(requests));
+    out.append(",\"ok\":").append(std::to_string(stats.ok));
+    out.append(",\"throughput_rps\":");
+    report::AppendNumber(out, seconds > 0 ? static_cast<double>(requests) / seconds : 0);
+    out.append(",\"errors\":{\"total\":").append(std::to_string(stats.Errors()));
+    out.append(",\"connect\":").append(std::to_string(stats.connect_errors));
+    out.append(",\"io\":").append(std::to_string(stats.io_errors));
+    out.append(",\"timeout\":").append(std::to_string(stats.timeouts));
+    out.append(",\"http\":").append(std::to_string(stats.http_errors));
+    out.append("},\"latency_us\":");
+    AppendDistribution(out, stats.latency_ns);
+    out.append(",\"lag_us\":");
+    AppendDistribution(out, stats.lag_ns);
+    out.push_back('}');
+}
+
+std::string RenderResult(const Options &options, Replayer &replayer, std::size_t requests, bool truncated)
+{
+    double seconds = replayer.ElapsedSeconds();
+    PathStats total;
+    for (const auto &[path, stats] : replayer.AllStats())
+    {
+        total.Merge(stats);
+    }
+
+    std::string out = "{\"tool\":\"gate_replay\",\"version\":1,\"label\":";
+    report::AppendJsonString(out, options.label);
+    out.append(",\"config\":{\"capture\":");
+    report::AppendJsonString(out, options.capture);
+    out.append(",\"host\":");
+    report::AppendJsonString(out, options.host);
+    out.append(",\"port\":");
+    report::AppendJsonString(out, options.port);
+    out.append(",\"speed\":");
+    if (options.speed > 0)
+    {
+        report::AppendNumber(out, options.speed);
+    }
+    else
+    {
+        out.append("\"max\"");
+    }
+    out.append(",\"connections\":").append(std::to_string(options.connections));
+    out.append(",\"timeout_ms\":").append(std::to_string(options.timeout_ms));
+    out.append("},\"capture\":{\"requests\":").append(std::to_string(requests));
+    out.append(",\"truncated\":").append(truncated ? "true" : "false");
+    out.append(",\"scheduled_s\":");
+    report::AppendNumber(out, replayer.ScheduledSeconds());
+    out.append("},\"elapsed_s\":");
+    report::AppendNumber(out, seconds);
+    out.append(",\"total\":");
+    AppendStats(out, total, seconds);
+    out.append(",\"paths\":{");
+    bool first = true;
+    for (auto &[path, stats] : replayer.AllStats())
+    {
+        out.append(first ? "" : ",");
+        first = false;
+        report::AppendJsonString(out, path);
+        out.push_back(':');
+        AppendStats(out, stats, seconds);
+    }
+    out.append("}}\n");
+    return out;
+}
+} // namespace
+
+int main(int argc, char *argv[])
+{
+    Options options;
+    if (!ParseOptions(argc, argv, options))
+    {
+        PrintUsage();
+        return 2;
+    }
+
+    CaptureReader reader;
+    std::string error;
+    if (!reader.Open(options.capture, error))
+    {
+        std::fprintf(stderr, "%s\n", error.c_str());
+        return 1;
+    }
+    std::vector<ReplayRequest> requests;
+    CapturedRequest captured;
+    while ((options.limit == 0 || requests.size() < options.limit) && reader.Next(captured))
+    {
+        requests.emplace_back();
+        Serialize(captured, requests.back());
+    }
+    if (reader.Failed())
+    {
+        // 录制进程被强杀时最后一块可能不完整，回放已读到的部分
+        std::fprintf(stderr, "capture truncated after %zu requests\n", requests.size());
+    }
+    if (requests.empty())
+    {
+        std::fprintf(stderr, "capture has no requests\n");
+        return 1;
+    }
+    // 从第一条请求开始计时，跳过录制开始到第一条请求之间的空闲
+    std::uint64_t first_offset = requests.front().offset_ns;
+    for (auto &request : requests)
+    {
+        request.offset_ns -= first_offset;
+    }
+
+    net::io_context ioc{1};
+    tcp::resolver resolver(ioc);
+    beast::error_code ec;
+    tcp::resolver::results_type endpoints = resolver.resolve(options.host, options.port, ec);
+    if (ec)
+    {
+        std::fprintf(stderr, "resolve %s:%s failed: %s\n", options.host.c_str(), options.port.c_str(),
+                     ec.message().c_str());
+        return 1;
+    }
+
+    Replayer replayer(ioc, options, requests, endpoints);
+    std::fprintf(stderr, "gate_replay: %zu requests (%.3fs recorded%s) -> %s:%s speed=%s connections=%u\n",
+                 requests.size(), static_cast<double>(requests.back().offset_ns) / 1e9,
+                 reader.HasBodies() ? "" : ", no bodies", options.host.c_str(), options.port.c_str(),
+                 options.speed > 0 ? std::to_string(options.speed).c_str() : "max", options.connections);
+    replayer.Start();
+    ioc.run();
+
+    std::string result = RenderResult(options, replayer, requests.size(), reader.Failed());
+    if (options.output.empty())
+    {
+        std::fwrite(result.data(), 1, result.size(), stdout);
+        return 0;
+    }
+    std::FILE *file = std::fopen(options.output.c_str(), "w");
+    if (file == nullptr)
+    {
+        std::fprintf(stderr, "cannot open %s\n", options.output.c_str());
+        return 1;
+    }
+    std::fwrite(result.data(), 1, result.size(), file);
+    std::fclose(file);
+    std::fprintf(stderr, "result written to %s\n", options.output.c_str());
+    return 0;
+}
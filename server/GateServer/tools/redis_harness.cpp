@@ -0,0 +1,470 @@
+/**
+ * @file    redis_harness.cpp
+ * @brief   RedisMgr 对本地 redis-server 的功能验证
+ * @author  msr
+ *
+ * @details
+ * 在 AsioIOServicePool (读取当前目录 config.ini 的 [IOPool] / [Redis]) 上建立连接后依次检查:
+ * - sync:      SET / GET / EXISTS / DEL / LPUSH / LPOP / HSET / HGET 往返，值含 \0 与 \r\n (二进制安全)
+ * - async:     从主线程连续发出 --requests 条 SET (不等待)，全部完成后再用 GET 逐条校验
+ * - chain:     在 IO 线程的回调里继续发命令 (GET -> SET -> GET)
+ * - guard:     在 IO 线程上调用同步接口立即失败，而不是卡住该线程
+ * - verify:    VerifyCodeStore 的各种结果、并发重试只有一个通过、SCRIPT FLUSH 后自动回退到 EVAL
+ * - near:      ([NearCache] Enabled = on 时) 重复读命中、负缓存、另一个客户端写入后经失效消息读到新值，
+ *              以及断线重连后重新就绪
+ * - reconnect: CLIENT KILL 断开全部连接后，在 [Redis] ReconnectMs 之后恢复 (--reconnect=off 跳过)
+ * 每项输出 PASS / FAIL，全部通过时退出码为 0。测试键以 gate_harness:<pid>: 为前缀，结束时删除。
+ *
+ * 用法: redis_harness [--host=127.0.0.1] [--port=6379] [--password=] [--requests=10000] [--reconnect=on|off]
+ *
+ * @warning 会在目标实例上写入测试键；reconnect 检查会断开该实例上的所有普通客户端，只应对本地实例运行。
+ */
+
+#include "AsioIOServicePool.h"
+#include "Logger.h"
+#include "RedisConnection.h"
+#include "RedisMgr.h"
+#include "VerifyCodeStore.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <future>
+#include <string>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+namespace
+{
+using Clock = std::chrono::steady_clock;
+
+/**
+ * @struct  Options
+ * @brief   命令行参数
+ */
+struct Options
+{
+    std::string host = "127.0.0.1";
+    int port = 6379;
+    std::string password;
+    int requests = 10000;
+    bool reconnect = true;
+};
+
+bool ParseOptions(int argc, char *argv[], Options &options)
+{
+    for (int i = 1; i < argc; ++i)
+    {
+        std::string arg = argv[i];
+        std::size_t eq = arg.find('=');
+        if (arg.compare(0, 2, "--") != 0 || eq == std::string::npos)
+        {
+            return false;
+        }
+        std::string key = arg.substr(2, eq - 2);
+        std::string value = arg.substr(eq + 1);
+        if (key == "host")
+        {
+            options.host = value;
+        }
+        else if (key == "port")
+        {
+            options.port = std::atoi(value.c_str());
+        }
+        else if (key == "password")
+        {
+            options.password = value;
+        }
+        else if (key == "requests")
+        {
+            options.requests = std::max(1, std::atoi(value.c_str()));
+        }
+        else if (key == "reconnect")
+        {
+            options.reconnect = (value == "on" || value == "1" || value == "true");
+        }
+        else
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+int g_failures = 0;
+
+void Check(const char *name, bool ok, const std::string &detail = "")
+{
+    if (ok)
+    {
+        std::printf("PASS %s\n", name);
+    }
+    else
+    {
+        ++g_failures;
+        std::printf("FAIL %s%s%s\n", name, detail.empty() ? "" : ": ", detail.c_str());
+    }
+    std::fflush(stdout);
+}
+
+double MillisSince(Clock::time_point start)
+{
+    return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+}
+
+void CheckSync(RedisMgr &redis, const std::string &prefix)
+{
+    const std::string binary("a\0b\r\nc", 6);
+    std::string value;
+    bool ok = redis.Set(prefix + "str", binary) && redis.Get(prefix + "str", value) && value == binary;
+    Check("sync set/get binary value", ok, "got " + std::to_string(value.size()) + " bytes");
+
+    Check("sync get missing key", !redis.Get(prefix + "missing", value));
+    Check("sync exists", redis.ExistsKey(prefix + "str") && !redis.ExistsKey(prefix + "missing"));
+    Check("sync del", redis.Del(prefix + "str") && !redis.ExistsKey(prefix + "str"));
+
+    std::string first;
+    std::string second;
+    ok = redis.LPush(prefix + "list", "1") && redis.LPush(prefix + "list", "2") &&
+         redis.LPop(prefix + "list", first) && redis.LPop(prefix + "list", second);
+    Check("sync lpush/lpop order", ok && first == "2" && second == "1", first + "," + second);
+    Check("sync lpop empty list", !redis.LPop(prefix + "list", value));
+
+    ok = redis.HSet(prefix + "hash", "field", "value");
+    Check("sync hset/hget", ok && redis.HGet(prefix + "hash", "field") == "value" &&
+                                redis.HGet(prefix + "hash", "nofield").empty());
+}
+
+void CheckAsync(RedisMgr &redis, const std::string &prefix, int requests)
+{
+    std::atomic<int> completed{0};
+    std::atomic<int> failed{0};
+    std::promise<void> all_set;
+    auto start = Clock::now();
+    for (int i = 0; i < requests; ++i)
+    {
+        redis.Set(prefix + "async:" + std::to_string(i), std::to_string(i),
+                  [&, requests](RedisReply reply)
+                  {
+                      if (reply.type != RedisReply::Type::Status || reply.str != "OK")
+                      {
+                          failed.fetch_add(1);
+                      }
+                      if (completed.fetch_add(1) + 1 == requests)
+                      {
+                          all_set.set_value();
+                      }
+                  });
+    }
+    bool done = all_set.get_future().wait_for(std::chrono::seconds(30)) == std::future_status::ready;
+    double set_ms = MillisSince(start);
+    Check("async set", done && failed == 0,
+          std::to_string(completed.load()) + " completed, " + std::to_string(failed.load()) + " failed");
+    if (!done)
+    {
+        // 回调仍引用栈上的计数器，不能继续
+        std::printf("async set did not complete, abort\n");
+        std::exit(1);
+    }
+
+    completed = 0;
+    failed = 0;
+    std::promise<void> all_get;
+    start = Clock::now();
+    for (int i = 0; i < requests; ++i)
+    {
+        redis.Get(prefix + "async:" + std::to_string(i),
+                  [&, i, requests](RedisReply reply)
+                  {
+                      if (reply.type != RedisReply::Type::String || reply.str != std::to_string(i))
+                      {
+                          failed.fetch_add(1);
+                      }
+                      if (completed.fetch_add(1) + 1 == requests)
+                      {
+                          all_get.set_value();
+                      }
+                  });
+    }
+    done = all_get.get_future().wait_for(std::chrono::seconds(30)) == std::future_status::ready;
+    double get_ms = MillisSince(start);
+    Check("async get values", done && failed == 0, std::to_string(failed.load()) + " mismatched");
+    if (!done)
+    {
+        std::printf("async get did not complete, abort\n");
+        std::exit(1);
+    }
+    std::printf("     %d SET in %.1f ms, %d GET in %.1f ms (%.0f ops/s)\n", requests, set_ms, requests, get_ms,
+                2.0 * requests / ((set_ms + get_ms) / 1000.0));
+
+    std::vector<std::string> del = {"DEL"};
+    for (int i = 0; i < requests; ++i)
+    {
+        del.push_back(prefix + "async:" + std::to_string(i));
+    }
+    RedisReply reply = redis.Execute(std::move(del));
+    Check("async cleanup", reply.type == RedisReply::Type::Integer && reply.integer == requests,
+          reply.IsError() ? reply.str : std::to_string(reply.integer));
+}
+
+void CheckChain(RedisMgr &redis, const std::string &prefix)
+{
+    auto result = std::make_shared<std::promise<std::string>>();
+    auto future = result->get_future();
+    const std::string key = prefix + "chain";
+    redis.Get(key,
+              [&redis, key, result](RedisReply first)
+              {
+                  if (first.type != RedisReply::Type::Nil)
+                  {
+                      result->set_value("first GET not nil");
+                      return;
+                  }
+                  redis.Set(key, "chained",
+                            [&redis, key, result](RedisReply set)
+                            {
+                                if (set.IsError())
+                                {
+                                    result->set_value("SET failed: " + set.str);
+                                    return;
+                                }
+                                redis.Get(key, [result](RedisReply second) { result->set_value(second.str); });
+                            });
+              });
+    bool done = future.wait_for(std::chrono::seconds(5)) == std::future_status::ready;
+    std::string value = done ? future.get() : "timeout";
+    Check("chain in callbacks", value == "chained", value);
+    redis.Del(key);
+}
+
+void CheckGuard(RedisMgr &redis, const std::string &prefix)
+{
+    std::promise<std::pair<bool, double>> result;
+    auto future = result.get_future();
+    boost::asio::post(*AsioIOServicePool::GetInstance()->GetIOService(),
+                      [&]()
+                      {
+                          auto start = Clock::now();
+                          std::string value;
+                          bool got = redis.Get(prefix + "guard", value);
+                          result.set_value({got, MillisSince(start)});
+                      });
+    auto [got, ms] = future.get();
+    Check("sync call on IO thread rejected", !got && ms < 100, std::to_string(ms) + " ms");
+}
+
+void CheckVerify(RedisMgr &redis, const std::string &prefix)
+{
+    using Result = VerifyCodeStore::Result;
+    auto store = VerifyCodeStore::GetInstance();
+    const std::string email = prefix + "verify:email";
+    const std::string user = prefix + "verify:user";
+
+    store->Save(email, "1234");
+    Check("verify mismatch keeps code",
+          store->VerifyAndConsume(email, "0000", user) == Result::Mismatch && redis.ExistsKey(email));
+    redis.Set(user, "1");
+    Check("verify user exists keeps code",
+          store->VerifyAndConsume(email, "1234", user) == Result::UserExists && redis.ExistsKey(email));
+    redis.Del(user);
+    Check("verify ok consumes code", store->VerifyAndConsume(email, "1234", user) == Result::Ok &&
+                                         !redis.ExistsKey(email));
+    Check("verify consumed code expired", store->VerifyAndConsume(email, "1234", user) == Result::Expired);
+
+    // 同一验证码的并发重试只能有一个通过
+    store->Save(email, "5678");
+    std::atomic<int> passed{0};
+    std::vector<std::thread> racers;
+    for (int i = 0; i < 8; ++i)
+    {
+        racers.emplace_back(
+            [&]()
+            {
+                if (store->VerifyAndConsume(email, "5678", user) == Result::Ok)
+                {
+                    passed.fetch_add(1);
+                }
+            });
+    }
+    for (auto &racer : racers)
+    {
+        racer.join();
+    }
+    Check("verify concurrent retries", passed == 1, std::to_string(passed.load()) + " passed");
+
+    // 服务端脚本缓存丢失后仍可用 (EVAL 回退并重新缓存)
+    redis.Execute({"SCRIPT", "FLUSH"});
+    store->Save(email, "9012");
+    std::promise<Result> async_result;
+    store->VerifyAndConsume(email, "9012", user, [&](Result result) { async_result.set_value(result); });
+    auto future = async_result.get_future();
+    bool done = future.wait_for(std::chrono::seconds(5)) == std::future_status::ready;
+    Check("verify async after SCRIPT FLUSH", done && future.get() == Result::Ok);
+    store->Save(email, "3456");
+    Check("verify sync after reload", store->VerifyAndConsume(email, "3456", user) == Result::Ok);
+}
+
+/**
+ * @brief   等待近端缓存就绪 (失效跟踪建立)
+ */
+bool WaitNearReady(NearCache &near, int timeout_ms)
+{
+    auto start = Clock::now();
+    while (!near.Ready() && MillisSince(start) < timeout_ms)
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    return near.Ready();
+}
+
+/**
+ * @brief   不经过 RedisMgr (因而不做本地失效) 的写入，模拟其他进程
+ */
+bool ExternalSet(const std::shared_ptr<RedisConnection> &connection, const std::string &key, const std::string &value)
+{
+    auto promise = std::make_shared<std::promise<RedisReply>>();
+    auto future = promise->get_future();
+    connection->Command({"SET", key, value}, [promise](RedisReply reply) { promise->set_value(std::move(reply)); });
+    return future.wait_for(std::chrono::seconds(1)) == std::future_status::ready && !future.get().IsError();
+}
+
+void CheckNearCache(RedisMgr &redis, const Options &options, const std::string &prefix)
+{
+    NearCache *near = redis.GetNearCache();
+    Check("near cache ready", WaitNearReady(*near, 2000));
+
+    const std::string key = prefix + "near";
+    std::string value;
+    redis.Set(key, "v1");
+    redis.Get(key, value);
+    auto before = near->GetStats();
+    bool ok = redis.Get(key, value) && value == "v1";
+    auto after = near->GetStats();
+    Check("near repeated get hits", ok && after.hits == before.hits + 1, value);
+
+    before = near->GetStats();
+    ok = !redis.ExistsKey(prefix + "near_missing") && !redis.ExistsKey(prefix + "near_missing");
+    after = near->GetStats();
+    Check("near negative hit", ok && after.negative_hits == before.negative_hits + 1);
+
+    redis.Set(key, "v2");
+    Check("near read your write", redis.Get(key, value) && value == "v2", value);
+
+    RedisConnection::Options external_options;
+    external_options.host = options.host;
+    external_options.port = options.port;
+    external_options.password = options.password;
+    auto external =
+        std::make_shared<RedisConnection>(*AsioIOServicePool::GetInstance()->GetIOService(), external_options);
+    external->Start();
+    auto start = Clock::now();
+    while (!external->Connected() && MillisSince(start) < 1000)
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+
+    // 远小于 TtlMs: 新值只能来自失效消息
+    auto invalidated = [&](const std::function<bool()> &converged)
+    {
+        auto begin = Clock::now();
+        while (MillisSince(begin) < 500)
+        {
+            if (converged())
+            {
+                return true;
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        return false;
+    };
+    redis.Get(key, value);
+    ok = ExternalSet(external, key, "v3") &&
+         invalidated([&]() { return redis.Get(key, value) && value == "v3"; });
+    Check("near invalidated by external write", ok, value);
+    ok = ExternalSet(external, prefix + "near_missing", "1") &&
+         invalidated([&]() { return redis.ExistsKey(prefix + "near_missing"); });
+    Check("near negative entry invalidated", ok);
+
+    auto promise = std::make_shared<std::promise<void>>();
+    external->Stop([promise]() { promise->set_value(); });
+    promise->get_future().wait_for(std::chrono::seconds(1));
+    redis.Execute({"DEL", key, prefix + "near_missing"});
+}
+
+void CheckReconnect(RedisMgr &redis, const std::string &prefix)
+{
+    // 本连接也会被断开，回复可能收不到，忽略结果
+    redis.Execute({"CLIENT", "KILL", "TYPE", "normal", "SKIPME", "no"});
+
+    auto start = Clock::now();
+    int failures = 0;
+    bool recovered = false;
+    while (MillisSince(start) < 10000)
+    {
+        std::string value;
+        if (redis.Set(prefix + "reconnect", "1") && redis.Get(prefix + "reconnect", value) && value == "1")
+        {
+            recovered = true;
+            break;
+        }
+        ++failures;
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    }
+    Check("reconnect after CLIENT KILL", recovered,
+          std::to_string(failures) + " failed attempts in " + std::to_string(MillisSince(start)) + " ms");
+    redis.Del(prefix + "reconnect");
+}
+} // namespace
+
+int main(int argc, char *argv[])
+{
+    Options options;
+    if (!ParseOptions(argc, argv, options))
+    {
+        std::fprintf(stderr, "usage: redis_harness [--host=127.0.0.1] [--port=6379] [--password=] "
+                             "[--requests=10000] [--reconnect=on|off]\n");
+        return 2;
+    }
+    Logger::SetLevel(LogLevel::Warn);
+
+    auto redis = RedisMgr::GetInstance();
+    if (!options.password.empty())
+    {
+        redis->Auth(options.password);
+    }
+    bool connected = redis->Connect(options.host, options.port);
+    Check("connect", connected, options.host + ":" + std::to_string(options.port));
+    if (connected)
+    {
+        const std::string prefix = "gate_harness:" + std::to_string(::getpid()) + ":";
+        RedisReply pong = redis->Execute({"PING"});
+        Check("ping", pong.str == "PONG", pong.str);
+        CheckSync(*redis, prefix);
+        CheckAsync(*redis, prefix, options.requests);
+        CheckChain(*redis, prefix);
+        CheckGuard(*redis, prefix);
+        CheckVerify(*redis, prefix);
+        if (redis->GetNearCache() != nullptr)
+        {
+            CheckNearCache(*redis, options, prefix);
+        }
+        if (options.reconnect)
+        {
+            CheckReconnect(*redis, prefix);
+            if (redis->GetNearCache() != nullptr)
+            {
+                Check("near cache ready after reconnect", WaitNearReady(*redis->GetNearCache(), 5000));
+            }
+        }
+        redis->Execute({"DEL", prefix + "list", prefix + "hash"});
+    }
+
+    std::printf("%s (%d failed)\n", g_failures == 0 ? "ALL PASSED" : "FAILED", g_failures);
+    redis->Close();
+    AsioIOServicePool::GetInstance()->Stop();
+    Logger::Shutdown();
+    return g_failures == 0 ? 0 : 1;
+}